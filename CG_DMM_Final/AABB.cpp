@@ -0,0 +1,92 @@
+#include "AABB.h"
+#include <algorithm>
+#include <limits>
+
+//
+// Default Constructor: AABB
+// Initializes an empty box (min = +infinity, max = -infinity) that any expand() replaces.
+//
+AABB::AABB()
+    : min(Vector3D(std::numeric_limits<Real>::infinity(),
+                   std::numeric_limits<Real>::infinity(),
+                   std::numeric_limits<Real>::infinity())),
+      max(Vector3D(-std::numeric_limits<Real>::infinity(),
+                   -std::numeric_limits<Real>::infinity(),
+                   -std::numeric_limits<Real>::infinity())) {}
+
+//
+// Constructor: AABB
+// Initializes a box from its two corners.
+// Parameters:
+//   - min: The corner with the smallest coordinates.
+//   - max: The corner with the largest coordinates.
+//
+AABB::AABB(const Vector3D& min, const Vector3D& max)
+    : min(min), max(max) {}
+
+//
+// Method: expand
+// Grows the box to contain a point.
+// Parameters:
+//   - point: The point to include.
+//
+void AABB::expand(const Vector3D& point) {
+    min = Vector3D(std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z));
+    max = Vector3D(std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z));
+}
+
+//
+// Method: expand
+// Grows the box to contain another box.
+// Parameters:
+//   - box: The box to include.
+//
+void AABB::expand(const AABB& box) {
+    expand(box.min);
+    expand(box.max);
+}
+
+//
+// Method: centroid
+// Returns: The center point of the box.
+//
+Vector3D AABB::centroid() const {
+    return (min + max) * 0.5;
+}
+
+//
+// Method: surfaceArea
+// Returns: The surface area of the box, or 0 for an empty box.
+//
+Real AABB::surfaceArea() const {
+    Vector3D extent = max - min;
+    if (extent.x < 0 || extent.y < 0 || extent.z < 0) return 0.0;
+    return 2.0 * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+//
+// Method: intersect
+// Slab test of a ray against the box.
+// Parameters:
+//   - ray: The ray to test.
+//   - invDirection: Component-wise reciprocal of the ray direction.
+//   - tMin, tMax: The accepted distance interval.
+//   - tEntry: The distance at which the ray enters the box (output).
+// Returns:
+//   - true if the ray overlaps the box within [tMin, tMax], false otherwise.
+//
+bool AABB::intersect(const Ray& ray, const Vector3D& invDirection,
+                     Real tMin, Real tMax, Real& tEntry) const {
+    Real tx1 = (min.x - ray.origin.x) * invDirection.x;
+    Real tx2 = (max.x - ray.origin.x) * invDirection.x;
+    Real ty1 = (min.y - ray.origin.y) * invDirection.y;
+    Real ty2 = (max.y - ray.origin.y) * invDirection.y;
+    Real tz1 = (min.z - ray.origin.z) * invDirection.z;
+    Real tz2 = (max.z - ray.origin.z) * invDirection.z;
+
+    Real entry = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::max(std::min(tz1, tz2), tMin));
+    Real exit = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::min(std::max(tz1, tz2), tMax));
+
+    tEntry = entry;
+    return entry <= exit;
+}
@@ -0,0 +1,80 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include "Vector3D.h"
+#include "Ray.h"
+
+//
+// Class: AABB
+// An axis-aligned bounding box, used to bound primitives and BVH nodes.
+//
+class AABB {
+public:
+    Vector3D min;   // The corner with the smallest coordinates.
+    Vector3D max;   // The corner with the largest coordinates.
+
+    //
+    // Default Constructor: AABB
+    // Initializes an empty box (min = +infinity, max = -infinity) that any expand() replaces.
+    //
+    AABB();
+
+    //
+    // Constructor: AABB
+    // Initializes a box from its two corners.
+    // Parameters:
+    //   - min: The corner with the smallest coordinates.
+    //   - max: The corner with the largest coordinates.
+    //
+    AABB(const Vector3D& min, const Vector3D& max);
+
+    //
+    // Destructor: ~AABB
+    // Default destructor for the AABB class.
+    //
+    ~AABB() = default;
+
+    //
+    // Method: expand
+    // Grows the box to contain a point.
+    // Parameters:
+    //   - point: The point to include.
+    //
+    void expand(const Vector3D& point);
+
+    //
+    // Method: expand
+    // Grows the box to contain another box.
+    // Parameters:
+    //   - box: The box to include.
+    //
+    void expand(const AABB& box);
+
+    //
+    // Method: centroid
+    // Returns: The center point of the box.
+    //
+    Vector3D centroid() const;
+
+    //
+    // Method: surfaceArea
+    // Returns: The surface area of the box, or 0 for an empty box.
+    //
+    Real surfaceArea() const;
+
+    //
+    // Method: intersect
+    // Slab test of a ray against the box.
+    // Parameters:
+    //   - ray: The ray to test.
+    //   - invDirection: Component-wise reciprocal of the ray direction.
+    //   - tMin, tMax: The accepted distance interval.
+    //   - tEntry: The distance at which the ray enters the box (output).
+    // Returns:
+    //   - true if the ray overlaps the box within [tMin, tMax], false otherwise.
+    //
+    bool intersect(const Ray& ray, const Vector3D& invDirection,
+                   Real tMin, Real tMax, Real& tEntry) const;
+};
+
+#endif // AABB_H
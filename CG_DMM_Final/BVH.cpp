@@ -0,0 +1,308 @@
+#include "BVH.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+const int BIN_COUNT = 16;              // Number of SAH bins per axis.
+const int MAX_LEAF_SIZE = 4;           // Leaves larger than this are always split if possible.
+const int MAX_SAH_DEPTH = 64;          // Below this depth nodes are split at the median.
+const int STACK_SIZE = 128;            // Traversal stack; covers MAX_SAH_DEPTH plus a median-split tail.
+const Real TRAVERSAL_COST = 1.0;       // Relative cost of visiting a node.
+const Real INTERSECTION_COST = 1.0;    // Relative cost of one primitive test.
+
+//
+// Function: axisValue
+// Returns the component of a vector along an axis (0 = x, 1 = y, 2 = z).
+//
+Real axisValue(const Vector3D& v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+} // namespace
+
+//
+// Constructor: BVH
+// Creates an empty hierarchy.
+//
+BVH::BVH() {}
+
+//
+// Destructor: ~BVH
+// Default destructor for the BVH class.
+//
+BVH::~BVH() {}
+
+//
+// Method: build
+// Builds the hierarchy over all given primitives, replacing any previous tree.
+// Parameters:
+//   - spheres: The scene's spheres.
+//   - triangles: The scene's triangles.
+//   - meshes: The scene's meshes; their triangles are numbered consecutively across all meshes.
+//
+void BVH::build(const std::vector<Sphere>& spheres, const std::vector<Triangle>& triangles,
+                const std::vector<Mesh>& meshes) {
+    nodes.clear();
+    primitives.clear();
+
+    std::size_t meshTriangles = 0;
+    for (const Mesh& mesh : meshes) meshTriangles += mesh.triangleCount();
+
+    std::vector<BuildEntry> entries;
+    entries.reserve(spheres.size() + triangles.size() + meshTriangles);
+    for (size_t i = 0; i < spheres.size(); i++) {
+        AABB box = spheres[i].bounds();
+        entries.push_back({box, box.centroid(), {PrimitiveType::SPHERE, static_cast<int>(i)}});
+    }
+    for (size_t i = 0; i < triangles.size(); i++) {
+        AABB box = triangles[i].bounds();
+        entries.push_back({box, box.centroid(), {PrimitiveType::TRIANGLE, static_cast<int>(i)}});
+    }
+    int meshTriangle = 0;
+    for (const Mesh& mesh : meshes) {
+        for (std::size_t i = 0; i < mesh.triangleCount(); i++) {
+            AABB box = mesh.triangleBounds(i);
+            entries.push_back({box, box.centroid(), {PrimitiveType::MESH_TRIANGLE, meshTriangle++}});
+        }
+    }
+    if (entries.empty()) return;
+
+    nodes.reserve(2 * entries.size());
+    primitives.reserve(entries.size());
+    buildNode(entries, 0, static_cast<int>(entries.size()), 0);
+}
+
+//
+// Method: buildNode
+// Recursively builds the subtree over entries[begin, end).
+// The split plane is chosen among BIN_COUNT candidate planes per axis by minimizing
+//   TRAVERSAL_COST + (area(L) * count(L) + area(R) * count(R)) / area(node) * INTERSECTION_COST.
+// Parameters:
+//   - entries: The build entries; reordered in place.
+//   - begin, end: The range of entries belonging to this node.
+//   - depth: The depth of this node.
+// Returns:
+//   - The index of the created node.
+//
+int BVH::buildNode(std::vector<BuildEntry>& entries, int begin, int end, int depth) {
+    int nodeIndex = static_cast<int>(nodes.size());
+    nodes.push_back(BVHNode());
+
+    AABB bounds;
+    AABB centroidBounds;
+    for (int i = begin; i < end; i++) {
+        bounds.expand(entries[i].bounds);
+        centroidBounds.expand(entries[i].centroid);
+    }
+    nodes[nodeIndex].bounds = bounds;
+
+    int count = end - begin;
+    int bestAxis = -1;
+    int bestBin = 0;
+    Real bestCost = std::numeric_limits<Real>::infinity();
+
+    if (count > 1 && depth < MAX_SAH_DEPTH) {
+        for (int axis = 0; axis < 3; axis++) {
+            Real axisMin = axisValue(centroidBounds.min, axis);
+            Real extent = axisValue(centroidBounds.max, axis) - axisMin;
+            if (extent <= 0.0) continue;
+
+            AABB binBounds[BIN_COUNT];
+            int binCounts[BIN_COUNT] = {0};
+            Real scale = BIN_COUNT / extent;
+            for (int i = begin; i < end; i++) {
+                int bin = std::min(BIN_COUNT - 1, static_cast<int>((axisValue(entries[i].centroid, axis) - axisMin) * scale));
+                binCounts[bin]++;
+                binBounds[bin].expand(entries[i].bounds);
+            }
+
+            // Sweep from the right to get the area and count of every right-hand side
+            Real rightArea[BIN_COUNT];
+            int rightCount[BIN_COUNT];
+            AABB accumulated;
+            int accumulatedCount = 0;
+            for (int bin = BIN_COUNT - 1; bin > 0; bin--) {
+                accumulated.expand(binBounds[bin]);
+                accumulatedCount += binCounts[bin];
+                rightArea[bin] = accumulated.surfaceArea();
+                rightCount[bin] = accumulatedCount;
+            }
+
+            // Sweep from the left and evaluate the split in front of every bin
+            accumulated = AABB();
+            accumulatedCount = 0;
+            for (int bin = 1; bin < BIN_COUNT; bin++) {
+                accumulated.expand(binBounds[bin - 1]);
+                accumulatedCount += binCounts[bin - 1];
+                if (accumulatedCount == 0 || rightCount[bin] == 0) continue;
+                Real cost = accumulated.surfaceArea() * accumulatedCount + rightArea[bin] * rightCount[bin];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = bin;
+                }
+            }
+        }
+    }
+
+    Real nodeArea = bounds.surfaceArea();
+    if (bestAxis >= 0 && nodeArea > 0.0) {
+        bestCost = TRAVERSAL_COST + bestCost / nodeArea * INTERSECTION_COST;
+    }
+    Real leafCost = count * INTERSECTION_COST;
+
+    int mid;
+    if (bestAxis >= 0 && (bestCost < leafCost || count > MAX_LEAF_SIZE)) {
+        // Binned SAH split
+        Real axisMin = axisValue(centroidBounds.min, bestAxis);
+        Real scale = BIN_COUNT / (axisValue(centroidBounds.max, bestAxis) - axisMin);
+        auto middle = std::partition(entries.begin() + begin, entries.begin() + end,
+            [&](const BuildEntry& entry) {
+                int bin = std::min(BIN_COUNT - 1, static_cast<int>((axisValue(entry.centroid, bestAxis) - axisMin) * scale));
+                return bin < bestBin;
+            });
+        mid = static_cast<int>(middle - entries.begin());
+    } else if (count > MAX_LEAF_SIZE) {
+        // Too deep for SAH, or all centroids coincide: split at the median of the widest axis
+        Vector3D extent = centroidBounds.max - centroidBounds.min;
+        int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+        mid = begin + count / 2;
+        std::nth_element(entries.begin() + begin, entries.begin() + mid, entries.begin() + end,
+            [axis](const BuildEntry& a, const BuildEntry& b) {
+                return axisValue(a.centroid, axis) < axisValue(b.centroid, axis);
+            });
+    } else {
+        // Leaf
+        nodes[nodeIndex].offset = static_cast<int>(primitives.size());
+        nodes[nodeIndex].count = count;
+        for (int i = begin; i < end; i++) {
+            primitives.push_back(entries[i].primitive);
+        }
+        return nodeIndex;
+    }
+
+    buildNode(entries, begin, mid, depth + 1);
+    int rightChild = buildNode(entries, mid, end, depth + 1);
+    nodes[nodeIndex].offset = rightChild;
+    nodes[nodeIndex].count = 0;
+    return nodeIndex;
+}
+
+//
+// Method: intersect
+// Finds the closest primitive hit by the ray with t_min < t < t_max.
+// Children are visited nearest-first and subtrees entered beyond the current closest hit are skipped.
+// Parameters:
+//   - geometry: The packed primitives the references point into.
+//   - ray: The ray to trace.
+//   - t_min, t_max: The accepted distance interval (exclusive).
+//   - hit: The closest hit (output, only written on success).
+// Returns:
+//   - true if any primitive was hit, false otherwise.
+//
+bool BVH::intersect(const PackedGeometry& geometry, const Ray& ray,
+                    Real t_min, Real t_max, Hit& hit) const {
+    if (nodes.empty()) return false;
+
+    Vector3D invDirection(1 / ray.direction.x, 1 / ray.direction.y, 1 / ray.direction.z);
+    Real closest_t = t_max;
+    bool found = false;
+
+    Real entry;
+    if (!nodes[0].bounds.intersect(ray, invDirection, t_min, closest_t, entry)) return false;
+
+    int stack[STACK_SIZE];
+    Real stackEntry[STACK_SIZE];
+    int stackSize = 0;
+    int nodeIndex = 0;
+
+    while (true) {
+        const BVHNode& node = nodes[nodeIndex];
+
+        if (node.count > 0) {
+            if (geometry.intersect(&primitives[node.offset], node.count, ray, t_min, closest_t, hit)) {
+                found = true;
+            }
+        } else {
+            int left = nodeIndex + 1;
+            int right = node.offset;
+            Real leftEntry, rightEntry;
+            bool hitLeft = nodes[left].bounds.intersect(ray, invDirection, t_min, closest_t, leftEntry);
+            bool hitRight = nodes[right].bounds.intersect(ray, invDirection, t_min, closest_t, rightEntry);
+
+            if (hitLeft && hitRight) {
+                if (rightEntry < leftEntry) {
+                    std::swap(left, right);
+                    std::swap(leftEntry, rightEntry);
+                }
+                stack[stackSize] = right;
+                stackEntry[stackSize] = rightEntry;
+                stackSize++;
+                nodeIndex = left;
+                continue;
+            }
+            if (hitLeft) {
+                nodeIndex = left;
+                continue;
+            }
+            if (hitRight) {
+                nodeIndex = right;
+                continue;
+            }
+        }
+
+        // Pop the next subtree that may still contain a closer hit
+        bool popped = false;
+        while (stackSize > 0) {
+            stackSize--;
+            if (stackEntry[stackSize] < closest_t) {
+                nodeIndex = stack[stackSize];
+                popped = true;
+                break;
+            }
+        }
+        if (!popped) break;
+    }
+
+    return found;
+}
+
+//
+// Method: occluded
+// Any-hit query for shadow rays: stops at the first primitive that blocks the segment
+// (0, t_max). Nodes are visited in stack order without sorting since any blocker will do.
+// Parameters:
+//   - geometry: The packed primitives the references point into.
+//   - ray: The shadow ray; its direction must be normalized.
+//   - t_max: The length of the segment.
+//   - occluder: The blocking primitive (output, only written on success).
+// Returns:
+//   - true if the segment is blocked, false otherwise.
+//
+bool BVH::occluded(const PackedGeometry& geometry, const Ray& ray,
+                   Real t_max, PrimitiveRef& occluder) const {
+    if (nodes.empty()) return false;
+
+    Vector3D invDirection(1 / ray.direction.x, 1 / ray.direction.y, 1 / ray.direction.z);
+    int stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const BVHNode& node = nodes[stack[--stackSize]];
+        Real entry;
+        if (!node.bounds.intersect(ray, invDirection, 0.0, t_max, entry)) continue;
+
+        if (node.count > 0) {
+            if (geometry.occludes(&primitives[node.offset], node.count, ray, t_max, occluder)) {
+                return true;
+            }
+        } else {
+            stack[stackSize++] = node.offset;
+            stack[stackSize++] = static_cast<int>(&node - nodes.data()) + 1;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,104 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include "AABB.h"
+#include "MappedArray.h"
+#include "Ray.h"
+#include "Sphere.h"
+#include "Triangle.h"
+#include "Mesh.h"
+#include "Primitive.h"
+#include "PackedGeometry.h"
+
+//
+// Struct: BVHNode
+// One node of the flattened hierarchy. Nodes are stored depth-first: the left child of an
+// interior node directly follows it, and `offset` holds the index of the right child.
+// For a leaf, `offset` is the first entry in the primitive reference list and `count` > 0.
+//
+struct BVHNode {
+    AABB bounds;   // Bounds of everything below this node.
+    int offset;    // Right child (interior) or first primitive reference (leaf).
+    int count;     // Number of primitives in a leaf, 0 for interior nodes.
+};
+
+//
+// Class: BVH
+// A bounding volume hierarchy over the spheres, triangles and mesh triangles of a scene, built with the
+// binned surface area heuristic (SAH). All primitive types live in the same tree, so a
+// closest-hit query visits roughly O(log N) nodes instead of testing every primitive.
+//
+class BVH {
+public:
+    MappedArray<BVHNode> nodes;               // The flattened tree; nodes[0] is the root.
+    MappedArray<PrimitiveRef> primitives;     // Primitive references, grouped by leaf. After
+                                              // Scene::build they index the packed geometry.
+
+    //
+    // Constructor: BVH
+    // Creates an empty hierarchy.
+    //
+    BVH();
+
+    //
+    // Destructor: ~BVH
+    // Default destructor for the BVH class.
+    //
+    ~BVH();
+
+    //
+    // Method: build
+    // Builds the hierarchy over all given primitives, replacing any previous tree.
+    // Parameters:
+    //   - spheres: The scene's spheres.
+    //   - triangles: The scene's triangles.
+    //   - meshes: The scene's meshes; their triangles are numbered consecutively across all meshes.
+    //
+    void build(const std::vector<Sphere>& spheres, const std::vector<Triangle>& triangles,
+               const std::vector<Mesh>& meshes);
+
+    //
+    // Method: intersect
+    // Finds the closest primitive hit by the ray with t_min < t < t_max.
+    // Parameters:
+    //   - geometry: The packed primitives the references point into.
+    //   - ray: The ray to trace.
+    //   - t_min, t_max: The accepted distance interval (exclusive).
+    //   - hit: The closest hit (output, only written on success).
+    // Returns:
+    //   - true if any primitive was hit, false otherwise.
+    //
+    bool intersect(const PackedGeometry& geometry, const Ray& ray,
+                   Real t_min, Real t_max, Hit& hit) const;
+
+    //
+    // Method: occluded
+    // Any-hit query for shadow rays: stops at the first primitive that blocks the segment
+    // (0, t_max). Nodes are visited in stack order without sorting since any blocker will do.
+    // Parameters:
+    //   - geometry: The packed primitives the references point into.
+    //   - ray: The shadow ray; its direction must be normalized.
+    //   - t_max: The length of the segment.
+    //   - occluder: The blocking primitive (output, only written on success).
+    // Returns:
+    //   - true if the segment is blocked, false otherwise.
+    //
+    bool occluded(const PackedGeometry& geometry, const Ray& ray,
+                  Real t_max, PrimitiveRef& occluder) const;
+
+private:
+    //
+    // Struct: BuildEntry
+    // Per-primitive data used only while building.
+    //
+    struct BuildEntry {
+        AABB bounds;
+        Vector3D centroid;
+        PrimitiveRef primitive;
+    };
+
+    int buildNode(std::vector<BuildEntry>& entries, int begin, int end, int depth);
+};
+
+#endif // BVH_H
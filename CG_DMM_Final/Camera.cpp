@@ -0,0 +1,43 @@
+#include "Camera.h"
+
+//
+// Constructor: Camera
+// Builds the camera basis from a position, a target point and a world up vector.
+// Parameters:
+//   - origin: The camera position.
+//   - lookAt: The point the camera is looking at.
+//   - worldUp: The world up direction used to orient the viewport.
+//   - aspectRatio: Image width divided by image height.
+//   - viewportHeight: Height of the viewport.
+//
+Camera::Camera(const Vector3D& origin, const Vector3D& lookAt, const Vector3D& worldUp,
+               Real aspectRatio, Real viewportHeight)
+    : origin(origin),
+      direction((lookAt - origin).normalize()),
+      viewportWidth(viewportHeight * aspectRatio),
+      viewportHeight(viewportHeight) {
+    right = direction.cross(worldUp).normalize(); // Right direction vector
+    up = right.cross(direction).normalize();      // Adjusted up vector
+}
+
+//
+// Destructor: ~Camera
+// Default destructor for the Camera class.
+//
+Camera::~Camera() {}
+
+//
+// Method: generateRay
+// Creates the primary ray through a point of the viewport.
+// Parameters:
+//   - u: Horizontal viewport coordinate in [-0.5, 0.5].
+//   - v: Vertical viewport coordinate in [-0.5, 0.5].
+// Returns:
+//   - The ray from the camera origin through (u, v).
+//
+Ray Camera::generateRay(Real u, Real v) const {
+    Vector3D rayDirection = (direction +
+                             right * (u * viewportWidth) +
+                             up * (v * viewportHeight)).normalize();
+    return Ray(origin, rayDirection);
+}
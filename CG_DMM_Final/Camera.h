@@ -0,0 +1,51 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "Vector3D.h"
+#include "Ray.h"
+
+//
+// Class: Camera
+// A simple pinhole camera that turns normalized image coordinates into primary rays.
+//
+class Camera {
+public:
+    Vector3D origin;          // The camera position.
+    Vector3D direction;       // The normalized viewing direction.
+    Vector3D right;           // The normalized horizontal axis of the viewport.
+    Vector3D up;              // The normalized vertical axis of the viewport.
+    Real viewportWidth;       // Width of the viewport at unit distance.
+    Real viewportHeight;      // Height of the viewport at unit distance.
+
+    //
+    // Constructor: Camera
+    // Builds the camera basis from a position, a target point and a world up vector.
+    // Parameters:
+    //   - origin: The camera position.
+    //   - lookAt: The point the camera is looking at.
+    //   - worldUp: The world up direction used to orient the viewport.
+    //   - aspectRatio: Image width divided by image height.
+    //   - viewportHeight: (Optional) Height of the viewport. Default is 2.0.
+    //
+    Camera(const Vector3D& origin, const Vector3D& lookAt, const Vector3D& worldUp,
+           Real aspectRatio, Real viewportHeight = 2.0);
+
+    //
+    // Destructor: ~Camera
+    // Default destructor for the Camera class.
+    //
+    ~Camera();
+
+    //
+    // Method: generateRay
+    // Creates the primary ray through a point of the viewport.
+    // Parameters:
+    //   - u: Horizontal viewport coordinate in [-0.5, 0.5].
+    //   - v: Vertical viewport coordinate in [-0.5, 0.5].
+    // Returns:
+    //   - The ray from the camera origin through (u, v).
+    //
+    Ray generateRay(Real u, Real v) const;
+};
+
+#endif // CAMERA_H
@@ -1,17 +1,32 @@
 #ifndef COLOR_H
 #define COLOR_H
 
+#include <algorithm>
+#include <type_traits>
+#include "Real.h"
+#include "SimdMath.h"
+
 //
-// Class: Color
+// Class: ColorT
 // Represents a color using RGB components, with support for basic color operations.
+// Defined inline and constexpr like Vector3D, with the same optional SIMD layout and the
+// same scalar type parameter; Color is the renderer's Real color (see Real.h).
 //
-class Color {
+template <typename T>
+#ifdef RAYTRACER_SIMD_MATH
+class alignas(4 * sizeof(T)) ColorT {
+#else
+class ColorT {
+#endif
 public:
-    double r, g, b; 
+    T r, g, b;
     // Public Members:
     //   - r: Red component of the color (range: 0.0 to 1.0).
     //   - g: Green component of the color (range: 0.0 to 1.0).
     //   - b: Blue component of the color (range: 0.0 to 1.0).
+#ifdef RAYTRACER_SIMD_MATH
+    T a;        // Padding lane of the SIMD layout, always 0 after construction
+#endif
 
     //
     // Constructor: Color
@@ -21,25 +36,27 @@ public:
     //   - g: Initial green component value.
     //   - b: Initial blue component value.
     //
-    Color(double r, double g, double b);
+#ifdef RAYTRACER_SIMD_MATH
+    constexpr ColorT(T r, T g, T b) : r(r), g(g), b(b), a(0) {}
+#else
+    constexpr ColorT(T r, T g, T b) : r(r), g(g), b(b) {}
+#endif
 
     //
     // Constructor: Color
     // Default constructor, initializes the color to black (r = g = b = 0.0).
     //
-    Color();
-
-    //
-    // Destructor: ~Color
-    // Default destructor for the Color class.
-    //
-    ~Color();
+    constexpr ColorT() : ColorT(0, 0, 0) {}
 
     //
     // Method: clamp
     // Clamps the RGB components to the range [0.0, 1.0].
     //
-    void clamp();
+    constexpr void clamp() {
+        r = std::min(T(1), std::max(T(0), r));
+        g = std::min(T(1), std::max(T(0), g));
+        b = std::min(T(1), std::max(T(0), b));
+    }
 
     //
     // Operator: +
@@ -49,7 +66,17 @@ public:
     // Returns:
     //   A new Color object with the summed RGB values.
     //
-    Color operator+(const Color& c) const;
+    constexpr ColorT operator+(const ColorT& c) const {
+#ifdef RAYTRACER_SIMD_MATH
+        if (!constantEvaluated()) {
+            SimdLanes4<T> x = {}, y = {};
+            simdLoad(&r, x);
+            simdLoad(&c.r, y);
+            return fromLanes(x + y);
+        }
+#endif
+        return ColorT(r + c.r, g + c.g, b + c.b);
+    }
 
     //
     // Operator: *
@@ -59,7 +86,16 @@ public:
     // Returns:
     //   A new Color object with the scaled RGB values.
     //
-    Color operator*(double scalar) const;
+    constexpr ColorT operator*(T scalar) const {
+#ifdef RAYTRACER_SIMD_MATH
+        if (!constantEvaluated()) {
+            SimdLanes4<T> x = {};
+            simdLoad(&r, x);
+            return fromLanes(x * scalar);
+        }
+#endif
+        return ColorT(r * scalar, g * scalar, b * scalar);
+    }
 
     //
     // Operator: *
@@ -69,7 +105,51 @@ public:
     // Returns:
     //   A new Color object with the component-wise multiplied RGB values.
     //
-    Color operator*(const Color& c) const;
+    constexpr ColorT operator*(const ColorT& c) const {
+#ifdef RAYTRACER_SIMD_MATH
+        if (!constantEvaluated()) {
+            SimdLanes4<T> x = {}, y = {};
+            simdLoad(&r, x);
+            simdLoad(&c.r, y);
+            return fromLanes(x * y);
+        }
+#endif
+        return ColorT(r * c.r, g * c.g, b * c.b);
+    }
+
+    //
+    // Method: multiplyAdd
+    // Computes this * scalar + c, the fused form of `c + this * scalar` used to accumulate
+    // weighted light contributions (see fusedMultiplyAdd).
+    // Parameters:
+    //   - scalar: The scalar value for multiplication.
+    //   - c: The Color object to be added.
+    // Returns:
+    //   A new Color object with the result.
+    //
+    constexpr ColorT multiplyAdd(T scalar, const ColorT& c) const {
+        return ColorT(fusedMultiplyAdd(r, scalar, c.r),
+                      fusedMultiplyAdd(g, scalar, c.g),
+                      fusedMultiplyAdd(b, scalar, c.b));
+    }
+
+private:
+#ifdef RAYTRACER_SIMD_MATH
+    //
+    // Function: fromLanes
+    // Builds a color from the four lanes of a SIMD register.
+    //
+    static ColorT fromLanes(const SimdLanes4<T>& lanes) {
+        ColorT result;
+        simdStore(lanes, &result.r);
+        return result;
+    }
+#endif
 };
 
-#endif // COLOR_H
\ No newline at end of file
+typedef ColorT<Real> Color;
+
+static_assert(std::is_trivially_copyable<ColorT<float>>::value, "Color must stay trivially copyable");
+static_assert(std::is_trivially_copyable<ColorT<double>>::value, "Color must stay trivially copyable");
+
+#endif // COLOR_H
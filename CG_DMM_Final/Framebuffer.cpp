@@ -0,0 +1,81 @@
+#include "Framebuffer.h"
+#include <algorithm>
+
+//
+// Constructor: Framebuffer
+// Allocates a black image of the given size.
+// Parameters:
+//   - width: Image width in pixels.
+//   - height: Image height in pixels.
+//
+Framebuffer::Framebuffer(int width, int height)
+    : width(width),
+      height(height),
+      pixels(static_cast<size_t>(width) * height),
+      sampleCounts(static_cast<size_t>(width) * height, 0) {}
+
+//
+// Destructor: ~Framebuffer
+// Default destructor for the Framebuffer class.
+//
+Framebuffer::~Framebuffer() {}
+
+//
+// Method: setPixel
+// Stores the color of one pixel.
+// Parameters:
+//   - x, y: The pixel coordinates.
+//   - color: The pixel color.
+//
+void Framebuffer::setPixel(int x, int y, const Color& color) {
+    pixels[static_cast<size_t>(y) * width + x] = color;
+}
+
+//
+// Method: getPixel
+// Returns the color of one pixel.
+// Parameters:
+//   - x, y: The pixel coordinates.
+//
+const Color& Framebuffer::getPixel(int x, int y) const {
+    return pixels[static_cast<size_t>(y) * width + x];
+}
+
+//
+// Method: setSampleCount
+// Records how many samples the renderer averaged for one pixel.
+// Parameters:
+//   - x, y: The pixel coordinates.
+//   - count: The number of samples.
+//
+void Framebuffer::setSampleCount(int x, int y, int count) {
+    sampleCounts[static_cast<size_t>(y) * width + x] = count;
+}
+
+//
+// Method: getSampleCount
+// Returns the number of samples recorded for one pixel.
+// Parameters:
+//   - x, y: The pixel coordinates.
+//
+int Framebuffer::getSampleCount(int x, int y) const {
+    return sampleCounts[static_cast<size_t>(y) * width + x];
+}
+
+//
+// Method: sampleCountImage
+// Builds a grayscale debug image of the per-pixel sample counts.
+// Parameters:
+//   - maxSamples: The sample count mapped to white.
+// Returns:
+//   - A framebuffer of the same size.
+//
+Framebuffer Framebuffer::sampleCountImage(int maxSamples) const {
+    Framebuffer image(width, height);
+    for (size_t i = 0; i < sampleCounts.size(); i++) {
+        double level = std::min(1.0, static_cast<double>(sampleCounts[i]) / maxSamples);
+        image.pixels[i] = Color(level, level, level);
+        image.sampleCounts[i] = sampleCounts[i];
+    }
+    return image;
+}
@@ -0,0 +1,81 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <vector>
+#include "Color.h"
+
+//
+// Class: Framebuffer
+// An in-memory image that render threads write finished pixels into.
+// Pixels are stored row by row; distinct pixels may be written from different threads.
+// Colors are kept unclamped; ImageWriter encodes them into image files.
+//
+class Framebuffer {
+public:
+    int width;                  // Image width in pixels.
+    int height;                 // Image height in pixels.
+    std::vector<Color> pixels;  // Pixel colors, row-major, top row first.
+    std::vector<int> sampleCounts;  // Samples taken per pixel, same layout as `pixels`.
+
+    //
+    // Constructor: Framebuffer
+    // Allocates a black image of the given size.
+    // Parameters:
+    //   - width: Image width in pixels.
+    //   - height: Image height in pixels.
+    //
+    Framebuffer(int width, int height);
+
+    //
+    // Destructor: ~Framebuffer
+    // Default destructor for the Framebuffer class.
+    //
+    ~Framebuffer();
+
+    //
+    // Method: setPixel
+    // Stores the color of one pixel.
+    // Parameters:
+    //   - x, y: The pixel coordinates.
+    //   - color: The pixel color.
+    //
+    void setPixel(int x, int y, const Color& color);
+
+    //
+    // Method: getPixel
+    // Returns the color of one pixel.
+    // Parameters:
+    //   - x, y: The pixel coordinates.
+    //
+    const Color& getPixel(int x, int y) const;
+
+    //
+    // Method: setSampleCount
+    // Records how many samples the renderer averaged for one pixel.
+    // Parameters:
+    //   - x, y: The pixel coordinates.
+    //   - count: The number of samples.
+    //
+    void setSampleCount(int x, int y, int count);
+
+    //
+    // Method: getSampleCount
+    // Returns the number of samples recorded for one pixel.
+    // Parameters:
+    //   - x, y: The pixel coordinates.
+    //
+    int getSampleCount(int x, int y) const;
+
+    //
+    // Method: sampleCountImage
+    // Builds a grayscale debug image of the per-pixel sample counts: black for no samples,
+    // white for `maxSamples` or more.
+    // Parameters:
+    //   - maxSamples: The sample count mapped to white.
+    // Returns:
+    //   - A framebuffer of the same size.
+    //
+    Framebuffer sampleCountImage(int maxSamples) const;
+};
+
+#endif // FRAMEBUFFER_H
@@ -0,0 +1,177 @@
+#include "GBuffer.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+#include "Renderer.h"
+#include "SceneCache.h"
+
+namespace {
+
+const char MAGIC[8] = {'R', 'T', 'G', 'B', 'U', 'F', 'F', '\n'};
+const uint32_t BYTE_ORDER_MARK = 0x01020304;   // Reads back differently on a foreign byte order
+
+static_assert(std::is_trivially_copyable<GBufferSample>::value, "GBufferSample is stored as raw bytes");
+
+//
+// Struct: GBufferHeader
+// The start of a G-buffer file.
+//
+struct GBufferHeader {
+    char magic[8];            // MAGIC.
+    uint32_t version;         // GBuffer::VERSION of the writer.
+    uint32_t byteOrder;       // BYTE_ORDER_MARK in the writer's byte order.
+    uint64_t fingerprint;     // What the hits depend on.
+    uint32_t sampleSize;      // sizeof(GBufferSample) of the writer.
+    int32_t width;            // Image width in pixels.
+    int32_t height;           // Image height in pixels.
+    int32_t spp;              // Samples per pixel.
+};
+
+} // namespace
+
+//
+// Method: resize
+// Sizes the buffer for an image; the samples are left to be written by a render.
+//
+void GBuffer::resize(int width, int height, int spp) {
+    this->width = width;
+    this->height = height;
+    this->spp = spp;
+    samples.resize(static_cast<size_t>(width) * height * spp);
+}
+
+//
+// Function: computeFingerprint
+// Hashes everything the primary hits of a render depend on: the scene's geometry, the
+// camera, the resolution, the samples per pixel, the tile size, the seed and the sampler.
+// Parameters:
+//   - scene: The scene, before build().
+//   - sources: Anything else the geometry depends on, e.g. mesh file paths and dates.
+//   - camera: The camera of the render.
+//   - settings: The render settings.
+// Returns: A 64-bit hash.
+//
+uint64_t GBuffer::computeFingerprint(const Scene& scene, const std::string& sources, const Camera& camera,
+                                     const RenderSettings& settings) {
+    // Hexadecimal floats name every bit of the camera
+    std::ostringstream view;
+    view << std::hexfloat;
+    for (const Vector3D* v : {&camera.origin, &camera.direction, &camera.right, &camera.up}) {
+        view << v->x << ' ' << v->y << ' ' << v->z << ' ';
+    }
+    view << camera.viewportWidth << ' ' << camera.viewportHeight << ' ' << settings.width << 'x'
+         << settings.height << ' ' << settings.spp << ' ' << settings.tileSize << ' ' << settings.seed << ' '
+         << samplerTypeName(settings.sampler);
+    return SceneCache::geometryFingerprint(scene, sources + '\n' + view.str());
+}
+
+//
+// Method: save
+// Writes the buffer to a file (via a temporary file that is then renamed).
+// Parameters:
+//   - path: The file path.
+//   - error: A description of the failure (output, only written on failure).
+// Returns:
+//   - true on success, false if the file could not be written.
+//
+bool GBuffer::save(const std::string& path, std::string& error) const {
+    GBufferHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.fingerprint = fingerprint;
+    header.sampleSize = sizeof(GBufferSample);
+    header.width = width;
+    header.height = height;
+    header.spp = spp;
+
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(samples.data()),
+               static_cast<std::streamsize>(samples.size() * sizeof(GBufferSample)));
+    file.close();
+    if (!file) {
+        error = "cannot write " + temporaryPath;
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        error = "cannot rename " + temporaryPath + " to " + path;
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+//
+// Method: load
+// Reads a buffer written by save and checks that every sample refers to a primitive and a
+// material of the scene.
+// Parameters:
+//   - path: The file path.
+//   - scene: The built scene the buffer will re-shade.
+//   - fingerprint: The fingerprint the buffer must have been recorded with.
+//   - error: Why the file cannot be used (output, only written on failure).
+// Returns:
+//   - true on success, false if the file is missing, stale, corrupt or from another build.
+//
+bool GBuffer::load(const std::string& path, const Scene& scene, uint64_t fingerprint, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    GBufferHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = path + " is not a G-buffer";
+        return false;
+    }
+    if (header.version != VERSION || header.byteOrder != BYTE_ORDER_MARK ||
+        header.sampleSize != sizeof(GBufferSample)) {
+        error = path + " was written by an incompatible build";
+        return false;
+    }
+    if (header.fingerprint != fingerprint) {
+        error = path + " is stale (the geometry, camera or sampling has changed)";
+        return false;
+    }
+    // The samples must fill the rest of the file exactly, before anything is allocated
+    file.seekg(0, std::ios::end);
+    uint64_t bytes = static_cast<uint64_t>(file.tellg()) - sizeof(header);
+    file.seekg(sizeof(header));
+    uint64_t pixels = static_cast<uint64_t>(header.width) * static_cast<uint64_t>(header.height);
+    if (header.width <= 0 || header.height <= 0 || header.spp <= 0 || !file ||
+        pixels > bytes / sizeof(GBufferSample) / static_cast<uint64_t>(header.spp) ||
+        pixels * static_cast<uint64_t>(header.spp) * sizeof(GBufferSample) != bytes) {
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+
+    resize(header.width, header.height, header.spp);
+    this->fingerprint = fingerprint;
+    file.read(reinterpret_cast<char*>(samples.data()),
+              static_cast<std::streamsize>(samples.size() * sizeof(GBufferSample)));
+    bool valid = static_cast<bool>(file);
+
+    // Re-shading indexes the materials with the stored ids, so a damaged body must fail here
+    size_t materials = scene.materials.size();
+    for (size_t i = 0; valid && i < samples.size(); i++) {
+        const GBufferSample& sample = samples[i];
+        if (sample.materialId == -1) {
+            valid = sample.primitive.index == -1;
+        } else {
+            valid = sample.materialId >= 0 && static_cast<size_t>(sample.materialId) < materials &&
+                    scene.geometry.contains(sample.primitive);
+        }
+    }
+    if (!valid) {
+        error = path + " is truncated or corrupt";
+        samples.clear();
+        return false;
+    }
+    return true;
+}
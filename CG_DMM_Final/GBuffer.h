@@ -0,0 +1,104 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Camera.h"
+#include "Primitive.h"
+#include "Scene.h"
+
+struct RenderSettings;
+
+//
+// Struct: GBufferSample
+// The primary hit of one camera ray sample.
+//
+struct GBufferSample {
+    Vector3D point;            // The hit point.
+    Vector3D normal;           // The surface normal at the point.
+    PrimitiveRef primitive;    // The hit primitive (packed index); index -1 for a miss.
+    int materialId;            // Index into Scene::materials; -1 for a miss.
+};
+
+//
+// Class: GBuffer
+// The primary hits of every sample of a render, kept so that later renders of the same
+// geometry, camera and sampling can re-shade them without tracing any camera rays (see
+// Renderer::reshade). Only the shapes decide what a camera ray hits, so the lights and
+// the material parameters may change between the render that recorded the buffer and
+// the renders that re-shade it; anything else invalidates it (see fingerprint).
+//
+// Samples are stored in pixel order, the samples of a pixel next to each other. The file
+// format is a small header followed by the raw samples; like the scene cache, a file is
+// only read back by a build with the same byte order and struct sizes.
+//
+class GBuffer {
+public:
+    static const uint32_t VERSION = 1;   // Bumped whenever the file layout changes.
+
+    int width = 0;                       // Image width in pixels.
+    int height = 0;                      // Image height in pixels.
+    int spp = 0;                         // Samples per pixel.
+    uint64_t fingerprint = 0;            // What the hits depend on (see computeFingerprint).
+    std::vector<GBufferSample> samples;  // width * height * spp primary hits.
+
+    //
+    // Method: resize
+    // Sizes the buffer for an image; the samples are left to be written by a render.
+    //
+    void resize(int width, int height, int spp);
+
+    //
+    // Method: sample
+    // Returns: The primary hit of sample s of pixel (x, y).
+    //
+    GBufferSample& sample(int x, int y, int s) {
+        return samples[(static_cast<size_t>(y) * width + x) * spp + s];
+    }
+    const GBufferSample& sample(int x, int y, int s) const {
+        return samples[(static_cast<size_t>(y) * width + x) * spp + s];
+    }
+
+    //
+    // Function: computeFingerprint
+    // Hashes everything the primary hits of a render depend on: the scene's geometry (see
+    // SceneCache::geometryFingerprint), the camera, the resolution, the samples per pixel,
+    // the tile size, the seed and the sampler (which decide each sample's jitter).
+    // Parameters:
+    //   - scene: The scene, before build().
+    //   - sources: Anything else the geometry depends on, e.g. mesh file paths and dates.
+    //   - camera: The camera of the render.
+    //   - settings: The render settings.
+    // Returns: A 64-bit hash.
+    //
+    static uint64_t computeFingerprint(const Scene& scene, const std::string& sources, const Camera& camera,
+                                       const RenderSettings& settings);
+
+    //
+    // Method: save
+    // Writes the buffer to a file (via a temporary file that is then renamed).
+    // Parameters:
+    //   - path: The file path.
+    //   - error: A description of the failure (output, only written on failure).
+    // Returns:
+    //   - true on success, false if the file could not be written.
+    //
+    bool save(const std::string& path, std::string& error) const;
+
+    //
+    // Method: load
+    // Reads a buffer written by save. Every sample must be a miss or refer to a primitive
+    // and a material of the scene, so a damaged file cannot make reshade read out of bounds.
+    // Parameters:
+    //   - path: The file path.
+    //   - scene: The built scene the buffer will re-shade.
+    //   - fingerprint: The fingerprint the buffer must have been recorded with.
+    //   - error: Why the file cannot be used (output, only written on failure).
+    // Returns:
+    //   - true on success, false if the file is missing, stale, corrupt or from another build.
+    //
+    bool load(const std::string& path, const Scene& scene, uint64_t fingerprint, std::string& error);
+};
+
+#endif // GBUFFER_H
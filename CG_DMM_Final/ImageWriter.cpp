@@ -0,0 +1,221 @@
+#include "ImageWriter.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+//
+// Function: imageHeader
+// Returns: The file header of an image in the given format.
+//
+std::string imageHeader(const Framebuffer& framebuffer, ImageFormat format) {
+    std::ostringstream header;
+    if (format == ImageFormat::PFM) {
+        // A negative scale marks little-endian floats
+        uint16_t probe = 1;
+        bool littleEndian = *reinterpret_cast<unsigned char*>(&probe) == 1;
+        header << "PF\n" << framebuffer.width << " " << framebuffer.height << "\n"
+               << (littleEndian ? "-1.0" : "1.0") << "\n";
+    } else {
+        header << "P6\n" << framebuffer.width << " " << framebuffer.height << "\n255\n";
+    }
+    return header.str();
+}
+
+//
+// Function: rowBytes
+// Returns: The size of one encoded row in bytes.
+//
+std::size_t rowBytes(const Framebuffer& framebuffer, ImageFormat format) {
+    return static_cast<std::size_t>(framebuffer.width) * 3 * (format == ImageFormat::PFM ? sizeof(float) : 1);
+}
+
+//
+// Function: encodeImageRows
+// Encodes rows [y0, y1) in the format's pixel layout and row order (PFM stores rows
+// bottom to top).
+// Parameters:
+//   - framebuffer: The image.
+//   - format: The file format.
+//   - y0, y1: The rows.
+//   - out: The encoded rows (output, rowBytes() per row).
+//
+void encodeImageRows(const Framebuffer& framebuffer, ImageFormat format, int y0, int y1, unsigned char* out) {
+    if (format == ImageFormat::PFM) {
+        for (int y = y1 - 1; y >= y0; y--) {
+            for (int x = 0; x < framebuffer.width; x++) {
+                const Color& pixel = framebuffer.getPixel(x, y);
+                float rgb[3] = {static_cast<float>(pixel.r), static_cast<float>(pixel.g), static_cast<float>(pixel.b)};
+                std::memcpy(out, rgb, sizeof(rgb));
+                out += sizeof(rgb);
+            }
+        }
+        return;
+    }
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = 0; x < framebuffer.width; x++) {
+            Color pixelColor = framebuffer.getPixel(x, y);
+            pixelColor.clamp(); // Ensure the color values are in range [0.0, 1.0]
+
+            // Convert color values to integers in range [0, 255]
+            *out++ = static_cast<unsigned char>(std::min(255, std::max(0, static_cast<int>(pixelColor.r * 255))));
+            *out++ = static_cast<unsigned char>(std::min(255, std::max(0, static_cast<int>(pixelColor.g * 255))));
+            *out++ = static_cast<unsigned char>(std::min(255, std::max(0, static_cast<int>(pixelColor.b * 255))));
+        }
+    }
+}
+
+} // namespace
+
+//
+// Function: imageFormatForPath
+// Chooses the format from the file extension: ".pfm" gives PFM, anything else PPM.
+// Parameters:
+//   - path: The output file path.
+// Returns: The image format.
+//
+ImageFormat imageFormatForPath(const std::string& path) {
+    std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".pfm" ? ImageFormat::PFM : ImageFormat::PPM;
+}
+
+//
+// Function: encodeImage
+// Encodes a whole image in memory, exactly as ImageWriter would write it to a file.
+// Parameters:
+//   - framebuffer: The image.
+//   - format: The file format.
+// Returns: The file contents.
+//
+std::vector<unsigned char> encodeImage(const Framebuffer& framebuffer, ImageFormat format) {
+    std::string header = imageHeader(framebuffer, format);
+    std::vector<unsigned char> bytes(header.size() + rowBytes(framebuffer, format) * framebuffer.height);
+    std::memcpy(bytes.data(), header.data(), header.size());
+    encodeImageRows(framebuffer, format, 0, framebuffer.height, bytes.data() + header.size());
+    return bytes;
+}
+
+//
+// Constructor: ImageWriter
+// Opens the output file, writes its header and starts the writer thread.
+// Parameters:
+//   - framebuffer: The image being rendered; must outlive the writer.
+//   - path: The output file path.
+//   - format: The file format.
+//
+ImageWriter::ImageWriter(const Framebuffer& framebuffer, const std::string& path, ImageFormat format)
+    : framebuffer(framebuffer),
+      format(format),
+      file(path, std::ios::binary | std::ios::trunc),
+      headerSize(0),
+      rowSize(0),
+      rowsWritten(0),
+      finishing(false),
+      finished(false),
+      ok(static_cast<bool>(file)) {
+    std::string text = imageHeader(framebuffer, format);
+    rowSize = rowBytes(framebuffer, format);
+    headerSize = static_cast<std::streamoff>(text.size());
+    file.write(text.data(), headerSize);
+    ok = ok && static_cast<bool>(file);
+
+    writer = std::thread(&ImageWriter::run, this);
+}
+
+//
+// Destructor: ~ImageWriter
+// Finishes writing (see finish) if that has not happened yet.
+//
+ImageWriter::~ImageWriter() {
+    finish();
+}
+
+//
+// Method: submitRows
+// Queues rows [y0, y1) for writing. The rows must be final; may be called from any thread.
+// Parameters:
+//   - y0: The first row.
+//   - y1: One past the last row.
+//
+void ImageWriter::submitRows(int y0, int y1) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bands.emplace_back(y0, y1);
+    }
+    wake.notify_one();
+}
+
+//
+// Method: finish
+// Waits until every submitted row is written and closes the file.
+// Returns:
+//   - true if the whole file was written, false on an I/O error or if rows are missing.
+//
+bool ImageWriter::finish() {
+    if (!finished) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finishing = true;
+        }
+        wake.notify_one();
+        writer.join();
+        file.close();
+        ok = ok && !file.fail() && rowsWritten == framebuffer.height;
+        finished = true;
+    }
+    return ok;
+}
+
+//
+// Method: run
+// The writer thread: encodes and writes queued bands until finish() is called.
+//
+void ImageWriter::run() {
+    std::vector<unsigned char> bytes;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return !bands.empty() || finishing; });
+        if (bands.empty()) break;   // Finishing and nothing left to write
+
+        std::pair<int, int> band = bands.front();
+        bands.pop_front();
+        lock.unlock();
+
+        encodeRows(band.first, band.second, bytes);
+        if (format == ImageFormat::PFM) {
+            // Bottom-to-top rows: the band's last row comes first in the file
+            file.seekp(rowOffset(band.second - 1));
+        } else {
+            file.seekp(rowOffset(band.first));
+        }
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        ok = ok && static_cast<bool>(file);
+        rowsWritten += band.second - band.first;
+
+        lock.lock();
+    }
+}
+
+//
+// Method: encodeRows
+// Encodes rows [y0, y1) into `bytes` in the file's pixel format.
+//
+void ImageWriter::encodeRows(int y0, int y1, std::vector<unsigned char>& bytes) const {
+    bytes.resize(rowSize * (y1 - y0));
+    encodeImageRows(framebuffer, format, y0, y1, bytes.data());
+}
+
+//
+// Method: rowOffset
+// Returns the file offset of row y (PFM stores rows bottom to top).
+//
+std::streamoff ImageWriter::rowOffset(int y) const {
+    int fileRow = (format == ImageFormat::PFM) ? framebuffer.height - 1 - y : y;
+    return headerSize + static_cast<std::streamoff>(fileRow) * static_cast<std::streamoff>(rowSize);
+}
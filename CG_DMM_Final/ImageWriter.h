@@ -0,0 +1,123 @@
+#ifndef IMAGEWRITER_H
+#define IMAGEWRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Framebuffer.h"
+
+//
+// Enum: ImageFormat
+// The file formats the image writer can produce.
+//
+enum class ImageFormat {
+    PPM,   // Binary 8-bit PPM (P6), clamped to [0, 1].
+    PFM    // Portable float map: 32-bit float RGB, unclamped (HDR).
+};
+
+//
+// Function: imageFormatForPath
+// Chooses the format from the file extension: ".pfm" gives PFM, anything else PPM.
+// Parameters:
+//   - path: The output file path.
+// Returns: The image format.
+//
+ImageFormat imageFormatForPath(const std::string& path);
+
+//
+// Function: encodeImage
+// Encodes a whole image in memory, exactly as ImageWriter would write it to a file.
+// Parameters:
+//   - framebuffer: The image.
+//   - format: The file format.
+// Returns: The file contents.
+//
+std::vector<unsigned char> encodeImage(const Framebuffer& framebuffer, ImageFormat format);
+
+//
+// Class: ImageWriter
+// Writes a framebuffer to disk on a background thread while it is being rendered.
+// The renderer reports bands of finished rows through submitRows(); the writer thread
+// encodes each band and writes it straight to its final position in the file, since both
+// formats have fixed-size rows. Formatting and I/O thus overlap with rendering instead of
+// following it, and rows may finish in any order.
+//
+class ImageWriter {
+public:
+    //
+    // Constructor: ImageWriter
+    // Opens the output file, writes its header and starts the writer thread.
+    // Parameters:
+    //   - framebuffer: The image being rendered; must outlive the writer.
+    //   - path: The output file path.
+    //   - format: The file format.
+    //
+    ImageWriter(const Framebuffer& framebuffer, const std::string& path, ImageFormat format);
+
+    //
+    // Destructor: ~ImageWriter
+    // Finishes writing (see finish) if that has not happened yet.
+    //
+    ~ImageWriter();
+
+    ImageWriter(const ImageWriter&) = delete;
+    ImageWriter& operator=(const ImageWriter&) = delete;
+
+    //
+    // Method: submitRows
+    // Queues rows [y0, y1) for writing. The rows must be final; may be called from any thread.
+    // Parameters:
+    //   - y0: The first row.
+    //   - y1: One past the last row.
+    //
+    void submitRows(int y0, int y1);
+
+    //
+    // Method: finish
+    // Waits until every submitted row is written and closes the file.
+    // Returns:
+    //   - true if the whole file was written, false on an I/O error or if rows are missing.
+    //
+    bool finish();
+
+private:
+    //
+    // Method: run
+    // The writer thread: encodes and writes queued bands until finish() is called.
+    //
+    void run();
+
+    //
+    // Method: encodeRows
+    // Encodes rows [y0, y1) into `bytes` in the file's pixel format.
+    //
+    void encodeRows(int y0, int y1, std::vector<unsigned char>& bytes) const;
+
+    //
+    // Method: rowOffset
+    // Returns the file offset of row y (PFM stores rows bottom to top).
+    //
+    std::streamoff rowOffset(int y) const;
+
+    const Framebuffer& framebuffer;     // The image being written.
+    ImageFormat format;                 // The file format.
+    std::ofstream file;                 // The output file.
+    std::streamoff headerSize;          // Size of the file header in bytes.
+    std::size_t rowSize;                // Size of one encoded row in bytes.
+    long rowsWritten;                   // Number of rows written so far (writer thread only).
+
+    std::mutex mutex;                               // Guards `bands` and `finishing`.
+    std::condition_variable wake;                   // Signals new bands or finish().
+    std::deque<std::pair<int, int>> bands;          // Submitted row ranges not yet written.
+    bool finishing;                                 // Set by finish(): write the rest and stop.
+    bool finished;                                  // finish() has completed.
+    bool ok;                                        // No I/O error so far.
+    std::thread writer;                             // The writer thread.
+};
+
+#endif // IMAGEWRITER_H
@@ -0,0 +1,316 @@
+#include "IrradianceCache.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "RayTracer.h"
+
+namespace {
+
+const int THETA_STRATA = 8;    // Strata of the hemisphere in cos^2 of the polar angle.
+const int PHI_STRATA = 16;     // Strata of the hemisphere in azimuth.
+const int64_t MAX_CELL = (1 << 20) - 1;   // Cell coordinates are clamped to 21 signed bits.
+
+//
+// Function: addScaled
+// Adds a direction scaled by each channel of a color to the three per-channel gradients.
+//
+void addScaled(Vector3D gradient[3], const Vector3D& direction, const Color& color) {
+    gradient[0] = direction.multiplyAdd(color.r, gradient[0]);
+    gradient[1] = direction.multiplyAdd(color.g, gradient[1]);
+    gradient[2] = direction.multiplyAdd(color.b, gradient[2]);
+}
+
+//
+// Function: difference
+// Returns: a - b, channel by channel.
+//
+Color difference(const Color& a, const Color& b) {
+    return Color(a.r - b.r, a.g - b.g, a.b - b.b);
+}
+
+//
+// Function: luminance
+// Returns: The Rec. 709 luminance of a color.
+//
+Real luminance(const Color& color) {
+    return 0.2126 * color.r + 0.7152 * color.g + 0.0722 * color.b;
+}
+
+} // namespace
+
+//
+// Constructor: IrradianceCache
+// Creates an empty cache.
+// Parameters:
+//   - accuracy: Ward's a; smaller values create more records (typically 0.1 to 0.4).
+//   - minRadius: The smallest radius of validity, in scene units.
+//   - maxRadius: The largest radius of validity, in scene units.
+//
+IrradianceCache::IrradianceCache(Real accuracy, Real minRadius, Real maxRadius)
+    : accuracy(accuracy), minRadius(minRadius), maxRadius(maxRadius), levelMask(0), shards(new Shard[SHARD_COUNT]),
+      count(0) {
+    cellSize[LEVEL_COUNT - 1] = accuracy * maxRadius;
+    for (int level = LEVEL_COUNT - 2; level >= 0; level--) cellSize[level] = cellSize[level + 1] / LEVEL_SCALE;
+}
+
+//
+// Destructor: ~IrradianceCache
+// Frees the records.
+//
+IrradianceCache::~IrradianceCache() {}
+
+//
+// Method: lookup
+// Interpolates the indirect light at a point from the records around it, computing and
+// storing a new record if none covers the point.
+// Parameters:
+//   - scene: The scene; its lighting must not change while the cache is in use.
+//   - point: The shading point.
+//   - normal: The surface normal at the point.
+//   - t_max: Maximum intersection distance of the record's rays.
+//   - depth: The remaining recursion depth at the point; at least 2.
+// Returns: The expected color of the indirect ray, before its weight.
+//
+Color IrradianceCache::lookup(const Scene& scene, const Vector3D& point, const Vector3D& normal, Real t_max,
+                              int depth) {
+    Color result;
+    if (interpolate(point, normal, depth, result)) {
+        STATS_ADD(indirectCacheHits, 1);
+        return result;
+    }
+    Record record = compute(scene, point, normal, t_max, depth);
+    insert(record);
+    STATS_ADD(indirectCacheRecords, 1);
+    return record.value;
+}
+
+//
+// Method: clear
+// Removes all records. Must not run concurrently with lookups.
+//
+void IrradianceCache::clear() {
+    for (int i = 0; i < SHARD_COUNT; i++) shards[i].cells.clear();
+    for (std::unique_ptr<Record[]>& chunk : chunks) chunk.reset();
+    levelMask = 0;
+    count = 0;
+}
+
+//
+// Method: recordCount
+// Returns: The number of records computed so far.
+//
+size_t IrradianceCache::recordCount() const {
+    return count.load();
+}
+
+//
+// Method: interpolate
+// Blends the records listed in the cells of a point on every level: each record of the same depth whose
+// error estimate at the point is below the accuracy contributes its value, extrapolated
+// with its gradients, with a weight falling linearly to zero at the accuracy (Tabellion
+// and Lamorlette, 2004), so records fade in and out without seams.
+// Parameters:
+//   - point: The shading point.
+//   - normal: The surface normal at the point.
+//   - depth: The remaining recursion depth at the point.
+//   - result: The interpolated color (output, only written on success).
+// Returns: true if any record covers the point, false otherwise.
+//
+bool IrradianceCache::interpolate(const Vector3D& point, const Vector3D& normal, int depth, Color& result) {
+    Real totalWeight = 0;
+    Real r = 0, g = 0, b = 0;
+    uint32_t levels = levelMask.load(std::memory_order_relaxed);
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        if (!(levels & (1u << level))) continue;
+        uint64_t key = cellKey(static_cast<int64_t>(std::floor(point.x / cellSize[level])),
+                               static_cast<int64_t>(std::floor(point.y / cellSize[level])),
+                               static_cast<int64_t>(std::floor(point.z / cellSize[level])), level);
+        Shard& shard = shards[key % SHARD_COUNT];
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto cell = shard.cells.find(key);
+        if (cell == shard.cells.end()) continue;
+
+        for (uint32_t index : cell->second) {
+            const Record& record = chunks[index / CHUNK_SIZE][index % CHUNK_SIZE];
+            if (record.depth != depth) continue;
+            Vector3D offset = point - record.point;
+            Real alignment = normal.dot(record.normal);
+            Real error = offset.length() / record.radius + std::sqrt(std::max(static_cast<Real>(0), 1 - alignment));
+            if (error >= accuracy) continue;
+            // Skip records in front of the point: they may see light that is hidden from it
+            if (offset.dot(normal + record.normal) * 0.5 < -0.05 * record.radius) continue;
+
+            Real weight = 1 - error / accuracy;
+            Vector3D turn = record.normal.cross(normal);
+            r += weight * (record.value.r + record.translation[0].dot(offset) + record.rotation[0].dot(turn));
+            g += weight * (record.value.g + record.translation[1].dot(offset) + record.rotation[1].dot(turn));
+            b += weight * (record.value.b + record.translation[2].dot(offset) + record.rotation[2].dot(turn));
+            totalWeight += weight;
+        }
+    }
+    if (totalWeight <= 0) return false;
+
+    // The extrapolation of a steep gradient can undershoot
+    Real scale = 1 / totalWeight;
+    result = Color(std::max(static_cast<Real>(0), r * scale), std::max(static_cast<Real>(0), g * scale),
+                   std::max(static_cast<Real>(0), b * scale));
+    return true;
+}
+
+//
+// Method: compute
+// Traces a stratified, cosine-distributed hemisphere of rays from a point, shading each hit
+// like an indirect ray of shadeSurface, and derives the record's value, gradients (Ward and
+// Heckbert, 1992, divided by pi since the value is a mean color, not an irradiance) and
+// radius of validity. The rays draw from the thread's random stream even with a pixel
+// sampler, so the sample that happens to create a record keeps its own dimensions.
+// Parameters:
+//   - scene: The scene.
+//   - point: The record point.
+//   - normal: The surface normal at the point.
+//   - t_max: Maximum intersection distance of the rays.
+//   - depth: The remaining recursion depth at the point.
+// Returns: The record.
+//
+IrradianceCache::Record IrradianceCache::compute(const Scene& scene, const Vector3D& point, const Vector3D& normal,
+                                                 Real t_max, int depth) const {
+    const Real infinity = std::numeric_limits<Real>::infinity();
+    Vector3D helper = (std::fabs(normal.x) > 0.1) ? Vector3D(0, 1, 0) : Vector3D(1, 0, 0);
+    Vector3D tangent = helper.cross(normal).normalize();
+    Vector3D bitangent = normal.cross(tangent);
+    Vector3D origin = normal.multiplyAdd(scene.rayOffset(), point);
+
+    Sampler pixelSampler = threadSampler;
+    threadSampler = Sampler();
+    Color radiance[THETA_STRATA][PHI_STRATA];
+    Real distance[THETA_STRATA][PHI_STRATA];
+    Real inverseDistanceSum = 0;
+    Color sum(0, 0, 0);
+    for (int j = 0; j < THETA_STRATA; j++) {
+        for (int k = 0; k < PHI_STRATA; k++) {
+            Real u = (j + randDouble()) / THETA_STRATA;
+            Real phi = 2.0 * M_PI * (k + randDouble()) / PHI_STRATA;
+            Real sinTheta = std::sqrt(u);
+            Vector3D direction = tangent * (sinTheta * std::cos(phi)) + bitangent * (sinTheta * std::sin(phi)) +
+                                 normal * std::sqrt(1 - u);
+            Ray ray(origin, direction);
+            Hit hit;
+            STATS_RAYS(RayType::INDIRECT, 1);
+            if (scene.intersect(ray, 0.001, t_max, hit)) {
+                STATS_HITS(RayType::INDIRECT, 1);
+                radiance[j][k] = shadeHit(scene, ray, hit, t_max, depth - 1, INDIRECT_WEIGHT);
+                distance[j][k] = hit.t;
+                inverseDistanceSum += 1 / hit.t;
+            } else {
+                radiance[j][k] = scene.backgroundColor;
+                distance[j][k] = infinity;
+            }
+            sum = sum + radiance[j][k];
+        }
+    }
+    threadSampler = pixelSampler;
+
+    Record record;
+    record.point = point;
+    record.normal = normal;
+    record.value = sum * (1.0 / (THETA_STRATA * PHI_STRATA));
+    record.depth = depth;
+    for (int c = 0; c < 3; c++) record.translation[c] = record.rotation[c] = Vector3D(0, 0, 0);
+
+    for (int k = 0; k < PHI_STRATA; k++) {
+        // The azimuth at the middle of stratum k, and at its boundary with stratum k - 1
+        Real phi = 2.0 * M_PI * (k + 0.5) / PHI_STRATA;
+        Real phiBoundary = 2.0 * M_PI * k / PHI_STRATA;
+        Vector3D across = tangent * std::cos(phi) + bitangent * std::sin(phi);
+        Vector3D turn = tangent * -std::sin(phi) + bitangent * std::cos(phi);
+        Vector3D boundaryTurn = tangent * -std::sin(phiBoundary) + bitangent * std::cos(phiBoundary);
+        int previous = (k + PHI_STRATA - 1) % PHI_STRATA;
+
+        Color rotation(0, 0, 0), radial(0, 0, 0), azimuthal(0, 0, 0);
+        for (int j = 0; j < THETA_STRATA; j++) {
+            Real u = (j + 0.5) / THETA_STRATA;
+            rotation = rotation + radiance[j][k] * -std::sqrt(u / (1 - u));   // -tan(theta) L
+
+            // Change across the boundary with the stratum below (polar) and beside (azimuthal)
+            Real sinLow = std::sqrt(static_cast<Real>(j) / THETA_STRATA);
+            Real sinHigh = std::sqrt(static_cast<Real>(j + 1) / THETA_STRATA);
+            if (j > 0) {
+                Real closest = std::min(distance[j][k], distance[j - 1][k]);
+                Real cosSquared = 1 - static_cast<Real>(j) / THETA_STRATA;
+                radial = radial + difference(radiance[j][k], radiance[j - 1][k]) * (sinLow * cosSquared / closest);
+            }
+            Real closest = std::min(distance[j][k], distance[j][previous]);
+            azimuthal = azimuthal + difference(radiance[j][k], radiance[j][previous]) * ((sinHigh - sinLow) / closest);
+        }
+        addScaled(record.rotation, turn, rotation * (1.0 / (THETA_STRATA * PHI_STRATA)));
+        addScaled(record.translation, across, radial * (2.0 / PHI_STRATA));
+        addScaled(record.translation, boundaryTurn, azimuthal * (1.0 / M_PI));
+    }
+
+    // The harmonic mean distance, limited where the gradient predicts the light to change
+    // by more than its own value within the radius
+    Real radius = inverseDistanceSum > 0 ? THETA_STRATA * PHI_STRATA / inverseDistanceSum : infinity;
+    Vector3D luminanceGradient = record.translation[0] * 0.2126 + record.translation[1] * 0.7152 +
+                                 record.translation[2] * 0.0722;
+    Real gradientLength = luminanceGradient.length();
+    if (gradientLength > 0) radius = std::min(radius, luminance(record.value) / gradientLength);
+    record.radius = std::min(maxRadius, std::max(minRadius, radius));
+    return record;
+}
+
+//
+// Method: insert
+// Stores a record and lists it in every cell of the finest level with cells at least as
+// large as its reach (accuracy * radius) that its sphere of validity overlaps, at most 8.
+// When the store is full the record is dropped, and the caller still uses its value.
+// Parameters:
+//   - record: The record.
+//
+void IrradianceCache::insert(const Record& record) {
+    uint32_t index;
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        index = count.load();
+        if (index >= CHUNK_SIZE * MAX_CHUNKS) return;
+        std::unique_ptr<Record[]>& chunk = chunks[index / CHUNK_SIZE];
+        if (!chunk) chunk.reset(new Record[CHUNK_SIZE]);
+        chunk[index % CHUNK_SIZE] = record;
+        count = index + 1;
+    }
+
+    Real reach = accuracy * record.radius;
+    int level = 0;
+    while (level < LEVEL_COUNT - 1 && cellSize[level] < reach) level++;
+    Real size = cellSize[level];
+    Vector3D low = record.point - Vector3D(reach, reach, reach);
+    Vector3D high = record.point + Vector3D(reach, reach, reach);
+    for (int64_t x = std::floor(low.x / size); x <= std::floor(high.x / size); x++) {
+        for (int64_t y = std::floor(low.y / size); y <= std::floor(high.y / size); y++) {
+            for (int64_t z = std::floor(low.z / size); z <= std::floor(high.z / size); z++) {
+                uint64_t key = cellKey(x, y, z, level);
+                Shard& shard = shards[key % SHARD_COUNT];
+                std::unique_lock<std::shared_mutex> lock(shard.mutex);
+                shard.cells[key].push_back(index);
+            }
+        }
+    }
+    levelMask.fetch_or(1u << level);
+}
+
+//
+// Method: cellKey
+// Packs clamped cell coordinates into a key, adds the level and mixes the bits (splitmix64
+// finalizer), so that neighbouring cells land in different shards. Clamping can merge
+// far-away cells, which only costs lookups some records that fail the error test.
+// Returns: The key of the grid cell with integer coordinates (x, y, z) on a level.
+//
+uint64_t IrradianceCache::cellKey(int64_t x, int64_t y, int64_t z, int level) {
+    const uint64_t mask = (uint64_t(1) << 21) - 1;
+    uint64_t key = (static_cast<uint64_t>(std::min(MAX_CELL, std::max(-MAX_CELL, x))) & mask) |
+                   (static_cast<uint64_t>(std::min(MAX_CELL, std::max(-MAX_CELL, y))) & mask) << 21 |
+                   (static_cast<uint64_t>(std::min(MAX_CELL, std::max(-MAX_CELL, z))) & mask) << 42;
+    key += static_cast<uint64_t>(level) * 0x9E3779B97F4A7C15ULL;
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+    return key ^ (key >> 31);
+}
@@ -0,0 +1,165 @@
+#ifndef IRRADIANCECACHE_H
+#define IRRADIANCECACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include "Color.h"
+#include "Vector3D.h"
+
+class Scene;
+
+//
+// Class: IrradianceCache
+// A Ward-style irradiance cache for the indirect diffuse bounce (Ward, Rubinstein and
+// Clear, "A Ray Tracing Solution for Diffuse Interreflection", 1988; Ward and Heckbert,
+// "Irradiance Gradients", 1992). Without it, shadeSurface traces one cosine-distributed
+// indirect ray per hit and fully shades whatever it hits. Indirect light changes slowly
+// across diffuse surfaces, so the cache instead computes it at a few record points, from
+// a stratified hemisphere of rays, and interpolates it at the shading points around them.
+//
+// Records are created lazily: a lookup that no record covers computes one at its own
+// point. Each record stores the mean color of the hemisphere, its translational and
+// rotational gradients, and a radius of validity: the harmonic mean distance of the
+// surfaces its rays hit, shortened where the translational gradient predicts that the
+// light changes by more than its own value, and clamped to [minRadius, maxRadius]. A
+// record is used at points whose error estimate |p - p_i| / R_i + sqrt(1 - n . n_i) is
+// below the accuracy, weighted by how far below, and extrapolated to the point with its
+// gradients. Records in front of the point are skipped, so light does not leak around
+// corners. The value of a shading point depends on its remaining recursion depth (deeper
+// points see more bounces), so records only serve lookups of the same depth.
+//
+// The cache is shared by all render threads. Records are appended to a chunked store that
+// never moves them, and are indexed by hash grids whose cells each list the records
+// reaching into them. Radii range from a fraction of an object near contacts to hundreds
+// of units on open ground, so there are three grid levels, each with 16 times larger cells
+// than the one below, and a record is listed on the finest level whose cells are at least
+// as large as its reach. The cells are split into shards, each behind a reader-writer
+// lock, so lookups only contend with the rare insertions into the same shard. Two threads may
+// compute nearby records at the same time; both are kept. Since the records depend on
+// which points were looked up first, an image rendered with the cache on more than one
+// thread is not bit-identical between runs.
+//
+class IrradianceCache {
+public:
+    Real accuracy;    // Ward's a: the largest accepted error estimate of a record.
+    Real minRadius;   // Smallest radius of validity, which bounds the record density in corners.
+    Real maxRadius;   // Largest radius of validity, for records that see mostly open sky.
+
+    //
+    // Constructor: IrradianceCache
+    // Creates an empty cache.
+    // Parameters:
+    //   - accuracy: Ward's a; smaller values create more records (typically 0.1 to 0.4).
+    //   - minRadius: The smallest radius of validity, in scene units.
+    //   - maxRadius: The largest radius of validity, in scene units.
+    //
+    explicit IrradianceCache(Real accuracy, Real minRadius = 0.05, Real maxRadius = 1024.0);
+
+    //
+    // Destructor: ~IrradianceCache
+    // Frees the records.
+    //
+    ~IrradianceCache();
+
+    IrradianceCache(const IrradianceCache&) = delete;
+    IrradianceCache& operator=(const IrradianceCache&) = delete;
+
+    //
+    // Method: lookup
+    // Returns the mean color seen by a cosine-distributed indirect ray from a shading point,
+    // interpolated from the records around it, or from a new record if none is close enough.
+    // Safe to call from several threads at once.
+    // Parameters:
+    //   - scene: The scene; its lighting must not change while the cache is in use.
+    //   - point: The shading point.
+    //   - normal: The surface normal at the point.
+    //   - t_max: Maximum intersection distance of the record's rays.
+    //   - depth: The remaining recursion depth at the point; at least 2.
+    // Returns: The expected color of the indirect ray, before its weight.
+    //
+    Color lookup(const Scene& scene, const Vector3D& point, const Vector3D& normal, Real t_max, int depth);
+
+    //
+    // Method: clear
+    // Removes all records, e.g. after the lights or materials changed. Must not run
+    // concurrently with lookups.
+    //
+    void clear();
+
+    //
+    // Method: recordCount
+    // Returns: The number of records computed so far.
+    //
+    size_t recordCount() const;
+
+private:
+    //
+    // Struct: Record
+    // The indirect light computed at one point.
+    //
+    struct Record {
+        Vector3D point;                 // Where the hemisphere was sampled.
+        Vector3D normal;                // The surface normal there.
+        Color value;                    // Mean color of the hemisphere's rays.
+        Vector3D translation[3];        // Gradient of each color channel along the surface.
+        Vector3D rotation[3];           // Gradient of each color channel under rotation of the normal.
+        Real radius;                    // Radius of validity.
+        int depth;                      // Remaining recursion depth of the point.
+    };
+
+    //
+    // Struct: Shard
+    // A part of the hash grid: the record indices of each cell, by cell key.
+    //
+    struct Shard {
+        std::shared_mutex mutex;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    };
+
+    static const int SHARD_COUNT = 64;
+    static const int LEVEL_COUNT = 3;          // Grid levels.
+    static const int LEVEL_SCALE = 16;         // Ratio of the cell sizes of consecutive levels.
+    static const uint32_t CHUNK_SIZE = 4096;   // Records per chunk of the store.
+    static const uint32_t MAX_CHUNKS = 1024;   // Chunks of the store; later records are not kept.
+
+    //
+    // Method: interpolate
+    // Blends the records listed in the cells of a point.
+    // Returns: true and the color if any record covers the point, false otherwise.
+    //
+    bool interpolate(const Vector3D& point, const Vector3D& normal, int depth, Color& result);
+
+    //
+    // Method: compute
+    // Samples the hemisphere at a point and fills a record.
+    //
+    Record compute(const Scene& scene, const Vector3D& point, const Vector3D& normal, Real t_max, int depth) const;
+
+    //
+    // Method: insert
+    // Stores a record and lists it in every cell its area of validity reaches.
+    //
+    void insert(const Record& record);
+
+    //
+    // Method: cellKey
+    // Returns: The key of the grid cell with integer coordinates (x, y, z) on a level.
+    //
+    static uint64_t cellKey(int64_t x, int64_t y, int64_t z, int level);
+
+    Real cellSize[LEVEL_COUNT];                       // Edge of a grid cell on each level; the
+                                                      // coarsest is accuracy * maxRadius.
+    std::atomic<uint32_t> levelMask;                  // Bit l is set once level l lists a record.
+    std::unique_ptr<Shard[]> shards;                  // SHARD_COUNT shards of the grid.
+    std::mutex storeMutex;                            // Serializes appends to the store.
+    std::unique_ptr<Record[]> chunks[MAX_CHUNKS];     // The record store.
+    std::atomic<uint32_t> count;                      // Records in the store.
+};
+
+#endif // IRRADIANCECACHE_H
@@ -0,0 +1,354 @@
+#include "IrradianceGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include "RayTracer.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+const Real CELL_FRACTION = 0.1;            // Cell edge as a fraction of the smallest SSS radius
+const int64_t COORDINATE_LIMIT = 1 << 20;  // Grid coordinates must lie in (-limit, limit)
+const int VERTICES_PER_TASK = 64;          // Vertices sampled per parallel task (one seed each)
+const uint64_t GRID_SEED = 0x9e3779b97f4a7c15ull;  // Seed of the visibility samples
+const uint64_t EMPTY_SLOT = ~0ull;         // Key of an unused hash table slot (no vertex key has bit 63)
+
+//
+// Struct: GridVertex
+// A grid vertex waiting to be sampled.
+//
+struct GridVertex {
+    int64_t x, y, z;   // Integer grid coordinates.
+    int plane;         // SSS triangle whose plane the vertex samples on, or -1.
+};
+
+//
+// Function: vertexKey
+// Packs integer grid coordinates (each in (-COORDINATE_LIMIT, COORDINATE_LIMIT)) into a hash key.
+//
+uint64_t vertexKey(int64_t x, int64_t y, int64_t z) {
+    return (static_cast<uint64_t>(x + COORDINATE_LIMIT) << 42) |
+           (static_cast<uint64_t>(y + COORDINATE_LIMIT) << 21) |
+           static_cast<uint64_t>(z + COORDINATE_LIMIT);
+}
+
+//
+// Function: slotOf
+// Returns: The home slot of a key in a table of mask + 1 slots (murmur3 finalizer).
+//
+uint64_t slotOf(uint64_t key, uint64_t mask) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return key & mask;
+}
+
+//
+// Function: hasSubsurface
+// Returns: true if the material parameters enable the SSS integration of shadeHit.
+//
+bool hasSubsurface(Real radius, Real scattering) {
+    return radius > 0.0 && scattering > 0.0;
+}
+
+//
+// Function: addRegion
+// Adds every vertex of the box [low, high] that passes the filter and lies outside all
+// spheres overlapping the box; vertices already in the grid keep their first entry.
+//
+template <typename Filter>
+void addRegion(const Scene& scene, Real cellSize, const Vector3D& low, const Vector3D& high,
+               int plane, Filter filter, std::unordered_map<uint64_t, uint32_t>& indexOf,
+               std::vector<GridVertex>& pending) {
+    std::vector<const Sphere*> solids;
+    for (const Sphere& sphere : scene.spheres) {
+        bool overlaps = sphere.center.x + sphere.radius >= low.x && sphere.center.x - sphere.radius <= high.x &&
+                        sphere.center.y + sphere.radius >= low.y && sphere.center.y - sphere.radius <= high.y &&
+                        sphere.center.z + sphere.radius >= low.z && sphere.center.z - sphere.radius <= high.z;
+        if (overlaps) solids.push_back(&sphere);
+    }
+
+    int64_t x0 = static_cast<int64_t>(std::ceil(low.x / cellSize)), x1 = static_cast<int64_t>(std::floor(high.x / cellSize));
+    int64_t y0 = static_cast<int64_t>(std::ceil(low.y / cellSize)), y1 = static_cast<int64_t>(std::floor(high.y / cellSize));
+    int64_t z0 = static_cast<int64_t>(std::ceil(low.z / cellSize)), z1 = static_cast<int64_t>(std::floor(high.z / cellSize));
+    if (std::min({x0, y0, z0}) <= -COORDINATE_LIMIT || std::max({x1, y1, z1}) >= COORDINATE_LIMIT) return;
+
+    for (int64_t x = x0; x <= x1; x++) {
+        for (int64_t y = y0; y <= y1; y++) {
+            for (int64_t z = z0; z <= z1; z++) {
+                Vector3D position(x * cellSize, y * cellSize, z * cellSize);
+                if (!filter(position)) continue;
+                bool inside = std::any_of(solids.begin(), solids.end(), [&](const Sphere* sphere) {
+                    return (position - sphere->center).lengthSquared() < sphere->radius * sphere->radius;
+                });
+                if (inside) continue;
+
+                uint64_t key = vertexKey(x, y, z);
+                if (indexOf.emplace(key, static_cast<uint32_t>(pending.size())).second) {
+                    pending.push_back(GridVertex{x, y, z, plane});
+                }
+            }
+        }
+    }
+}
+
+//
+// Function: sampleVisibility
+// Estimates the unoccluded fraction of a light from a point with the same shadow rays,
+// sample budget and early exit as computeLighting. On a triangle's plane the ray starts
+// just off the plane on the light's side, as it does for a shading point on the triangle.
+//
+Real sampleVisibility(const Scene& scene, const Light& light, const Vector3D& point,
+                      const Vector3D* planeNormal, PrimitiveRef& lastOccluder) {
+    const int convergenceBatch = 8;   // Matches computeLighting
+    int numSamples = shadowSampleBudget(light, point);
+    int samplesTaken = 0;
+    int litSamples = 0;
+
+    for (int i = 0; i < numSamples; i++) {
+        if (i == convergenceBatch && (litSamples == 0 || litSamples == samplesTaken)) break;
+        samplesTaken++;
+
+        Vector3D lightDir = (sampleLightPoint(light) - point).normalize();
+        Vector3D origin = point;
+        if (planeNormal) {
+            Real offset = scene.rayOffset();
+            origin = planeNormal->multiplyAdd((lightDir.dot(*planeNormal) < 0) ? -offset : offset, point);
+        }
+        if (!scene.occluded(Ray(origin, lightDir), shadowRayLength(light), lastOccluder)) litSamples++;
+    }
+    return static_cast<Real>(litSamples) / samplesTaken;
+}
+
+} // namespace
+
+//
+// Constructor: IrradianceGrid
+// Creates an empty grid; lighting() falls back to tracing until build() is called.
+//
+IrradianceGrid::IrradianceGrid() : cellSize(0.0), lightCount(0) {}
+
+//
+// Method: build
+// Samples the visibility of every light at all grid vertices near translucent objects,
+// in parallel. The scene's BVH and packed geometry must already be built. The result
+// does not depend on the thread count.
+// Parameters:
+//   - scene: The scene.
+//
+void IrradianceGrid::build(const Scene& scene) {
+    slotKeys.clear();
+    slotVertices.clear();
+    visibility.clear();
+    lightCount = scene.lights.size();
+
+    Real smallestRadius = std::numeric_limits<Real>::infinity();
+    for (const Sphere& sphere : scene.spheres) {
+        if (hasSubsurface(sphere.subsurfaceRadius, sphere.scatteringCoefficient)) {
+            smallestRadius = std::min(smallestRadius, sphere.subsurfaceRadius);
+        }
+    }
+    for (const Triangle& triangle : scene.triangles) {
+        if (hasSubsurface(triangle.subsurfaceRadius, triangle.scatteringCoefficient)) {
+            smallestRadius = std::min(smallestRadius, triangle.subsurfaceRadius);
+        }
+    }
+    if (std::isinf(smallestRadius) || lightCount == 0) return;
+    cellSize = CELL_FRACTION * smallestRadius;
+    Real margin = 2.0 * cellSize;     // Covers the 8 corners of any cell a probe falls into
+
+    // Probes of a triangle lie in its plane, within R of the triangle. Triangles go first so
+    // that vertices shared with a sphere region sample on the plane, as the triangle needs.
+    std::vector<GridVertex> pending;
+    std::unordered_map<uint64_t, uint32_t> indexOf;
+    std::vector<Vector3D> planeNormals(scene.triangles.size());
+    for (size_t i = 0; i < scene.triangles.size(); i++) {
+        const Triangle& triangle = scene.triangles[i];
+        if (!hasSubsurface(triangle.subsurfaceRadius, triangle.scatteringCoefficient)) continue;
+        Vector3D normal = (triangle.B - triangle.A).cross(triangle.C - triangle.A).normalize();
+        planeNormals[i] = normal;
+        Real reach = triangle.subsurfaceRadius + margin;
+        Vector3D low(std::min({triangle.A.x, triangle.B.x, triangle.C.x}) - reach,
+                     std::min({triangle.A.y, triangle.B.y, triangle.C.y}) - reach,
+                     std::min({triangle.A.z, triangle.B.z, triangle.C.z}) - reach);
+        Vector3D high(std::max({triangle.A.x, triangle.B.x, triangle.C.x}) + reach,
+                      std::max({triangle.A.y, triangle.B.y, triangle.C.y}) + reach,
+                      std::max({triangle.A.z, triangle.B.z, triangle.C.z}) + reach);
+        addRegion(scene, cellSize, low, high, static_cast<int>(i),
+                  [&](const Vector3D& p) { return std::fabs((p - triangle.A).dot(normal)) <= margin; },
+                  indexOf, pending);
+    }
+
+    // Probes of a sphere lie on tangent disks: between r and sqrt(r^2 + R^2) from its center
+    for (const Sphere& sphere : scene.spheres) {
+        if (!hasSubsurface(sphere.subsurfaceRadius, sphere.scatteringCoefficient)) continue;
+        Real outer = std::sqrt(sphere.radius * sphere.radius + sphere.subsurfaceRadius * sphere.subsurfaceRadius) + margin;
+        Vector3D extent(outer, outer, outer);
+        addRegion(scene, cellSize, sphere.center - extent, sphere.center + extent, -1,
+                  [&](const Vector3D& p) { return (p - sphere.center).lengthSquared() <= outer * outer; },
+                  indexOf, pending);
+    }
+
+    // Lay the vertices out in an open-addressing table that lookups can probe in place
+    size_t slots = 1;
+    while (slots < 2 * pending.size()) slots *= 2;
+    slotKeys.resize(slots, EMPTY_SLOT);
+    slotVertices.resize(slots, 0);
+    for (size_t v = 0; v < pending.size(); v++) {
+        uint64_t key = vertexKey(pending[v].x, pending[v].y, pending[v].z);
+        uint64_t slot = slotOf(key, slots - 1);
+        while (slotKeys[slot] != EMPTY_SLOT) slot = (slot + 1) & (slots - 1);
+        slotKeys[slot] = key;
+        slotVertices[slot] = static_cast<uint32_t>(v);
+    }
+
+    // Sample in fixed chunks, each with its own seed, so any thread count gives the same grid
+    visibility.resize(pending.size() * lightCount);
+    float* visible = visibility.data();
+    int taskCount = static_cast<int>((pending.size() + VERTICES_PER_TASK - 1) / VERTICES_PER_TASK);
+    WorkStealingPool pool(0);
+    pool.parallelFor(taskCount, [&](int task) {
+        seedRandom(tileSeed(GRID_SEED, static_cast<uint64_t>(task)));
+        std::vector<PrimitiveRef> lastOccluders(lightCount, PrimitiveRef{PrimitiveType::SPHERE, -1});
+        size_t end = std::min(pending.size(), static_cast<size_t>(task + 1) * VERTICES_PER_TASK);
+
+        for (size_t v = static_cast<size_t>(task) * VERTICES_PER_TASK; v < end; v++) {
+            const GridVertex& vertex = pending[v];
+            Vector3D point(vertex.x * cellSize, vertex.y * cellSize, vertex.z * cellSize);
+            const Vector3D* planeNormal = nullptr;
+            if (vertex.plane >= 0) {
+                // Sample on the plane itself, where the triangle's probes are
+                planeNormal = &planeNormals[vertex.plane];
+                point = point - *planeNormal * (point - scene.triangles[vertex.plane].A).dot(*planeNormal);
+            }
+            for (size_t l = 0; l < lightCount; l++) {
+                const Light& light = scene.lights[l];
+                Real fraction = (light.type == LightType::AMBIENT)
+                    ? 1.0 : sampleVisibility(scene, light, point, planeNormal, lastOccluders[l]);
+                visible[v * lightCount + l] = static_cast<float>(fraction);
+            }
+        }
+    });
+}
+
+//
+// Method: lighting
+// Computes the lighting at a point like computeLighting, with shadow visibility
+// interpolated from the grid instead of traced.
+// Parameters:
+//   - scene: The scene the grid was built for.
+//   - point: The 3D point being shaded.
+//   - normal: The normal vector at the point.
+//   - view: The view direction vector.
+//   - specular: The specular reflection coefficient.
+//   - result: The lighting color (output).
+// Returns:
+//   - true on success, false if the point lies outside the grid (use computeLighting).
+//
+bool IrradianceGrid::lighting(const Scene& scene, const Vector3D& point, const Vector3D& normal,
+                              const Vector3D& view, Real specular, Color& result) const {
+    if (slotKeys.empty()) return false;
+
+    Real gx = point.x / cellSize, gy = point.y / cellSize, gz = point.z / cellSize;
+    Real fx = std::floor(gx), fy = std::floor(gy), fz = std::floor(gz);
+    if (std::fabs(fx) >= COORDINATE_LIMIT - 1 || std::fabs(fy) >= COORDINATE_LIMIT - 1 ||
+        std::fabs(fz) >= COORDINATE_LIMIT - 1) return false;
+    int64_t x = static_cast<int64_t>(fx), y = static_cast<int64_t>(fy), z = static_cast<int64_t>(fz);
+    Real tx = gx - fx, ty = gy - fy, tz = gz - fz;
+
+    // Trilinear blend of the corners that exist, renormalized over their weights
+    const float* cornerSamples[8];
+    Real cornerWeights[8];
+    int cornerCount = 0;
+    Real totalWeight = 0.0;
+    for (int corner = 0; corner < 8; corner++) {
+        int dx = corner & 1, dy = (corner >> 1) & 1, dz = (corner >> 2) & 1;
+        long vertex = findVertex(vertexKey(x + dx, y + dy, z + dz));
+        if (vertex < 0) continue;
+
+        Real weight = (dx ? tx : 1 - tx) * (dy ? ty : 1 - ty) * (dz ? tz : 1 - tz);
+        cornerSamples[cornerCount] = &visibility[static_cast<size_t>(vertex) * lightCount];
+        cornerWeights[cornerCount++] = weight;
+        totalWeight += weight;
+    }
+    if (totalWeight <= 1e-6) return false;
+
+    // The lit fraction of one light, blended only for the lights that are evaluated
+    auto lightColor = [&](size_t l) {
+        Real visible = 0.0;
+        for (int c = 0; c < cornerCount; c++) visible += cornerWeights[c] * cornerSamples[c][l];
+        Real fraction = visible / totalWeight;
+        Color color(0, 0, 0);
+        if (fraction <= 0.0) return color;
+        const Light& light = scene.lights[l];
+        addLightSample(color, light, (light.position - point).normalize(), normal, view, specular);
+        return color * fraction;
+    };
+
+    // With light sampling, point lights are picked from the light tree as in computeLighting
+    bool sampleLights = scene.lightSamples > 0 && !scene.lightTree.empty();
+    result = Color(0, 0, 0);
+    for (size_t l = 0; l < lightCount; l++) {
+        const Light& light = scene.lights[l];
+        if (light.type == LightType::AMBIENT) {
+            result = result + Color(light.intensity, light.intensity, light.intensity);
+        } else if (!sampleLights || light.type != LightType::POINT) {
+            result = result + lightColor(l);
+        }
+    }
+    if (sampleLights) {
+        for (int i = 0; i < scene.lightSamples; i++) {
+            Real probability;
+            int l = scene.lightTree.sample(point, normal, view, specular, probability);
+            if (l < 0) break;
+            result = result + lightColor(l) * (1.0 / (scene.lightSamples * probability));
+        }
+    }
+    return true;
+}
+
+//
+// Method: vertexCount
+// Returns: The number of sampled grid vertices.
+//
+size_t IrradianceGrid::vertexCount() const {
+    return lightCount > 0 ? visibility.size() / lightCount : 0;
+}
+
+//
+// Method: isConsistent
+// Checks a grid mapped from a file before any lookup.
+//
+bool IrradianceGrid::isConsistent(size_t lights) const {
+    size_t slots = slotKeys.size();
+    if (slotVertices.size() != slots || (slots & (slots - 1)) != 0) return false;
+    if (slots == 0) return true;
+    if (!(cellSize > 0) || lightCount == 0 || lightCount > lights || visibility.size() % lightCount != 0) {
+        return false;
+    }
+    size_t vertices = vertexCount();
+    bool freeSlot = false;
+    for (size_t slot = 0; slot < slots; slot++) {
+        if (slotKeys[slot] == EMPTY_SLOT) {
+            freeSlot = true;
+        } else if (slotVertices[slot] >= vertices) {
+            return false;
+        }
+    }
+    return freeSlot;
+}
+
+//
+// Method: findVertex
+// Returns: The index of the vertex with the given key, or -1 if it is not in the grid.
+//
+long IrradianceGrid::findVertex(uint64_t key) const {
+    uint64_t mask = slotKeys.size() - 1;
+    for (uint64_t slot = slotOf(key, mask);; slot = (slot + 1) & mask) {
+        if (slotKeys[slot] == key) return static_cast<long>(slotVertices[slot]);
+        if (slotKeys[slot] == EMPTY_SLOT) return -1;
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef IRRADIANCEGRID_H
+#define IRRADIANCEGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include "MappedArray.h"
+#include "Color.h"
+#include "Vector3D.h"
+
+class Scene;
+
+//
+// Class: IrradianceGrid
+// Precomputed light visibility for subsurface scattering.
+// The SSS integration in shadeHit evaluates the lighting at 16 probe points on the
+// tangent disk (radius subsurfaceRadius) around each hit on a translucent object; with
+// full shadow sampling that costs thousands of shadow rays per hit. The grid samples,
+// once per scene, the unoccluded fraction of every light at the vertices of a sparse
+// hash grid covering exactly the region those disks can reach. A probe then interpolates
+// the visibility of the 8 surrounding vertices and only evaluates the cheap diffuse and
+// specular terms, which depend on the probe's normal and are not cached.
+// Vertices inside a sphere are left out, so probes next to a surface never blend in the
+// darkness of its interior, and vertices near a translucent triangle sample on its plane,
+// where that triangle's probes lie.
+//
+class IrradianceGrid {
+public:
+    //
+    // Constructor: IrradianceGrid
+    // Creates an empty grid; lighting() falls back to tracing until build() is called.
+    //
+    IrradianceGrid();
+
+    //
+    // Method: build
+    // Samples the visibility of every light at all grid vertices near translucent objects,
+    // in parallel. The scene's BVH and packed geometry must already be built. The result
+    // does not depend on the thread count.
+    // Parameters:
+    //   - scene: The scene.
+    //
+    void build(const Scene& scene);
+
+    //
+    // Method: lighting
+    // Computes the lighting at a point like computeLighting, with shadow visibility
+    // interpolated from the grid instead of traced.
+    // Parameters:
+    //   - scene: The scene the grid was built for.
+    //   - point: The 3D point being shaded.
+    //   - normal: The normal vector at the point.
+    //   - view: The view direction vector.
+    //   - specular: The specular reflection coefficient.
+    //   - result: The lighting color (output).
+    // Returns:
+    //   - true on success, false if the point lies outside the grid (use computeLighting).
+    //
+    bool lighting(const Scene& scene, const Vector3D& point, const Vector3D& normal,
+                  const Vector3D& view, Real specular, Color& result) const;
+
+    //
+    // Method: vertexCount
+    // Returns: The number of sampled grid vertices.
+    //
+    size_t vertexCount() const;
+
+    //
+    // Method: isConsistent
+    // Checks a grid mapped from a file: the hash table is a power of two in size, has a free
+    // slot to end every probe, and only refers to vertices that have visibility samples.
+    // Parameters:
+    //   - lights: The number of lights in the scene.
+    // Returns:
+    //   - true if lookups stay inside the grid's arrays.
+    //
+    bool isConsistent(size_t lights) const;
+
+private:
+    friend class SceneCache;   // Stores and maps the arrays below.
+
+    //
+    // Method: findVertex
+    // Returns: The index of the vertex with the given key, or -1 if it is not in the grid.
+    //
+    long findVertex(uint64_t key) const;
+
+    Real cellSize;                         // Edge length of a grid cell.
+    size_t lightCount;                     // Number of scene lights per vertex.
+    MappedArray<uint64_t> slotKeys;        // Open-addressing hash table of vertex keys (power-of-two
+    MappedArray<uint32_t> slotVertices;    // size, linear probing) and the vertex index of each slot.
+    MappedArray<float> visibility;         // lightCount unoccluded fractions per vertex.
+};
+
+#endif // IRRADIANCEGRID_H
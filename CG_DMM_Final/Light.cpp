@@ -6,7 +6,7 @@
 // Parameters:
 //   - intensity: The intensity of the light.
 //
-Light::Light(double intensity)
+Light::Light(Real intensity)
     : type(LightType::AMBIENT),          // Set the light type to AMBIENT.
       intensity(intensity),             // Set the light's intensity.
       position(Vector3D()),             // Ambient light has no position.
@@ -21,7 +21,7 @@ Light::Light(double intensity)
 //   - position: The position of the point light in 3D space.
 //   - radius: The radius of the light's influence.
 //
-Light::Light(double intensity, const Vector3D& position, double radius)
+Light::Light(Real intensity, const Vector3D& position, Real radius)
     : type(LightType::POINT),           // Set the light type to POINT.
       intensity(intensity),             // Set the light's intensity.
       position(position),               // Set the light's position.
@@ -35,7 +35,7 @@ Light::Light(double intensity, const Vector3D& position, double radius)
 //   - direction: The direction of the light (normalized automatically).
 //   - intensity: The intensity of the light.
 //
-Light::Light(const Vector3D& direction, double intensity)
+Light::Light(const Vector3D& direction, Real intensity)
     : type(LightType::DIRECTIONAL),     // Set the light type to DIRECTIONAL.
       intensity(intensity),             // Set the light's intensity.
       position(Vector3D()),             // Directional light has no position.
@@ -20,10 +20,10 @@ enum class LightType {
 class Light {
 public:
     LightType type;          // The type of the light (AMBIENT, POINT, or DIRECTIONAL).
-    double intensity;        // The intensity of the light.
+    Real intensity;          // The intensity of the light.
     Vector3D position;       // The position of the light (applicable for POINT lights).
     Vector3D direction;      // The direction of the light (applicable for DIRECTIONAL lights).
-    double radius;           // The radius of influence (applicable for POINT lights).
+    Real radius;             // The radius of influence (applicable for POINT lights).
 
     //
     // Constructor: Light (Ambient)
@@ -31,7 +31,7 @@ public:
     // Parameters:
     //   - intensity: The intensity of the ambient light.
     //
-    Light(double intensity);
+    Light(Real intensity);
 
     //
     // Constructor: Light (Point)
@@ -41,7 +41,7 @@ public:
     //   - position: The position of the point light in 3D space.
     //   - radius: (Optional) The radius of influence for the point light. Default is 0.0.
     //
-    Light(double intensity, const Vector3D& position, double radius = 0.0);
+    Light(Real intensity, const Vector3D& position, Real radius = 0.0);
 
     //
     // Constructor: Light (Directional)
@@ -50,7 +50,7 @@ public:
     //   - direction: The direction of the directional light.
     //   - intensity: The intensity of the directional light.
     //
-    Light(const Vector3D& direction, double intensity);
+    Light(const Vector3D& direction, Real intensity);
 
     //
     // Destructor: ~Light
@@ -0,0 +1,163 @@
+#include "LightTree.h"
+#include <algorithm>
+#include <cmath>
+#include "Random.h"
+
+namespace {
+
+const Real DIFFUSE_WEIGHT = 0.8;    // Matches addLightSample
+const Real SPECULAR_WEIGHT = 0.5;   // Matches addLightSample
+
+//
+// Function: axisValue
+// Returns the component of a vector along an axis (0 = x, 1 = y, 2 = z).
+//
+Real axisValue(const Vector3D& v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+//
+// Function: maxCosine
+// Returns: The largest cosine between an axis and any direction from the origin of
+// `toCenter` into a sphere of the given radius around its end, clamped to 0.
+//
+Real maxCosine(const Vector3D& axis, const Vector3D& toCenter, Real radius) {
+    Real distance = toCenter.length();
+    if (distance <= radius) return 1;
+    Real cosAxis = axis.dot(toCenter) / distance;
+    Real sinHalfAngle = radius / distance;
+    Real cosHalfAngle = std::sqrt(1 - sinHalfAngle * sinHalfAngle);
+    if (cosAxis >= cosHalfAngle) return 1;   // The axis points into the sphere
+    Real sinAxis = std::sqrt(std::max(Real(0), 1 - cosAxis * cosAxis));
+    return std::max(Real(0), cosAxis * cosHalfAngle + sinAxis * sinHalfAngle);
+}
+
+} // namespace
+
+//
+// Method: build
+// Builds the tree over the point lights, replacing any previous tree.
+// Parameters:
+//   - lights: The scene's lights.
+//
+void LightTree::build(const std::vector<Light>& lights) {
+    nodes.clear();
+    std::vector<BuildEntry> entries;
+    for (size_t i = 0; i < lights.size(); i++) {
+        const Light& light = lights[i];
+        if (light.type != LightType::POINT) continue;
+        Vector3D extent(light.radius, light.radius, light.radius);
+        AABB box(light.position - extent, light.position + extent);
+        entries.push_back({box, light.position, light.intensity, static_cast<int>(i)});
+    }
+    if (entries.empty()) return;
+
+    nodes.reserve(2 * entries.size());
+    buildNode(entries, 0, static_cast<int>(entries.size()));
+}
+
+//
+// Method: buildNode
+// Recursively builds the subtree over entries[begin, end), splitting at the median of
+// the widest centroid axis down to one light per leaf.
+// Parameters:
+//   - entries: The build entries; reordered in place.
+//   - begin, end: The range of entries belonging to this node.
+// Returns:
+//   - The index of the created node.
+//
+int LightTree::buildNode(std::vector<BuildEntry>& entries, int begin, int end) {
+    int nodeIndex = static_cast<int>(nodes.size());
+    nodes.push_back(LightTreeNode());
+
+    AABB bounds;
+    AABB centroidBounds;
+    Real intensity = 0;
+    for (int i = begin; i < end; i++) {
+        bounds.expand(entries[i].bounds);
+        centroidBounds.expand(entries[i].centroid);
+        intensity += entries[i].intensity;
+    }
+    nodes[nodeIndex].center = bounds.centroid();
+    nodes[nodeIndex].radius = (bounds.max - bounds.min).length() * 0.5;
+    nodes[nodeIndex].intensity = intensity;
+
+    if (end - begin == 1) {
+        nodes[nodeIndex].offset = entries[begin].light;
+        nodes[nodeIndex].count = 1;
+        return nodeIndex;
+    }
+
+    Vector3D extent = centroidBounds.max - centroidBounds.min;
+    int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+    int mid = begin + (end - begin) / 2;
+    std::nth_element(entries.begin() + begin, entries.begin() + mid, entries.begin() + end,
+        [axis](const BuildEntry& a, const BuildEntry& b) {
+            return axisValue(a.centroid, axis) < axisValue(b.centroid, axis);
+        });
+
+    buildNode(entries, begin, mid);
+    int right = buildNode(entries, mid, end);
+    nodes[nodeIndex].offset = right;
+    nodes[nodeIndex].count = 0;
+    return nodeIndex;
+}
+
+//
+// Method: sample
+// Picks one point light for a shading point, drawing one random number per level.
+// Parameters:
+//   - point: The shading point.
+//   - normal: The surface normal at the point.
+//   - view: The direction from the point towards the viewer.
+//   - specular: The specular exponent of the surface (negative for none).
+//   - probability: The probability of picking the returned light (output).
+// Returns: The index of the light in Scene::lights, or -1 if no point light can
+// contribute at the point.
+//
+int LightTree::sample(const Vector3D& point, const Vector3D& normal, const Vector3D& view, Real specular,
+                      Real& probability) const {
+    probability = 1;
+    if (nodes.empty()) return -1;
+
+    // The specular lobe of addLightSample is centered on the view reflected about the normal
+    Vector3D reflectedView = 2 * normal * normal.dot(view) - view;
+    if (importance(nodes[0], point, normal, reflectedView, specular) <= 0) return -1;
+
+    int node = 0;
+    while (nodes[node].count == 0) {
+        int left = node + 1;
+        int right = nodes[node].offset;
+        Real leftImportance = importance(nodes[left], point, normal, reflectedView, specular);
+        Real rightImportance = importance(nodes[right], point, normal, reflectedView, specular);
+        Real total = leftImportance + rightImportance;
+        // The bounds of both children can be tighter than their parent's; then neither can contribute
+        if (total <= 0) return -1;
+
+        Real leftProbability = leftImportance / total;
+        if (randDouble() < leftProbability) {
+            probability *= leftProbability;
+            node = left;
+        } else {
+            probability *= 1 - leftProbability;
+            node = right;
+        }
+    }
+    return nodes[node].offset;
+}
+
+//
+// Method: importance
+// Returns: An upper bound of the contribution of a node's lights at a shading point: their
+// summed intensity times the largest diffuse and specular terms of addLightSample for any
+// direction into the node's bounding sphere.
+//
+Real LightTree::importance(const LightTreeNode& node, const Vector3D& point, const Vector3D& normal,
+                           const Vector3D& reflectedView, Real specular) {
+    Vector3D toCenter = node.center - point;
+    Real bound = DIFFUSE_WEIGHT * maxCosine(normal, toCenter, node.radius);
+    if (specular >= 0) {
+        bound += SPECULAR_WEIGHT * std::pow(maxCosine(reflectedView, toCenter, node.radius), specular);
+    }
+    return node.intensity * bound;
+}
@@ -0,0 +1,92 @@
+#ifndef LIGHTTREE_H
+#define LIGHTTREE_H
+
+#include <vector>
+#include "AABB.h"
+#include "Light.h"
+
+//
+// Struct: LightTreeNode
+// One node of the flattened light tree. Nodes are stored depth-first like BVHNode: the
+// left child of an interior node directly follows it, and `offset` holds the index of
+// the right child. A leaf holds a single light, whose index in Scene::lights is `offset`.
+//
+struct LightTreeNode {
+    Vector3D center;   // Center of a sphere around every light below, area light disks included.
+    Real radius;       // Radius of that sphere.
+    Real intensity;    // Summed intensity of the lights below.
+    int offset;        // Right child (interior) or light index (leaf).
+    int count;         // 1 for a leaf, 0 for interior nodes.
+};
+
+//
+// Class: LightTree
+// A bounding volume hierarchy over the point lights of a scene, used to pick a few lights
+// per shading point instead of visiting all of them (see Scene::lightSamples). Sampling
+// walks from the root to one leaf, choosing each child with probability proportional to
+// an upper bound of its lights' contribution at the shading point, so a sample costs
+// O(log N) and bright, well-placed lights are picked more often.
+//
+// The bound follows addLightSample, which has no distance falloff: the summed intensity
+// times the largest diffuse and specular cosines any direction towards the node's
+// bounding sphere can reach. At a leaf the bound is close to the light's actual
+// contribution, and the probability of the path is exact, so dividing a light's
+// contribution by it gives an unbiased estimate of the sum over all point lights.
+//
+class LightTree {
+public:
+    std::vector<LightTreeNode> nodes;   // The flattened tree; nodes[0] is the root.
+
+    //
+    // Method: build
+    // Builds the tree over the point lights, replacing any previous tree.
+    // Ambient and directional lights are left out; they are always evaluated.
+    // Parameters:
+    //   - lights: The scene's lights.
+    //
+    void build(const std::vector<Light>& lights);
+
+    //
+    // Method: empty
+    // Returns: true if the scene has no point lights.
+    //
+    bool empty() const { return nodes.empty(); }
+
+    //
+    // Method: sample
+    // Picks one point light for a shading point, drawing one random number per level.
+    // Parameters:
+    //   - point: The shading point.
+    //   - normal: The surface normal at the point.
+    //   - view: The direction from the point towards the viewer.
+    //   - specular: The specular exponent of the surface (negative for none).
+    //   - probability: The probability of picking the returned light (output).
+    // Returns: The index of the light in Scene::lights, or -1 if no point light can
+    // contribute at the point.
+    //
+    int sample(const Vector3D& point, const Vector3D& normal, const Vector3D& view, Real specular,
+               Real& probability) const;
+
+private:
+    //
+    // Struct: BuildEntry
+    // Per-light data used only while building.
+    //
+    struct BuildEntry {
+        AABB bounds;
+        Vector3D centroid;
+        Real intensity;
+        int light;
+    };
+
+    int buildNode(std::vector<BuildEntry>& entries, int begin, int end);
+
+    //
+    // Method: importance
+    // Returns: An upper bound of the contribution of a node's lights at a shading point.
+    //
+    static Real importance(const LightTreeNode& node, const Vector3D& point, const Vector3D& normal,
+                           const Vector3D& reflectedView, Real specular);
+};
+
+#endif // LIGHTTREE_H
@@ -0,0 +1,135 @@
+#ifndef MAPPEDARRAY_H
+#define MAPPEDARRAY_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//
+// Class: MappedArray
+// A contiguous array that either owns its elements (in a std::vector) or refers to
+// elements stored elsewhere, typically in a memory-mapped scene cache (see SceneCache).
+// Reads go through one pointer in both cases, so code that only reads a built scene does
+// not care where the data lives. Any modifying call on a mapped array first copies the
+// elements into owned storage; the mapping itself is never written.
+//
+template <typename T>
+class MappedArray {
+    static_assert(std::is_trivially_copyable<T>::value, "MappedArray elements must be trivially copyable");
+
+public:
+    //
+    // Constructor: MappedArray
+    // Creates an empty, owning array.
+    //
+    MappedArray() : elements(nullptr), count(0), mapped(false) {}
+
+    MappedArray(const MappedArray& other) : storage(other.storage), elements(other.elements),
+                                            count(other.count), mapped(other.mapped) {
+        if (!mapped) sync();
+    }
+
+    MappedArray(MappedArray&& other) noexcept : storage(std::move(other.storage)), elements(other.elements),
+                                                count(other.count), mapped(other.mapped) {
+        if (!mapped) sync();
+        other.clear();
+    }
+
+    MappedArray& operator=(const MappedArray& other) {
+        if (this != &other) {
+            storage = other.storage;
+            elements = other.elements;
+            count = other.count;
+            mapped = other.mapped;
+            if (!mapped) sync();
+        }
+        return *this;
+    }
+
+    MappedArray& operator=(MappedArray&& other) noexcept {
+        if (this != &other) {
+            storage = std::move(other.storage);
+            elements = other.elements;
+            count = other.count;
+            mapped = other.mapped;
+            if (!mapped) sync();
+            other.clear();
+        }
+        return *this;
+    }
+
+    //
+    // Method: map
+    // Refers to `size` elements at `data` instead of owning them. The memory must stay valid
+    // and unchanged as long as the array refers to it.
+    //
+    void map(const T* data, std::size_t size) {
+        storage.clear();
+        storage.shrink_to_fit();
+        elements = data;
+        count = size;
+        mapped = true;
+    }
+
+    //
+    // Method: isMapped
+    // Returns: true if the elements live outside the array.
+    //
+    bool isMapped() const { return mapped; }
+
+    // Read access
+    const T* data() const { return elements; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](std::size_t i) const { return elements[i]; }
+    const T* begin() const { return elements; }
+    const T* end() const { return elements + count; }
+
+    // Write access (owned storage)
+    T* data() { own(); return storage.data(); }
+    T& operator[](std::size_t i) { own(); return storage[i]; }
+    T* begin() { own(); return storage.data(); }
+    T* end() { own(); return storage.data() + storage.size(); }
+    void push_back(const T& value) { own(); storage.push_back(value); sync(); }
+    void reserve(std::size_t capacity) { own(); storage.reserve(capacity); sync(); }
+    void resize(std::size_t size) { own(); storage.resize(size); sync(); }
+    void resize(std::size_t size, const T& value) { own(); storage.resize(size, value); sync(); }
+    void clear() { storage.clear(); mapped = false; sync(); }
+
+    //
+    // Method: append
+    // Appends the elements of [first, last).
+    //
+    template <typename Iterator>
+    void append(Iterator first, Iterator last) {
+        own();
+        storage.insert(storage.end(), first, last);
+        sync();
+    }
+
+private:
+    //
+    // Method: own
+    // Copies mapped elements into owned storage before a modification.
+    //
+    void own() {
+        if (mapped) {
+            storage.assign(elements, elements + count);
+            mapped = false;
+            sync();
+        }
+    }
+
+    void sync() {
+        elements = storage.data();
+        count = storage.size();
+    }
+
+    std::vector<T> storage;   // The owned elements (empty while mapped).
+    const T* elements;        // The first element, owned or mapped.
+    std::size_t count;        // The number of elements.
+    bool mapped;              // The elements live outside `storage`.
+};
+
+#endif // MAPPEDARRAY_H
@@ -0,0 +1,94 @@
+#include "MappedFile.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//
+// Constructor: MappedFile
+// Creates an empty mapping; see open().
+//
+MappedFile::MappedFile() : bytes(nullptr), length(0) {}
+
+//
+// Destructor: ~MappedFile
+// Unmaps the file if one is open.
+//
+MappedFile::~MappedFile() {
+    close();
+}
+
+//
+// Method: open
+// Maps a file, replacing any previous mapping.
+// Parameters:
+//   - path: The file to map.
+//   - error: A description of the failure (output, only written on failure).
+// Returns:
+//   - true on success, false if the file could not be opened or mapped.
+//
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        error = "cannot stat " + path + ": " + std::strerror(errno);
+        ::close(descriptor);
+        return false;
+    }
+
+    // An empty file cannot be mapped, but is a valid (empty) input
+    length = static_cast<std::size_t>(status.st_size);
+    if (length == 0) {
+        ::close(descriptor);
+        bytes = "";
+        return true;
+    }
+
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);   // The mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        length = 0;
+        return false;
+    }
+    madvise(mapping, length, MADV_WILLNEED);
+    bytes = static_cast<const char*>(mapping);
+    return true;
+}
+
+//
+// Method: close
+// Unmaps the file; data() is null afterwards.
+//
+void MappedFile::close() {
+    if (bytes && length > 0) {
+        munmap(const_cast<char*>(bytes), length);
+    }
+    bytes = nullptr;
+    length = 0;
+}
+
+//
+// Method: data
+// Returns: The first byte of the file, or null if nothing is mapped.
+//
+const char* MappedFile::data() const {
+    return bytes;
+}
+
+//
+// Method: size
+// Returns: The size of the file in bytes.
+//
+std::size_t MappedFile::size() const {
+    return length;
+}
@@ -0,0 +1,64 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+//
+// Class: MappedFile
+// A read-only memory mapping of a whole file. The pages are read by the kernel on demand
+// (with read-ahead), so large files can be parsed in place from several threads without
+// copying them into a buffer first. The mapping is released by the destructor.
+//
+class MappedFile {
+public:
+    //
+    // Constructor: MappedFile
+    // Creates an empty mapping; see open().
+    //
+    MappedFile();
+
+    //
+    // Destructor: ~MappedFile
+    // Unmaps the file if one is open.
+    //
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //
+    // Method: open
+    // Maps a file, replacing any previous mapping.
+    // Parameters:
+    //   - path: The file to map.
+    //   - error: A description of the failure (output, only written on failure).
+    // Returns:
+    //   - true on success, false if the file could not be opened or mapped.
+    //
+    bool open(const std::string& path, std::string& error);
+
+    //
+    // Method: close
+    // Unmaps the file; data() is null afterwards.
+    //
+    void close();
+
+    //
+    // Method: data
+    // Returns: The first byte of the file, or null if nothing is mapped.
+    //
+    const char* data() const;
+
+    //
+    // Method: size
+    // Returns: The size of the file in bytes.
+    //
+    std::size_t size() const;
+
+private:
+    const char* bytes;   // The mapped file contents.
+    std::size_t length;  // The size of the mapping in bytes.
+};
+
+#endif // MAPPEDFILE_H
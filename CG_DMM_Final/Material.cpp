@@ -0,0 +1,31 @@
+#include "Material.h"
+
+//
+// Constructor: Material
+// Initializes a material with the given properties.
+// Parameters:
+//   - color: The surface color.
+//   - specular: The specular reflection coefficient.
+//   - reflective: The reflectivity.
+//   - subsurfaceRadius: Radius for SSS effects.
+//   - scatteringCoefficient: Scattering coefficient for SSS.
+//
+Material::Material(const Color& color, Real specular, Real reflective,
+                   Real subsurfaceRadius, Real scatteringCoefficient)
+    : color(color),
+      specular(specular),
+      reflective(reflective),
+      subsurfaceRadius(subsurfaceRadius),
+      scatteringCoefficient(scatteringCoefficient) {}
+
+//
+// Default Constructor: Material
+// Initializes a black, non-reflective material without subsurface scattering.
+//
+Material::Material()
+    : color(Color()),
+      specular(0.0),
+      reflective(0.0),
+      subsurfaceRadius(0.0),
+      scatteringCoefficient(0.0) {}
+
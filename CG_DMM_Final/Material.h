@@ -0,0 +1,45 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "Color.h"
+
+//
+// Class: Material
+// The shading properties of a primitive, kept apart from its geometry so that
+// intersection loops never touch them.
+//
+class Material {
+public:
+    Color color;                   // The surface color.
+    Real specular;                 // The specular reflection coefficient.
+    Real reflective;               // The reflectivity.
+    Real subsurfaceRadius;         // The radius for subsurface scattering (SSS) effects.
+    Real scatteringCoefficient;    // The scattering coefficient for subsurface scattering.
+
+    //
+    // Constructor: Material
+    // Initializes a material with the given properties.
+    // Parameters:
+    //   - color: The surface color.
+    //   - specular: The specular reflection coefficient.
+    //   - reflective: The reflectivity.
+    //   - subsurfaceRadius: Radius for SSS effects.
+    //   - scatteringCoefficient: Scattering coefficient for SSS.
+    //
+    Material(const Color& color, Real specular, Real reflective,
+             Real subsurfaceRadius, Real scatteringCoefficient);
+
+    //
+    // Default Constructor: Material
+    // Initializes a black, non-reflective material without subsurface scattering.
+    //
+    Material();
+
+    //
+    // Destructor: ~Material
+    // Default destructor for the Material class.
+    //
+    ~Material() = default;
+};
+
+#endif // MATERIAL_H
@@ -0,0 +1,117 @@
+#include "Mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//
+// Constructor: Mesh
+// Initializes an empty mesh with a neutral grey, slightly glossy material.
+//
+Mesh::Mesh() : Mesh(Color(0.8, 0.8, 0.8), 100, 0.1) {}
+
+//
+// Constructor: Mesh
+// Initializes an empty mesh with the given material.
+// Parameters:
+//   - color: The color of the mesh.
+//   - specular: The specular reflection coefficient.
+//   - reflective: The reflectivity of the mesh.
+//   - subsurfaceRadius: (Optional) Radius for SSS effects. Default is 0.0.
+//   - scatteringCoefficient: (Optional) Scattering coefficient for SSS. Default is 0.0.
+//
+Mesh::Mesh(const Color& color, Real specular, Real reflective,
+           Real subsurfaceRadius, Real scatteringCoefficient)
+    : color(color), specular(specular), reflective(reflective),
+      subsurfaceRadius(subsurfaceRadius), scatteringCoefficient(scatteringCoefficient) {}
+
+//
+// Destructor: ~Mesh
+// Default destructor for the Mesh class.
+//
+Mesh::~Mesh() {}
+
+//
+// Method: vertexCount
+// Returns: The number of vertices.
+//
+std::size_t Mesh::vertexCount() const {
+    return positions.size() / 3;
+}
+
+//
+// Method: triangleCount
+// Returns: The number of triangles.
+//
+std::size_t Mesh::triangleCount() const {
+    return indices.size() / 3;
+}
+
+//
+// Method: vertex
+// Returns: The position of a vertex.
+//
+Vector3D Mesh::vertex(uint32_t index) const {
+    const float* p = &positions[static_cast<std::size_t>(index) * 3];
+    return Vector3D(p[0], p[1], p[2]);
+}
+
+//
+// Method: bounds
+// Returns: The smallest AABB containing every vertex.
+//
+AABB Mesh::bounds() const {
+    AABB box;
+    for (std::size_t i = 0; i < vertexCount(); i++) {
+        box.expand(vertex(static_cast<uint32_t>(i)));
+    }
+    return box;
+}
+
+//
+// Method: triangleBounds
+// Returns: The smallest AABB containing one triangle.
+//
+AABB Mesh::triangleBounds(std::size_t triangle) const {
+    AABB box;
+    for (int corner = 0; corner < 3; corner++) {
+        box.expand(vertex(indices[triangle * 3 + corner]));
+    }
+    return box;
+}
+
+//
+// Method: fitInto
+// Scales the mesh uniformly to the largest size that fits the box and moves it to the
+// middle of the box in x and z, resting on its bottom (min y); normals are unchanged.
+// Parameters:
+//   - box: The target box.
+//
+void Mesh::fitInto(const AABB& box) {
+    if (positions.empty()) return;
+
+    AABB current = bounds();
+    Vector3D size = current.max - current.min;
+    Vector3D target = box.max - box.min;
+    Real scale = std::numeric_limits<Real>::infinity();
+    if (size.x > 0) scale = std::min(scale, target.x / size.x);
+    if (size.y > 0) scale = std::min(scale, target.y / size.y);
+    if (size.z > 0) scale = std::min(scale, target.z / size.z);
+    if (std::isinf(scale)) scale = 1.0;
+
+    Vector3D from(current.centroid().x, current.min.y, current.centroid().z);
+    Vector3D to(box.centroid().x, box.min.y, box.centroid().z);
+    for (std::size_t i = 0; i < positions.size(); i += 3) {
+        positions[i] = static_cast<float>((positions[i] - from.x) * scale + to.x);
+        positions[i + 1] = static_cast<float>((positions[i + 1] - from.y) * scale + to.y);
+        positions[i + 2] = static_cast<float>((positions[i + 2] - from.z) * scale + to.z);
+    }
+}
+
+//
+// Method: memoryBytes
+// Returns: The size of the vertex, normal and index buffers in bytes.
+//
+std::size_t Mesh::memoryBytes() const {
+    return positions.size() * sizeof(float) + normals.size() * sizeof(float) +
+           indices.size() * sizeof(uint32_t) + normalIndices.size() * sizeof(uint32_t);
+}
@@ -0,0 +1,105 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AABB.h"
+#include "Color.h"
+#include "Vector3D.h"
+
+//
+// Class: Mesh
+// An indexed triangle mesh: vertices and normals are stored once in shared buffers and
+// each triangle refers to them by index, with a single material for the whole mesh.
+// Positions and normals are single precision, so a triangle of a typical closed mesh
+// (about half a vertex per triangle) takes roughly 30 bytes instead of the ~130 bytes of a
+// standalone Triangle with its own vertices and material.
+//
+class Mesh {
+public:
+    static const uint32_t NO_NORMAL = 0xffffffffu;   // Normal index of a corner without a normal.
+
+    std::vector<float> positions;          // x, y, z of every vertex.
+    std::vector<float> normals;            // x, y, z of every normal; empty if the mesh has none.
+    std::vector<uint32_t> indices;         // Three vertex indices per triangle.
+    std::vector<uint32_t> normalIndices;   // Three normal indices per triangle (or NO_NORMAL);
+                                           // empty if the mesh has no normals.
+    Color color;                           // The color of the mesh.
+    Real specular;                         // The specular reflection coefficient.
+    Real reflective;                       // The reflectivity of the mesh.
+    Real subsurfaceRadius;                 // The radius for subsurface scattering (SSS) effects.
+    Real scatteringCoefficient;            // The scattering coefficient for subsurface scattering.
+
+    //
+    // Constructor: Mesh
+    // Initializes an empty mesh with a neutral grey, slightly glossy material.
+    //
+    Mesh();
+
+    //
+    // Constructor: Mesh
+    // Initializes an empty mesh with the given material.
+    // Parameters:
+    //   - color: The color of the mesh.
+    //   - specular: The specular reflection coefficient.
+    //   - reflective: The reflectivity of the mesh.
+    //   - subsurfaceRadius: (Optional) Radius for SSS effects. Default is 0.0.
+    //   - scatteringCoefficient: (Optional) Scattering coefficient for SSS. Default is 0.0.
+    //
+    Mesh(const Color& color, Real specular, Real reflective,
+         Real subsurfaceRadius = 0.0, Real scatteringCoefficient = 0.0);
+
+    //
+    // Destructor: ~Mesh
+    // Default destructor for the Mesh class.
+    //
+    ~Mesh();
+
+    //
+    // Method: vertexCount
+    // Returns: The number of vertices.
+    //
+    std::size_t vertexCount() const;
+
+    //
+    // Method: triangleCount
+    // Returns: The number of triangles.
+    //
+    std::size_t triangleCount() const;
+
+    //
+    // Method: vertex
+    // Returns: The position of a vertex.
+    //
+    Vector3D vertex(uint32_t index) const;
+
+    //
+    // Method: bounds
+    // Returns: The smallest AABB containing every vertex.
+    //
+    AABB bounds() const;
+
+    //
+    // Method: triangleBounds
+    // Returns: The smallest AABB containing one triangle.
+    //
+    AABB triangleBounds(std::size_t triangle) const;
+
+    //
+    // Method: fitInto
+    // Scales the mesh uniformly to the largest size that fits the box and moves it to the
+    // middle of the box in x and z, resting on its bottom (min y); normals are unchanged.
+    // Parameters:
+    //   - box: The target box.
+    //
+    void fitInto(const AABB& box);
+
+    //
+    // Method: memoryBytes
+    // Returns: The size of the vertex, normal and index buffers in bytes.
+    //
+    std::size_t memoryBytes() const;
+};
+
+#endif // MESH_H
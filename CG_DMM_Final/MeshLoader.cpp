@@ -0,0 +1,737 @@
+#include "MeshLoader.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include "MappedFile.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+const std::size_t MIN_CHUNK_BYTES = 1 << 20;   // Smallest OBJ chunk worth a task of its own
+const int CHUNKS_PER_THREAD = 8;               // OBJ chunks per parser thread, for load balance
+const std::size_t PLY_BLOCK = 1 << 16;         // PLY records decoded per task
+
+//
+// Function: extensionOf
+// Returns: The lower-case extension of a path including the dot, or "" if it has none.
+//
+std::string extensionOf(const std::string& path) {
+    std::size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || path.find('/', dot) != std::string::npos) return "";
+    std::string extension = path.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+//
+// Function: lineNumber
+// Returns: The 1-based line number of a position in a text file (for error messages).
+//
+std::size_t lineNumber(const char* begin, const char* position) {
+    return static_cast<std::size_t>(std::count(begin, position, '\n')) + 1;
+}
+
+//
+// OBJ parsing
+//
+
+//
+// Enum: ObjLine
+// The OBJ statements the loader reads; everything else is skipped.
+//
+enum class ObjLine {
+    VERTEX,   // "v x y z"
+    NORMAL,   // "vn x y z"
+    FACE,     // "f v1[/vt1][/vn1] v2... v3..."
+    OTHER     // Comments, texture coordinates, groups, materials, ...
+};
+
+//
+// Struct: ObjChunk
+// A range of whole lines and its share of the output buffers.
+//
+struct ObjChunk {
+    const char* begin;                  // First byte of the chunk.
+    const char* end;                    // One past the last byte (after a newline or at EOF).
+    std::size_t vertices = 0;           // Number of "v" statements.
+    std::size_t normals = 0;            // Number of "vn" statements.
+    std::size_t triangles = 0;          // Number of triangles after fan triangulation.
+    std::size_t firstVertex = 0;        // Index of the chunk's first vertex in the file.
+    std::size_t firstNormal = 0;        // Index of the chunk's first normal in the file.
+    std::size_t firstTriangle = 0;      // Index of the chunk's first triangle in the file.
+    const char* errorAt = nullptr;      // Position of the first malformed statement, if any.
+    const char* errorMessage = nullptr; // What is wrong with it.
+};
+
+bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) p++;
+    return p;
+}
+
+//
+// Function: objLineType
+// Classifies the line starting at p and moves p past its keyword.
+//
+ObjLine objLineType(const char*& p, const char* end) {
+    p = skipBlanks(p, end);
+    if (end - p >= 2 && p[0] == 'v' && isBlank(p[1])) {
+        p += 2;
+        return ObjLine::VERTEX;
+    }
+    if (end - p >= 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2])) {
+        p += 3;
+        return ObjLine::NORMAL;
+    }
+    if (end - p >= 2 && p[0] == 'f' && isBlank(p[1])) {
+        p += 2;
+        return ObjLine::FACE;
+    }
+    return ObjLine::OTHER;
+}
+
+//
+// Function: lineEndOf
+// Returns: The position of the newline ending the line at p, or end.
+//
+const char* lineEndOf(const char* p, const char* end) {
+    const void* newline = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+    return newline ? static_cast<const char*>(newline) : end;
+}
+
+//
+// Function: parseFloats
+// Parses `count` blank-separated numbers at p into out. Returns false on malformed input.
+//
+bool parseFloats(const char* p, const char* end, int count, float* out) {
+    for (int i = 0; i < count; i++) {
+        p = skipBlanks(p, end);
+        if (p < end && *p == '+') p++;
+        std::from_chars_result result = std::from_chars(p, end, out[i]);
+        if (result.ec != std::errc() || (result.ptr < end && !isBlank(*result.ptr))) return false;
+        p = result.ptr;
+    }
+    return true;
+}
+
+//
+// Function: resolveIndex
+// Converts a 1-based (or negative, relative) OBJ index to a 0-based one.
+// Parameters:
+//   - index: The index as written in the file.
+//   - defined: The number of elements defined before the statement (for relative indices).
+//   - total: The number of elements in the file.
+//   - resolved: The 0-based index (output).
+// Returns:
+//   - true if the index refers to an existing element.
+//
+bool resolveIndex(long long index, std::size_t defined, std::size_t total, uint32_t& resolved) {
+    long long zeroBased = index > 0 ? index - 1 : static_cast<long long>(defined) + index;
+    if (index == 0 || zeroBased < 0 || static_cast<std::size_t>(zeroBased) >= total) return false;
+    resolved = static_cast<uint32_t>(zeroBased);
+    return true;
+}
+
+//
+// Function: countObjChunk
+// First pass: counts the vertices, normals and triangles of a chunk.
+//
+void countObjChunk(ObjChunk& chunk) {
+    for (const char* line = chunk.begin; line < chunk.end;) {
+        const char* lineEnd = lineEndOf(line, chunk.end);
+        const char* p = line;
+        switch (objLineType(p, lineEnd)) {
+            case ObjLine::VERTEX: chunk.vertices++; break;
+            case ObjLine::NORMAL: chunk.normals++; break;
+            case ObjLine::FACE: {
+                std::size_t corners = 0;
+                while (true) {
+                    p = skipBlanks(p, lineEnd);
+                    if (p == lineEnd) break;
+                    corners++;
+                    while (p < lineEnd && !isBlank(*p)) p++;
+                }
+                if (corners >= 3) chunk.triangles += corners - 2;
+                break;
+            }
+            case ObjLine::OTHER: break;
+        }
+        line = lineEnd + 1;
+    }
+}
+
+//
+// Function: parseObjChunk
+// Second pass: parses a chunk into its ranges of the mesh buffers. Stops at the first
+// malformed statement and records it in the chunk.
+//
+void parseObjChunk(ObjChunk& chunk, Mesh& mesh, std::size_t totalVertices, std::size_t totalNormals) {
+    float* position = mesh.positions.data() + 3 * chunk.firstVertex;
+    float* normal = mesh.normals.data() + 3 * chunk.firstNormal;
+    uint32_t* index = mesh.indices.data() + 3 * chunk.firstTriangle;
+    uint32_t* normalIndex = totalNormals > 0 ? mesh.normalIndices.data() + 3 * chunk.firstTriangle : nullptr;
+    std::size_t vertexCount = chunk.firstVertex;   // Vertices defined so far, for relative indices
+    std::size_t normalCount = chunk.firstNormal;
+    std::vector<uint32_t> corners, cornerNormals;
+
+    auto fail = [&chunk](const char* at, const char* message) {
+        chunk.errorAt = at;
+        chunk.errorMessage = message;
+    };
+
+    for (const char* line = chunk.begin; line < chunk.end;) {
+        const char* lineEnd = lineEndOf(line, chunk.end);
+        const char* p = line;
+        switch (objLineType(p, lineEnd)) {
+            case ObjLine::VERTEX:
+                if (!parseFloats(p, lineEnd, 3, position)) return fail(line, "malformed vertex");
+                position += 3;
+                vertexCount++;
+                break;
+            case ObjLine::NORMAL:
+                if (!parseFloats(p, lineEnd, 3, normal)) return fail(line, "malformed normal");
+                normal += 3;
+                normalCount++;
+                break;
+            case ObjLine::FACE: {
+                corners.clear();
+                cornerNormals.clear();
+                while (true) {
+                    p = skipBlanks(p, lineEnd);
+                    if (p == lineEnd) break;
+
+                    // v, v/vt, v//vn or v/vt/vn
+                    long long value = 0;
+                    uint32_t vertex = 0, vertexNormal = Mesh::NO_NORMAL;
+                    std::from_chars_result result = std::from_chars(p, lineEnd, value);
+                    if (result.ec != std::errc() || !resolveIndex(value, vertexCount, totalVertices, vertex)) {
+                        return fail(line, "invalid vertex index in face");
+                    }
+                    p = result.ptr;
+                    if (p < lineEnd && *p == '/') {
+                        p++;
+                        if (p < lineEnd && *p != '/') {
+                            result = std::from_chars(p, lineEnd, value);   // Texture coordinate, unused
+                            if (result.ec != std::errc()) return fail(line, "malformed face");
+                            p = result.ptr;
+                        }
+                        if (p < lineEnd && *p == '/') {
+                            result = std::from_chars(p + 1, lineEnd, value);
+                            if (result.ec != std::errc() || !resolveIndex(value, normalCount, totalNormals, vertexNormal)) {
+                                return fail(line, "invalid normal index in face");
+                            }
+                            p = result.ptr;
+                        }
+                    }
+                    if (p < lineEnd && !isBlank(*p)) return fail(line, "malformed face");
+                    corners.push_back(vertex);
+                    cornerNormals.push_back(vertexNormal);
+                }
+
+                // Triangulate the polygon as a fan around its first corner
+                for (std::size_t i = 2; i < corners.size(); i++) {
+                    *index++ = corners[0];
+                    *index++ = corners[i - 1];
+                    *index++ = corners[i];
+                    if (normalIndex) {
+                        *normalIndex++ = cornerNormals[0];
+                        *normalIndex++ = cornerNormals[i - 1];
+                        *normalIndex++ = cornerNormals[i];
+                    }
+                }
+                break;
+            }
+            case ObjLine::OTHER: break;
+        }
+        line = lineEnd + 1;
+    }
+}
+
+//
+// Function: loadObj
+// Loads an OBJ file in two parallel passes over line-aligned chunks (see loadMesh).
+//
+bool loadObj(const MappedFile& file, Mesh& mesh, std::string& error, WorkStealingPool& pool) {
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+
+    // Cut the file into chunks that end after a newline
+    std::size_t chunkBytes = std::max(MIN_CHUNK_BYTES,
+        file.size() / (static_cast<std::size_t>(pool.threadCount()) * CHUNKS_PER_THREAD) + 1);
+    std::vector<ObjChunk> chunks;
+    for (const char* p = begin; p < end;) {
+        const char* chunkEnd = p + std::min(chunkBytes, static_cast<std::size_t>(end - p));
+        if (chunkEnd < end) chunkEnd = std::min(end, lineEndOf(chunkEnd - 1, end) + 1);
+        ObjChunk chunk;
+        chunk.begin = p;
+        chunk.end = chunkEnd;
+        chunks.push_back(chunk);
+        p = chunkEnd;
+    }
+
+    // Pass 1: counts, then each chunk's offsets
+    pool.parallelFor(static_cast<int>(chunks.size()), [&](int i) { countObjChunk(chunks[i]); });
+    std::size_t vertices = 0, normals = 0, triangles = 0;
+    for (ObjChunk& chunk : chunks) {
+        chunk.firstVertex = vertices;
+        chunk.firstNormal = normals;
+        chunk.firstTriangle = triangles;
+        vertices += chunk.vertices;
+        normals += chunk.normals;
+        triangles += chunk.triangles;
+    }
+    if (vertices > Mesh::NO_NORMAL || normals > Mesh::NO_NORMAL) {
+        error = "too many vertices for 32-bit indices";
+        return false;
+    }
+
+    // Pass 2: parse straight into the buffers
+    mesh.positions.resize(3 * vertices);
+    mesh.normals.resize(3 * normals);
+    mesh.indices.resize(3 * triangles);
+    mesh.normalIndices.resize(normals > 0 ? 3 * triangles : 0);
+    pool.parallelFor(static_cast<int>(chunks.size()),
+                     [&](int i) { parseObjChunk(chunks[i], mesh, vertices, normals); });
+
+    for (const ObjChunk& chunk : chunks) {
+        if (chunk.errorAt) {
+            std::ostringstream message;
+            message << "line " << lineNumber(begin, chunk.errorAt) << ": " << chunk.errorMessage;
+            error = message.str();
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// PLY parsing
+//
+
+//
+// Enum: PlyType
+// The scalar types of the PLY format.
+//
+enum class PlyType { INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, INVALID };
+
+//
+// Struct: PlyProperty
+// One property of a PLY element: a scalar, or a list with a count and item type.
+//
+struct PlyProperty {
+    std::string name;
+    PlyType type = PlyType::INVALID;        // Scalar type, or the item type of a list.
+    PlyType countType = PlyType::INVALID;   // Count type of a list; INVALID for scalars.
+};
+
+//
+// Struct: PlyElement
+// An element declaration of the PLY header with its records' layout.
+//
+struct PlyElement {
+    std::string name;
+    std::size_t count = 0;                  // Number of records.
+    std::vector<PlyProperty> properties;    // Properties in record order.
+};
+
+PlyType plyType(const std::string& name) {
+    if (name == "char" || name == "int8") return PlyType::INT8;
+    if (name == "uchar" || name == "uint8") return PlyType::UINT8;
+    if (name == "short" || name == "int16") return PlyType::INT16;
+    if (name == "ushort" || name == "uint16") return PlyType::UINT16;
+    if (name == "int" || name == "int32") return PlyType::INT32;
+    if (name == "uint" || name == "uint32") return PlyType::UINT32;
+    if (name == "float" || name == "float32") return PlyType::FLOAT32;
+    if (name == "double" || name == "float64") return PlyType::FLOAT64;
+    return PlyType::INVALID;
+}
+
+std::size_t plySize(PlyType type) {
+    switch (type) {
+        case PlyType::INT8: case PlyType::UINT8: return 1;
+        case PlyType::INT16: case PlyType::UINT16: return 2;
+        case PlyType::INT32: case PlyType::UINT32: case PlyType::FLOAT32: return 4;
+        case PlyType::FLOAT64: return 8;
+        default: return 0;
+    }
+}
+
+//
+// Function: readPly
+// Reads one scalar of the given type, swapping its bytes if the file's byte order differs
+// from the host's.
+//
+template <typename T>
+T readPly(const char* p, PlyType type, bool swap) {
+    unsigned char bytes[8];
+    std::size_t size = plySize(type);
+    std::memcpy(bytes, p, size);
+    if (swap) std::reverse(bytes, bytes + size);
+
+    switch (type) {
+        case PlyType::INT8: { int8_t v; std::memcpy(&v, bytes, 1); return static_cast<T>(v); }
+        case PlyType::UINT8: { uint8_t v; std::memcpy(&v, bytes, 1); return static_cast<T>(v); }
+        case PlyType::INT16: { int16_t v; std::memcpy(&v, bytes, 2); return static_cast<T>(v); }
+        case PlyType::UINT16: { uint16_t v; std::memcpy(&v, bytes, 2); return static_cast<T>(v); }
+        case PlyType::INT32: { int32_t v; std::memcpy(&v, bytes, 4); return static_cast<T>(v); }
+        case PlyType::UINT32: { uint32_t v; std::memcpy(&v, bytes, 4); return static_cast<T>(v); }
+        case PlyType::FLOAT32: { float v; std::memcpy(&v, bytes, 4); return static_cast<T>(v); }
+        case PlyType::FLOAT64: { double v; std::memcpy(&v, bytes, 8); return static_cast<T>(v); }
+        default: return T();
+    }
+}
+
+//
+// Function: propertySize
+// Returns the size of one property's value at p, or 0 if it extends past end.
+//
+std::size_t propertySize(const PlyProperty& property, const char* p, const char* end, bool swap) {
+    std::size_t size = plySize(property.type);
+    if (property.countType != PlyType::INVALID) {
+        std::size_t countSize = plySize(property.countType);
+        if (static_cast<std::size_t>(end - p) < countSize) return 0;
+        long long count = readPly<long long>(p, property.countType, swap);
+        if (count < 0) return 0;
+        size = countSize + static_cast<std::size_t>(count) * size;
+    }
+    return size <= static_cast<std::size_t>(end - p) ? size : 0;
+}
+
+//
+// Function: recordSize
+// Returns the size of the record at p, or 0 if it extends past end. With `stop` >= 0, only
+// the properties before property `stop` are counted, which gives that property's offset.
+//
+std::size_t recordSize(const PlyElement& element, const char* p, const char* end, bool swap, int stop = -1) {
+    std::size_t size = 0;
+    int count = stop >= 0 ? stop : static_cast<int>(element.properties.size());
+    for (int i = 0; i < count; i++) {
+        std::size_t property = propertySize(element.properties[i], p + size, end, swap);
+        if (property == 0) return 0;
+        size += property;
+    }
+    return size;
+}
+
+//
+// Function: fixedRecordSize
+// Returns the record size of an element without lists, or 0 if it has lists.
+//
+std::size_t fixedRecordSize(const PlyElement& element) {
+    std::size_t size = 0;
+    for (const PlyProperty& property : element.properties) {
+        if (property.countType != PlyType::INVALID) return 0;
+        size += plySize(property.type);
+    }
+    return size;
+}
+
+//
+// Function: parsePlyHeader
+// Reads the header; sets the byte order and the offset of the first record.
+//
+bool parsePlyHeader(const MappedFile& file, std::vector<PlyElement>& elements, bool& littleEndian,
+                    std::size_t& dataOffset, std::string& error) {
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    const char* marker = "\nend_header";
+    const char* headerEnd = std::search(begin, end, marker, marker + std::strlen(marker));
+    if (file.size() < 4 || std::memcmp(begin, "ply", 3) != 0 || headerEnd == end) {
+        error = "not a PLY file";
+        return false;
+    }
+    const char* dataStart = lineEndOf(headerEnd + 1, end);
+    if (dataStart == end) {
+        error = "truncated PLY header";
+        return false;
+    }
+    dataOffset = static_cast<std::size_t>(dataStart + 1 - begin);
+
+    std::istringstream header(std::string(begin, headerEnd));
+    std::string line;
+    bool formatSeen = false;
+    while (std::getline(header, line)) {
+        std::istringstream words(line);
+        std::string keyword;
+        words >> keyword;
+        if (keyword == "format") {
+            std::string format;
+            words >> format;
+            if (format == "ascii") {
+                error = "ASCII PLY is not supported; convert it to binary";
+                return false;
+            }
+            if (format != "binary_little_endian" && format != "binary_big_endian") {
+                error = "unknown PLY format '" + format + "'";
+                return false;
+            }
+            littleEndian = format == "binary_little_endian";
+            formatSeen = true;
+        } else if (keyword == "element") {
+            PlyElement element;
+            words >> element.name >> element.count;
+            elements.push_back(element);
+        } else if (keyword == "property") {
+            if (elements.empty()) {
+                error = "PLY property before any element";
+                return false;
+            }
+            PlyProperty property;
+            std::string type;
+            words >> type;
+            bool valid = true;
+            if (type == "list") {
+                std::string countType, itemType;
+                words >> countType >> itemType;
+                property.countType = plyType(countType);
+                property.type = plyType(itemType);
+                valid = property.countType != PlyType::INVALID;
+            } else {
+                property.type = plyType(type);
+            }
+            words >> property.name;
+            if (!valid || property.type == PlyType::INVALID || property.name.empty()) {
+                error = "unsupported PLY property '" + line + "'";
+                return false;
+            }
+            elements.back().properties.push_back(property);
+        }
+    }
+    if (!formatSeen) {
+        error = "PLY header has no format";
+        return false;
+    }
+    return true;
+}
+
+//
+// Function: loadPly
+// Loads a binary PLY file: vertex and face records are decoded in parallel blocks.
+//
+bool loadPly(const MappedFile& file, Mesh& mesh, std::string& error, WorkStealingPool& pool) {
+    std::vector<PlyElement> elements;
+    bool littleEndian = true;
+    std::size_t offset = 0;
+    if (!parsePlyHeader(file, elements, littleEndian, offset, error)) return false;
+
+    uint16_t probe = 1;
+    bool hostLittleEndian = *reinterpret_cast<unsigned char*>(&probe) == 1;
+    bool swap = littleEndian != hostLittleEndian;
+    const char* end = file.data() + file.size();
+    bool verticesSeen = false;
+
+    for (const PlyElement& element : elements) {
+        const char* data = file.data() + offset;
+
+        if (element.name == "vertex") {
+            // Fixed-size records: decode ranges in parallel
+            std::size_t size = fixedRecordSize(element);
+            if (size == 0) {
+                error = "PLY vertex element with list properties";
+                return false;
+            }
+            if (static_cast<std::size_t>(end - data) / size < element.count) {
+                error = "truncated PLY vertex data";
+                return false;
+            }
+            if (element.count > Mesh::NO_NORMAL) {
+                error = "too many vertices for 32-bit indices";
+                return false;
+            }
+
+            const char* names[6] = {"x", "y", "z", "nx", "ny", "nz"};
+            int found[6] = {-1, -1, -1, -1, -1, -1};
+            std::size_t fieldOffsets[6] = {};
+            PlyType fieldTypes[6] = {};
+            std::size_t propertyOffset = 0;
+            for (const PlyProperty& property : element.properties) {
+                for (int f = 0; f < 6; f++) {
+                    if (property.name == names[f]) {
+                        found[f] = 1;
+                        fieldOffsets[f] = propertyOffset;
+                        fieldTypes[f] = property.type;
+                    }
+                }
+                propertyOffset += plySize(property.type);
+            }
+            if (found[0] < 0 || found[1] < 0 || found[2] < 0) {
+                error = "PLY vertices without x, y and z";
+                return false;
+            }
+            bool hasNormals = found[3] >= 0 && found[4] >= 0 && found[5] >= 0;
+
+            mesh.positions.resize(3 * element.count);
+            mesh.normals.resize(hasNormals ? 3 * element.count : 0);
+            int blocks = static_cast<int>((element.count + PLY_BLOCK - 1) / PLY_BLOCK);
+            pool.parallelFor(blocks, [&](int block) {
+                std::size_t first = static_cast<std::size_t>(block) * PLY_BLOCK;
+                std::size_t last = std::min(element.count, first + PLY_BLOCK);
+                for (std::size_t v = first; v < last; v++) {
+                    const char* record = data + v * size;
+                    for (int f = 0; f < 3; f++) {
+                        mesh.positions[3 * v + f] = readPly<float>(record + fieldOffsets[f], fieldTypes[f], swap);
+                        if (hasNormals) {
+                            mesh.normals[3 * v + f] = readPly<float>(record + fieldOffsets[3 + f], fieldTypes[3 + f], swap);
+                        }
+                    }
+                }
+            });
+            offset += element.count * size;
+            verticesSeen = true;
+        } else if (element.name == "face") {
+            int listIndex = -1;
+            for (std::size_t i = 0; i < element.properties.size(); i++) {
+                const PlyProperty& property = element.properties[i];
+                if (property.countType != PlyType::INVALID &&
+                    (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                    listIndex = static_cast<int>(i);
+                }
+            }
+            if (listIndex < 0) {
+                error = "PLY faces without vertex_indices";
+                return false;
+            }
+            if (!verticesSeen) {
+                error = "PLY faces before vertices";
+                return false;
+            }
+            // Every record holds at least its list count, so the header cannot size the
+            // block tables beyond the file
+            if (static_cast<std::size_t>(end - data) / plySize(element.properties[listIndex].countType) <
+                element.count) {
+                error = "truncated PLY face data";
+                return false;
+            }
+
+            // Walk the variable-size records once to find where each block starts
+            std::size_t blocks = (element.count + PLY_BLOCK - 1) / PLY_BLOCK;
+            std::vector<std::size_t> blockOffsets(blocks + 1), blockTriangles(blocks + 1);
+            std::size_t faceOffset = 0, triangles = 0;
+            for (std::size_t f = 0; f < element.count; f++) {
+                if (f % PLY_BLOCK == 0) {
+                    blockOffsets[f / PLY_BLOCK] = faceOffset;
+                    blockTriangles[f / PLY_BLOCK] = triangles;
+                }
+                const char* record = data + faceOffset;
+                std::size_t size = recordSize(element, record, end, swap);
+                if (size == 0) {
+                    error = "truncated PLY face data";
+                    return false;
+                }
+                std::size_t listOffset = recordSize(element, record, end, swap, listIndex);
+                long long corners = readPly<long long>(record + listOffset, element.properties[listIndex].countType, swap);
+                if (corners >= 3) triangles += static_cast<std::size_t>(corners) - 2;
+                faceOffset += size;
+            }
+            blockOffsets[blocks] = faceOffset;
+            blockTriangles[blocks] = triangles;
+
+            // Decode the blocks in parallel; each writes its own range of triangles
+            mesh.indices.resize(3 * triangles);
+            std::size_t vertexCount = mesh.vertexCount();
+            std::vector<char> invalid(blocks, 0);
+            pool.parallelFor(static_cast<int>(blocks), [&](int block) {
+                const PlyProperty& list = element.properties[listIndex];
+                std::size_t countSize = plySize(list.countType), itemSize = plySize(list.type);
+                const char* record = data + blockOffsets[block];
+                uint32_t* index = mesh.indices.data() + 3 * blockTriangles[block];
+                std::size_t first = static_cast<std::size_t>(block) * PLY_BLOCK;
+                std::size_t last = std::min(element.count, first + PLY_BLOCK);
+                for (std::size_t f = first; f < last; f++) {
+                    const char* p = record + recordSize(element, record, end, swap, listIndex);
+                    long long corners = readPly<long long>(p, list.countType, swap);
+                    const char* items = p + countSize;
+                    for (long long c = 0; c < corners; c++) {
+                        long long value = readPly<long long>(items + c * itemSize, list.type, swap);
+                        if (value < 0 || static_cast<std::size_t>(value) >= vertexCount) invalid[block] = 1;
+                    }
+                    // Triangulate the polygon as a fan around its first corner
+                    for (long long c = 2; c < corners; c++) {
+                        *index++ = readPly<uint32_t>(items, list.type, swap);
+                        *index++ = readPly<uint32_t>(items + (c - 1) * itemSize, list.type, swap);
+                        *index++ = readPly<uint32_t>(items + c * itemSize, list.type, swap);
+                    }
+                    record += recordSize(element, record, end, swap);
+                }
+            });
+            if (std::find(invalid.begin(), invalid.end(), 1) != invalid.end()) {
+                error = "PLY face refers to a missing vertex";
+                return false;
+            }
+            offset += faceOffset;
+        } else {
+            // Skip any other element
+            std::size_t size = fixedRecordSize(element);
+            if (size > 0) {
+                offset += element.count * size;
+            } else {
+                for (std::size_t r = 0; r < element.count; r++) {
+                    std::size_t record = recordSize(element, file.data() + offset, end, swap);
+                    if (record == 0) {
+                        error = "truncated PLY element '" + element.name + "'";
+                        return false;
+                    }
+                    offset += record;
+                }
+            }
+        }
+        if (offset > file.size()) {
+            error = "truncated PLY element '" + element.name + "'";
+            return false;
+        }
+    }
+
+    if (!mesh.normals.empty()) {
+        // PLY normals belong to the vertices: corners share their vertex's index
+        mesh.normalIndices = mesh.indices;
+    }
+    return true;
+}
+
+} // namespace
+
+//
+// Function: loadMesh
+// Loads a triangle mesh from a Wavefront OBJ (.obj) or binary PLY (.ply) file, chosen by
+// the file extension; see MeshLoader.h for how the file is split between the threads.
+// Parameters:
+//   - path: The file to load.
+//   - mesh: Receives the vertex, normal and index buffers (output); its material is kept.
+//   - error: A description of the failure (output, only written on failure).
+//   - threadCount: (Optional) Number of parser threads. Values <= 0 use the hardware concurrency.
+// Returns:
+//   - true on success, false if the file cannot be read or is malformed.
+//
+bool loadMesh(const std::string& path, Mesh& mesh, std::string& error, int threadCount) {
+    std::string extension = extensionOf(path);
+    if (extension != ".obj" && extension != ".ply") {
+        error = path + ": unsupported mesh format (expected .obj or .ply)";
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(path, error)) return false;
+
+    mesh.positions.clear();
+    mesh.normals.clear();
+    mesh.indices.clear();
+    mesh.normalIndices.clear();
+
+    WorkStealingPool pool(threadCount);
+    bool loaded = (extension == ".obj") ? loadObj(file, mesh, error, pool) : loadPly(file, mesh, error, pool);
+    if (!loaded) {
+        error = path + ": " + error;
+        mesh.positions.clear();
+        mesh.normals.clear();
+        mesh.indices.clear();
+        mesh.normalIndices.clear();
+    }
+    return loaded;
+}
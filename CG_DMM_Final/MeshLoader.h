@@ -0,0 +1,27 @@
+#ifndef MESHLOADER_H
+#define MESHLOADER_H
+
+#include <string>
+#include "Mesh.h"
+
+//
+// Function: loadMesh
+// Loads a triangle mesh from a Wavefront OBJ (.obj) or binary PLY (.ply) file, chosen by
+// the file extension. The file is memory-mapped and parsed in parallel chunks:
+//   - OBJ: the file is cut at line boundaries; a first pass counts the vertices, normals
+//     and triangles of every chunk, which gives each chunk its output offsets (and the base
+//     for relative indices), and a second pass parses the chunks straight into the buffers.
+//     Polygons are triangulated as fans; texture coordinates, groups and materials are ignored.
+//   - PLY (binary, either byte order): the fixed-size vertex records are decoded in parallel
+//     ranges; the face records are walked once to find block offsets, then decoded in parallel.
+// Parameters:
+//   - path: The file to load.
+//   - mesh: Receives the vertex, normal and index buffers (output); its material is kept.
+//   - error: A description of the failure (output, only written on failure).
+//   - threadCount: (Optional) Number of parser threads. Values <= 0 use the hardware concurrency.
+// Returns:
+//   - true on success, false if the file cannot be read or is malformed.
+//
+bool loadMesh(const std::string& path, Mesh& mesh, std::string& error, int threadCount = 0);
+
+#endif // MESHLOADER_H
@@ -0,0 +1,403 @@
+#include "PackedGeometry.h"
+#include <algorithm>
+#include <cmath>
+#include "RenderStats.h"
+
+namespace {
+
+//
+// Function: mollerTrumbore
+// Ray/triangle test on a triangle given by its first vertex and both edges.
+//
+inline bool mollerTrumbore(const Ray& ray, Real aX, Real aY, Real aZ,
+                           Real e1X, Real e1Y, Real e1Z,
+                           Real e2X, Real e2Y, Real e2Z, Real& t) {
+    const Real EPSILON = 1e-8;
+    const Vector3D& d = ray.direction;
+
+    // h = d x edge2
+    Real hX = d.y * e2Z - d.z * e2Y;
+    Real hY = d.z * e2X - d.x * e2Z;
+    Real hZ = d.x * e2Y - d.y * e2X;
+    Real a = e1X * hX + e1Y * hY + e1Z * hZ;
+    if (std::fabs(a) < EPSILON) return false;
+
+    Real f = 1 / a;
+    Real sX = ray.origin.x - aX;
+    Real sY = ray.origin.y - aY;
+    Real sZ = ray.origin.z - aZ;
+    Real u = f * (sX * hX + sY * hY + sZ * hZ);
+    if (u < 0.0 || u > 1.0) return false;
+
+    // q = s x edge1
+    Real qX = sY * e1Z - sZ * e1Y;
+    Real qY = sZ * e1X - sX * e1Z;
+    Real qZ = sX * e1Y - sY * e1X;
+    Real v = f * (d.x * qX + d.y * qY + d.z * qZ);
+    if (v < 0.0 || u + v > 1.0) return false;
+
+    Real tempT = f * (e2X * qX + e2Y * qY + e2Z * qZ);
+    if (tempT <= EPSILON) return false;
+    t = tempT;
+    return true;
+}
+
+} // namespace
+
+//
+// Constructor: PackedGeometry
+// Creates empty geometry.
+//
+PackedGeometry::PackedGeometry() {}
+
+//
+// Destructor: ~PackedGeometry
+// Default destructor for the PackedGeometry class.
+//
+PackedGeometry::~PackedGeometry() {}
+
+//
+// Method: build
+// Packs the primitives in the order they are referenced and rewrites the references to
+// packed indices. Sphere i uses material i; triangle i uses material spheres.size() + i;
+// the triangles of mesh m use material spheres.size() + triangles.size() + m.
+// Parameters:
+//   - spheres: The scene's spheres.
+//   - triangles: The scene's triangles.
+//   - meshes: The scene's meshes.
+//   - order: References into spheres/triangles/meshes, typically in BVH leaf order
+//     (input/output). Mesh triangles are numbered consecutively across all meshes.
+//
+void PackedGeometry::build(const std::vector<Sphere>& spheres, const std::vector<Triangle>& triangles,
+                           const std::vector<Mesh>& meshes, MappedArray<PrimitiveRef>& order) {
+    *this = PackedGeometry();
+
+    // Concatenate the vertex and normal pools; firstTriangle[m] numbers mesh m's triangles
+    std::vector<std::size_t> firstTriangle(meshes.size() + 1, 0), firstVertex(meshes.size(), 0), firstNormal(meshes.size(), 0);
+    bool anyNormals = false;
+    for (std::size_t m = 0; m < meshes.size(); m++) {
+        firstTriangle[m + 1] = firstTriangle[m] + meshes[m].triangleCount();
+        firstVertex[m] = meshPositions.size() / 3;
+        firstNormal[m] = meshNormals.size() / 3;
+        meshPositions.append(meshes[m].positions.begin(), meshes[m].positions.end());
+        meshNormals.append(meshes[m].normals.begin(), meshes[m].normals.end());
+        anyNormals = anyNormals || !meshes[m].normalIndices.empty();
+    }
+    meshTriangleVertices.reserve(3 * firstTriangle.back());
+    meshTriangleNormals.reserve(anyNormals ? 3 * firstTriangle.back() : 0);
+    meshTriangleMaterial.reserve(firstTriangle.back());
+
+    for (PrimitiveRef& primitive : order) {
+        if (primitive.type == PrimitiveType::SPHERE) {
+            const Sphere& sphere = spheres[primitive.index];
+            sphereCenterX.push_back(sphere.center.x);
+            sphereCenterY.push_back(sphere.center.y);
+            sphereCenterZ.push_back(sphere.center.z);
+            sphereRadiusSquared.push_back(sphere.radius * sphere.radius);
+            sphereInvRadius.push_back(1 / sphere.radius);
+            sphereMaterial.push_back(primitive.index);
+            primitive.index = sphereCount() - 1;
+        } else if (primitive.type == PrimitiveType::TRIANGLE) {
+            const Triangle& triangle = triangles[primitive.index];
+            Vector3D edge1 = triangle.B - triangle.A;
+            Vector3D edge2 = triangle.C - triangle.A;
+            Vector3D normal = triangle.getNormal();
+            triangleAX.push_back(triangle.A.x);
+            triangleAY.push_back(triangle.A.y);
+            triangleAZ.push_back(triangle.A.z);
+            triangleEdge1X.push_back(edge1.x);
+            triangleEdge1Y.push_back(edge1.y);
+            triangleEdge1Z.push_back(edge1.z);
+            triangleEdge2X.push_back(edge2.x);
+            triangleEdge2Y.push_back(edge2.y);
+            triangleEdge2Z.push_back(edge2.z);
+            triangleNormalX.push_back(normal.x);
+            triangleNormalY.push_back(normal.y);
+            triangleNormalZ.push_back(normal.z);
+            triangleMaterial.push_back(static_cast<int>(spheres.size()) + primitive.index);
+            primitive.index = triangleCount() - 1;
+        } else {
+            std::size_t m = static_cast<std::size_t>(std::upper_bound(firstTriangle.begin(), firstTriangle.end(),
+                static_cast<std::size_t>(primitive.index)) - firstTriangle.begin()) - 1;
+            const Mesh& mesh = meshes[m];
+            std::size_t triangle = static_cast<std::size_t>(primitive.index) - firstTriangle[m];
+            for (int corner = 0; corner < 3; corner++) {
+                meshTriangleVertices.push_back(static_cast<uint32_t>(firstVertex[m] + mesh.indices[3 * triangle + corner]));
+                if (anyNormals) {
+                    uint32_t normal = mesh.normalIndices.empty() ? Mesh::NO_NORMAL : mesh.normalIndices[3 * triangle + corner];
+                    meshTriangleNormals.push_back(normal == Mesh::NO_NORMAL ? Mesh::NO_NORMAL
+                                                                            : static_cast<uint32_t>(firstNormal[m] + normal));
+                }
+            }
+            meshTriangleMaterial.push_back(static_cast<int>(spheres.size() + triangles.size() + m));
+            primitive.index = meshTriangleCount() - 1;
+        }
+    }
+}
+
+//
+// Method: intersect
+// Closest-hit test of a run of primitives, updating the hit when a closer one is found.
+// Parameters:
+//   - primitives: The first reference of the run.
+//   - count: The number of references.
+//   - ray: The ray; its direction must be normalized.
+//   - t_min: The minimum accepted distance (exclusive).
+//   - closest_t: The current closest distance (input/output).
+//   - hit: The closest hit (output, only written when a closer hit is found).
+// Returns:
+//   - true if a closer hit was found, false otherwise.
+//
+bool PackedGeometry::intersect(const PrimitiveRef* primitives, int count, const Ray& ray,
+                               Real t_min, Real& closest_t, Hit& hit) const {
+    STATS_ADD(primitiveTests, count);
+    bool found = false;
+    for (int i = 0; i < count; i++) {
+        const PrimitiveRef& primitive = primitives[i];
+        Real t;
+        bool intersects;
+        if (primitive.type == PrimitiveType::SPHERE) {
+            intersects = intersectSphere(primitive.index, ray, t);
+        } else if (primitive.type == PrimitiveType::TRIANGLE) {
+            intersects = intersectTriangle(primitive.index, ray, t);
+        } else {
+            intersects = intersectMeshTriangle(primitive.index, ray, t);
+        }
+        if (intersects && t > t_min && t < closest_t) {
+            closest_t = t;
+            hit.t = t;
+            hit.primitive = primitive;
+            found = true;
+        }
+    }
+    return found;
+}
+
+//
+// Method: occludes
+// Any-hit test of a run of primitives against the segment (0, t_max).
+// Parameters:
+//   - primitives: The first reference of the run.
+//   - count: The number of references.
+//   - ray: The ray; its direction must be normalized.
+//   - t_max: The length of the segment.
+//   - occluder: The first blocking primitive (output, only written on success).
+// Returns:
+//   - true if any primitive blocks the segment, false otherwise.
+//
+bool PackedGeometry::occludes(const PrimitiveRef* primitives, int count, const Ray& ray,
+                              Real t_max, PrimitiveRef& occluder) const {
+    for (int i = 0; i < count; i++) {
+        const PrimitiveRef& primitive = primitives[i];
+        bool blocks;
+        if (primitive.type == PrimitiveType::SPHERE) {
+            blocks = occludesSphere(primitive.index, ray, t_max);
+        } else if (primitive.type == PrimitiveType::TRIANGLE) {
+            Real t;
+            blocks = intersectTriangle(primitive.index, ray, t) && t < t_max;
+        } else {
+            Real t;
+            blocks = intersectMeshTriangle(primitive.index, ray, t) && t < t_max;
+        }
+        if (blocks) {
+            STATS_ADD(primitiveTests, i + 1);
+            occluder = primitive;
+            return true;
+        }
+    }
+    STATS_ADD(primitiveTests, count);
+    return false;
+}
+
+//
+// Method: normal
+// Returns the unit surface normal of a primitive at a point on its surface.
+// Parameters:
+//   - primitive: The primitive.
+//   - point: The point on the primitive.
+//
+Vector3D PackedGeometry::normal(const PrimitiveRef& primitive, const Vector3D& point) const {
+    int i = primitive.index;
+    if (primitive.type == PrimitiveType::SPHERE) {
+        return Vector3D(point.x - sphereCenterX[i],
+                        point.y - sphereCenterY[i],
+                        point.z - sphereCenterZ[i]) * sphereInvRadius[i];
+    }
+    if (primitive.type == PrimitiveType::TRIANGLE) {
+        return Vector3D(triangleNormalX[i], triangleNormalY[i], triangleNormalZ[i]);
+    }
+    return meshTriangleNormal(i, point);
+}
+
+//
+// Method: materialId
+// Returns the index of a primitive's material in the scene's material list.
+// Parameters:
+//   - primitive: The primitive.
+//
+int PackedGeometry::materialId(const PrimitiveRef& primitive) const {
+    switch (primitive.type) {
+        case PrimitiveType::SPHERE: return sphereMaterial[primitive.index];
+        case PrimitiveType::TRIANGLE: return triangleMaterial[primitive.index];
+        default: return meshTriangleMaterial[primitive.index];
+    }
+}
+
+//
+// Method: sphereCount
+// Returns: The number of packed spheres.
+//
+int PackedGeometry::sphereCount() const {
+    return static_cast<int>(sphereMaterial.size());
+}
+
+//
+// Method: triangleCount
+// Returns: The number of packed triangles.
+//
+int PackedGeometry::triangleCount() const {
+    return static_cast<int>(triangleMaterial.size());
+}
+
+//
+// Method: meshTriangleCount
+// Returns: The number of packed mesh triangles.
+//
+int PackedGeometry::meshTriangleCount() const {
+    return static_cast<int>(meshTriangleMaterial.size());
+}
+
+//
+// Method: meshTriangleCorners
+// Loads the first vertex and both edges of a packed mesh triangle.
+// Parameters:
+//   - i: The packed mesh triangle index.
+//   - a: The first vertex (output).
+//   - edge1, edge2: The edges from the first vertex to the second and third (output).
+//
+void PackedGeometry::meshTriangleCorners(int i, Vector3D& a, Vector3D& edge1, Vector3D& edge2) const {
+    const uint32_t* corners = &meshTriangleVertices[3 * static_cast<std::size_t>(i)];
+    const float* p0 = &meshPositions[3 * static_cast<std::size_t>(corners[0])];
+    const float* p1 = &meshPositions[3 * static_cast<std::size_t>(corners[1])];
+    const float* p2 = &meshPositions[3 * static_cast<std::size_t>(corners[2])];
+    a = Vector3D(p0[0], p0[1], p0[2]);
+    edge1 = Vector3D(p1[0], p1[1], p1[2]) - a;
+    edge2 = Vector3D(p2[0], p2[1], p2[2]) - a;
+}
+
+//
+// Method: contains
+// Returns: true if the reference points to a packed primitive.
+//
+bool PackedGeometry::contains(const PrimitiveRef& primitive) const {
+    if (primitive.index < 0) return false;
+    switch (primitive.type) {
+        case PrimitiveType::SPHERE: return primitive.index < sphereCount();
+        case PrimitiveType::TRIANGLE: return primitive.index < triangleCount();
+        default: return primitive.index < meshTriangleCount();
+    }
+}
+
+//
+// Method: intersectSphere
+// Closest non-negative root of the ray/sphere quadratic. The ray direction is unit length,
+// so the quadratic term is 1 and the roots are -b -/+ sqrt(b^2 - c).
+//
+bool PackedGeometry::intersectSphere(int i, const Ray& ray, Real& t) const {
+    Real ocX = ray.origin.x - sphereCenterX[i];
+    Real ocY = ray.origin.y - sphereCenterY[i];
+    Real ocZ = ray.origin.z - sphereCenterZ[i];
+    Real b = ocX * ray.direction.x + ocY * ray.direction.y + ocZ * ray.direction.z;
+    Real c = ocX * ocX + ocY * ocY + ocZ * ocZ - sphereRadiusSquared[i];
+    Real discriminant = b * b - c;
+    if (discriminant < 0.0) return false;
+
+    Real sqrtDiscriminant = std::sqrt(discriminant);
+    Real nearRoot = -b - sqrtDiscriminant;
+    Real farRoot = -b + sqrtDiscriminant;
+    if (nearRoot >= 0.0) {
+        t = nearRoot;
+    } else if (farRoot >= 0.0) {
+        t = farRoot;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+//
+// Method: occludesSphere
+// Any-hit sphere test against the segment (0, t_max); see Sphere::occludes.
+//
+bool PackedGeometry::occludesSphere(int i, const Ray& ray, Real t_max) const {
+    Real ocX = ray.origin.x - sphereCenterX[i];
+    Real ocY = ray.origin.y - sphereCenterY[i];
+    Real ocZ = ray.origin.z - sphereCenterZ[i];
+    Real b = ocX * ray.direction.x + ocY * ray.direction.y + ocZ * ray.direction.z;
+    Real c = ocX * ocX + ocY * ocY + ocZ * ocZ - sphereRadiusSquared[i];
+
+    if (c > 0.0) {
+        if (b >= 0.0) return false;
+        Real discriminant = b * b - c;
+        if (discriminant < 0.0) return false;
+        Real m = -b - t_max;
+        return m < 0.0 || m * m < discriminant;
+    }
+    if (c < 0.0) {
+        Real m = t_max + b;
+        return m > 0.0 && b * b - c < m * m;
+    }
+    return false;
+}
+
+//
+// Method: intersectTriangle
+// Möller-Trumbore test using the precomputed edges.
+//
+bool PackedGeometry::intersectTriangle(int i, const Ray& ray, Real& t) const {
+    return mollerTrumbore(ray, triangleAX[i], triangleAY[i], triangleAZ[i],
+                          triangleEdge1X[i], triangleEdge1Y[i], triangleEdge1Z[i],
+                          triangleEdge2X[i], triangleEdge2Y[i], triangleEdge2Z[i], t);
+}
+
+//
+// Method: intersectMeshTriangle
+// Möller-Trumbore test of a mesh triangle, with its edges computed from the vertex pool.
+//
+bool PackedGeometry::intersectMeshTriangle(int i, const Ray& ray, Real& t) const {
+    Vector3D a, edge1, edge2;
+    meshTriangleCorners(i, a, edge1, edge2);
+    return mollerTrumbore(ray, a.x, a.y, a.z, edge1.x, edge1.y, edge1.z, edge2.x, edge2.y, edge2.z, t);
+}
+
+//
+// Method: meshTriangleNormal
+// The normal of a mesh triangle: the vertex normals interpolated at the point's barycentric
+// coordinates if all three corners have one, otherwise the geometric normal following the
+// winding order (counter-clockwise faces outward, as in OBJ and PLY files).
+//
+Vector3D PackedGeometry::meshTriangleNormal(int i, const Vector3D& point) const {
+    Vector3D a, edge1, edge2;
+    meshTriangleCorners(i, a, edge1, edge2);
+    if (meshTriangleNormals.empty() || meshTriangleNormals[3 * static_cast<std::size_t>(i)] == Mesh::NO_NORMAL ||
+        meshTriangleNormals[3 * static_cast<std::size_t>(i) + 1] == Mesh::NO_NORMAL ||
+        meshTriangleNormals[3 * static_cast<std::size_t>(i) + 2] == Mesh::NO_NORMAL) {
+        return edge1.cross(edge2).normalize();
+    }
+
+    Vector3D offset = point - a;
+    Real d00 = edge1.dot(edge1), d01 = edge1.dot(edge2), d11 = edge2.dot(edge2);
+    Real d20 = offset.dot(edge1), d21 = offset.dot(edge2);
+    Real denominator = d00 * d11 - d01 * d01;
+    if (denominator == 0.0) return edge1.cross(edge2).normalize();
+    Real v = (d11 * d20 - d01 * d21) / denominator;
+    Real w = (d00 * d21 - d01 * d20) / denominator;
+    Real weights[3] = {1 - v - w, v, w};
+
+    Vector3D normal(0, 0, 0);
+    for (int corner = 0; corner < 3; corner++) {
+        const float* n = &meshNormals[3 * static_cast<std::size_t>(meshTriangleNormals[3 * static_cast<std::size_t>(i) + corner])];
+        normal = normal + Vector3D(n[0], n[1], n[2]) * weights[corner];
+    }
+    return normal.normalize();
+}
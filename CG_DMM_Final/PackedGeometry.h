@@ -0,0 +1,167 @@
+#ifndef PACKEDGEOMETRY_H
+#define PACKEDGEOMETRY_H
+
+#include <cstdint>
+#include <vector>
+#include "MappedArray.h"
+#include "Vector3D.h"
+#include "Ray.h"
+#include "Sphere.h"
+#include "Triangle.h"
+#include "Mesh.h"
+#include "Primitive.h"
+
+//
+// Class: PackedGeometry
+// The intersection-only representation of the scene's spheres and triangles, stored as
+// structure-of-arrays with everything the intersection tests need precomputed:
+//   - spheres: center, squared radius and inverse radius,
+//   - triangles: first vertex, both edges and the (camera-facing) unit normal,
+//   - mesh triangles: three indices into a shared single-precision vertex pool (and normal
+//     pool), so large meshes are not expanded; edges and normals are computed when needed.
+// Material data is not stored here; each primitive only carries a material index.
+// Primitives are packed in BVH leaf order, so a leaf's primitives are adjacent in memory.
+//
+class PackedGeometry {
+public:
+    // Sphere arrays, indexed by packed sphere index
+    MappedArray<Real> sphereCenterX, sphereCenterY, sphereCenterZ;
+    MappedArray<Real> sphereRadiusSquared;
+    MappedArray<Real> sphereInvRadius;
+    MappedArray<int> sphereMaterial;
+
+    // Triangle arrays, indexed by packed triangle index
+    MappedArray<Real> triangleAX, triangleAY, triangleAZ;
+    MappedArray<Real> triangleEdge1X, triangleEdge1Y, triangleEdge1Z;
+    MappedArray<Real> triangleEdge2X, triangleEdge2Y, triangleEdge2Z;
+    MappedArray<Real> triangleNormalX, triangleNormalY, triangleNormalZ;
+    MappedArray<int> triangleMaterial;
+
+    // Mesh vertex and normal pools (x, y, z each; all meshes concatenated)
+    MappedArray<float> meshPositions;
+    MappedArray<float> meshNormals;
+
+    // Mesh triangle arrays, indexed by packed mesh triangle index: three pool indices each.
+    // meshTriangleNormals is empty if no mesh has normals; Mesh::NO_NORMAL marks a corner without one.
+    MappedArray<uint32_t> meshTriangleVertices;
+    MappedArray<uint32_t> meshTriangleNormals;
+    MappedArray<int> meshTriangleMaterial;
+
+    //
+    // Constructor: PackedGeometry
+    // Creates empty geometry.
+    //
+    PackedGeometry();
+
+    //
+    // Destructor: ~PackedGeometry
+    // Default destructor for the PackedGeometry class.
+    //
+    ~PackedGeometry();
+
+    //
+    // Method: build
+    // Packs the primitives in the order they are referenced and rewrites the references to
+    // packed indices. Sphere i uses material i; triangle i uses material spheres.size() + i;
+    // the triangles of mesh m use material spheres.size() + triangles.size() + m.
+    // Parameters:
+    //   - spheres: The scene's spheres.
+    //   - triangles: The scene's triangles.
+    //   - meshes: The scene's meshes.
+    //   - order: References into spheres/triangles/meshes, typically in BVH leaf order
+    //     (input/output). Mesh triangles are numbered consecutively across all meshes.
+    //
+    void build(const std::vector<Sphere>& spheres, const std::vector<Triangle>& triangles,
+               const std::vector<Mesh>& meshes, MappedArray<PrimitiveRef>& order);
+
+    //
+    // Method: intersect
+    // Closest-hit test of a run of primitives, updating the hit when a closer one is found.
+    // Parameters:
+    //   - primitives: The first reference of the run.
+    //   - count: The number of references.
+    //   - ray: The ray; its direction must be normalized.
+    //   - t_min: The minimum accepted distance (exclusive).
+    //   - closest_t: The current closest distance (input/output).
+    //   - hit: The closest hit (output, only written when a closer hit is found).
+    // Returns:
+    //   - true if a closer hit was found, false otherwise.
+    //
+    bool intersect(const PrimitiveRef* primitives, int count, const Ray& ray,
+                   Real t_min, Real& closest_t, Hit& hit) const;
+
+    //
+    // Method: occludes
+    // Any-hit test of a run of primitives against the segment (0, t_max).
+    // Parameters:
+    //   - primitives: The first reference of the run.
+    //   - count: The number of references.
+    //   - ray: The ray; its direction must be normalized.
+    //   - t_max: The length of the segment.
+    //   - occluder: The first blocking primitive (output, only written on success).
+    // Returns:
+    //   - true if any primitive blocks the segment, false otherwise.
+    //
+    bool occludes(const PrimitiveRef* primitives, int count, const Ray& ray,
+                  Real t_max, PrimitiveRef& occluder) const;
+
+    //
+    // Method: normal
+    // Returns the unit surface normal of a primitive at a point on its surface.
+    // Parameters:
+    //   - primitive: The primitive.
+    //   - point: The point on the primitive.
+    //
+    Vector3D normal(const PrimitiveRef& primitive, const Vector3D& point) const;
+
+    //
+    // Method: materialId
+    // Returns the index of a primitive's material in the scene's material list.
+    // Parameters:
+    //   - primitive: The primitive.
+    //
+    int materialId(const PrimitiveRef& primitive) const;
+
+    //
+    // Method: sphereCount
+    // Returns: The number of packed spheres.
+    //
+    int sphereCount() const;
+
+    //
+    // Method: triangleCount
+    // Returns: The number of packed triangles.
+    //
+    int triangleCount() const;
+
+    //
+    // Method: meshTriangleCount
+    // Returns: The number of packed mesh triangles.
+    //
+    int meshTriangleCount() const;
+
+    //
+    // Method: meshTriangleCorners
+    // Loads the first vertex and both edges of a packed mesh triangle.
+    // Parameters:
+    //   - i: The packed mesh triangle index.
+    //   - a: The first vertex (output).
+    //   - edge1, edge2: The edges from the first vertex to the second and third (output).
+    //
+    void meshTriangleCorners(int i, Vector3D& a, Vector3D& edge1, Vector3D& edge2) const;
+
+    //
+    // Method: contains
+    // Returns: true if the reference points to a packed primitive.
+    //
+    bool contains(const PrimitiveRef& primitive) const;
+
+private:
+    bool intersectSphere(int i, const Ray& ray, Real& t) const;
+    bool occludesSphere(int i, const Ray& ray, Real t_max) const;
+    bool intersectTriangle(int i, const Ray& ray, Real& t) const;
+    bool intersectMeshTriangle(int i, const Ray& ray, Real& t) const;
+    Vector3D meshTriangleNormal(int i, const Vector3D& point) const;
+};
+
+#endif // PACKEDGEOMETRY_H
@@ -0,0 +1,472 @@
+#include "PacketTracer.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "RenderStats.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PACKET_TRACER_X86 1
+#endif
+
+namespace {
+
+const int STACK_SIZE = 128;    // Matches the scalar BVH traversal stack.
+
+//
+// Packet vector types
+// A packet keeps each ray component in K native vectors of W Reals (GCC/Clang vector
+// extensions), one register each: an xmm register (SSE2), a ymm register (AVX2) or a zmm
+// register (AVX-512). W is 2, 4 and 8 for doubles and twice that for floats. Vectors
+// wider than the target's registers are split into scalar code by GCC, so wider packets
+// use several registers per component rather than wider types. Comparisons yield integer
+// vectors of the same width, which serve as lane masks and as per-lane primitive indices.
+//
+typedef Real PacketRealXmm __attribute__((vector_size(16)));
+typedef Real PacketRealYmm __attribute__((vector_size(32)));
+typedef Real PacketRealZmm __attribute__((vector_size(64)));
+
+// Integers of the size of Real, for the primitive index lanes
+typedef std::conditional<sizeof(Real) == 8, int64_t, int32_t>::type PacketIndex;
+
+// Rays per packet of two registers per component
+const int SSE2_WIDTH = 2 * sizeof(PacketRealXmm) / sizeof(Real);
+const int AVX2_WIDTH = 2 * sizeof(PacketRealYmm) / sizeof(Real);
+const int AVX512_WIDTH = 2 * sizeof(PacketRealZmm) / sizeof(Real);
+
+//
+// Struct: PacketData
+// The rays of one packet and their running closest hits, in memory.
+// Vectors are only loaded and stored inside the kernel, never passed between functions,
+// so functions compiled for different targets never exchange vector registers.
+//
+template <int N>
+struct PacketData {
+    alignas(64) Real originX[N], originY[N], originZ[N];
+    alignas(64) Real directionX[N], directionY[N], directionZ[N];
+    alignas(64) Real closest[N];       // Closest accepted distance; -1 marks an unused lane.
+    alignas(64) PacketIndex primitive[N];  // Index into BVH::primitives of the closest hit, or -1.
+};
+
+// Lane-wise select as a bitwise blend, and min/max with the same operand order as
+// std::min/std::max
+#define PACKET_SELECT(mask, a, b) ((RealVector)(((mask) & (Mask)(a)) | (~(mask) & (Mask)(b))))
+#define PACKET_MIN(a, b) PACKET_SELECT((b) < (a), b, a)
+#define PACKET_MAX(a, b) PACKET_SELECT((a) < (b), b, a)
+
+// Repeats a statement for each of the K vectors of a packet
+#define FOR_EACH_VECTOR for (int k = 0; k < K; k++)
+
+//
+// Function: anyLane
+// Returns true if any lane of K masks is set.
+//
+template <int K, typename Mask>
+inline __attribute__((always_inline)) bool anyLane(const Mask* masks) {
+    Mask any = masks[0];
+    for (int k = 1; k < K; k++) {
+        any |= masks[k];
+    }
+    int64_t lanes[sizeof(Mask) / sizeof(int64_t)];
+    std::memcpy(lanes, &any, sizeof(Mask));
+    int64_t result = 0;
+    for (int64_t lane : lanes) {
+        result |= lane;
+    }
+    return result != 0;
+}
+
+//
+// Function: intersectPacketKernel
+// Closest-hit traversal of one packet of K vectors of Real. The arithmetic of every
+// primitive test mirrors PackedGeometry term by term, so each lane gets exactly the
+// scalar result. Always inlined into the per-target wrappers below, which decide the
+// instruction set.
+//
+template <typename RealVector, int K>
+inline __attribute__((always_inline)) void intersectPacketKernel(const BVH& bvh, const PackedGeometry& geometry,
+                                                                PacketData<K * sizeof(RealVector) / sizeof(Real)>& packet,
+                                                                Real t_min) {
+    typedef decltype(RealVector() < RealVector()) Mask;
+    const Real EPSILON = 1e-8;
+
+    RealVector ox[K], oy[K], oz[K], dx[K], dy[K], dz[K], closest[K];
+    Mask primitive[K];
+    std::memcpy(ox, packet.originX, sizeof(ox));
+    std::memcpy(oy, packet.originY, sizeof(oy));
+    std::memcpy(oz, packet.originZ, sizeof(oz));
+    std::memcpy(dx, packet.directionX, sizeof(dx));
+    std::memcpy(dy, packet.directionY, sizeof(dy));
+    std::memcpy(dz, packet.directionZ, sizeof(dz));
+    std::memcpy(closest, packet.closest, sizeof(closest));
+    std::memcpy(primitive, packet.primitive, sizeof(primitive));
+
+    const RealVector zero = {};
+    const Mask noLanes = {};
+    const RealVector tMin = zero + t_min;
+    RealVector invX[K], invY[K], invZ[K];
+    FOR_EACH_VECTOR {
+        invX[k] = (zero + 1.0) / dx[k];
+        invY[k] = (zero + 1.0) / dy[k];
+        invZ[k] = (zero + 1.0) / dz[k];
+    }
+
+    int stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        int nodeIndex = stack[--stackSize];
+        const BVHNode& node = bvh.nodes[nodeIndex];
+
+        // Slab test of every lane against the node bounds
+        Mask overlaps[K];
+        FOR_EACH_VECTOR {
+            RealVector tx1 = (node.bounds.min.x - ox[k]) * invX[k];
+            RealVector tx2 = (node.bounds.max.x - ox[k]) * invX[k];
+            RealVector ty1 = (node.bounds.min.y - oy[k]) * invY[k];
+            RealVector ty2 = (node.bounds.max.y - oy[k]) * invY[k];
+            RealVector tz1 = (node.bounds.min.z - oz[k]) * invZ[k];
+            RealVector tz2 = (node.bounds.max.z - oz[k]) * invZ[k];
+            RealVector xNear = PACKET_MIN(tx1, tx2), xFar = PACKET_MAX(tx1, tx2);
+            RealVector yNear = PACKET_MIN(ty1, ty2), yFar = PACKET_MAX(ty1, ty2);
+            RealVector zNear = PACKET_MIN(tz1, tz2), zFar = PACKET_MAX(tz1, tz2);
+            RealVector xyNear = PACKET_MAX(xNear, yNear), zNearClamped = PACKET_MAX(zNear, tMin);
+            RealVector xyFar = PACKET_MIN(xFar, yFar), zFarClamped = PACKET_MIN(zFar, closest[k]);
+            RealVector entry = PACKET_MAX(xyNear, zNearClamped);
+            RealVector exit = PACKET_MIN(xyFar, zFarClamped);
+            overlaps[k] = entry <= exit;
+        }
+        if (!anyLane<K>(overlaps)) continue;
+
+        if (node.count == 0) {
+            // Visit the child nearer along the first ray's direction first, so lanes find
+            // close hits early and cull the farther child's subtrees
+            const AABB& left = bvh.nodes[nodeIndex + 1].bounds;
+            const AABB& right = bvh.nodes[node.offset].bounds;
+            Real order = (right.min.x + right.max.x - left.min.x - left.max.x) * packet.directionX[0]
+                         + (right.min.y + right.max.y - left.min.y - left.max.y) * packet.directionY[0]
+                         + (right.min.z + right.max.z - left.min.z - left.max.z) * packet.directionZ[0];
+            if (order >= 0.0) {
+                stack[stackSize++] = node.offset;
+                stack[stackSize++] = nodeIndex + 1;
+            } else {
+                stack[stackSize++] = nodeIndex + 1;
+                stack[stackSize++] = node.offset;
+            }
+            continue;
+        }
+
+        STATS_ADD(packetTests, node.count);
+        for (int i = node.offset; i < node.offset + node.count; i++) {
+            const PrimitiveRef& ref = bvh.primitives[i];
+            int p = ref.index;
+            RealVector t[K];
+            Mask valid[K];
+
+            if (ref.type == PrimitiveType::SPHERE) {
+                Real centerX = geometry.sphereCenterX[p], centerY = geometry.sphereCenterY[p];
+                Real centerZ = geometry.sphereCenterZ[p], radiusSquared = geometry.sphereRadiusSquared[p];
+                RealVector b[K], discriminant[K];
+                FOR_EACH_VECTOR {
+                    RealVector ocX = ox[k] - centerX;
+                    RealVector ocY = oy[k] - centerY;
+                    RealVector ocZ = oz[k] - centerZ;
+                    b[k] = ocX * dx[k] + ocY * dy[k] + ocZ * dz[k];
+                    RealVector c = ocX * ocX + ocY * ocY + ocZ * ocZ - radiusSquared;
+                    discriminant[k] = b[k] * b[k] - c;
+                    valid[k] = discriminant[k] >= 0.0;
+                }
+                if (!anyLane<K>(valid)) continue;
+
+                FOR_EACH_VECTOR {
+                    RealVector clamped = PACKET_MAX(discriminant[k], zero);
+                    RealVector sqrtDiscriminant;
+                    for (int lane = 0; lane < static_cast<int>(sizeof(RealVector) / sizeof(Real)); lane++) {
+                        sqrtDiscriminant[lane] = std::sqrt(clamped[lane]);
+                    }
+                    RealVector nearRoot = -b[k] - sqrtDiscriminant;
+                    RealVector farRoot = -b[k] + sqrtDiscriminant;
+                    Mask nearValid = nearRoot >= 0.0;
+                    t[k] = PACKET_SELECT(nearValid, nearRoot, farRoot);
+                    valid[k] = valid[k] & (nearValid | (farRoot >= 0.0));
+                }
+            } else {
+                Real e1X, e1Y, e1Z, e2X, e2Y, e2Z, aX, aY, aZ;
+                if (ref.type == PrimitiveType::TRIANGLE) {
+                    e1X = geometry.triangleEdge1X[p], e1Y = geometry.triangleEdge1Y[p], e1Z = geometry.triangleEdge1Z[p];
+                    e2X = geometry.triangleEdge2X[p], e2Y = geometry.triangleEdge2Y[p], e2Z = geometry.triangleEdge2Z[p];
+                    aX = geometry.triangleAX[p], aY = geometry.triangleAY[p], aZ = geometry.triangleAZ[p];
+                } else {
+                    Vector3D a, edge1, edge2;
+                    geometry.meshTriangleCorners(p, a, edge1, edge2);
+                    e1X = edge1.x, e1Y = edge1.y, e1Z = edge1.z;
+                    e2X = edge2.x, e2Y = edge2.y, e2Z = edge2.z;
+                    aX = a.x, aY = a.y, aZ = a.z;
+                }
+
+                RealVector hX[K], hY[K], hZ[K], a[K];
+                FOR_EACH_VECTOR {
+                    hX[k] = dy[k] * e2Z - dz[k] * e2Y;
+                    hY[k] = dz[k] * e2X - dx[k] * e2Z;
+                    hZ[k] = dx[k] * e2Y - dy[k] * e2X;
+                    a[k] = e1X * hX[k] + e1Y * hY[k] + e1Z * hZ[k];
+                    valid[k] = (a[k] <= -EPSILON) | (a[k] >= EPSILON);
+                }
+                if (!anyLane<K>(valid)) continue;
+
+                RealVector f[K], sX[K], sY[K], sZ[K], u[K];
+                FOR_EACH_VECTOR {
+                    f[k] = (zero + 1.0) / a[k];
+                    sX[k] = ox[k] - aX;
+                    sY[k] = oy[k] - aY;
+                    sZ[k] = oz[k] - aZ;
+                    u[k] = f[k] * (sX[k] * hX[k] + sY[k] * hY[k] + sZ[k] * hZ[k]);
+                    valid[k] = valid[k] & (u[k] >= 0.0) & (u[k] <= 1.0);
+                }
+                if (!anyLane<K>(valid)) continue;
+
+                FOR_EACH_VECTOR {
+                    RealVector qX = sY[k] * e1Z - sZ[k] * e1Y;
+                    RealVector qY = sZ[k] * e1X - sX[k] * e1Z;
+                    RealVector qZ = sX[k] * e1Y - sY[k] * e1X;
+                    RealVector v = f[k] * (dx[k] * qX + dy[k] * qY + dz[k] * qZ);
+                    valid[k] = valid[k] & (v >= 0.0) & (u[k] + v <= 1.0);
+                    t[k] = f[k] * (e2X * qX + e2Y * qY + e2Z * qZ);
+                    valid[k] = valid[k] & (t[k] > EPSILON);
+                }
+            }
+
+            FOR_EACH_VECTOR {
+                Mask accept = valid[k] & (t[k] > tMin) & (t[k] < closest[k]);
+                closest[k] = PACKET_SELECT(accept, t[k], closest[k]);
+                primitive[k] = (accept & (noLanes + i)) | (~accept & primitive[k]);
+            }
+        }
+    }
+
+    std::memcpy(packet.closest, closest, sizeof(closest));
+    std::memcpy(packet.primitive, primitive, sizeof(primitive));
+}
+
+#undef PACKET_SELECT
+#undef PACKET_MIN
+#undef PACKET_MAX
+#undef FOR_EACH_VECTOR
+
+//
+// Per-target kernels
+// Each wrapper is compiled for its instruction set; the kernel is inlined into it. Every
+// packet holds two registers per ray component, which hides the latency of dependent
+// vector operations.
+//
+void intersectPacketSse2(const BVH& bvh, const PackedGeometry& geometry, PacketData<SSE2_WIDTH>& packet,
+                         Real t_min) {
+    intersectPacketKernel<PacketRealXmm, 2>(bvh, geometry, packet, t_min);
+}
+
+#ifdef PACKET_TRACER_X86
+__attribute__((target("avx2")))
+void intersectPacketAvx2(const BVH& bvh, const PackedGeometry& geometry, PacketData<AVX2_WIDTH>& packet,
+                         Real t_min) {
+    intersectPacketKernel<PacketRealYmm, 2>(bvh, geometry, packet, t_min);
+}
+
+__attribute__((target("avx512f")))
+void intersectPacketAvx512(const BVH& bvh, const PackedGeometry& geometry, PacketData<AVX512_WIDTH>& packet,
+                           Real t_min) {
+    intersectPacketKernel<PacketRealZmm, 2>(bvh, geometry, packet, t_min);
+}
+#endif
+
+//
+// Function: rayAt
+// Returns: Ray `index` of an array of rays or of a structure of arrays.
+//
+inline const Ray& rayAt(const Ray* rays, int index) {
+    return rays[index];
+}
+
+inline Ray rayAt(const RayArrays& rays, int index) {
+    return Ray(Vector3D(rays.originX[index], rays.originY[index], rays.originZ[index]),
+               Vector3D(rays.directionX[index], rays.directionY[index], rays.directionZ[index]));
+}
+
+//
+// Function: tracePackets
+// Splits the rays into packets of N, pads the last one with unused lanes and runs the kernel.
+//
+template <int N, typename Rays>
+void tracePackets(const Scene& scene, void (*kernel)(const BVH&, const PackedGeometry&, PacketData<N>&, Real),
+                  const Rays& rays, int count, Real t_min, Real t_max, Hit* hits, bool* found) {
+    PacketData<N> packet;
+    for (int first = 0; first < count; first += N) {
+        int lanes = (count - first < N) ? count - first : N;
+        for (int lane = 0; lane < N; lane++) {
+            const Ray& ray = rayAt(rays, first + (lane < lanes ? lane : 0));
+            packet.originX[lane] = ray.origin.x;
+            packet.originY[lane] = ray.origin.y;
+            packet.originZ[lane] = ray.origin.z;
+            packet.directionX[lane] = ray.direction.x;
+            packet.directionY[lane] = ray.direction.y;
+            packet.directionZ[lane] = ray.direction.z;
+            packet.closest[lane] = lane < lanes ? t_max : -1.0;
+            packet.primitive[lane] = -1;
+        }
+
+        if (!scene.bvh.nodes.empty()) {
+            kernel(scene.bvh, scene.geometry, packet, t_min);
+        }
+
+        for (int lane = 0; lane < lanes; lane++) {
+            found[first + lane] = packet.primitive[lane] >= 0;
+            if (found[first + lane]) {
+                hits[first + lane].t = packet.closest[lane];
+                hits[first + lane].primitive = scene.bvh.primitives[packet.primitive[lane]];
+            }
+        }
+    }
+}
+
+//
+// Function: traceRays
+// Runs the packet tracer of an instruction set over the rays, or Scene::intersect on each.
+//
+template <typename Rays>
+void traceRays(const Scene& scene, PacketIsa isa, const Rays& rays, int count,
+               Real t_min, Real t_max, Hit* hits, bool* found) {
+    switch (isa) {
+        case PacketIsa::SSE2:
+            tracePackets<SSE2_WIDTH>(scene, intersectPacketSse2, rays, count, t_min, t_max, hits, found);
+            return;
+#ifdef PACKET_TRACER_X86
+        case PacketIsa::AVX2:
+            tracePackets<AVX2_WIDTH>(scene, intersectPacketAvx2, rays, count, t_min, t_max, hits, found);
+            return;
+        case PacketIsa::AVX512:
+            tracePackets<AVX512_WIDTH>(scene, intersectPacketAvx512, rays, count, t_min, t_max, hits, found);
+            return;
+#endif
+        default:
+            for (int i = 0; i < count; i++) {
+                found[i] = scene.intersect(rayAt(rays, i), t_min, t_max, hits[i]);
+            }
+            return;
+    }
+}
+
+//
+// Function: isaSupported
+// Returns true if the running CPU can execute the given instruction set.
+//
+bool isaSupported(PacketIsa isa) {
+#ifdef PACKET_TRACER_X86
+    __builtin_cpu_init();
+    if (isa == PacketIsa::AVX512) return __builtin_cpu_supports("avx512f");
+    if (isa == PacketIsa::AVX2) return __builtin_cpu_supports("avx2");
+    return true;
+#else
+    return isa != PacketIsa::AVX2 && isa != PacketIsa::AVX512;
+#endif
+}
+
+} // namespace
+
+//
+// Function: detectPacketIsa
+// Returns: The fastest packet instruction set supported by the running CPU. Double
+// precision SSE2 packets carry only two rays per register and trace slower than single
+// rays, so CPUs without AVX2 trace one ray at a time.
+//
+PacketIsa detectPacketIsa() {
+    if (isaSupported(PacketIsa::AVX512)) return PacketIsa::AVX512;
+    if (isaSupported(PacketIsa::AVX2)) return PacketIsa::AVX2;
+    return PacketIsa::SCALAR;
+}
+
+//
+// Function: resolvePacketIsa
+// Maps a requested instruction set to one the CPU can run.
+// Parameters:
+//   - requested: The requested instruction set.
+// Returns: The instruction set to use.
+//
+PacketIsa resolvePacketIsa(PacketIsa requested) {
+    if (requested == PacketIsa::AUTO) return detectPacketIsa();
+    if (requested == PacketIsa::AVX512 && !isaSupported(PacketIsa::AVX512)) requested = PacketIsa::AVX2;
+    if (requested == PacketIsa::AVX2 && !isaSupported(PacketIsa::AVX2)) requested = PacketIsa::SSE2;
+    return requested;
+}
+
+//
+// Function: parsePacketIsa
+// Parses "auto", "scalar", "sse2", "avx2" or "avx512".
+// Parameters:
+//   - name: The name to parse.
+//   - isa: The parsed instruction set (output).
+// Returns: true on success, false for an unknown name.
+//
+bool parsePacketIsa(const char* name, PacketIsa& isa) {
+    const PacketIsa all[] = {PacketIsa::AUTO, PacketIsa::SCALAR, PacketIsa::SSE2, PacketIsa::AVX2, PacketIsa::AVX512};
+    for (PacketIsa candidate : all) {
+        if (std::strcmp(name, packetIsaName(candidate)) == 0) {
+            isa = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// Function: packetIsaName
+// Returns: The lower-case name of an instruction set.
+//
+const char* packetIsaName(PacketIsa isa) {
+    switch (isa) {
+        case PacketIsa::AUTO: return "auto";
+        case PacketIsa::SCALAR: return "scalar";
+        case PacketIsa::SSE2: return "sse2";
+        case PacketIsa::AVX2: return "avx2";
+        case PacketIsa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+//
+// Function: packetWidth
+// Returns: The number of rays per packet (1 for SCALAR).
+//
+int packetWidth(PacketIsa isa) {
+    switch (isa) {
+        case PacketIsa::SSE2: return SSE2_WIDTH;
+        case PacketIsa::AVX2: return AVX2_WIDTH;
+        case PacketIsa::AVX512: return AVX512_WIDTH;
+        default: return 1;
+    }
+}
+
+//
+// Function: intersectPackets
+// Finds the closest hit of every ray, tracing them through the BVH in packets.
+// Parameters:
+//   - scene: The built scene.
+//   - isa: The instruction set to use; must be supported (see resolvePacketIsa).
+//   - rays: The rays; directions must be normalized.
+//   - count: The number of rays.
+//   - t_min, t_max: The accepted distance interval (exclusive).
+//   - hits: The closest hit of each ray (output).
+//   - found: Whether each ray hit anything (output).
+//
+void intersectPackets(const Scene& scene, PacketIsa isa, const Ray* rays, int count,
+                      Real t_min, Real t_max, Hit* hits, bool* found) {
+    traceRays(scene, isa, rays, count, t_min, t_max, hits, found);
+}
+
+//
+// Function: intersectPackets
+// Finds the closest hit of every ray of a structure of arrays, like the overload above.
+//
+void intersectPackets(const Scene& scene, PacketIsa isa, const RayArrays& rays, int count,
+                      Real t_min, Real t_max, Hit* hits, bool* found) {
+    traceRays(scene, isa, rays, count, t_min, t_max, hits, found);
+}
@@ -0,0 +1,99 @@
+#ifndef PACKETTRACER_H
+#define PACKETTRACER_H
+
+#include "Ray.h"
+#include "Scene.h"
+
+//
+// Enum: PacketIsa
+// The instruction set used to trace packets of coherent rays.
+//
+enum class PacketIsa {
+    AUTO,     // Pick the widest instruction set the CPU supports.
+    SCALAR,   // No packets: every ray is traced alone through Scene::intersect.
+    SSE2,     // Two 128-bit registers per component: 4-ray packets (8 in float mode), the x86-64 baseline.
+    AVX2,     // Two 256-bit registers per component: 8-ray packets (16 in float mode).
+    AVX512    // Two 512-bit registers per component: 16-ray packets (32 in float mode).
+};
+
+//
+// Function: detectPacketIsa
+// Returns: The fastest packet instruction set supported by the running CPU: AVX-512 or
+// AVX2 where available, otherwise SCALAR (double precision SSE2 packets are slower than
+// single rays).
+//
+PacketIsa detectPacketIsa();
+
+//
+// Function: resolvePacketIsa
+// Maps a requested instruction set to one the CPU can run: AUTO becomes the detected one,
+// and a set the CPU lacks falls back to the next narrower one (AVX-512, AVX2, SSE2).
+// Parameters:
+//   - requested: The requested instruction set.
+// Returns: The instruction set to use.
+//
+PacketIsa resolvePacketIsa(PacketIsa requested);
+
+//
+// Function: parsePacketIsa
+// Parses "auto", "scalar", "sse2", "avx2" or "avx512".
+// Parameters:
+//   - name: The name to parse.
+//   - isa: The parsed instruction set (output).
+// Returns: true on success, false for an unknown name.
+//
+bool parsePacketIsa(const char* name, PacketIsa& isa);
+
+//
+// Function: packetIsaName
+// Returns: The lower-case name of an instruction set.
+//
+const char* packetIsaName(PacketIsa isa);
+
+//
+// Function: packetWidth
+// Returns: The number of rays per packet (1 for SCALAR).
+//
+int packetWidth(PacketIsa isa);
+
+//
+// Struct: RayArrays
+// Rays stored as one array per component (structure of arrays), as in the ray queues of
+// the wavefront tracer. Packets load their lanes from these arrays directly.
+//
+struct RayArrays {
+    const Real* originX;
+    const Real* originY;
+    const Real* originZ;
+    const Real* directionX;
+    const Real* directionY;
+    const Real* directionZ;
+};
+
+//
+// Function: intersectPackets
+// Finds the closest hit of every ray, tracing them through the BVH in packets of
+// packetWidth(isa) rays. Each packet visits a node if any of its rays overlaps it, and
+// tests each leaf primitive against all rays at once. The results are identical to
+// calling Scene::intersect on every ray. Rays should be coherent (e.g. camera rays of one
+// tile); incoherent rays are better traced one at a time.
+// Parameters:
+//   - scene: The built scene.
+//   - isa: The instruction set to use; must be supported (see resolvePacketIsa).
+//   - rays: The rays; directions must be normalized.
+//   - count: The number of rays.
+//   - t_min, t_max: The accepted distance interval (exclusive).
+//   - hits: The closest hit of each ray (output).
+//   - found: Whether each ray hit anything (output).
+//
+void intersectPackets(const Scene& scene, PacketIsa isa, const Ray* rays, int count,
+                      Real t_min, Real t_max, Hit* hits, bool* found);
+
+//
+// Function: intersectPackets
+// Finds the closest hit of every ray of a structure of arrays, like the overload above.
+//
+void intersectPackets(const Scene& scene, PacketIsa isa, const RayArrays& rays, int count,
+                      Real t_min, Real t_max, Hit* hits, bool* found);
+
+#endif // PACKETTRACER_H
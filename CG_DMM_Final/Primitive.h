@@ -0,0 +1,32 @@
+#ifndef PRIMITIVE_H
+#define PRIMITIVE_H
+
+//
+// Enum: PrimitiveType
+// Identifies which kind of primitive a reference points to.
+//
+enum class PrimitiveType {
+    SPHERE,    // Index into the sphere arrays.
+    TRIANGLE,  // Index into the triangle arrays.
+    MESH_TRIANGLE   // Index into the mesh triangle arrays.
+};
+
+//
+// Struct: PrimitiveRef
+// A reference to one sphere, triangle or mesh triangle of the scene.
+//
+struct PrimitiveRef {
+    PrimitiveType type;   // The kind of primitive.
+    int index;            // Its index in the packed geometry arrays, or -1 for no primitive.
+};
+
+//
+// Struct: Hit
+// The result of a closest-hit query.
+//
+struct Hit {
+    Real t;                    // Distance along the ray to the hit point.
+    PrimitiveRef primitive;    // The primitive that was hit.
+};
+
+#endif // PRIMITIVE_H
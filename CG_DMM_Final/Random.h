@@ -0,0 +1,44 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <random>
+#include "Sampler.h"
+
+//
+// Per-thread random number generation for project-wide use
+// Every thread owns its own generator, so concurrent render threads never share state.
+// The renderer reseeds the generator at the start of each tile (see seedRandom), which
+// makes every tile's random sequence independent of the thread that renders it. With a
+// sampler other than RANDOM, the renderer instead points threadSampler at each pixel
+// sample in turn, and randDouble reads the sample's next dimension (see Sampler).
+//
+inline thread_local std::mt19937 rng;                                       // Random number generator
+inline thread_local std::uniform_real_distribution<double> dist(0.0, 1.0);  // Uniform distribution
+inline thread_local Sampler threadSampler;                                  // The current pixel sample's sampler
+
+//
+// Function: randDouble
+// Generates a random double in the range [0.0, 1.0).
+// Returns: A random double.
+//
+inline double randDouble() {
+    if (threadSampler.type() == SamplerType::RANDOM) return dist(rng);
+    return threadSampler.next();
+}
+
+//
+// Function: seedRandom
+// Restarts the calling thread's random sequence from the given seed, and makes randDouble
+// draw from it again.
+// Parameters:
+//   - seed: The 64-bit seed.
+//
+inline void seedRandom(uint64_t seed) {
+    std::seed_seq sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    rng.seed(sequence);
+    dist.reset();
+    threadSampler = Sampler();
+}
+
+#endif // RANDOM_H
@@ -8,7 +8,8 @@
 //   - origin: The starting point of the ray.
 //   - direction: The direction in which the ray points.
 //
-Ray::Ray(const Vector3D& origin, const Vector3D& direction)
+template <typename T>
+RayT<T>::RayT(const Vector3T<T>& origin, const Vector3T<T>& direction)
     : origin(origin),                     // Set the ray's origin.
       direction(direction.normalize()) {} // Normalize and set the ray's direction.
 
@@ -16,12 +17,18 @@ Ray::Ray(const Vector3D& origin, const Vector3D& direction)
 // Default Constructor: Ray
 // Initializes a ray with the origin at (0, 0, 0) and the direction pointing along the positive Z-axis.
 //
-Ray::Ray() 
-    : origin(Vector3D()),                 // Set the origin to (0, 0, 0).
-      direction(Vector3D(0, 0, 1)) {}     // Set the direction to (0, 0, 1).
+template <typename T>
+RayT<T>::RayT()
+    : origin(Vector3T<T>()),              // Set the origin to (0, 0, 0).
+      direction(Vector3T<T>(0, 0, 1)) {}  // Set the direction to (0, 0, 1).
 
 //
 // Destructor: ~Ray
 // Default destructor for the Ray class.
 //
-Ray::~Ray() {}
\ No newline at end of file
+template <typename T>
+RayT<T>::~RayT() {}
+
+// Both precisions are compiled here, whichever one Real selects
+template class RayT<float>;
+template class RayT<double>;
@@ -4,13 +4,15 @@
 #include "Vector3D.h"
 
 //
-// Class: Ray
+// Class: RayT
 // Represents a ray in 3D space, defined by an origin point and a direction vector.
+// T is the scalar type; Ray is the renderer's Real ray (see Real.h).
 //
-class Ray {
+template <typename T>
+class RayT {
 public:
-    Vector3D origin;     // The starting point of the ray.
-    Vector3D direction;  // The direction of the ray (normalized).
+    Vector3T<T> origin;     // The starting point of the ray.
+    Vector3T<T> direction;  // The direction of the ray (normalized).
 
     //
     // Constructor: Ray
@@ -20,19 +22,24 @@ public:
     //   - origin: The starting point of the ray.
     //   - direction: The direction of the ray.
     //
-    Ray(const Vector3D& origin, const Vector3D& direction);
+    RayT(const Vector3T<T>& origin, const Vector3T<T>& direction);
 
     //
     // Default Constructor: Ray
     // Initializes a ray with the origin at (0, 0, 0) and the direction pointing along the positive Z-axis.
     //
-    Ray();
+    RayT();
 
     //
     // Destructor: ~Ray
     // Default destructor for the Ray class.
     //
-    ~Ray();
+    ~RayT();
 };
 
-#endif // RAY_H
\ No newline at end of file
+extern template class RayT<float>;
+extern template class RayT<double>;
+
+typedef RayT<Real> Ray;
+
+#endif // RAY_H
@@ -0,0 +1,138 @@
+#include "RaySort.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const int MORTON_BITS = 10;                       // Bits per axis of the origin's Morton code.
+const int RADIX_BITS = 11;                        // Bits per radix sort pass.
+const int RADIX_BUCKETS = 1 << RADIX_BITS;
+
+//
+// Function: octant
+// Returns: The direction octant of a ray (the signs of its direction components), 0 to 7.
+//
+inline uint64_t octant(Real x, Real y, Real z) {
+    return (x < 0 ? 1 : 0) | (y < 0 ? 2 : 0) | (z < 0 ? 4 : 0);
+}
+
+//
+// Function: spreadBits
+// Returns: The low 10 bits of a value spread out to every third bit.
+//
+inline uint64_t spreadBits(uint64_t v) {
+    v = (v | (v << 16)) & 0x030000FFULL;
+    v = (v | (v << 8)) & 0x0300F00FULL;
+    v = (v | (v << 4)) & 0x030C30C3ULL;
+    v = (v | (v << 2)) & 0x09249249ULL;
+    return v;
+}
+
+//
+// Function: quantize
+// Returns: A coordinate mapped from [low, low + 1 / scale] to an integer in [0, 2^MORTON_BITS).
+//
+inline uint64_t quantize(Real value, Real low, Real scale) {
+    Real cell = (value - low) * scale;
+    const Real maxCell = (1 << MORTON_BITS) - 1;
+    return static_cast<uint64_t>(std::min(maxCell, std::max(Real(0), cell)));
+}
+
+} // namespace
+
+//
+// Function: parseRayOrder
+// Parses "none", "octant" or "morton".
+// Parameters:
+//   - name: The name to parse.
+//   - order: The parsed order (output).
+// Returns: true on success, false for an unknown name.
+//
+bool parseRayOrder(const char* name, RayOrder& order) {
+    const RayOrder all[] = {RayOrder::NONE, RayOrder::OCTANT, RayOrder::MORTON};
+    for (RayOrder candidate : all) {
+        if (std::strcmp(name, rayOrderName(candidate)) == 0) {
+            order = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// Function: rayOrderName
+// Returns: The lower-case name of a ray order.
+//
+const char* rayOrderName(RayOrder order) {
+    switch (order) {
+        case RayOrder::NONE: return "none";
+        case RayOrder::OCTANT: return "octant";
+        case RayOrder::MORTON: return "morton";
+    }
+    return "unknown";
+}
+
+//
+// Method: sort
+// Computes the order in which to trace a batch of rays.
+// Parameters:
+//   - order: The ordering to use.
+//   - rays: The rays.
+//   - count: The number of rays.
+//   - permutation: The index of the ray to trace at each position (output).
+//
+void RaySorter::sort(RayOrder order, const RayArrays& rays, int count, std::vector<int>& permutation) {
+    permutation.resize(count);
+    for (int i = 0; i < count; i++) permutation[i] = i;
+    if (order == RayOrder::NONE || count < 2) return;
+
+    keys.resize(count);
+    int keyBits = 3;
+    if (order == RayOrder::OCTANT) {
+        for (int i = 0; i < count; i++) {
+            keys[i] = octant(rays.directionX[i], rays.directionY[i], rays.directionZ[i]);
+        }
+    } else {
+        // Quantize the origins within the bounds of the batch
+        Real low[3] = {rays.originX[0], rays.originY[0], rays.originZ[0]};
+        Real high[3] = {low[0], low[1], low[2]};
+        const Real* origin[3] = {rays.originX, rays.originY, rays.originZ};
+        for (int axis = 0; axis < 3; axis++) {
+            for (int i = 1; i < count; i++) {
+                low[axis] = std::min(low[axis], origin[axis][i]);
+                high[axis] = std::max(high[axis], origin[axis][i]);
+            }
+        }
+        Real scale[3];
+        for (int axis = 0; axis < 3; axis++) {
+            Real extent = high[axis] - low[axis];
+            scale[axis] = extent > 0 ? ((1 << MORTON_BITS) - 1) / extent : 0;
+        }
+
+        for (int i = 0; i < count; i++) {
+            uint64_t morton = spreadBits(quantize(rays.originX[i], low[0], scale[0])) |
+                              (spreadBits(quantize(rays.originY[i], low[1], scale[1])) << 1) |
+                              (spreadBits(quantize(rays.originZ[i], low[2], scale[2])) << 2);
+            keys[i] = (octant(rays.directionX[i], rays.directionY[i], rays.directionZ[i]) << (3 * MORTON_BITS)) |
+                      morton;
+        }
+        keyBits += 3 * MORTON_BITS;
+    }
+
+    // Stable LSD radix sort of the keys, carrying the permutation along
+    scratchKeys.resize(count);
+    scratchIndices.resize(count);
+    std::vector<int> bucketStart(RADIX_BUCKETS + 1);
+    for (int shift = 0; shift < keyBits; shift += RADIX_BITS) {
+        std::fill(bucketStart.begin(), bucketStart.end(), 0);
+        for (int i = 0; i < count; i++) bucketStart[((keys[i] >> shift) & (RADIX_BUCKETS - 1)) + 1]++;
+        for (int b = 1; b <= RADIX_BUCKETS; b++) bucketStart[b] += bucketStart[b - 1];
+        for (int i = 0; i < count; i++) {
+            int position = bucketStart[(keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+            scratchKeys[position] = keys[i];
+            scratchIndices[position] = permutation[i];
+        }
+        keys.swap(scratchKeys);
+        permutation.swap(scratchIndices);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef RAYSORT_H
+#define RAYSORT_H
+
+#include <cstdint>
+#include <vector>
+#include "PacketTracer.h"
+
+//
+// Enum: RayOrder
+// The order in which a batch of secondary rays is traced.
+//
+enum class RayOrder {
+    NONE,     // The order the rays were spawned in.
+    OCTANT,   // Grouped by the signs of their direction components.
+    MORTON    // By direction octant, then by the Morton code of their origin.
+};
+
+//
+// Function: parseRayOrder
+// Parses "none", "octant" or "morton".
+// Parameters:
+//   - name: The name to parse.
+//   - order: The parsed order (output).
+// Returns: true on success, false for an unknown name.
+//
+bool parseRayOrder(const char* name, RayOrder& order);
+
+//
+// Function: rayOrderName
+// Returns: The lower-case name of a ray order.
+//
+const char* rayOrderName(RayOrder order);
+
+//
+// Class: RaySorter
+// Orders batches of rays so that rays traced one after another start close together and
+// travel the same way, and therefore visit the same BVH nodes and primitives while they
+// are still in cache. The key of a ray is its direction octant (3 bits) above the Morton
+// code of its origin, quantized to 10 bits per axis within the bounds of the batch's
+// origins. Keys are sorted with a stable LSD radix sort of 11-bit digits.
+//
+// A sorter keeps its buffers between calls; use one per thread.
+//
+class RaySorter {
+public:
+    //
+    // Method: sort
+    // Computes the order in which to trace a batch of rays.
+    // Parameters:
+    //   - order: The ordering to use.
+    //   - rays: The rays.
+    //   - count: The number of rays.
+    //   - permutation: The index of the ray to trace at each position (output).
+    //
+    void sort(RayOrder order, const RayArrays& rays, int count, std::vector<int>& permutation);
+
+private:
+    std::vector<uint64_t> keys, scratchKeys;   // Sort keys, in and out of a radix pass.
+    std::vector<int> scratchIndices;           // Permutation out of a radix pass.
+};
+
+#endif // RAYSORT_H
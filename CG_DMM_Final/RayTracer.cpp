@@ -4,14 +4,9 @@
 #include <limits>
 #include <iostream>
 
-std::vector<Sphere> spheres;
-std::vector<Triangle> triangles;
-std::vector<Light> lights;
-Color backgroundColor(0.2, 0.3, 0.5); // Soft blue background
-
-void setupScene() {
+void setupScene(Scene& scene) {
     // Add spheres with enhanced SSS parameters
-    spheres.push_back(Sphere(
+    scene.spheres.push_back(Sphere(
         Vector3D(0, -1, 3),
         1,
         Color(1, 0.5, 0.5), // Light reddish color
@@ -21,7 +16,7 @@ void setupScene() {
         0.5  // Lower scatteringCoefficient for stronger effect
     ));
 
-    spheres.push_back(Sphere(
+    scene.spheres.push_back(Sphere(
         Vector3D(2, 0, 4),
         1,
         Color(0.5, 0.5, 1), // Light bluish color
@@ -31,7 +26,7 @@ void setupScene() {
         0.3  // Reduced scatteringCoefficient
     ));
 
-    spheres.push_back(Sphere(
+    scene.spheres.push_back(Sphere(
         Vector3D(-2, 0, 4),
         1,
         Color(0.5, 1, 0.5), // Light greenish color
@@ -42,7 +37,7 @@ void setupScene() {
     ));
 
     // Ground plane (large sphere)
-    spheres.push_back(Sphere(
+    scene.spheres.push_back(Sphere(
         Vector3D(0, -5002, 0), // Lower ground plane for better contrast
         5000,
         Color(1.0, 0.9, 0.6), // Bright yellow base
@@ -52,7 +47,7 @@ void setupScene() {
     ));
 
     // Add triangle with magenta color and reflectivity
-    triangles.push_back(Triangle(
+    scene.triangles.push_back(Triangle(
         Vector3D(0, 0, 2),
         Vector3D(1, 2, 2),
         Vector3D(-1, 2, 2),
@@ -64,193 +59,364 @@ void setupScene() {
     ));
 
     // Lights
-    lights.push_back(Light(0.3)); // Ambient light (reduced intensity for subtle effect)
-    lights.push_back(Light(0.8, Vector3D(-4, 3, 3), 1.0)); // Stronger point light from the side
-    lights.push_back(Light(Vector3D(1, 4, 4), 0.5)); // Directional light
-    lights.push_back(Light(1.0, Vector3D(0, 1.5, -2), 0.5)); // Backlight for enhanced translucency
+    scene.lights.push_back(Light(0.3)); // Ambient light (reduced intensity for subtle effect)
+    scene.lights.push_back(Light(0.8, Vector3D(-4, 3, 3), 1.0)); // Stronger point light from the side
+    scene.lights.push_back(Light(Vector3D(1, 4, 4), 0.5)); // Directional light
+    scene.lights.push_back(Light(1.0, Vector3D(0, 1.5, -2), 0.5)); // Backlight for enhanced translucency
 }
 
-Color computeLighting(const Vector3D& point, const Vector3D& normal, const Vector3D& view, double specular) {
-    Color result(0, 0, 0);
-    const int numSamples = 128; // High for soft shadows
+int shadowSampleBudget(const Light& light, const Vector3D& point) {
+    const int maxSamples = 128;            // Budget for lights covering a large solid angle
+    const int minSamples = 16;             // Smallest budget for an area light
+    const Real samplesPerSteradian = 512.0;
 
-    for (const Light& light : lights) {
-        if (light.type == LightType::AMBIENT) {
-            result = result + Color(light.intensity, light.intensity, light.intensity);
-        } else {
-            Color sampleColor(0, 0, 0);
-
-            for (int i = 0; i < numSamples; i++) {
-                Vector3D lightSample = light.position;
-                if (light.radius > 0) {
-                    // Sample area light
-                    double r = light.radius * std::sqrt(randDouble());
-                    double theta = 2.0 * M_PI * randDouble();
-                    double x = r * std::cos(theta);
-                    double y = r * std::sin(theta);
-                    double z = 0.0;
-                    lightSample = light.position + Vector3D(x, y, z);
-                }
+    // Delta lights: every sample would trace the same shadow ray
+    if (light.type != LightType::POINT || light.radius <= 0) return 1;
 
-                Vector3D lightDir = (lightSample - point).normalize();
-                double t_max = (light.type == LightType::POINT) ? 1.0 : std::numeric_limits<double>::infinity();
+    // Solid angle of the light disk as seen from the point (disk facing the point)
+    Real distanceSquared = (light.position - point).lengthSquared();
+    Real solidAngle = 2.0 * M_PI * (1 - std::sqrt(distanceSquared / (distanceSquared + light.radius * light.radius)));
 
-                Vector3D shadowOrig = (lightDir.dot(normal) < 0) ? point - normal * 1e-5 : point + normal * 1e-5;
-                Ray shadowRay(shadowOrig, lightDir);
+    int samples = static_cast<int>(std::ceil(solidAngle * samplesPerSteradian));
+    return std::min(maxSamples, std::max(minSamples, samples));
+}
 
-                bool inShadow = false;
-                for (const Sphere& sphere : spheres) {
-                    double t;
-                    if (sphere.intersect(shadowRay, t) && t > 0 && t < t_max) {
-                        inShadow = true;
-                        break;
-                    }
-                }
+Vector3D sampleLightPoint(const Light& light) {
+    Vector3D lightSample = light.position;
+    if (light.radius > 0) {
+        // Sample area light
+        Real r = light.radius * std::sqrt(randDouble());
+        Real theta = 2.0 * M_PI * randDouble();
+        Real x = r * std::cos(theta);
+        Real y = r * std::sin(theta);
+        Real z = 0.0;
+        lightSample = light.position + Vector3D(x, y, z);
+    }
+    return lightSample;
+}
 
-                if (!inShadow) {
-                    for (const Triangle& triangle : triangles) {
-                        double t;
-                        if (triangle.intersect(shadowRay, t) && t > 0 && t < t_max) {
-                            inShadow = true;
-                            break;
-                        }
-                    }
-                }
+Real shadowRayLength(const Light& light) {
+    return (light.type == LightType::POINT) ? 1.0 : std::numeric_limits<Real>::infinity();
+}
 
-                if (inShadow) continue;
+void addLightSample(Color& color, const Light& light, const Vector3D& lightDir,
+                    const Vector3D& normal, const Vector3D& view, Real specular) {
+    Real n_dot_l = normal.dot(lightDir);
+    if (n_dot_l > 0) {
+        Real diffuseIntensity = light.intensity * n_dot_l;
+        color = color + Color(diffuseIntensity, diffuseIntensity, diffuseIntensity) * 0.8;
+    }
 
-                double n_dot_l = normal.dot(lightDir);
-                if (n_dot_l > 0) {
-                    double diffuseIntensity = light.intensity * n_dot_l;
-                    sampleColor = sampleColor + Color(diffuseIntensity, diffuseIntensity, diffuseIntensity) * 0.8;
-                }
+    if (specular >= 0) {
+        Vector3D reflectDir = 2 * normal * normal.dot(lightDir) - lightDir;
+        Real r_dot_v = reflectDir.dot(view);
+        if (r_dot_v > 0) {
+            Real specularIntensity = light.intensity * std::pow(r_dot_v, specular);
+            color = color + Color(specularIntensity, specularIntensity, specularIntensity) * 0.5;
+        }
+    }
+}
 
-                if (specular >= 0) {
-                    Vector3D reflectDir = 2 * normal * normal.dot(lightDir) - lightDir;
-                    double r_dot_v = reflectDir.dot(view);
-                    if (r_dot_v > 0) {
-                        double specularIntensity = light.intensity * std::pow(r_dot_v, specular);
-                        sampleColor = sampleColor + Color(specularIntensity, specularIntensity, specularIntensity) * 0.5;
-                    }
-                }
-            }
+//
+// Function: lightContribution
+// Samples the shadow rays of one non-ambient light, up to its shadowSampleBudget(), and
+// returns the averaged light of the unoccluded samples. Without AreaLights, the light must
+// be a delta light and gets its single shadow ray directly.
+//
+template <bool AreaLights>
+static Color lightContribution(const Scene& scene, const Light& light, PrimitiveRef& lastOccluder,
+                               const Vector3D& point, const Vector3D& normal, const Vector3D& view,
+                               Real specular, Real offset) {
+    const int convergenceBatch = 8; // Area lights stop after this many samples if all agree on visibility
+    Color sampleColor(0, 0, 0);
+    int numSamples = AreaLights ? shadowSampleBudget(light, point) : 1;
+    int samplesTaken = 0;
+    int litSamples = 0;
+
+    for (int i = 0; i < numSamples; i++) {
+        // A fully lit or fully shadowed first batch means the point is outside the penumbra
+        if (AreaLights && i == convergenceBatch && (litSamples == 0 || litSamples == samplesTaken)) break;
+        samplesTaken++;
+
+        Vector3D lightDir = ((AreaLights ? sampleLightPoint(light) : light.position) - point).normalize();
+        Real t_max = shadowRayLength(light);
+
+        Vector3D shadowOrig = normal.multiplyAdd((lightDir.dot(normal) < 0) ? -offset : offset, point);
+        Ray shadowRay(shadowOrig, lightDir);
+        bool inShadow = scene.occluded(shadowRay, t_max, lastOccluder);
+        STATS_RAYS(RayType::SHADOW, 1);
+        STATS_HITS(RayType::SHADOW, inShadow);
+
+        if (inShadow) continue;
+        litSamples++;
+
+        addLightSample(sampleColor, light, lightDir, normal, view, specular);
+    }
+
+    return AreaLights ? sampleColor * (1.0 / samplesTaken) : sampleColor;
+}
+
+Real branchSurvival(const Scene& scene, Real throughput) {
+    const Color& background = scene.backgroundColor;
+    Real brightest = std::max(std::max(static_cast<Real>(1), background.r), std::max(background.g, background.b));
+    if (throughput * brightest < scene.cullThroughput) {
+        STATS_ADD(culledBranches, 1);
+        return 0;
+    }
+    return throughput < scene.rouletteThroughput ? throughput / scene.rouletteThroughput : 1;
+}
 
-            result = result + (sampleColor * (1.0 / numSamples));
+//
+// Function: lighting
+// computeLighting, with the area light sampling compiled in only if AreaLights is set.
+//
+template <bool AreaLights>
+static Color lighting(const Scene& scene, const Vector3D& point, const Vector3D& normal, const Vector3D& view,
+                      Real specular) {
+    STATS_STAGE(LIGHTING);
+    Color result(0, 0, 0);
+
+    // Last blocker of each light, kept per thread across shading points
+    thread_local std::vector<PrimitiveRef> lastOccluders;
+    if (lastOccluders.size() < scene.lights.size()) {
+        lastOccluders.resize(scene.lights.size(), PrimitiveRef{PrimitiveType::SPHERE, -1});
+    }
+
+    // With light sampling, point lights are picked from the light tree below
+    bool sampleLights = scene.lightSamples > 0 && !scene.lightTree.empty();
+    Real offset = scene.rayOffset();
+    for (size_t lightIndex = 0; lightIndex < scene.lights.size(); lightIndex++) {
+        const Light& light = scene.lights[lightIndex];
+        if (light.type == LightType::AMBIENT) {
+            result = result + Color(light.intensity, light.intensity, light.intensity);
+        } else if (!sampleLights || light.type != LightType::POINT) {
+            result = result + lightContribution<AreaLights>(scene, light, lastOccluders[lightIndex], point, normal,
+                                                            view, specular, offset);
+        }
+    }
+
+    if (sampleLights) {
+        for (int i = 0; i < scene.lightSamples; i++) {
+            Real probability;
+            int lightIndex = scene.lightTree.sample(point, normal, view, specular, probability);
+            if (lightIndex < 0) break;   // No point light can reach the point
+            STATS_ADD(lightTreeSamples, 1);
+            Color contribution = lightContribution<AreaLights>(scene, scene.lights[lightIndex],
+                                                               lastOccluders[lightIndex], point, normal, view,
+                                                               specular, offset);
+            result = result + contribution * (1.0 / (scene.lightSamples * probability));
         }
     }
 
     return result;
 }
 
-Color TraceRay(const Ray& ray, double t_min, double t_max, int depth) {
-    if (depth <= 0) return Color(0, 0, 0);
-
-    double closest_t = std::numeric_limits<double>::infinity();
-    const Sphere* closest_sphere = nullptr;
-    const Triangle* closest_triangle = nullptr;
+Color computeLighting(const Scene& scene, const Vector3D& point, const Vector3D& normal, const Vector3D& view, Real specular) {
+    return lighting<true>(scene, point, normal, view, specular);
+}
 
-    for (const Sphere& sphere : spheres) {
-        double t;
-        if (sphere.intersect(ray, t) && t > t_min && t < t_max && t < closest_t) {
-            closest_t = t;
-            closest_sphere = &sphere;
-            closest_triangle = nullptr;
-        }
+namespace {
+
+//
+// Constant: DYNAMIC_DEPTH
+// The Depth of a ShadingKernel whose recursion depth is only known at run time.
+//
+constexpr int DYNAMIC_DEPTH = -1;
+
+//
+// Struct: ShadingKernel
+// TraceRay and shadeSurface for one feature set and recursion depth. Features (a set of
+// ShadingFeature bits) says which optional parts are compiled in: without a bit, its
+// material and light tests and its code are left out entirely. Depth is the remaining
+// recursion depth, so the tests for the last level are resolved at compile time and each
+// level calls the next one's kernel; with DYNAMIC_DEPTH it is the run-time `depth`.
+// ShadingKernel<SHADE_ALL, DYNAMIC_DEPTH> is the generic shader behind TraceRay.
+//
+template <unsigned Features, int Depth>
+struct ShadingKernel {
+    using Next = ShadingKernel<Features, Depth == DYNAMIC_DEPTH ? DYNAMIC_DEPTH : Depth - 1>;
+
+    static Color trace(const Scene& scene, const Ray& ray, Real t_min, Real t_max, int depth, RayType type,
+                       Real throughput) {
+        if (Depth == DYNAMIC_DEPTH && depth <= 0) return Color(0, 0, 0);
+
+        Hit hit;
+        STATS_RAYS(type, 1);
+        if (!scene.intersect(ray, t_min, t_max, hit)) return scene.backgroundColor;
+        STATS_HITS(type, 1);
+
+        Vector3D point = ray.direction.multiplyAdd(hit.t, ray.origin);
+        Vector3D normal = scene.geometry.normal(hit.primitive, point);
+        return shade(scene, point, normal, ray.direction, scene.material(hit.primitive), t_max, depth, throughput);
     }
 
-    for (const Triangle& triangle : triangles) {
-        double t;
-        if (triangle.intersect(ray, t) && t > t_min && t < t_max && t < closest_t) {
-            closest_t = t;
-            closest_triangle = &triangle;
-            closest_sphere = nullptr;
+    static Color shade(const Scene& scene, const Vector3D& point, const Vector3D& normal,
+                       const Vector3D& direction, const Material& material, Real t_max, int depth,
+                       Real throughput) {
+        const int level = Depth == DYNAMIC_DEPTH ? depth : Depth;
+        const Color& objectColor = material.color;
+        Real specular = material.specular;
+
+        Color localLighting = lighting<(Features & SHADE_AREA_LIGHTS) != 0>(scene, point, normal, -direction, specular);
+        Color localColor = objectColor * localLighting;
+
+        Color reflectionColor(0, 0, 0);
+        Color indirectColor(0, 0, 0);
+        if constexpr (Depth == DYNAMIC_DEPTH || Depth > 1) {
+            // Reflection; at the last level it would return black
+            Real reflective = material.reflective;
+            if ((Features & SHADE_REFLECTION) && reflective > 0 && level > 1) {
+                Real survival = branchSurvival(scene, throughput * reflective);
+                if (survival >= 1 || (survival > 0 && randDouble() > 1 - survival)) {
+                    Vector3D reflectDir = direction - normal * 2 * direction.dot(normal);
+                    Ray reflectRay(normal.multiplyAdd(scene.rayOffset(), point), reflectDir);
+                    Real weight = reflective / survival;
+                    reflectionColor = Next::trace(scene, reflectRay, 0.001, t_max, level - 1, RayType::REFLECTION,
+                                                  throughput * weight) * weight;
+                } else if (survival > 0) {
+                    STATS_ADD(rouletteTerminations, 1);
+                }
+            }
+
+            // Indirect lighting (simple diffuse)
+            if (level > 1) {
+                Real survival = branchSurvival(scene, throughput * INDIRECT_WEIGHT);
+                if ((Features & SHADE_INDIRECT_CACHE) && survival > 0 && scene.indirectCache) {
+                    // The cache holds the mean color of the indirect ray, so it gets the ray's expected weight
+                    indirectColor = scene.indirectCache->lookup(scene, point, normal, t_max, level) * INDIRECT_WEIGHT;
+                } else if (survival >= 1 || (survival > 0 && randDouble() > 1 - survival)) {
+                    Vector3D randomDir = normal.randomHemisphere();
+                    Ray indirectRay(normal.multiplyAdd(scene.rayOffset(), point), randomDir);
+                    Real weight = INDIRECT_WEIGHT / survival;
+                    indirectColor = Next::trace(scene, indirectRay, 0.001, t_max, level - 1, RayType::INDIRECT,
+                                                throughput * weight) * weight;
+                } else if (survival > 0) {
+                    STATS_ADD(rouletteTerminations, 1);
+                }
+            }
         }
+
+        // Approximate Subsurface Scattering
+        if (Features & SHADE_SSS) localColor = addSubsurfaceScattering(scene, point, normal, material, localColor);
+
+        Color finalColor = localColor + reflectionColor + indirectColor;
+        finalColor.clamp();
+        return finalColor;
     }
+};
+
+using GenericKernel = ShadingKernel<SHADE_ALL, DYNAMIC_DEPTH>;
+
+//
+// Function: selectDepth
+// Returns: The shader of a feature set for a maximum depth, or its DYNAMIC_DEPTH shader
+//          for depths beyond MAX_SPECIALIZED_DEPTH.
+//
+template <unsigned Features, int Depth = MAX_SPECIALIZED_DEPTH>
+SurfaceShader selectDepth(int maxDepth) {
+    if constexpr (Depth == 0) {
+        return &ShadingKernel<Features, DYNAMIC_DEPTH>::shade;
+    } else {
+        return maxDepth == Depth ? &ShadingKernel<Features, Depth>::shade : selectDepth<Features, Depth - 1>(maxDepth);
+    }
+}
 
-    if (!closest_sphere && !closest_triangle) return backgroundColor;
-
-    Vector3D point = ray.origin + ray.direction * closest_t;
-    Vector3D normal;
-    Color objectColor;
-    double specular;
-    double reflective;
-    double sssRadius;
-    double sssScatter;
-
-    if (closest_sphere) {
-        normal = closest_sphere->getNormal(point);
-        objectColor = closest_sphere->color;
-        specular = closest_sphere->specular;
-        reflective = closest_sphere->reflective;
-        sssRadius = closest_sphere->subsurfaceRadius;
-        sssScatter = closest_sphere->scatteringCoefficient;
+//
+// Function: selectFeatures
+// Returns: The shader of a feature set for a maximum depth, found by counting down from
+//          the feature set Features.
+//
+template <unsigned Features = SHADE_ALL>
+SurfaceShader selectFeatures(unsigned features, int maxDepth) {
+    if constexpr (Features == 0) {
+        return selectDepth<0>(maxDepth);
     } else {
-        normal = closest_triangle->getNormal();
-        objectColor = closest_triangle->color;
-        specular = closest_triangle->specular;
-        reflective = closest_triangle->reflective;
-        sssRadius = closest_triangle->subsurfaceRadius;
-        sssScatter = closest_triangle->scatteringCoefficient;
+        return features == Features ? selectDepth<Features>(maxDepth) : selectFeatures<Features - 1>(features, maxDepth);
     }
+}
 
-    Color localLighting = computeLighting(point, normal, -ray.direction, specular);
-    Color localColor = objectColor * localLighting;
+} // namespace
 
-    // Reflection
-    Color reflectionColor(0, 0, 0);
-    if (reflective > 0) {
-        Vector3D reflectDir = ray.direction - normal * 2 * ray.direction.dot(normal);
-        Ray reflectRay(point + normal * 1e-5, reflectDir);
-        reflectionColor = TraceRay(reflectRay, 0.001, t_max, depth - 1) * reflective;
-    }
+Color TraceRay(const Scene& scene, const Ray& ray, Real t_min, Real t_max, int depth, RayType type, Real throughput) {
+    return GenericKernel::trace(scene, ray, t_min, t_max, depth, type, throughput);
+}
 
-    // Indirect lighting (simple diffuse)
-    Color indirectColor(0, 0, 0);
-    if (depth > 1) {
-        double terminationProbability = 0.2; // Russian roulette
-        if (randDouble() > terminationProbability) {
-            Vector3D randomDir = normal.randomHemisphere();
-            Ray indirectRay(point + normal * 1e-5, randomDir);
-            indirectColor = TraceRay(indirectRay, 0.001, t_max, depth - 1) * 0.1;
-        }
+Color shadeHit(const Scene& scene, const Ray& ray, const Hit& hit, Real t_max, int depth, Real throughput) {
+    Vector3D point = ray.direction.multiplyAdd(hit.t, ray.origin);
+    Vector3D normal = scene.geometry.normal(hit.primitive, point);
+    return GenericKernel::shade(scene, point, normal, ray.direction, scene.material(hit.primitive), t_max, depth,
+                                throughput);
+}
+
+Color shadeSurface(const Scene& scene, const Vector3D& point, const Vector3D& normal,
+                   const Vector3D& direction, const Material& material, Real t_max, int depth,
+                   Real throughput) {
+    return GenericKernel::shade(scene, point, normal, direction, material, t_max, depth, throughput);
+}
+
+unsigned shadingFeatures(const Scene& scene) {
+    unsigned features = 0;
+    for (size_t i = 0; i < scene.materials.size(); i++) {
+        const Material& material = scene.materials[i];
+        if (material.reflective > 0) features |= SHADE_REFLECTION;
+        if (material.subsurfaceRadius > 0 && material.scatteringCoefficient > 0) features |= SHADE_SSS;
     }
+    for (const Light& light : scene.lights) {
+        if (light.type != LightType::AMBIENT && light.radius > 0) features |= SHADE_AREA_LIGHTS;
+    }
+    if (scene.indirectCache) features |= SHADE_INDIRECT_CACHE;
+    return features;
+}
 
-    // Approximate Subsurface Scattering
-    if (sssRadius > 0.0 && sssScatter > 0.0) {
-        const int sssSamples = 16;
-        Color sssAccum(0,0,0);
-        double totalWeight = 0.0;
-
-        Vector3D N = normal;
-        Vector3D helper = (std::fabs(N.x) > 0.1) ? Vector3D(0,1,0) : Vector3D(1,0,0);
-        Vector3D T = helper.cross(N).normalize();
-        Vector3D B = N.cross(T);
-
-        for (int i = 0; i < sssSamples; i++) {
-            double r = sssRadius * std::sqrt(randDouble());
-            double theta = 2.0 * M_PI * randDouble();
-            double dx = r * std::cos(theta);
-            double dy = r * std::sin(theta);
-
-            Vector3D offsetPoint = point + T * dx + B * dy;
-            Ray probeRay(offsetPoint + N*1e-5, N);
-            // Compute simple local lighting at offset
-            Color probeLight = computeLighting(offsetPoint, N, -probeRay.direction, specular) * objectColor;
-
-            double dist = (offsetPoint - point).length();
-            double weight = std::exp(-dist / (sssScatter * sssRadius));
-            sssAccum = sssAccum + probeLight * weight;
-            totalWeight += weight;
-        }
+SurfaceShader selectSurfaceShader(const Scene& scene, int maxDepth) {
+    return selectFeatures(shadingFeatures(scene), maxDepth);
+}
 
-        if (totalWeight > 0.0) {
-            Color sssResult = sssAccum * (1.0 / totalWeight);
-            double blendFactor = 0.5; // Adjust how much SSS affects the final color
-            localColor = localColor * (1.0 - blendFactor) + sssResult * blendFactor;
+Color addSubsurfaceScattering(const Scene& scene, const Vector3D& point, const Vector3D& normal,
+                              const Material& material, Color localColor) {
+    const Color& objectColor = material.color;
+    Real specular = material.specular;
+    Real sssRadius = material.subsurfaceRadius;
+    Real sssScatter = material.scatteringCoefficient;
+    if (sssRadius <= 0.0 || sssScatter <= 0.0) return localColor;
+
+    STATS_STAGE(SSS);
+    const int sssSamples = 16;
+    STATS_RAYS(RayType::SSS_PROBE, sssSamples);
+    Color sssAccum(0,0,0);
+    Real totalWeight = 0.0;
+
+    Vector3D N = normal;
+    Vector3D helper = (std::fabs(N.x) > 0.1) ? Vector3D(0,1,0) : Vector3D(1,0,0);
+    Vector3D T = helper.cross(N).normalize();
+    Vector3D B = N.cross(T);
+
+    for (int i = 0; i < sssSamples; i++) {
+        Real r = sssRadius * std::sqrt(randDouble());
+        Real theta = 2.0 * M_PI * randDouble();
+        Real dx = r * std::cos(theta);
+        Real dy = r * std::sin(theta);
+
+        Vector3D offsetPoint = point + T * dx + B * dy;
+        Ray probeRay(offsetPoint + N*scene.rayOffset(), N);
+        // Compute simple local lighting at offset, with shadows from the irradiance grid
+        Color probeLight;
+        if (!scene.irradiance.lighting(scene, offsetPoint, N, -probeRay.direction, specular, probeLight)) {
+            probeLight = computeLighting(scene, offsetPoint, N, -probeRay.direction, specular);
+            STATS_ADD(irradianceFallbacks, 1);
         }
+        probeLight = probeLight * objectColor;
+
+        Real dist = (offsetPoint - point).length();
+        Real weight = std::exp(-dist / (sssScatter * sssRadius));
+        sssAccum = sssAccum + probeLight * weight;
+        totalWeight += weight;
     }
 
-    Color finalColor = localColor + reflectionColor + indirectColor;
-    finalColor.clamp();
-    return finalColor;
-}
\ No newline at end of file
+    if (totalWeight > 0.0) {
+        Color sssResult = sssAccum * (1 / totalWeight);
+        Real blendFactor = 0.5; // Adjust how much SSS affects the final color
+        localColor = localColor * (1 - blendFactor) + sssResult * blendFactor;
+    }
+    return localColor;
+}
@@ -1,65 +1,225 @@
 #ifndef RAYTRACER_H
 #define RAYTRACER_H
 
-#include <vector>
-#include <random>
+#include "Random.h"
 #include "Vector3D.h"
 #include "Color.h"
 #include "Ray.h"
 #include "Sphere.h"
 #include "Triangle.h"
 #include "Light.h"
+#include "Scene.h"
+#include "RenderStats.h"
 
 //
-// Inline random number generation for project-wide use
-// Provides random doubles in the range [0.0, 1.0].
+// Function: setupScene
+// Configures the scene by adding objects and lights.
+// Parameters:
+//   - scene: The scene to fill.
 //
-inline static std::mt19937 rng(std::random_device{}());                 // Random number generator
-inline static std::uniform_real_distribution<double> dist(0.0, 1.0);   // Uniform distribution
+void setupScene(Scene& scene);
 
 //
-// Function: randDouble
-// Generates a random double in the range [0.0, 1.0].
-// Returns: A random double.
+// Function: shadowSampleBudget
+// Chooses how many shadow samples a light gets at a shading point.
+// Delta lights (directional lights and point lights with radius 0) get a single sample,
+// since every sample would trace the same ray. Area lights get a budget proportional to
+// the solid angle their disk subtends at the point, between 16 and 128 samples.
+// Parameters:
+//   - light: A non-ambient light.
+//   - point: The 3D point being shaded.
+// Returns: The maximum number of shadow samples for the light.
 //
-inline double randDouble() {
-    return dist(rng);
-}
+int shadowSampleBudget(const Light& light, const Vector3D& point);
 
-// Global scene data
-extern std::vector<Sphere> spheres;       // List of spheres in the scene
-extern std::vector<Triangle> triangles;   // List of triangles in the scene
-extern std::vector<Light> lights;         // List of lights in the scene
-extern Color backgroundColor;             // Background color for the scene
+//
+// Function: sampleLightPoint
+// Picks the point a shadow sample aims at: the light position, or a uniformly random
+// point on the disk of an area light (consumes two random numbers).
+// Parameters:
+//   - light: A non-ambient light.
+// Returns: The sample point.
+//
+Vector3D sampleLightPoint(const Light& light);
 
 //
-// Function: setupScene
-// Configures the scene by adding objects and lights.
+// Function: shadowRayLength
+// Returns: The length of the shadow ray segment tested for a light.
 //
-void setupScene();
+Real shadowRayLength(const Light& light);
+
+//
+// Function: addLightSample
+// Adds the diffuse and specular contribution of one unoccluded light sample to a color.
+// Parameters:
+//   - color: The color to add to (input/output).
+//   - light: The light.
+//   - lightDir: The normalized direction from the point towards the light sample.
+//   - normal: The surface normal at the point.
+//   - view: The view direction.
+//   - specular: The specular exponent; negative disables the highlight.
+//
+void addLightSample(Color& color, const Light& light, const Vector3D& lightDir,
+                    const Vector3D& normal, const Vector3D& view, Real specular);
+
+//
+// Constant: INDIRECT_WEIGHT
+// The expected factor of the indirect ray's color in its parent's color: a weight of 0.1
+// behind a 20% Russian roulette at full path throughput (see branchSurvival).
+//
+constexpr Real INDIRECT_WEIGHT = 0.08;
+
+//
+// Function: branchSurvival
+// Decides how likely a child ray of a path is to be traced. Colors are clamped to 1 at
+// every hit, so a child can add at most its throughput (the path throughput times its
+// expected weight) times the brightest of 1 and the background to the pixel. Children
+// that could add less than Scene::cullThroughput are skipped; children whose throughput
+// is below Scene::rouletteThroughput play Russian roulette, surviving in proportion to
+// it. A traced child's color is divided by the probability, so its expected weight stays
+// the same.
+// Parameters:
+//   - scene: The scene with the thresholds.
+//   - throughput: The child's throughput.
+// Returns: The probability of tracing the child: 0 if it is culled, 1 if it is always traced.
+//
+Real branchSurvival(const Scene& scene, Real throughput);
 
 //
 // Function: computeLighting
 // Calculates the lighting at a specific point in the scene.
+// Each light is sampled up to its shadowSampleBudget(); area lights stop after the first
+// batch of 8 samples when all of them are lit or all are occluded. When
+// Scene::lightSamples is set, point lights are not all visited: that many of them are
+// picked from the light tree, and each one's light is divided by its probability.
 // Parameters:
+//   - scene: The scene providing lights and occluders.
 //   - point: The 3D point being shaded.
 //   - normal: The normal vector at the point.
 //   - view: The view direction vector.
 //   - specular: The specular reflection coefficient.
 // Returns: The calculated lighting color at the point.
 //
-Color computeLighting(const Vector3D& point, const Vector3D& normal, const Vector3D& view, double specular);
+Color computeLighting(const Scene& scene, const Vector3D& point, const Vector3D& normal, const Vector3D& view, Real specular);
 
 //
 // Function: TraceRay
 // Traces a ray through the scene to determine its color based on intersections and lighting.
 // Parameters:
+//   - scene: The scene to trace against.
 //   - ray: The ray being traced.
 //   - t_min: Minimum intersection distance.
 //   - t_max: Maximum intersection distance.
 //   - depth: Current recursion depth for reflections.
+//   - type: (Optional) The kind of ray, for the render statistics. Default is CAMERA.
+//   - throughput: (Optional) The factor of the ray's color in the pixel. Default is 1.
 // Returns: The color of the traced ray.
 //
-Color TraceRay(const Ray& ray, double t_min, double t_max, int depth);
+Color TraceRay(const Scene& scene, const Ray& ray, Real t_min, Real t_max, int depth,
+               RayType type = RayType::CAMERA, Real throughput = 1);
+
+//
+// Function: shadeHit
+// Computes the color of a ray that is known to hit the scene: local lighting, reflection,
+// indirect light and subsurface scattering (see shadeSurface). TraceRay calls this after
+// its closest-hit query.
+// Parameters:
+//   - scene: The scene to trace against.
+//   - ray: The ray that produced the hit.
+//   - hit: The closest hit of the ray.
+//   - t_max: Maximum intersection distance for secondary rays.
+//   - depth: Current recursion depth; must be at least 1.
+//   - throughput: (Optional) The factor of the ray's color in the pixel. Default is 1.
+// Returns: The color of the ray.
+//
+Color shadeHit(const Scene& scene, const Ray& ray, const Hit& hit, Real t_max, int depth, Real throughput = 1);
+
+//
+// Function: shadeSurface
+// Shades a surface point whose position, normal and material are already known: local
+// lighting, reflection, indirect light and subsurface scattering. The renderer calls this
+// for primary hits found in packets or read back from a G-buffer. With Scene::indirectCache,
+// the indirect light is interpolated from the cache instead of traced. The reflection and
+// indirect rays are traced, rouletted or culled by their throughput (see branchSurvival).
+// Parameters:
+//   - scene: The scene to trace against.
+//   - point: The hit point.
+//   - normal: The surface normal at the point.
+//   - direction: The direction of the ray that hit the point.
+//   - material: The material of the surface.
+//   - t_max: Maximum intersection distance for secondary rays.
+//   - depth: Current recursion depth; must be at least 1.
+//   - throughput: (Optional) The factor of the point's color in the pixel. Default is 1.
+// Returns: The color of the ray.
+//
+Color shadeSurface(const Scene& scene, const Vector3D& point, const Vector3D& normal,
+                   const Vector3D& direction, const Material& material, Real t_max, int depth,
+                   Real throughput = 1);
+
+//
+// Enum: ShadingFeature
+// The optional parts of shading, as bits of a feature set. A shader specialized for a
+// feature set leaves out the tests and code of every part whose bit is clear, so it must
+// only shade scenes that do not use those parts (see shadingFeatures).
+//
+enum ShadingFeature : unsigned {
+    SHADE_SSS = 1u << 0,              // Subsurface scattering of translucent materials.
+    SHADE_REFLECTION = 1u << 1,       // Mirror reflection of reflective materials.
+    SHADE_AREA_LIGHTS = 1u << 2,      // Soft shadows of lights with a radius.
+    SHADE_INDIRECT_CACHE = 1u << 3,   // Indirect light from Scene::indirectCache instead of traced.
+    SHADE_ALL = (1u << 4) - 1         // Every part: the generic shader of shadeSurface.
+};
+
+//
+// Constant: MAX_SPECIALIZED_DEPTH
+// The largest maximum depth with its own specialized shaders; deeper renders get a
+// shader specialized on the features only, with the depth tested at run time.
+//
+constexpr int MAX_SPECIALIZED_DEPTH = 4;
+
+//
+// Typedef: SurfaceShader
+// A function with the parameters and result of shadeSurface.
+//
+using SurfaceShader = Color (*)(const Scene& scene, const Vector3D& point, const Vector3D& normal,
+                                const Vector3D& direction, const Material& material, Real t_max, int depth,
+                                Real throughput);
+
+//
+// Function: shadingFeatures
+// Returns: The ShadingFeature bits a scene uses: reflective or translucent materials, lights
+//          with a radius, and an irradiance cache.
+//
+unsigned shadingFeatures(const Scene& scene);
+
+//
+// Function: selectSurfaceShader
+// Picks the shader specialized for a scene's features and a render's maximum depth, once per
+// render: a variant of shadeSurface compiled with only the parts the scene uses, whose
+// recursion depth is a compile-time constant at every level. Its result is bit-identical to
+// shadeSurface called with `maxDepth`, including the random numbers it draws.
+// Parameters:
+//   - scene: The scene to shade; its materials, lights and cache must not change while the
+//     shader is in use.
+//   - maxDepth: The depth the shader is called with; at least 1.
+// Returns: The shader.
+//
+SurfaceShader selectSurfaceShader(const Scene& scene, int maxDepth);
+
+//
+// Function: addSubsurfaceScattering
+// Blends the approximate subsurface scattering of a translucent material into the local
+// color of a shading point: 16 probes on a disk around the point, lit from the irradiance
+// grid, weighted by their distance. Opaque materials return the local color unchanged.
+// Parameters:
+//   - scene: The scene providing lights and the irradiance grid.
+//   - point: The shaded point.
+//   - normal: The surface normal at the point.
+//   - material: The material of the surface.
+//   - localColor: The lit surface color at the point.
+// Returns: The local color with the scattered light blended in.
+//
+Color addSubsurfaceScattering(const Scene& scene, const Vector3D& point, const Vector3D& normal,
+                              const Material& material, Color localColor);
 
 #endif // RAYTRACER_H
\ No newline at end of file
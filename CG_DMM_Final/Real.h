@@ -0,0 +1,20 @@
+#ifndef REAL_H
+#define REAL_H
+
+//
+// Scalar precision of the renderer
+// Geometry, shading and colors are computed in `Real`: double by default, float when
+// compiled with -DRAYTRACER_FLOAT (`make main-float`). The math and geometry classes are
+// templates over their scalar type (Vector3T, ColorT, RayT, SphereT, TriangleT), and
+// Vector3D, Color, Ray, Sphere and Triangle name their Real instantiations; both
+// precisions can be used side by side, e.g. to compare them in a benchmark.
+// Single precision halves the size of every vector, primitive and BVH node and doubles
+// the number of rays per SIMD packet.
+//
+#ifdef RAYTRACER_FLOAT
+typedef float Real;
+#else
+typedef double Real;
+#endif
+
+#endif // REAL_H
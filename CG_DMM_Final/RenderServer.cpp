@@ -0,0 +1,427 @@
+#include "RenderServer.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "ImageWriter.h"
+#include "Socket.h"
+
+namespace {
+
+const int LISTEN_BACKLOG = 64;
+const size_t MAX_LINE_LENGTH = 4096;   // Longer request lines close the connection
+const long long MAX_JOB_PIXELS = 4096LL * 4096;    // Largest image of a job (about 470 MB of framebuffer)
+const long long MAX_JOB_SAMPLES = 1LL << 32;       // Most samples of a job (e.g. 1920x1080 at 2048 spp)
+
+//
+// Function: parseInteger
+// Parses a whole string as a decimal integer.
+//
+bool parseInteger(const std::string& text, long long& value) {
+    if (text.empty()) return false;
+    char* end;
+    errno = 0;
+    value = std::strtoll(text.c_str(), &end, 10);
+    return errno == 0 && *end == '\0';
+}
+
+//
+// Function: parseReal
+// Parses a whole string as a number.
+//
+bool parseReal(const std::string& text, Real& value) {
+    if (text.empty()) return false;
+    char* end;
+    value = static_cast<Real>(std::strtod(text.c_str(), &end));
+    return *end == '\0';
+}
+
+//
+// Function: parseVector
+// Parses "x,y,z".
+//
+bool parseVector(const std::string& text, Vector3D& vector) {
+    Real components[3];
+    size_t start = 0;
+    for (int i = 0; i < 3; i++) {
+        size_t comma = text.find(',', start);
+        if ((i < 2) != (comma != std::string::npos)) return false;
+        if (!parseReal(text.substr(start, comma == std::string::npos ? std::string::npos : comma - start),
+                       components[i])) {
+            return false;
+        }
+        start = comma + 1;
+    }
+    vector = Vector3D(components[0], components[1], components[2]);
+    return true;
+}
+
+} // namespace
+
+//
+// Function: parseRenderJob
+// Parses a render request line of the server protocol (see RenderServer): the word
+// "render" followed by key=value fields. Fields not given keep their value in `job`.
+// Parameters:
+//   - line: The request line, without the newline.
+//   - job: The job, filled with the defaults on input (input/output).
+//   - error: Why the line is not a valid request (output, only written on failure).
+// Returns:
+//   - true on success, false for an unknown field or an invalid value.
+//
+bool parseRenderJob(const std::string& line, RenderJob& job, std::string& error) {
+    std::istringstream fields(line);
+    std::string field;
+    if (!(fields >> field) || field != "render") {
+        error = "unknown request";
+        return false;
+    }
+
+    RenderSettings& settings = job.settings;
+    while (fields >> field) {
+        size_t equals = field.find('=');
+        std::string key = field.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : field.substr(equals + 1);
+        long long integer = 0;
+        bool valid;
+        if (key == "width" || key == "height" || key == "spp" || key == "max-spp" || key == "depth" ||
+            key == "tile") {
+            valid = parseInteger(value, integer) && integer >= 0 && integer <= (1 << 16);
+            int& target = key == "width" ? settings.width : key == "height" ? settings.height
+                        : key == "spp" ? settings.spp : key == "max-spp" ? settings.maxSpp
+                        : key == "depth" ? settings.maxDepth : settings.tileSize;
+            if (valid) target = static_cast<int>(integer);
+        } else if (key == "seed") {
+            valid = parseInteger(value, integer);
+            if (valid) settings.seed = static_cast<uint64_t>(integer);
+        } else if (key == "threshold") {
+            valid = parseReal(value, settings.errorThreshold);
+        } else if (key == "engine") {
+            valid = value == "recursive" || value == "wavefront";
+            if (valid) settings.engine = value == "wavefront" ? RenderEngine::WAVEFRONT : RenderEngine::RECURSIVE;
+        } else if (key == "sampler") {
+            valid = parseSamplerType(value.c_str(), settings.sampler);
+        } else if (key == "ray-order") {
+            valid = parseRayOrder(value.c_str(), settings.rayOrder);
+        } else if (key == "position") {
+            valid = parseVector(value, job.position);
+        } else if (key == "target") {
+            valid = parseVector(value, job.target);
+        } else if (key == "up") {
+            valid = parseVector(value, job.up);
+        } else if (key == "output") {
+            // A path below the server's output directory: relative, without ".." components
+            valid = !value.empty() && value[0] != '/' && ("/" + value + "/").find("/../") == std::string::npos;
+            job.outputPath = value;
+        } else {
+            error = "unknown field " + key;
+            return false;
+        }
+        if (!valid) {
+            error = "invalid value for " + key;
+            return false;
+        }
+    }
+
+    if (settings.width <= 0 || settings.height <= 0 || settings.spp <= 0 || settings.tileSize <= 0) {
+        error = "width, height, spp and tile must be positive";
+        return false;
+    }
+    return true;
+}
+
+//
+// Function: withinJobLimits
+// Checks that one request cannot take all the memory or time of the server.
+// Parameters:
+//   - job: A parsed job.
+//   - error: Which limit the job exceeds (output, only written on failure).
+// Returns:
+//   - true if the job has at most MAX_JOB_PIXELS pixels and MAX_JOB_SAMPLES samples.
+//
+static bool withinJobLimits(const RenderJob& job, std::string& error) {
+    const RenderSettings& settings = job.settings;
+    long long pixels = static_cast<long long>(settings.width) * settings.height;
+    if (pixels > MAX_JOB_PIXELS) {
+        error = "image larger than " + std::to_string(MAX_JOB_PIXELS) + " pixels";
+        return false;
+    }
+    if (pixels * std::max(settings.spp, settings.maxSpp) > MAX_JOB_SAMPLES) {
+        error = "more than " + std::to_string(MAX_JOB_SAMPLES) + " samples";
+        return false;
+    }
+    return true;
+}
+
+//
+// Function: formatRenderJob
+// Formats a job as a request line that parseRenderJob reads back exactly.
+// Parameters:
+//   - job: The job.
+// Returns: The request line, without the newline.
+//
+std::string formatRenderJob(const RenderJob& job) {
+    const RenderSettings& settings = job.settings;
+    std::ostringstream line;
+    line.precision(std::numeric_limits<double>::max_digits10);
+    // The seed is parsed as a signed integer; its two's complement gives back every bit
+    line << "render width=" << settings.width << " height=" << settings.height << " spp=" << settings.spp
+         << " max-spp=" << settings.maxSpp << " threshold=" << static_cast<double>(settings.errorThreshold)
+         << " depth=" << settings.maxDepth << " tile=" << settings.tileSize << " seed=" << static_cast<long long>(settings.seed)
+         << " engine=" << (settings.engine == RenderEngine::WAVEFRONT ? "wavefront" : "recursive")
+         << " sampler=" << samplerTypeName(settings.sampler) << " ray-order=" << rayOrderName(settings.rayOrder);
+    const char* names[] = {" position=", " target=", " up="};
+    const Vector3D* vectors[] = {&job.position, &job.target, &job.up};
+    for (int i = 0; i < 3; i++) {
+        line << names[i] << static_cast<double>(vectors[i]->x) << ',' << static_cast<double>(vectors[i]->y) << ','
+             << static_cast<double>(vectors[i]->z);
+    }
+    return line.str();
+}
+
+//
+// Constructor: RenderServer
+// Creates the renderers; nothing listens until listen() is called.
+// Parameters:
+//   - scene: The built scene; must outlive the server and not change.
+//   - defaults: The settings and camera of fields a job leaves out.
+//   - threadCount: Render threads in total. Values <= 0 use the hardware concurrency.
+//   - rendererCount: Jobs rendered at the same time, each on threadCount / rendererCount threads.
+//   - outputDirectory: The directory that jobs' output paths are relative to; empty refuses
+//     jobs with an output path.
+//
+RenderServer::RenderServer(const Scene& scene, const RenderJob& defaults, int threadCount, int rendererCount,
+                           const std::string& outputDirectory)
+    : scene(scene), defaults(defaults), outputDirectory(outputDirectory), activeConnections(0), listener(-1),
+      stopping(false) {
+    if (threadCount <= 0) threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    rendererCount = std::max(1, rendererCount);
+    int threadsPerRenderer = std::max(1, threadCount / rendererCount);
+    for (int i = 0; i < rendererCount; i++) {
+        renderers.push_back(std::unique_ptr<Renderer>(new Renderer(threadsPerRenderer)));
+        idle.push_back(renderers.back().get());
+    }
+}
+
+//
+// Destructor: RenderServer
+// Stops the server (see shutdown) and removes the socket file.
+//
+RenderServer::~RenderServer() {
+    shutdown();
+    {
+        // Connection threads may still be answering if run() was never called
+        std::unique_lock<std::mutex> lock(mutex);
+        connectionClosed.wait(lock, [this] { return activeConnections == 0; });
+    }
+    if (listener >= 0) {
+        close(listener);
+        unlink(socketPath.c_str());
+    }
+}
+
+//
+// Method: listen
+// Binds the socket, replacing a stale socket file at the path.
+// Parameters:
+//   - path: The socket path.
+//   - error: A description of the failure (output, only written on failure).
+// Returns:
+//   - true on success, false if the socket cannot be created or bound.
+//
+bool RenderServer::listen(const std::string& path, std::string& error) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "invalid socket path " + path;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+
+    // A socket file left behind by a previous server can be replaced; anything else cannot
+    struct stat status;
+    if (lstat(path.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+            error = path + " exists and is not a socket";
+            return false;
+        }
+        unlink(path.c_str());
+    }
+
+    int descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (descriptor < 0) {
+        error = std::string("cannot create a socket: ") + std::strerror(errno);
+        return false;
+    }
+    if (bind(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(descriptor, LISTEN_BACKLOG) != 0) {
+        error = "cannot listen on " + path + ": " + std::strerror(errno);
+        close(descriptor);
+        return false;
+    }
+    // Only the server's user may send jobs, whatever the umask
+    if (chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0) {
+        error = "cannot restrict the permissions of " + path + ": " + std::strerror(errno);
+        close(descriptor);
+        unlink(path.c_str());
+        return false;
+    }
+    listener = descriptor;
+    socketPath = path;
+    return true;
+}
+
+//
+// Method: run
+// Accepts connections until shutdown() is called or a client sends "shutdown", then
+// waits for every connection to close.
+//
+void RenderServer::run() {
+    while (true) {
+        int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            if (connection >= 0) close(connection);
+            break;
+        }
+        if (connection < 0) continue;   // Interrupted, or the client gave up before being accepted
+        connections.insert(connection);
+        activeConnections++;
+        std::thread(&RenderServer::serve, this, connection).detach();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    connectionClosed.wait(lock, [this] { return activeConnections == 0; });
+}
+
+//
+// Method: shutdown
+// Stops accepting connections and closes the open ones; may be called from any thread.
+// Jobs that are rendering finish and are still answered.
+//
+void RenderServer::shutdown() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping) return;
+    stopping = true;
+    if (listener >= 0) ::shutdown(listener, SHUT_RDWR);   // Wakes accept()
+    // Ends the connections' reads but lets their current replies through
+    for (int connection : connections) ::shutdown(connection, SHUT_RD);
+}
+
+//
+// Method: serve
+// The thread of one connection: reads request lines and answers them in order.
+//
+void RenderServer::serve(int connection) {
+    LineReader reader(connection, MAX_LINE_LENGTH);
+    std::string line;
+    bool open = true;
+    while (open && reader.next(line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.find_first_not_of(" \t") == std::string::npos) continue;
+
+        std::string reply;
+        std::vector<unsigned char> image;
+        if (line == "quit") {
+            break;
+        } else if (line == "shutdown") {
+            reply = "ok\n";
+            open = false;
+            shutdown();
+        } else {
+            RenderJob job = defaults;
+            std::string error;
+            try {
+                if (!parseRenderJob(line, job, error) || !withinJobLimits(job, error)) {
+                    reply = "error " + error + "\n";
+                } else if (!job.outputPath.empty() && outputDirectory.empty()) {
+                    reply = "error output is disabled (start the server with --serve-output DIR)\n";
+                } else {
+                    if (!job.outputPath.empty()) job.outputPath = outputDirectory + "/" + job.outputPath;
+                    reply = renderJob(job, image);
+                }
+            } catch (const std::exception& exception) {
+                // E.g. out of memory: fail this job, not the server
+                image.clear();
+                reply = std::string("error ") + exception.what() + "\n";
+            }
+        }
+        open = open && sendAll(connection, reply.data(), reply.size()) &&
+               sendAll(connection, image.data(), image.size());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    connections.erase(connection);
+    close(connection);
+    if (--activeConnections == 0) connectionClosed.notify_all();
+}
+
+//
+// Method: renderJob
+// Renders one job on a free renderer, waiting for one if all are busy.
+// Returns: The reply line, and the image bytes of a returned frame.
+//
+std::string RenderServer::renderJob(const RenderJob& job, std::vector<unsigned char>& image) {
+    // Allocated before taking a renderer, so a job too large for the memory fails alone
+    const RenderSettings& settings = job.settings;
+    Camera camera(job.position, job.target, job.up, static_cast<Real>(settings.width) / settings.height);
+    Framebuffer framebuffer(settings.width, settings.height);
+
+    Renderer* renderer;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        rendererFree.wait(lock, [this] { return !idle.empty(); });
+        renderer = idle.back();
+        idle.pop_back();
+    }
+    auto release = [this, renderer] {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            idle.push_back(renderer);
+        }
+        rendererFree.notify_one();
+    };
+
+    std::chrono::duration<double> elapsed;
+    bool written = true;
+    try {
+        if (job.outputPath.empty()) {
+            auto start = std::chrono::steady_clock::now();
+            renderer->render(scene, camera, settings, framebuffer);
+            elapsed = std::chrono::steady_clock::now() - start;
+        } else {
+            // Streamed to the file while rendering, as main does
+            ImageWriter writer(framebuffer, job.outputPath, imageFormatForPath(job.outputPath));
+            auto start = std::chrono::steady_clock::now();
+            renderer->render(scene, camera, settings, framebuffer,
+                             [&writer](int y0, int y1) { writer.submitRows(y0, y1); });
+            elapsed = std::chrono::steady_clock::now() - start;
+            written = writer.finish();
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+    release();
+
+    std::ostringstream reply;
+    if (!written) {
+        reply << "error cannot write " << job.outputPath << "\n";
+    } else if (job.outputPath.empty()) {
+        image = encodeImage(framebuffer, ImageFormat::PPM);
+        reply << "frame " << elapsed.count() << " " << image.size() << "\n";
+    } else {
+        reply << "written " << elapsed.count() << " " << job.outputPath << "\n";
+    }
+    return reply.str();
+}
@@ -0,0 +1,157 @@
+#ifndef RENDERSERVER_H
+#define RENDERSERVER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "Renderer.h"
+#include "Scene.h"
+
+//
+// Struct: RenderJob
+// One frame requested from the render server: the render settings, the camera and where
+// the image goes.
+//
+struct RenderJob {
+    RenderSettings settings;      // Resolution, sampling, depth, seed and engine.
+    Vector3D position;            // The camera position.
+    Vector3D target;              // The point the camera is looking at.
+    Vector3D up;                  // The world up direction.
+    std::string outputPath;       // The image file to write; empty returns the image instead.
+};
+
+//
+// Function: parseRenderJob
+// Parses a render request line of the server protocol (see RenderServer): the word
+// "render" followed by key=value fields. Fields not given keep their value in `job`.
+// The size of the job is not limited; the server checks that separately.
+// Parameters:
+//   - line: The request line, without the newline.
+//   - job: The job, filled with the defaults on input (input/output).
+//   - error: Why the line is not a valid request (output, only written on failure).
+// Returns:
+//   - true on success, false for an unknown field or an invalid value.
+//
+bool parseRenderJob(const std::string& line, RenderJob& job, std::string& error);
+
+//
+// Function: formatRenderJob
+// Formats a job as a request line of the server protocol, with every field that affects
+// the image and enough digits to read every number back exactly; parseRenderJob of the
+// line gives the same job. The output path is left out.
+// Parameters:
+//   - job: The job.
+// Returns: The request line, without the newline.
+//
+std::string formatRenderJob(const RenderJob& job);
+
+//
+// Class: RenderServer
+// A long-running render process: the scene is built once and then serves render jobs
+// sent over a Unix domain socket, so a frame costs only its trace time. Each connection
+// is served by its own thread and may send any number of jobs, one line each:
+//
+//   render width=640 height=360 spp=4 depth=2 position=0,1,-3 target=0,1,2 up=0,1,0
+//          [max-spp=N] [threshold=E] [seed=N] [tile=N] [engine=recursive|wavefront]
+//          [sampler=random|hash|halton|sobol] [ray-order=none|octant|morton] [output=PATH]
+//
+// Fields not given take the server's defaults (its command line). An output PATH must be
+// relative and free of ".." components; it names a file in the output directory given to
+// the constructor, and is refused if there is none. Every job is answered
+// with one line:
+//
+//   written <seconds> <path>     the image was written to `output` (PPM, or PFM for .pfm)
+//                                in the server's output directory
+//   frame <seconds> <bytes>      followed by that many bytes of binary PPM
+//   error <message>
+//
+// where <seconds> is the render time. Jobs of more than 4096x4096 pixels or 2^32 samples,
+// and jobs that fail while rendering (e.g. out of memory), get an error and leave the
+// connection open. "quit" closes the connection and "shutdown" stops the server. Jobs of different connections render concurrently on a fixed set of
+// renderers that split the render threads between them; with one renderer (the default)
+// jobs take turns, and each frame uses every thread.
+//
+class RenderServer {
+public:
+    //
+    // Constructor: RenderServer
+    // Creates the renderers; nothing listens until listen() is called.
+    // Parameters:
+    //   - scene: The built scene; must outlive the server and not change.
+    //   - defaults: The settings and camera of fields a job leaves out.
+    //   - threadCount: Render threads in total. Values <= 0 use the hardware concurrency.
+    //   - rendererCount: Jobs rendered at the same time, each on threadCount / rendererCount threads.
+    //   - outputDirectory: (Optional) The directory that jobs' output paths are relative to;
+    //     empty (the default) refuses jobs with an output path.
+    //
+    RenderServer(const Scene& scene, const RenderJob& defaults, int threadCount, int rendererCount,
+                 const std::string& outputDirectory = "");
+
+    //
+    // Destructor: ~RenderServer
+    // Stops the server (see shutdown) and removes the socket file.
+    //
+    ~RenderServer();
+
+    RenderServer(const RenderServer&) = delete;
+    RenderServer& operator=(const RenderServer&) = delete;
+
+    //
+    // Method: listen
+    // Binds the socket, replacing a stale socket file at the path, and makes it accessible to
+    // the server's user only.
+    // Parameters:
+    //   - path: The socket path.
+    //   - error: A description of the failure (output, only written on failure).
+    // Returns:
+    //   - true on success, false if the socket cannot be created or bound.
+    //
+    bool listen(const std::string& path, std::string& error);
+
+    //
+    // Method: run
+    // Accepts connections until shutdown() is called or a client sends "shutdown", then
+    // waits for every connection to close.
+    //
+    void run();
+
+    //
+    // Method: shutdown
+    // Stops accepting connections and closes the open ones; may be called from any thread.
+    // Jobs that are rendering finish and are still answered.
+    //
+    void shutdown();
+
+private:
+    //
+    // Method: serve
+    // The (detached) thread of one connection: reads request lines and answers them in order.
+    //
+    void serve(int connection);
+
+    //
+    // Method: renderJob
+    // Renders one job on a free renderer, waiting for one if all are busy.
+    // Returns: The reply line, and the image bytes of a returned frame.
+    //
+    std::string renderJob(const RenderJob& job, std::vector<unsigned char>& image);
+
+    const Scene& scene;                                   // The served scene.
+    RenderJob defaults;                                   // The values of fields a job leaves out.
+    std::string outputDirectory;                          // Where output paths point; empty refuses them.
+    std::vector<std::unique_ptr<Renderer>> renderers;     // Every renderer.
+    std::vector<Renderer*> idle;                          // The renderers not rendering a job.
+    std::mutex mutex;                                     // Guards idle, connections, activeConnections and stopping.
+    std::condition_variable rendererFree;                 // Signals a renderer returned to `idle`.
+    std::condition_variable connectionClosed;             // Signals the last connection closed.
+    std::set<int> connections;                            // The open connection sockets.
+    int activeConnections;                                // Connection threads still running.
+    int listener;                                         // The listening socket, or -1.
+    std::string socketPath;                               // The bound socket path.
+    bool stopping;                                        // Set by shutdown().
+};
+
+#endif // RENDERSERVER_H
@@ -0,0 +1,199 @@
+#include "RenderStats.h"
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+const char* const RAY_TYPE_NAMES[] = {"camera", "shadow", "reflection", "indirect", "sss_probe"};
+const char* const STAGE_NAMES[] = {"camera_rays", "primary_hits", "secondary_hits", "sorting", "shading",
+                                   "lighting", "sss"};
+
+static_assert(sizeof(RAY_TYPE_NAMES) / sizeof(RAY_TYPE_NAMES[0]) == static_cast<int>(RayType::COUNT),
+              "Every ray type needs a name");
+static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == static_cast<int>(RenderStage::COUNT),
+              "Every stage needs a name");
+
+double perSecond(uint64_t count, double seconds) {
+    return seconds > 0 ? count / seconds : 0.0;
+}
+
+#ifdef RAYTRACER_STATS
+
+//
+// Registry of the counters of every thread that has counted anything
+//
+std::mutex registryMutex;
+std::vector<RenderStats*> registry;   // Counters of live threads
+RenderStats retired;                  // Counters of threads that have exited
+
+//
+// Struct: ThreadSlot
+// Owns a thread's counters and keeps them in the registry while the thread lives.
+//
+struct ThreadSlot {
+    RenderStats stats;
+
+    ThreadSlot() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(&stats);
+    }
+
+    ~ThreadSlot() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        retired.merge(stats);
+        registry.erase(std::find(registry.begin(), registry.end(), &stats));
+    }
+};
+
+#endif // RAYTRACER_STATS
+
+} // namespace
+
+#ifdef RAYTRACER_STATS
+
+//
+// Function: threadStats
+// Returns: The counters of the calling thread. They are registered on first use and
+//          stay registered (and their counts kept) after the thread exits.
+//
+RenderStats& threadStats() {
+    thread_local ThreadSlot slot;
+    return slot.stats;
+}
+
+//
+// Function: resetStats
+// Zeros the counters of every thread. Must not run concurrently with counting threads.
+//
+void resetStats() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (RenderStats* stats : registry) *stats = RenderStats();
+    retired = RenderStats();
+}
+
+//
+// Function: collectStats
+// Returns: The sum of the counters of every thread. Must not run concurrently with
+//          counting threads.
+//
+RenderStats collectStats() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    RenderStats total = retired;
+    for (const RenderStats* stats : registry) total.merge(*stats);
+    return total;
+}
+
+#endif // RAYTRACER_STATS
+
+//
+// Method: merge
+// Adds the counters of another RenderStats to this one.
+//
+void RenderStats::merge(const RenderStats& other) {
+    for (int i = 0; i < static_cast<int>(RayType::COUNT); i++) {
+        rays[i] += other.rays[i];
+        hits[i] += other.hits[i];
+    }
+    primitiveTests += other.primitiveTests;
+    packetTests += other.packetTests;
+    rouletteTerminations += other.rouletteTerminations;
+    culledBranches += other.culledBranches;
+    irradianceFallbacks += other.irradianceFallbacks;
+    lightTreeSamples += other.lightTreeSamples;
+    indirectCacheHits += other.indirectCacheHits;
+    indirectCacheRecords += other.indirectCacheRecords;
+    for (int i = 0; i < static_cast<int>(RenderStage::COUNT); i++) {
+        stageNanoseconds[i] += other.stageNanoseconds[i];
+    }
+}
+
+//
+// Method: print
+// Writes a human-readable summary.
+// Parameters:
+//   - out: The stream to write to.
+//   - seconds: The wall-clock time of the render, for rates.
+//
+void RenderStats::print(std::ostream& out, double seconds) const {
+    uint64_t totalRays = 0;
+    for (int i = 0; i < static_cast<int>(RayType::COUNT); i++) totalRays += rays[i];
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    out << "Render statistics:\n";
+    out << "  rays            count        hits      misses      Mrays/s\n";
+    for (int i = 0; i < static_cast<int>(RayType::COUNT); i++) {
+        out << "  " << std::left << std::setw(11) << RAY_TYPE_NAMES[i] << std::right << std::setw(10) << rays[i];
+        if (static_cast<RayType>(i) == RayType::SSS_PROBE) {
+            out << std::setw(12) << "-" << std::setw(12) << "-";
+        } else {
+            out << std::setw(12) << hits[i] << std::setw(12) << rays[i] - hits[i];
+        }
+        out << std::setw(13) << perSecond(rays[i], seconds) * 1e-6 << "\n";
+    }
+    out << "  " << std::left << std::setw(11) << "total" << std::right << std::setw(10) << totalRays
+        << std::setw(37) << perSecond(totalRays, seconds) * 1e-6 << "\n";
+    out << "  primitive tests: " << primitiveTests << " single-ray, " << packetTests << " packet\n";
+    out << "  Russian roulette terminations: " << rouletteTerminations << ", culled rays: " << culledBranches << "\n";
+    out << "  SSS probes outside the irradiance grid: " << irradianceFallbacks << "\n";
+    out << "  lights sampled from the light tree: " << lightTreeSamples << "\n";
+    out << "  irradiance cache: " << indirectCacheHits << " interpolated, " << indirectCacheRecords
+        << " records computed\n";
+    out << "  stage times (summed over threads):\n";
+    for (int i = 0; i < static_cast<int>(RenderStage::COUNT); i++) {
+        out << "    " << std::left << std::setw(15) << STAGE_NAMES[i] << std::right << std::setw(10)
+            << stageNanoseconds[i] * 1e-9 << " s\n";
+    }
+    out.flags(flags);
+}
+
+//
+// Method: writeJson
+// Writes the counters as a JSON document.
+// Parameters:
+//   - path: The output file.
+//   - seconds: The wall-clock time of the render, for rates.
+//   - error: A description of the failure (output, only written on failure).
+// Returns:
+//   - true on success, false if the file cannot be written.
+//
+bool RenderStats::writeJson(const std::string& path, double seconds, std::string& error) const {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        error = "cannot open " + path + " for writing";
+        return false;
+    }
+    std::fprintf(file, "{\n  \"seconds\": %.6f,\n  \"rays\": {\n", seconds);
+    for (int i = 0; i < static_cast<int>(RayType::COUNT); i++) {
+        std::fprintf(file, "    \"%s\": {\"count\": %llu", RAY_TYPE_NAMES[i], static_cast<unsigned long long>(rays[i]));
+        if (static_cast<RayType>(i) != RayType::SSS_PROBE) {
+            std::fprintf(file, ", \"hits\": %llu", static_cast<unsigned long long>(hits[i]));
+        }
+        std::fprintf(file, "}%s\n", i + 1 < static_cast<int>(RayType::COUNT) ? "," : "");
+    }
+    std::fprintf(file, "  },\n  \"primitive_tests\": %llu,\n  \"packet_tests\": %llu,\n"
+                       "  \"roulette_terminations\": %llu,\n  \"culled_branches\": %llu,\n"
+                       "  \"irradiance_fallbacks\": %llu,\n"
+                       "  \"light_tree_samples\": %llu,\n  \"indirect_cache_hits\": %llu,\n"
+                       "  \"indirect_cache_records\": %llu,\n  \"stage_seconds\": {\n",
+                 static_cast<unsigned long long>(primitiveTests), static_cast<unsigned long long>(packetTests),
+                 static_cast<unsigned long long>(rouletteTerminations),
+                 static_cast<unsigned long long>(culledBranches),
+                 static_cast<unsigned long long>(irradianceFallbacks),
+                 static_cast<unsigned long long>(lightTreeSamples),
+                 static_cast<unsigned long long>(indirectCacheHits),
+                 static_cast<unsigned long long>(indirectCacheRecords));
+    for (int i = 0; i < static_cast<int>(RenderStage::COUNT); i++) {
+        std::fprintf(file, "    \"%s\": %.6f%s\n", STAGE_NAMES[i], stageNanoseconds[i] * 1e-9,
+                     i + 1 < static_cast<int>(RenderStage::COUNT) ? "," : "");
+    }
+    std::fprintf(file, "  }\n}\n");
+    if (std::fclose(file) != 0) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,167 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+//
+// Render statistics
+// Counters of the work done by a render: rays by type, primitive intersection tests, hits
+// and misses, Russian-roulette terminations and the time spent in each stage.
+//
+// The counters are only compiled in when RAYTRACER_STATS is defined (see `make main-stats`);
+// otherwise every STATS_* macro expands to nothing and production builds carry no trace of
+// them. Each render thread counts into its own RenderStats, so counting is a plain
+// increment without atomics or shared cache lines; Renderer::render merges the counters of
+// all threads when the render is finished.
+//
+
+//
+// Enum: RayType
+// The kinds of rays counted separately.
+//
+enum class RayType {
+    CAMERA,       // Primary rays from the camera.
+    SHADOW,       // Shadow rays towards light samples.
+    REFLECTION,   // Mirror reflection rays.
+    INDIRECT,     // Diffuse indirect rays.
+    SSS_PROBE,    // Subsurface scattering probes (shaded, not traced).
+    COUNT
+};
+
+//
+// Enum: RenderStage
+// The timed stages of a render. With the recursive engine times are inclusive: LIGHTING
+// includes the shadow rays of computeLighting, SHADING includes the lighting, reflection,
+// indirect and SSS work below it. The stages of the wavefront engine (see Wavefront.h) run
+// one after another, so its times are exclusive.
+//
+enum class RenderStage {
+    CAMERA_RAYS,      // Generating the jittered camera rays of a tile.
+    PRIMARY_HITS,     // Intersecting the camera rays in packets.
+    SECONDARY_HITS,   // Intersecting queued reflection and indirect rays (wavefront engine).
+    SORTING,          // Sorting queued hits by material and rays by direction (wavefront engine).
+    SHADING,          // Shading the camera ray hits (shadeHit and everything below it).
+    LIGHTING,         // computeLighting, wherever it is called from, or the wavefront shadow stage.
+    SSS,              // The subsurface scattering probes of shadeHit.
+    COUNT
+};
+
+//
+// Struct: RenderStats
+// The counters of one thread, or of a whole render after merging.
+//
+struct RenderStats {
+    // Whether the counters are compiled in; all counters stay zero otherwise.
+#ifdef RAYTRACER_STATS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    uint64_t rays[static_cast<int>(RayType::COUNT)] = {};   // Rays by type.
+    uint64_t hits[static_cast<int>(RayType::COUNT)] = {};   // Rays that hit something (shadow rays: occluded).
+    uint64_t primitiveTests = 0;         // Ray-primitive intersection tests of single rays.
+    uint64_t packetTests = 0;            // Packet-primitive intersection tests (one per primitive and packet).
+    uint64_t rouletteTerminations = 0;   // Reflection and indirect rays ended by Russian roulette.
+    uint64_t culledBranches = 0;         // Reflection and indirect rays skipped for their low throughput.
+    uint64_t irradianceFallbacks = 0;    // SSS probes outside the irradiance grid (shaded with shadow rays).
+    uint64_t lightTreeSamples = 0;       // Point lights picked from the light tree (see Scene::lightSamples).
+    uint64_t indirectCacheHits = 0;      // Indirect bounces interpolated from the irradiance cache.
+    uint64_t indirectCacheRecords = 0;   // Irradiance cache records computed (see IrradianceCache).
+    uint64_t stageNanoseconds[static_cast<int>(RenderStage::COUNT)] = {};   // Time by stage, summed over threads.
+
+    //
+    // Method: merge
+    // Adds the counters of another RenderStats to this one.
+    //
+    void merge(const RenderStats& other);
+
+    //
+    // Method: print
+    // Writes a human-readable summary.
+    // Parameters:
+    //   - out: The stream to write to.
+    //   - seconds: The wall-clock time of the render, for rates.
+    //
+    void print(std::ostream& out, double seconds) const;
+
+    //
+    // Method: writeJson
+    // Writes the counters as a JSON document.
+    // Parameters:
+    //   - path: The output file.
+    //   - seconds: The wall-clock time of the render, for rates.
+    //   - error: A description of the failure (output, only written on failure).
+    // Returns:
+    //   - true on success, false if the file cannot be written.
+    //
+    bool writeJson(const std::string& path, double seconds, std::string& error) const;
+};
+
+#ifdef RAYTRACER_STATS
+
+//
+// Function: threadStats
+// Returns: The counters of the calling thread. They are registered on first use and
+//          stay registered (and their counts kept) after the thread exits.
+//
+RenderStats& threadStats();
+
+//
+// Function: resetStats
+// Zeros the counters of every thread. Must not run concurrently with counting threads.
+//
+void resetStats();
+
+//
+// Function: collectStats
+// Returns: The sum of the counters of every thread. Must not run concurrently with
+//          counting threads.
+//
+RenderStats collectStats();
+
+//
+// Class: StageTimer
+// Adds the lifetime of a scope to the calling thread's time of a stage.
+//
+class StageTimer {
+public:
+    explicit StageTimer(RenderStage stage) : stage(stage), start(std::chrono::steady_clock::now()) {}
+    ~StageTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        threadStats().stageNanoseconds[static_cast<int>(stage)] +=
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    RenderStage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define STATS_CONCAT_(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT_(a, b)
+
+// Counts n rays of a type
+#define STATS_RAYS(type, n) (threadStats().rays[static_cast<int>(type)] += (n))
+// Counts n rays of a type that hit something
+#define STATS_HITS(type, n) (threadStats().hits[static_cast<int>(type)] += (n))
+// Adds n to a scalar counter of RenderStats
+#define STATS_ADD(counter, n) (threadStats().counter += (n))
+// Times the rest of the enclosing scope as a stage
+#define STATS_STAGE(stage) StageTimer STATS_CONCAT(stageTimer, __LINE__)(RenderStage::stage)
+
+#else
+
+#define STATS_RAYS(type, n) ((void)0)
+#define STATS_HITS(type, n) ((void)0)
+#define STATS_ADD(counter, n) ((void)0)
+#define STATS_STAGE(stage) ((void)0)
+
+#endif // RAYTRACER_STATS
+
+#endif // RENDERSTATS_H
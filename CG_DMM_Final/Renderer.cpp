@@ -0,0 +1,380 @@
+#include "Renderer.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "RayTracer.h"
+#include "Wavefront.h"
+
+//
+// Constructor: Renderer
+// Creates a renderer with its own worker threads.
+// Parameters:
+//   - threadCount: Number of render threads. Values <= 0 use the hardware concurrency.
+//
+Renderer::Renderer(int threadCount)
+    : pool(threadCount) {}
+
+//
+// Destructor: ~Renderer
+// Default destructor for the Renderer class.
+//
+Renderer::~Renderer() {}
+
+namespace {
+
+//
+// Function: surfaceShader
+// Returns: The shader of a render: the one selectSurfaceShader picks for the scene's
+//          features and the maximum depth, or shadeSurface.
+//
+SurfaceShader surfaceShader(const Scene& scene, const RenderSettings& settings) {
+    if (settings.specializeShading && settings.maxDepth > 0) return selectSurfaceShader(scene, settings.maxDepth);
+    return shadeSurface;
+}
+
+} // namespace
+
+//
+// Method: render
+// Renders the scene as seen from the camera into the framebuffer.
+// Parameters:
+//   - scene: The scene to render. It must not change while rendering.
+//   - camera: The camera generating the primary rays.
+//   - settings: Resolution, sampling and tiling parameters.
+//   - framebuffer: The output image; must match the settings' resolution.
+//   - onRowsDone: Optional; called with [y0, y1) when a row of tiles is finished.
+//   - gbuffer: Optional; receives the primary hit of every sample (output).
+//
+void Renderer::render(const Scene& scene, const Camera& camera,
+                      const RenderSettings& settings, Framebuffer& framebuffer,
+                      const std::function<void(int, int)>& onRowsDone, GBuffer* gbuffer) {
+    GBuffer* record = nullptr;
+    if (gbuffer) {
+        // Adaptive sampling and the wavefront engine have no fixed set of primary samples
+        bool recordable = settings.engine == RenderEngine::RECURSIVE && settings.maxSpp <= settings.spp;
+        gbuffer->resize(recordable ? settings.width : 0, recordable ? settings.height : 0,
+                        recordable ? settings.spp : 0);
+        if (recordable) record = gbuffer;
+    }
+    renderTiles(scene, camera, settings, framebuffer, onRowsDone, nullptr, record);
+}
+
+//
+// Method: reshade
+// Renders the image again from the primary hits recorded by an earlier render, without
+// tracing any camera rays.
+// Parameters:
+//   - scene: The scene to shade; its geometry must be the one the hits were recorded from.
+//   - camera: The camera of the recording render.
+//   - gbuffer: The recorded hits; must match the settings' resolution and spp.
+//   - settings: The settings of the recording render; the depth may differ.
+//   - framebuffer: The output image; must match the settings' resolution.
+//   - onRowsDone: Optional; called with [y0, y1) when a row of tiles is finished.
+//
+void Renderer::reshade(const Scene& scene, const Camera& camera, const GBuffer& gbuffer,
+                       const RenderSettings& settings, Framebuffer& framebuffer,
+                       const std::function<void(int, int)>& onRowsDone) {
+    RenderSettings fixed = settings;
+    fixed.engine = RenderEngine::RECURSIVE;
+    fixed.maxSpp = 0;
+    renderTiles(scene, camera, fixed, framebuffer, onRowsDone, &gbuffer, nullptr);
+}
+
+//
+// Method: renderTileStream
+// Renders the tiles a source hands out, e.g. the share of one process of a tile farm.
+// Parameters:
+//   - scene: The scene to render. It must not change while rendering.
+//   - camera: The camera generating the primary rays.
+//   - settings: Resolution, sampling and tiling parameters of the whole image.
+//   - nextTile: Returns the next tile index, waiting if need be, or -1 when there are no more.
+//   - framebuffer: The whole image; only the pixels of the tiles are written.
+//   - onTileDone: Optional; called with a tile's index from a render thread when it is finished.
+//
+void Renderer::renderTileStream(const Scene& scene, const Camera& camera, const RenderSettings& settings,
+                                const std::function<int()>& nextTile, Framebuffer& framebuffer,
+                                const std::function<void(int)>& onTileDone) {
+    PacketIsa isa = resolvePacketIsa(settings.packetIsa);
+    SurfaceShader shader = surfaceShader(scene, settings);
+
+#ifdef RAYTRACER_STATS
+    resetStats();
+#endif
+
+    // One task per render thread, each taking tiles until the source runs dry
+    pool.parallelFor(pool.threadCount(), [&](int) {
+        for (int tileIndex = nextTile(); tileIndex >= 0; tileIndex = nextTile()) {
+            renderTile(scene, camera, settings, isa, shader, framebuffer, tileIndex, nullptr, nullptr);
+            if (onTileDone) onTileDone(tileIndex);
+        }
+    });
+
+#ifdef RAYTRACER_STATS
+    stats = collectStats();
+#endif
+}
+
+//
+// Method: renderTiles
+// Renders every tile on the pool; the thread finishing the last tile of a row of tiles
+// reports the rows.
+//
+void Renderer::renderTiles(const Scene& scene, const Camera& camera, const RenderSettings& settings,
+                           Framebuffer& framebuffer, const std::function<void(int, int)>& onRowsDone,
+                           const GBuffer* source, GBuffer* record) {
+    int tilesX = (settings.width + settings.tileSize - 1) / settings.tileSize;
+    int tilesY = (settings.height + settings.tileSize - 1) / settings.tileSize;
+
+    PacketIsa isa = resolvePacketIsa(settings.packetIsa);
+    SurfaceShader shader = surfaceShader(scene, settings);
+
+    // Finished tiles per row of tiles; the thread finishing the last one reports the rows
+    std::vector<std::atomic<int>> tilesDone(tilesY);
+
+#ifdef RAYTRACER_STATS
+    resetStats();
+#endif
+
+    pool.parallelFor(tilesX * tilesY, [&](int tileIndex) {
+        renderTile(scene, camera, settings, isa, shader, framebuffer, tileIndex, source, record);
+
+        int tileRow = tileIndex / tilesX;
+        if (onRowsDone && tilesDone[tileRow].fetch_add(1, std::memory_order_acq_rel) + 1 == tilesX) {
+            int y0 = tileRow * settings.tileSize;
+            onRowsDone(y0, std::min(y0 + settings.tileSize, settings.height));
+        }
+    });
+
+#ifdef RAYTRACER_STATS
+    stats = collectStats();
+#endif
+}
+
+//
+// Method: threadCount
+// Returns: The number of render threads.
+//
+int Renderer::threadCount() const {
+    return pool.threadCount();
+}
+
+//
+// Method: statistics
+// Returns: The merged counters of the last render; all zero unless the renderer was
+//          built with RAYTRACER_STATS (see RenderStats).
+//
+const RenderStats& Renderer::statistics() const {
+    return stats;
+}
+
+namespace {
+
+//
+// Struct: PixelSamples
+// The running sample statistics of one pixel: the color sum, and Welford's running
+// mean and sum of squared deviations of the luminance.
+//
+struct PixelSamples {
+    Color sum;
+    int count = 0;
+    Real mean = 0.0;
+    Real m2 = 0.0;
+
+    //
+    // Method: add
+    // Adds one sample to the statistics.
+    //
+    void add(const Color& sample) {
+        sum = sum + sample;
+        count++;
+        Real luminance = 0.2126 * sample.r + 0.7152 * sample.g + 0.0722 * sample.b;
+        Real delta = luminance - mean;
+        mean += delta / count;
+        m2 += delta * (luminance - mean);
+    }
+
+    //
+    // Method: standardError
+    // Returns the estimated standard error of the mean luminance; infinite with fewer
+    // than two samples.
+    //
+    Real standardError() const {
+        if (count < 2) return std::numeric_limits<Real>::infinity();
+        return std::sqrt(m2 / (count - 1) / count);
+    }
+};
+
+} // namespace
+
+//
+// Method: renderTile
+// Renders the pixels of one tile in rounds: each round generates the camera rays of all
+// unconverged pixels in scanline order, finds their hits in packets (or reads them from
+// the G-buffer), then shades each sample (or traces the whole round with the wavefront
+// engine). Without adaptive sampling there is exactly one round of `spp` samples.
+// Parameters:
+//   - scene: The scene to render.
+//   - camera: The camera generating the primary rays.
+//   - settings: Resolution, sampling and tiling parameters.
+//   - isa: The resolved packet instruction set.
+//   - shader: Shades the primary hits; called with the settings' maximum depth.
+//   - framebuffer: The output image.
+//   - tileIndex: The index of the tile in row-major tile order.
+//   - source: Optional; the recorded primary hits to shade instead of tracing camera rays.
+//   - record: Optional; receives the primary hits of the tile's samples (output).
+//
+void Renderer::renderTile(const Scene& scene, const Camera& camera, const RenderSettings& settings,
+                          PacketIsa isa, SurfaceShader shader, Framebuffer& framebuffer, int tileIndex,
+                          const GBuffer* source, GBuffer* record) const {
+    int x0, y0, x1, y1;
+    tileBounds(settings, tileIndex, x0, y0, x1, y1);
+    int tileWidth = x1 - x0;
+    const Real t_max = std::numeric_limits<Real>::infinity();
+    const int maxSamples = std::max(settings.spp, settings.maxSpp);
+
+    seedRandom(tileSeed(settings.seed, tileIndex));
+    bool sampled = settings.sampler != SamplerType::RANDOM && settings.engine == RenderEngine::RECURSIVE;
+    if (sampled) threadSampler = Sampler(settings.sampler, settings.seed);
+
+    // Every pixel takes part in the first round
+    std::vector<PixelSamples> samples(tileWidth * (y1 - y0));
+    std::vector<int> active(samples.size());
+    for (size_t i = 0; i < active.size(); i++) active[i] = static_cast<int>(i);
+
+    std::vector<Ray> rays;
+    std::vector<Hit> hits;
+    std::unique_ptr<bool[]> found;
+    std::vector<Color> colors;
+    std::vector<int> stillActive;
+
+    while (!active.empty()) {
+        // Generate the jittered camera rays of this round
+        rays.clear();
+        {
+            STATS_STAGE(CAMERA_RAYS);
+            for (int pixel : active) {
+                int x = x0 + pixel % tileWidth;
+                int y = y0 + pixel / tileWidth;
+                int batch = std::min(settings.spp, maxSamples - samples[pixel].count);
+                for (int s = 0; s < batch; s++) {
+                    if (sampled) threadSampler.startSample(y * settings.width + x, samples[pixel].count + s, 0);
+                    Real u = ((x + randDouble()) / settings.width) - 0.5;    // Randomized horizontal offset
+                    Real v = ((y + randDouble()) / settings.height) - 0.5;   // Randomized vertical offset
+                    rays.push_back(camera.generateRay(u, v));
+                }
+            }
+        }
+
+        int rayCount = static_cast<int>(rays.size());
+        if (settings.engine == RenderEngine::WAVEFRONT) {
+            // The whole round, bounce by bounce
+            thread_local WavefrontTracer wavefront;
+            colors.resize(rayCount);
+            wavefront.trace(scene, isa, rays.data(), rayCount, settings.maxDepth, settings.rayOrder,
+                            colors.data());
+        } else if (!source) {
+            // Primary visibility for the whole round, in packets
+            hits.resize(rayCount);
+            found.reset(new bool[rayCount]);
+            {
+                STATS_STAGE(PRIMARY_HITS);
+                intersectPackets(scene, isa, rays.data(), rayCount, 1.0, t_max, hits.data(), found.get());
+            }
+            STATS_RAYS(RayType::CAMERA, rayCount);
+            STATS_HITS(RayType::CAMERA, std::count(found.get(), found.get() + rayCount, true));
+        }
+
+        // Shade the samples in generation order
+        STATS_STAGE(SHADING);
+        int sample = 0;
+        stillActive.clear();
+        for (int pixel : active) {
+            int batch = std::min(settings.spp, maxSamples - samples[pixel].count);
+            for (int s = 0; s < batch; s++, sample++) {
+                if (settings.engine == RenderEngine::WAVEFRONT) {
+                    samples[pixel].add(colors[sample]);
+                    continue;
+                }
+
+                // The primary hit, from the packets or from the G-buffer
+                int x = x0 + pixel % tileWidth;
+                int y = y0 + pixel / tileWidth;
+                if (sampled) threadSampler.startSample(y * settings.width + x, samples[pixel].count, 2);
+                GBufferSample primary;
+                if (source) {
+                    primary = source->sample(x, y, samples[pixel].count);
+                } else if (found[sample]) {
+                    primary.point = rays[sample].direction.multiplyAdd(hits[sample].t, rays[sample].origin);
+                    primary.normal = scene.geometry.normal(hits[sample].primitive, primary.point);
+                    primary.primitive = hits[sample].primitive;
+                    primary.materialId = scene.geometry.materialId(hits[sample].primitive);
+                } else {
+                    primary.primitive = PrimitiveRef{PrimitiveType::SPHERE, -1};
+                    primary.materialId = -1;
+                }
+                if (record) record->sample(x, y, samples[pixel].count) = primary;
+
+                if (settings.maxDepth <= 0) {
+                    samples[pixel].add(Color(0, 0, 0));
+                } else if (primary.materialId < 0) {
+                    samples[pixel].add(scene.backgroundColor);
+                } else {
+                    samples[pixel].add(shader(scene, primary.point, primary.normal, rays[sample].direction,
+                                              scene.materials[primary.materialId], t_max, settings.maxDepth, 1));
+                }
+            }
+            if (samples[pixel].count < maxSamples && samples[pixel].standardError() > settings.errorThreshold) {
+                stillActive.push_back(pixel);
+            }
+        }
+        active.swap(stillActive);
+    }
+
+    // Average the samples to compute the final pixel colors; 8-bit output clamps them
+    for (size_t pixel = 0; pixel < samples.size(); pixel++) {
+        int x = x0 + static_cast<int>(pixel) % tileWidth;
+        int y = y0 + static_cast<int>(pixel) / tileWidth;
+        framebuffer.setPixel(x, y, samples[pixel].sum * (1.0 / samples[pixel].count));
+        framebuffer.setSampleCount(x, y, samples[pixel].count);
+    }
+}
+
+//
+// Function: tileCount
+// Returns: The number of tiles of an image.
+//
+int tileCount(const RenderSettings& settings) {
+    int tilesX = (settings.width + settings.tileSize - 1) / settings.tileSize;
+    int tilesY = (settings.height + settings.tileSize - 1) / settings.tileSize;
+    return tilesX * tilesY;
+}
+
+//
+// Function: tileBounds
+// Computes the pixels [x0, x1) x [y0, y1) of one tile.
+//
+void tileBounds(const RenderSettings& settings, int tileIndex, int& x0, int& y0, int& x1, int& y1) {
+    int tilesX = (settings.width + settings.tileSize - 1) / settings.tileSize;
+    x0 = (tileIndex % tilesX) * settings.tileSize;
+    y0 = (tileIndex / tilesX) * settings.tileSize;
+    x1 = std::min(x0 + settings.tileSize, settings.width);
+    y1 = std::min(y0 + settings.tileSize, settings.height);
+}
+
+//
+// Function: tileSeed
+// Derives the random seed of one tile from the render seed (splitmix64 mixing).
+// Parameters:
+//   - seed: The render seed.
+//   - tileIndex: The index of the tile in row-major tile order.
+// Returns: The tile's 64-bit seed.
+//
+uint64_t tileSeed(uint64_t seed, uint64_t tileIndex) {
+    uint64_t z = seed + (tileIndex + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
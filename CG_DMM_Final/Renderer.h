@@ -0,0 +1,210 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Camera.h"
+#include "Framebuffer.h"
+#include "GBuffer.h"
+#include "PacketTracer.h"
+#include "RaySort.h"
+#include "RayTracer.h"
+#include "RenderStats.h"
+#include "Sampler.h"
+#include "Scene.h"
+#include "WorkStealingPool.h"
+
+//
+// Enum: RenderEngine
+// How the samples of a tile are shaded.
+//
+enum class RenderEngine {
+    RECURSIVE,   // Each camera ray's hit is shaded depth-first by shadeHit and TraceRay.
+    WAVEFRONT    // All rays of a round are traced breadth-first in stages (see WavefrontTracer).
+};
+
+//
+// Struct: RenderSettings
+// The parameters of one render.
+//
+struct RenderSettings {
+    int width = 1280;        // Image width in pixels.
+    int height = 720;        // Image height in pixels.
+    int spp = 4;             // Samples per pixel for anti-aliasing (the minimum when adaptive).
+    int maxSpp = 0;          // Adaptive sampling: most samples per pixel; <= spp disables it.
+    Real errorThreshold = 0.01;    // Adaptive sampling: target standard error of pixel luminance.
+    int maxDepth = 2;        // Maximum recursion depth for ray tracing.
+    int tileSize = 16;       // Edge length of a square render tile in pixels.
+    uint64_t seed = 0;       // Base seed of the per-tile random sequences.
+    PacketIsa packetIsa = PacketIsa::AUTO;  // Instruction set for primary-ray packets.
+    RenderEngine engine = RenderEngine::RECURSIVE;   // Recursive or wavefront shading.
+    RayOrder rayOrder = RayOrder::MORTON;   // Wavefront engine: order of each wave's secondary rays.
+    SamplerType sampler = SamplerType::RANDOM;   // Recursive engine: source of each sample's random numbers.
+    bool specializeShading = true;   // Recursive engine: shade with selectSurfaceShader instead of shadeSurface.
+};
+
+//
+// Class: Renderer
+// Splits the image into square tiles and renders them on a work-stealing thread pool.
+// Each tile reseeds the calling thread's random generator from the render seed and the
+// tile index, so the image is identical for any thread count. Within a tile, all camera
+// rays are generated first, their hits are found in SIMD packets, and the hits are then
+// shaded one sample at a time; random numbers are drawn in the same order for every
+// packet width, so the image is also identical for any instruction set. The wavefront
+// engine instead hands all rays of a round to a per-thread WavefrontTracer, which also
+// traces the secondary rays of the whole round in packets.
+//
+// The recursive engine shades the hits with the shader selectSurfaceShader picks for the
+// scene's features and the maximum depth, unless `specializeShading` is off.
+//
+// A render can record the primary hit of every sample in a GBuffer; reshade() then renders
+// the image again from those hits alone, e.g. after the lights or materials were edited.
+//
+// With a sampler other than RANDOM, the recursive engine takes the random numbers of each
+// sample from the sampler, indexed by pixel, sample and dimension (the jitter is dimensions
+// 0 and 1, shading starts at 2), so they depend neither on the tile order nor on the other
+// samples; the wavefront engine, which interleaves the draws of many samples, always uses
+// the per-tile random stream.
+//
+// With adaptive sampling, a tile is sampled in rounds of `spp` samples per pixel. After
+// each round, pixels whose luminance standard error (from a running Welford variance)
+// is still above the threshold get another round, up to `maxSpp` samples; converged
+// pixels such as flat background stop after the first round.
+//
+class Renderer {
+public:
+    //
+    // Constructor: Renderer
+    // Creates a renderer with its own worker threads.
+    // Parameters:
+    //   - threadCount: Number of render threads. Values <= 0 use the hardware concurrency.
+    //
+    explicit Renderer(int threadCount);
+
+    //
+    // Destructor: ~Renderer
+    // Default destructor for the Renderer class.
+    //
+    ~Renderer();
+
+    //
+    // Method: render
+    // Renders the scene as seen from the camera into the framebuffer.
+    // Parameters:
+    //   - scene: The scene to render. It must not change while rendering.
+    //   - camera: The camera generating the primary rays.
+    //   - settings: Resolution, sampling and tiling parameters.
+    //   - framebuffer: The output image; must match the settings' resolution.
+    //   - onRowsDone: Optional; called with [y0, y1) from a render thread as soon as every
+    //     tile of a row of tiles is finished, e.g. to stream the rows to an ImageWriter.
+    //   - gbuffer: Optional; receives the primary hit of every sample (output). Only the
+    //     recursive engine without adaptive sampling records hits; otherwise it is left empty.
+    //
+    void render(const Scene& scene, const Camera& camera,
+                const RenderSettings& settings, Framebuffer& framebuffer,
+                const std::function<void(int, int)>& onRowsDone = nullptr, GBuffer* gbuffer = nullptr);
+
+    //
+    // Method: reshade
+    // Renders the image again from the primary hits recorded by an earlier render, without
+    // tracing any camera rays: each sample is shaded at its recorded hit with the scene's
+    // current lights and materials. The samples draw the same random numbers as in a full
+    // render, so the image is identical to render() of the same scene. Always uses the
+    // recursive engine with `spp` samples per pixel.
+    // Parameters:
+    //   - scene: The scene to shade; its geometry must be the one the hits were recorded from.
+    //   - camera: The camera of the recording render.
+    //   - gbuffer: The recorded hits; must match the settings' resolution and spp.
+    //   - settings: The settings of the recording render; the depth may differ.
+    //   - framebuffer: The output image; must match the settings' resolution.
+    //   - onRowsDone: Optional; as for render.
+    //
+    void reshade(const Scene& scene, const Camera& camera, const GBuffer& gbuffer,
+                 const RenderSettings& settings, Framebuffer& framebuffer,
+                 const std::function<void(int, int)>& onRowsDone = nullptr);
+
+    //
+    // Method: renderTileStream
+    // Renders only some tiles of the image, e.g. the share of one process of a tile farm
+    // (see TileFarm.h), taking them from a source that may still be receiving them: every
+    // render thread asks the source for its next tile as soon as it is idle. Each tile is
+    // seeded from its index as in render(), so its pixels are the same as in a render of the
+    // whole image.
+    // Parameters:
+    //   - scene: The scene to render. It must not change while rendering.
+    //   - camera: The camera generating the primary rays.
+    //   - settings: Resolution, sampling and tiling parameters of the whole image.
+    //   - nextTile: Called from the render threads; returns the index of the next tile to
+    //     render (see tileCount), waiting for one if need be, or -1 when there are no more.
+    //   - framebuffer: The whole image; only the pixels of the tiles are written.
+    //   - onTileDone: Optional; called with a tile's index from a render thread as soon as
+    //     the tile is finished.
+    //
+    void renderTileStream(const Scene& scene, const Camera& camera, const RenderSettings& settings,
+                          const std::function<int()>& nextTile, Framebuffer& framebuffer,
+                          const std::function<void(int)>& onTileDone = nullptr);
+
+    //
+    // Method: threadCount
+    // Returns: The number of render threads.
+    //
+    int threadCount() const;
+
+    //
+    // Method: statistics
+    // Returns: The merged counters of the last render; all zero unless the renderer was
+    //          built with RAYTRACER_STATS (see RenderStats).
+    //
+    const RenderStats& statistics() const;
+
+private:
+    //
+    // Method: renderTiles
+    // Renders every tile on the pool, reporting finished rows of tiles.
+    //
+    void renderTiles(const Scene& scene, const Camera& camera, const RenderSettings& settings,
+                     Framebuffer& framebuffer, const std::function<void(int, int)>& onRowsDone,
+                     const GBuffer* source, GBuffer* record);
+
+    //
+    // Method: renderTile
+    // Renders the pixels of one tile in rounds of samples, tracing the camera rays of each
+    // round in packets, or reading their hits from `source`, and shading them with `shader`.
+    //
+    void renderTile(const Scene& scene, const Camera& camera, const RenderSettings& settings,
+                    PacketIsa isa, SurfaceShader shader, Framebuffer& framebuffer, int tileIndex,
+                    const GBuffer* source, GBuffer* record) const;
+
+    WorkStealingPool pool;   // The render threads.
+    RenderStats stats;       // The counters of the last render.
+};
+
+//
+// Function: tileCount
+// Returns: The number of tiles of an image; tile i covers the pixels from tileBounds.
+//
+int tileCount(const RenderSettings& settings);
+
+//
+// Function: tileBounds
+// Computes the pixels of one tile.
+// Parameters:
+//   - settings: The resolution and tile size.
+//   - tileIndex: The index of the tile in row-major tile order.
+//   - x0, y0: The first column and row of the tile (output).
+//   - x1, y1: One past the last column and row of the tile (output).
+//
+void tileBounds(const RenderSettings& settings, int tileIndex, int& x0, int& y0, int& x1, int& y1);
+
+//
+// Function: tileSeed
+// Derives the random seed of one tile from the render seed (splitmix64 mixing).
+// Parameters:
+//   - seed: The render seed.
+//   - tileIndex: The index of the tile in row-major tile order.
+// Returns: The tile's 64-bit seed.
+//
+uint64_t tileSeed(uint64_t seed, uint64_t tileIndex);
+
+#endif // RENDERER_H
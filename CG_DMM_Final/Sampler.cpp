@@ -0,0 +1,224 @@
+#include "Sampler.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const int HALTON_DIMENSIONS = 256;   // Dimensions with their own prime base; later ones use the hash
+
+//
+// Function: mix64
+// The splitmix64 finalizer: a bijective 64-bit mixing function.
+//
+uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+//
+// Function: hashKey
+// Returns: A 64-bit hash of a seed and three 32-bit counters.
+//
+uint64_t hashKey(uint64_t seed, uint32_t a, uint32_t b, uint32_t c) {
+    uint64_t h = mix64(seed + 0x9E3779B97F4A7C15ULL);
+    h = mix64(h ^ ((static_cast<uint64_t>(a) << 32) | b));
+    return mix64(h ^ c);
+}
+
+//
+// Function: unitInterval
+// Returns: The top 53 bits of a hash as a double in [0, 1).
+//
+double unitInterval(uint64_t bits) {
+    return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+//
+// Function: reverseBits
+// Returns: x with its 32 bits in reverse order.
+//
+uint32_t reverseBits(uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+//
+// Function: nestedUniformScramble
+// Owen-scrambles the bits of x from the most significant one down: each bit is flipped
+// depending on the bits above it and the seed (a Laine-Karras style permutation applied
+// to the reversed bits).
+//
+uint32_t nestedUniformScramble(uint32_t x, uint32_t seed) {
+    x = reverseBits(x);
+    x ^= x * 0x3d20adeau;
+    x += seed;
+    x *= (seed >> 16) | 1;
+    x ^= x * 0x05526c56u;
+    x ^= x * 0x53a22864u;
+    return reverseBits(x);
+}
+
+//
+// Function: sobol
+// Returns: Dimension 0 (the van der Corput sequence) or 1 of the Sobol sequence, as 32 bits.
+//          Dimension 1's generator matrix is Pascal's triangle mod 2: digit k of the point is
+//          the parity of the index bits j with (j & k) == k, a superset sum taken in 5 steps.
+//
+uint32_t sobol(uint32_t index, int dimension) {
+    if (dimension == 1) {
+        index ^= (index >> 1) & 0x55555555u;
+        index ^= (index >> 2) & 0x33333333u;
+        index ^= (index >> 4) & 0x0F0F0F0Fu;
+        index ^= (index >> 8) & 0x00FF00FFu;
+        index ^= (index >> 16) & 0x0000FFFFu;
+    }
+    return reverseBits(index);
+}
+
+//
+// Function: primes
+// Returns: The first HALTON_DIMENSIONS primes.
+//
+const std::vector<uint32_t>& primes() {
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> found;
+        for (uint32_t candidate = 2; found.size() < HALTON_DIMENSIONS; candidate++) {
+            bool prime = true;
+            for (uint32_t p : found) {
+                if (p * p > candidate) break;
+                if (candidate % p == 0) {
+                    prime = false;
+                    break;
+                }
+            }
+            if (prime) found.push_back(candidate);
+        }
+        return found;
+    }();
+    return table;
+}
+
+//
+// Function: permute
+// Returns: Element i of a pseudo-random permutation of [0, length) chosen by `seed`
+//          (Kensler, "Correlated Multi-Jittered Sampling", 2013: a hash of i within the next
+//          power of two, repeated until it falls inside the range).
+//
+uint32_t permute(uint32_t i, uint32_t length, uint32_t seed) {
+    uint32_t w = length - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+    do {
+        i ^= seed;
+        i *= 0xe170893du;
+        i ^= seed >> 16;
+        i ^= (i & w) >> 4;
+        i ^= seed >> 8;
+        i *= 0x0929eb3fu;
+        i ^= seed >> 23;
+        i ^= (i & w) >> 1;
+        i *= 1 | seed >> 27;
+        i *= 0x6935fa69u;
+        i ^= (i & w) >> 11;
+        i *= 0x74dcb303u;
+        i ^= (i & w) >> 2;
+        i *= 0x9e501cc3u;
+        i ^= (i & w) >> 2;
+        i *= 0xc860a3dfu;
+        i &= w;
+        i ^= i >> 5;
+    } while (i >= length);
+    return (i + seed) % length;
+}
+
+//
+// Function: scrambledRadicalInverse
+// Returns: The digits of `index` in base `base` mirrored about the radix point, each digit
+//          permuted by a permutation chosen by the seed and the digits before it (Owen
+//          scrambling). The digits past the last nonzero one are scrambled zeros, which
+//          together are uniform over the remaining interval and drawn as one value.
+//
+double scrambledRadicalInverse(uint32_t index, uint32_t base, uint64_t seed) {
+    double inverseBase = 1.0 / base;
+    double scale = inverseBase;
+    double result = 0.0;
+    uint64_t prefix = seed;
+    for (; index != 0; index /= base) {
+        uint32_t digit = index % base;
+        result += permute(digit, base, static_cast<uint32_t>(mix64(prefix))) * scale;
+        scale *= inverseBase;
+        prefix = mix64(prefix + digit + 1);
+    }
+    result += unitInterval(mix64(prefix)) * scale * base;
+    return result < 1.0 ? result : 0x1.fffffffffffffp-1;
+}
+
+} // namespace
+
+//
+// Function: parseSamplerType
+// Parses "random", "hash", "halton" or "sobol".
+// Parameters:
+//   - name: The name to parse.
+//   - type: The parsed sampler (output).
+// Returns: true on success, false for an unknown name.
+//
+bool parseSamplerType(const char* name, SamplerType& type) {
+    const SamplerType all[] = {SamplerType::RANDOM, SamplerType::HASH, SamplerType::HALTON, SamplerType::SOBOL};
+    for (SamplerType candidate : all) {
+        if (std::strcmp(name, samplerTypeName(candidate)) == 0) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// Function: samplerTypeName
+// Returns: The lower-case name of a sampler.
+//
+const char* samplerTypeName(SamplerType type) {
+    switch (type) {
+        case SamplerType::RANDOM: return "random";
+        case SamplerType::HASH: return "hash";
+        case SamplerType::HALTON: return "halton";
+        case SamplerType::SOBOL: return "sobol";
+    }
+    return "unknown";
+}
+
+//
+// Function: value
+// Computes one value of a sample.
+// Parameters:
+//   - type: The kind of sequence; not RANDOM.
+//   - seed: The render seed.
+//   - pixel: The pixel index.
+//   - sampleIndex: The index of the sample within the pixel.
+//   - dimension: The dimension.
+// Returns: The value in [0, 1).
+//
+double Sampler::value(SamplerType type, uint64_t seed, uint32_t pixel, uint32_t sampleIndex, uint32_t dimension) {
+    if (type == SamplerType::SOBOL) {
+        // Dimensions 2k and 2k + 1 are one scrambled 2-D Sobol point; the shuffled index
+        // gives every pair its own order of the same stratified point set
+        uint32_t shuffleSeed = static_cast<uint32_t>(hashKey(seed, pixel, dimension / 2, 0x50B0u));
+        uint32_t scrambleSeed = static_cast<uint32_t>(hashKey(seed, pixel, dimension, 0x50B1u));
+        uint32_t index = nestedUniformScramble(sampleIndex, shuffleSeed);
+        uint32_t bits = nestedUniformScramble(sobol(index, dimension & 1), scrambleSeed);
+        return bits * (1.0 / 4294967296.0);
+    }
+    if (type == SamplerType::HALTON && dimension < HALTON_DIMENSIONS) {
+        // Every pixel and dimension scrambles its digits differently
+        return scrambledRadicalInverse(sampleIndex, primes()[dimension], hashKey(seed, pixel, dimension, 0x4A17u));
+    }
+    return unitInterval(hashKey(seed, pixel, sampleIndex, dimension));
+}
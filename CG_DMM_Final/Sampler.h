@@ -0,0 +1,105 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstdint>
+
+//
+// Enum: SamplerType
+// Where the random numbers of a pixel sample come from.
+//
+enum class SamplerType {
+    RANDOM,   // The thread's mt19937 stream, in drawing order (see Random.h).
+    HASH,     // A counter-based hash of (seed, pixel, sample, dimension).
+    HALTON,   // Halton points, digit-scrambled per pixel and dimension.
+    SOBOL     // Owen-scrambled, shuffled Sobol (0,2)-sequences, one per pair of dimensions.
+};
+
+//
+// Function: parseSamplerType
+// Parses "random", "hash", "halton" or "sobol".
+// Parameters:
+//   - name: The name to parse.
+//   - type: The parsed sampler (output).
+// Returns: true on success, false for an unknown name.
+//
+bool parseSamplerType(const char* name, SamplerType& type);
+
+//
+// Function: samplerTypeName
+// Returns: The lower-case name of a sampler.
+//
+const char* samplerTypeName(SamplerType type);
+
+//
+// Class: Sampler
+// The random numbers of one pixel sample, addressed by a dimension index: the n-th
+// decision of the sample's path (pixel jitter, area light point, Russian roulette,
+// hemisphere direction, SSS probe, light tree branch, ...) reads dimension n. Each value
+// depends only on the seed, the pixel, the sample index and the dimension, never on the
+// thread or on other pixels, so renders are reproducible bit for bit.
+//
+// The low-discrepancy samplers stratify each sample index across the samples of a pixel:
+// Halton uses the radical inverse in the dimension's prime base with hashed Owen scrambling
+// of its digits (dimensions past the prime table fall back to the hash). Sobol uses the
+// first two Sobol dimensions for every pair of dimensions, each pair with its own Owen
+// scrambling and shuffled sample order (Burley, "Practical Hash-based Owen Scrambling",
+// 2020), so every pair of consecutive dimensions is a well-distributed 2-D point set for
+// any sample count.
+//
+class Sampler {
+public:
+    //
+    // Constructor: Sampler
+    // Creates a sampler; RANDOM samplers leave the values to the thread's mt19937.
+    // Parameters:
+    //   - type: The kind of sequence.
+    //   - seed: The render seed, decorrelating renders with different seeds.
+    //
+    explicit Sampler(SamplerType type = SamplerType::RANDOM, uint64_t seed = 0)
+        : samplerType(type), seed(seed), pixel(0), sampleIndex(0), dimension(0) {}
+
+    //
+    // Method: type
+    // Returns: The kind of sequence.
+    //
+    SamplerType type() const { return samplerType; }
+
+    //
+    // Method: startSample
+    // Moves to a pixel sample.
+    // Parameters:
+    //   - pixel: The pixel index (y * width + x).
+    //   - sampleIndex: The index of the sample within the pixel.
+    //   - dimension: The first dimension to read.
+    //
+    void startSample(uint32_t pixel, uint32_t sampleIndex, uint32_t dimension) {
+        this->pixel = pixel;
+        this->sampleIndex = sampleIndex;
+        this->dimension = dimension;
+    }
+
+    //
+    // Method: next
+    // Returns: The value of the current dimension in [0, 1), then moves to the next one.
+    //
+    double next() {
+        return value(samplerType, seed, pixel, sampleIndex, dimension++);
+    }
+
+    //
+    // Function: value
+    // Returns: Dimension `dimension` of sample `sampleIndex` of a pixel, in [0, 1); not
+    //          defined for RANDOM.
+    //
+    static double value(SamplerType type, uint64_t seed, uint32_t pixel, uint32_t sampleIndex,
+                        uint32_t dimension);
+
+private:
+    SamplerType samplerType;   // The kind of sequence.
+    uint64_t seed;             // The render seed.
+    uint32_t pixel;            // The current pixel.
+    uint32_t sampleIndex;      // The current sample of the pixel.
+    uint32_t dimension;        // The dimension the next value is read from.
+};
+
+#endif // SAMPLER_H
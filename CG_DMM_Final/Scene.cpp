@@ -0,0 +1,115 @@
+#include "Scene.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//
+// Constructor: Scene
+// Creates an empty scene with the default soft blue background.
+//
+Scene::Scene()
+    : backgroundColor(0.2, 0.3, 0.5) {} // Soft blue background
+
+//
+// Destructor: ~Scene
+// Default destructor for the Scene class.
+//
+Scene::~Scene() {}
+
+//
+// Method: build
+// Builds the BVH, packs the primitives in its leaf order, collects their materials, builds
+// the light tree and samples the irradiance grid for subsurface scattering.
+//
+void Scene::build() {
+    bvh.build(spheres, triangles, meshes);
+    geometry.build(spheres, triangles, meshes, bvh.primitives);
+    materials.clear();
+    buildShading();
+    cacheFile.reset();   // Nothing refers to a previously loaded cache any more
+}
+
+//
+// Method: buildShading
+// Rebuilds the material list, the light tree and the irradiance grid from the objects'
+// materials and the lights, and empties the irradiance cache, keeping the BVH and the
+// packed geometry. Material entries
+// beyond the described objects are kept: a scene mapped from a cache has no meshes loaded,
+// so their materials stay as cached.
+//
+void Scene::buildShading() {
+    MappedArray<Material> described;
+    described.reserve(std::max(materials.size(), spheres.size() + triangles.size() + meshes.size()));
+    for (const Sphere& sphere : spheres) {
+        described.push_back(Material(sphere.color, sphere.specular, sphere.reflective,
+                                     sphere.subsurfaceRadius, sphere.scatteringCoefficient));
+    }
+    for (const Triangle& triangle : triangles) {
+        described.push_back(Material(triangle.color, triangle.specular, triangle.reflective,
+                                     triangle.subsurfaceRadius, triangle.scatteringCoefficient));
+    }
+    for (const Mesh& mesh : meshes) {
+        described.push_back(Material(mesh.color, mesh.specular, mesh.reflective,
+                                     mesh.subsurfaceRadius, mesh.scatteringCoefficient));
+    }
+    for (size_t i = described.size(); i < materials.size(); i++) described.push_back(materials[i]);
+    materials = std::move(described);
+
+    lightTree.build(lights);
+    irradiance.build(*this);
+    if (indirectCache) indirectCache->clear();
+}
+
+//
+// Method: intersect
+// Finds the closest sphere, triangle or mesh triangle hit by the ray with t_min < t < t_max.
+// Parameters:
+//   - ray: The ray to trace.
+//   - t_min, t_max: The accepted distance interval (exclusive).
+//   - hit: The closest hit (output).
+// Returns:
+//   - true if any object was hit, false otherwise.
+//
+bool Scene::intersect(const Ray& ray, Real t_min, Real t_max, Hit& hit) const {
+    return bvh.intersect(geometry, ray, t_min, t_max, hit);
+}
+
+//
+// Method: occluded
+// Reports whether anything blocks the shadow ray segment (0, t_max), trying the cached
+// blocker of the light before traversing the BVH.
+// Parameters:
+//   - ray: The shadow ray; its direction must be normalized.
+//   - t_max: The length of the segment.
+//   - lastOccluder: The cached blocker for this light (input/output; index -1 if none).
+// Returns:
+//   - true if the segment is blocked, false otherwise.
+//
+bool Scene::occluded(const Ray& ray, Real t_max, PrimitiveRef& lastOccluder) const {
+    if (geometry.contains(lastOccluder) && geometry.occludes(&lastOccluder, 1, ray, t_max, lastOccluder)) {
+        return true;
+    }
+    return bvh.occluded(geometry, ray, t_max, lastOccluder);
+}
+
+//
+// Method: material
+// Returns: The material of a hit primitive.
+//
+const Material& Scene::material(const PrimitiveRef& primitive) const {
+    return materials[geometry.materialId(primitive)];
+}
+
+//
+// Method: rayOffset
+// Returns: The offset of secondary ray origins: 1e-5, or four ulps of the largest
+// coordinate of the scene bounds if that is larger.
+//
+Real Scene::rayOffset() const {
+    const Real minimumOffset = 1e-5;
+    if (bvh.nodes.empty()) return minimumOffset;
+    const AABB& bounds = bvh.nodes[0].bounds;
+    Real extent = std::max({std::fabs(bounds.min.x), std::fabs(bounds.min.y), std::fabs(bounds.min.z),
+                            std::fabs(bounds.max.x), std::fabs(bounds.max.y), std::fabs(bounds.max.z)});
+    return std::max(minimumOffset, 4 * std::numeric_limits<Real>::epsilon() * extent);
+}
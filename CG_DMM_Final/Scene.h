@@ -0,0 +1,118 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <memory>
+#include <vector>
+#include "Color.h"
+#include "Sphere.h"
+#include "Triangle.h"
+#include "Mesh.h"
+#include "Light.h"
+#include "Material.h"
+#include "PackedGeometry.h"
+#include "BVH.h"
+#include "IrradianceCache.h"
+#include "IrradianceGrid.h"
+#include "LightTree.h"
+#include "MappedFile.h"
+
+//
+// Class: Scene
+// Holds every object, light and the background color of a scene.
+// A Scene is filled once (see setupScene and loadMesh), its acceleration structure is built with
+// build(), and it is then only read while rendering, so a single instance can be
+// shared by all render threads without locking. The one exception is the optional
+// irradiance cache, which renders fill as they go and which locks internally.
+//
+class Scene {
+public:
+    std::vector<Sphere> spheres;       // List of spheres in the scene.
+    std::vector<Triangle> triangles;   // List of triangles in the scene.
+    std::vector<Mesh> meshes;          // Indexed triangle meshes in the scene (see loadMesh).
+    std::vector<Light> lights;         // List of lights in the scene.
+    LightTree lightTree;               // Hierarchy over the point lights (see build).
+    int lightSamples = 0;              // Point lights picked from lightTree per shading point; 0 visits all.
+    Real rouletteThroughput = 0.1;     // Child rays below this path throughput play Russian roulette.
+    Real cullThroughput = 1.0 / 512;   // Child rays that can add less than this to a pixel are skipped.
+    Color backgroundColor;             // Color returned by rays that miss every object.
+    BVH bvh;                           // Hierarchy over spheres and triangles (see build).
+    PackedGeometry geometry;           // Intersection data in BVH leaf order (see build).
+    MappedArray<Material> materials;   // Shading data, indexed by PackedGeometry::materialId.
+    IrradianceGrid irradiance;         // Light visibility around translucent objects (see build).
+    std::unique_ptr<IrradianceCache> indirectCache;   // Interpolated indirect light, filled while rendering;
+                                                      // null traces one indirect ray per hit.
+    std::shared_ptr<MappedFile> cacheFile;   // The scene cache the built data is mapped from, if any
+                                             // (see SceneCache::load).
+
+    //
+    // Constructor: Scene
+    // Creates an empty scene with the default soft blue background.
+    //
+    Scene();
+
+    //
+    // Destructor: ~Scene
+    // Default destructor for the Scene class.
+    //
+    ~Scene();
+
+    //
+    // Method: build
+    // Builds the acceleration structure, the packed intersection data, the material list,
+    // the light tree and the irradiance grid used for subsurface scattering.
+    // Must be called after the last object is added and before rendering; call it again
+    // whenever objects change. Hits and occluders refer to packed primitive indices.
+    //
+    void build();
+
+    //
+    // Method: buildShading
+    // Rebuilds only what depends on materials and lights (the material list, the light tree
+    // and the irradiance grid) and empties the irradiance cache, keeping the BVH and the
+    // packed geometry; for edits that do not move any object. build() calls it.
+    //
+    void buildShading();
+
+    //
+    // Method: intersect
+    // Finds the closest sphere, triangle or mesh triangle hit by the ray with t_min < t < t_max.
+    // Parameters:
+    //   - ray: The ray to trace.
+    //   - t_min, t_max: The accepted distance interval (exclusive).
+    //   - hit: The closest hit (output).
+    // Returns:
+    //   - true if any object was hit, false otherwise.
+    //
+    bool intersect(const Ray& ray, Real t_min, Real t_max, Hit& hit) const;
+
+    //
+    // Method: occluded
+    // Reports whether anything blocks the shadow ray segment (0, t_max).
+    // The primitive that blocked the previous query of the same light is tested first,
+    // since neighbouring shadow samples are usually blocked by the same object; only if
+    // it misses is the BVH traversed, stopping at the first blocker.
+    // Parameters:
+    //   - ray: The shadow ray; its direction must be normalized.
+    //   - t_max: The length of the segment.
+    //   - lastOccluder: The cached blocker for this light (input/output; index -1 if none).
+    // Returns:
+    //   - true if the segment is blocked, false otherwise.
+    //
+    bool occluded(const Ray& ray, Real t_max, PrimitiveRef& lastOccluder) const;
+
+    //
+    // Method: material
+    // Returns: The material of a hit primitive.
+    //
+    const Material& material(const PrimitiveRef& primitive) const;
+
+    //
+    // Method: rayOffset
+    // Returns: How far secondary rays start off a surface along its normal, so they do not
+    // hit the surface they leave. This is 1e-5, widened to a few ulps of the largest
+    // coordinate in the scene when Real cannot resolve 1e-5 there (float mode).
+    //
+    Real rayOffset() const;
+};
+
+#endif // SCENE_H
@@ -0,0 +1,509 @@
+#include "SceneCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "MappedFile.h"
+
+namespace {
+
+const char MAGIC[8] = {'R', 'T', 'S', 'C', 'E', 'N', 'E', '\n'};
+const uint32_t BYTE_ORDER_MARK = 0x01020304;   // Reads back differently on a foreign byte order
+const uint64_t SECTION_ALIGNMENT = 64;         // Sections start on cache-line boundaries
+const int MAX_TREE_DEPTH = 128;                // Matches the BVH traversal stack.
+
+static_assert(std::is_trivially_copyable<BVHNode>::value, "BVHNode is stored as raw bytes");
+static_assert(std::is_trivially_copyable<Material>::value, "Material is stored as raw bytes");
+
+//
+// Struct: CacheHeader
+// The start of a cache file.
+//
+struct CacheHeader {
+    char magic[8];                 // MAGIC.
+    uint32_t version;              // SceneCache::VERSION of the writer.
+    uint32_t byteOrder;            // BYTE_ORDER_MARK in the writer's byte order.
+    uint64_t fingerprint;          // Fingerprint of the scene description.
+    uint64_t geometryFingerprint;  // Fingerprint of the geometry alone.
+    uint64_t fileSize;             // Size of the whole file, to detect truncation.
+    uint32_t layout[4];            // sizeof(BVHNode, PrimitiveRef, Material, Vector3D) of the writer.
+    uint32_t sectionCount;         // Number of entries in the section table.
+    uint32_t lightCount;           // Number of CachedLight records after the section table.
+    double background[3];          // The scene's background color.
+    double irradianceCellSize;     // IrradianceGrid::cellSize.
+    uint64_t irradianceLightCount; // IrradianceGrid::lightCount.
+};
+
+//
+// Struct: CacheSection
+// Where one array is stored.
+//
+struct CacheSection {
+    uint64_t offset;        // File offset of the first element.
+    uint64_t count;         // Number of elements.
+    uint64_t elementSize;   // sizeof(element) of the writer.
+};
+
+//
+// Struct: CachedLight
+// A light as stored in the file.
+//
+struct CachedLight {
+    uint64_t type;
+    double intensity;
+    double position[3];
+    double direction[3];
+    double radius;
+};
+
+//
+// Function: layoutOf
+// Returns: The struct sizes that must agree between writer and reader.
+//
+void layoutOf(uint32_t layout[4]) {
+    layout[0] = sizeof(BVHNode);
+    layout[1] = sizeof(PrimitiveRef);
+    layout[2] = sizeof(Material);
+    layout[3] = sizeof(Vector3D);
+}
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+//
+// Function: hashBytes
+// Folds bytes into an FNV-1a hash.
+//
+void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+}
+
+void hashValues(uint64_t& hash, std::initializer_list<double> values) {
+    for (double value : values) hashBytes(hash, &value, sizeof(value));
+}
+
+void hashVector(uint64_t& hash, const Vector3D& v) {
+    hashValues(hash, {v.x, v.y, v.z});
+}
+
+void hashColor(uint64_t& hash, const Color& c) {
+    hashValues(hash, {c.r, c.g, c.b});
+}
+
+//
+// Function: geometryValid
+// Checks, in one pass over the mapped arrays, that every index in the BVH and the packed
+// geometry stays inside the array it points into: child nodes, primitive references, mesh
+// vertex and normal indices and material ids. Children must follow their parent and be
+// reached once, so the tree has no cycles, and no leaf may be deeper than the traversal
+// stack.
+// Returns: true if the geometry can be traversed and shaded safely.
+//
+bool geometryValid(const Scene& scene) {
+    const BVH& bvh = scene.bvh;
+    const PackedGeometry& g = scene.geometry;
+
+    // The arrays of each primitive type must have the same length
+    size_t spheres = g.sphereMaterial.size();
+    for (size_t size : {g.sphereCenterX.size(), g.sphereCenterY.size(), g.sphereCenterZ.size(),
+                        g.sphereRadiusSquared.size(), g.sphereInvRadius.size()}) {
+        if (size != spheres) return false;
+    }
+    size_t triangles = g.triangleMaterial.size();
+    for (size_t size : {g.triangleAX.size(), g.triangleAY.size(), g.triangleAZ.size(),
+                        g.triangleEdge1X.size(), g.triangleEdge1Y.size(), g.triangleEdge1Z.size(),
+                        g.triangleEdge2X.size(), g.triangleEdge2Y.size(), g.triangleEdge2Z.size(),
+                        g.triangleNormalX.size(), g.triangleNormalY.size(), g.triangleNormalZ.size()}) {
+        if (size != triangles) return false;
+    }
+    size_t meshTriangles = g.meshTriangleMaterial.size();
+    if (g.meshTriangleVertices.size() != 3 * meshTriangles ||
+        (!g.meshTriangleNormals.empty() && g.meshTriangleNormals.size() != 3 * meshTriangles) ||
+        g.meshPositions.size() % 3 != 0 || g.meshNormals.size() % 3 != 0) {
+        return false;
+    }
+
+    size_t materials = scene.materials.size();
+    auto materialValid = [materials](int id) { return id >= 0 && static_cast<size_t>(id) < materials; };
+    for (size_t i = 0; i < spheres; i++) {
+        if (!materialValid(g.sphereMaterial[i])) return false;
+    }
+    for (size_t i = 0; i < triangles; i++) {
+        if (!materialValid(g.triangleMaterial[i])) return false;
+    }
+    for (size_t i = 0; i < meshTriangles; i++) {
+        if (!materialValid(g.meshTriangleMaterial[i])) return false;
+    }
+    size_t vertices = g.meshPositions.size() / 3, normals = g.meshNormals.size() / 3;
+    for (size_t i = 0; i < g.meshTriangleVertices.size(); i++) {
+        if (g.meshTriangleVertices[i] >= vertices) return false;
+    }
+    for (size_t i = 0; i < g.meshTriangleNormals.size(); i++) {
+        uint32_t normal = g.meshTriangleNormals[i];
+        if (normal != Mesh::NO_NORMAL && normal >= normals) return false;
+    }
+
+    for (size_t i = 0; i < bvh.primitives.size(); i++) {
+        const PrimitiveRef& primitive = bvh.primitives[i];
+        size_t count;
+        switch (primitive.type) {
+            case PrimitiveType::SPHERE: count = spheres; break;
+            case PrimitiveType::TRIANGLE: count = triangles; break;
+            case PrimitiveType::MESH_TRIANGLE: count = meshTriangles; break;
+            default: return false;
+        }
+        if (primitive.index < 0 || static_cast<size_t>(primitive.index) >= count) return false;
+    }
+
+    // The left child is the next node and the right child comes after it
+    std::vector<int> depth(bvh.nodes.size(), -1);
+    if (!depth.empty()) depth[0] = 0;
+    for (size_t i = 0; i < bvh.nodes.size(); i++) {
+        const BVHNode& node = bvh.nodes[i];
+        if (depth[i] < 0 || node.count < 0 || node.offset < 0) return false;
+        size_t offset = static_cast<size_t>(node.offset);
+        if (node.count > 0) {
+            if (offset > bvh.primitives.size() || static_cast<size_t>(node.count) > bvh.primitives.size() - offset) {
+                return false;
+            }
+            continue;
+        }
+        if (offset <= i + 1 || offset >= bvh.nodes.size() || depth[i + 1] >= 0 || depth[offset] >= 0 ||
+            depth[i] + 1 >= MAX_TREE_DEPTH) {
+            return false;
+        }
+        depth[i + 1] = depth[offset] = depth[i] + 1;
+    }
+    return true;
+}
+
+} // namespace
+
+//
+// Function: forEachArray
+// Calls visit(array) for every stored array of the scene, in file order.
+//
+template <typename SceneType, typename Visitor>
+void SceneCache::forEachArray(SceneType& scene, Visitor&& visit) {
+    auto& bvh = scene.bvh;
+    visit(bvh.nodes);
+    visit(bvh.primitives);
+
+    auto& g = scene.geometry;
+    visit(g.sphereCenterX); visit(g.sphereCenterY); visit(g.sphereCenterZ);
+    visit(g.sphereRadiusSquared); visit(g.sphereInvRadius); visit(g.sphereMaterial);
+    visit(g.triangleAX); visit(g.triangleAY); visit(g.triangleAZ);
+    visit(g.triangleEdge1X); visit(g.triangleEdge1Y); visit(g.triangleEdge1Z);
+    visit(g.triangleEdge2X); visit(g.triangleEdge2Y); visit(g.triangleEdge2Z);
+    visit(g.triangleNormalX); visit(g.triangleNormalY); visit(g.triangleNormalZ);
+    visit(g.triangleMaterial);
+    visit(g.meshPositions); visit(g.meshNormals);
+    visit(g.meshTriangleVertices); visit(g.meshTriangleNormals); visit(g.meshTriangleMaterial);
+
+    visit(scene.materials);
+
+    auto& grid = scene.irradiance;
+    visit(grid.slotKeys);
+    visit(grid.slotVertices);
+    visit(grid.visibility);
+}
+
+//
+// Function: fingerprint
+// Hashes the description of a scene: its spheres, triangles, meshes, lights and
+// background, plus a string naming inputs that are not in the scene yet.
+// Parameters:
+//   - scene: The scene, before build().
+//   - sources: Anything else the built scene depends on, e.g. mesh file paths and dates.
+// Returns: A 64-bit FNV-1a hash.
+//
+uint64_t SceneCache::fingerprint(const Scene& scene, const std::string& sources) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const Sphere& sphere : scene.spheres) {
+        hashVector(hash, sphere.center);
+        hashColor(hash, sphere.color);
+        hashValues(hash, {sphere.radius, sphere.specular, sphere.reflective,
+                          sphere.subsurfaceRadius, sphere.scatteringCoefficient});
+    }
+    for (const Triangle& triangle : scene.triangles) {
+        hashVector(hash, triangle.A);
+        hashVector(hash, triangle.B);
+        hashVector(hash, triangle.C);
+        hashColor(hash, triangle.color);
+        hashValues(hash, {triangle.specular, triangle.reflective,
+                          triangle.subsurfaceRadius, triangle.scatteringCoefficient});
+    }
+    for (const Mesh& mesh : scene.meshes) {
+        hashBytes(hash, mesh.positions.data(), mesh.positions.size() * sizeof(float));
+        hashBytes(hash, mesh.normals.data(), mesh.normals.size() * sizeof(float));
+        hashBytes(hash, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+        hashBytes(hash, mesh.normalIndices.data(), mesh.normalIndices.size() * sizeof(uint32_t));
+        hashColor(hash, mesh.color);
+        hashValues(hash, {mesh.specular, mesh.reflective, mesh.subsurfaceRadius, mesh.scatteringCoefficient});
+    }
+    for (const Light& light : scene.lights) {
+        hashValues(hash, {static_cast<double>(light.type), light.intensity, light.radius});
+        hashVector(hash, light.position);
+        hashVector(hash, light.direction);
+    }
+    hashColor(hash, scene.backgroundColor);
+    hashBytes(hash, sources.data(), sources.size());
+    return hash;
+}
+
+//
+// Function: geometryFingerprint
+// Hashes only the shapes of a scene: the positions and sizes of its spheres, triangles
+// and meshes, but not their materials, the lights or the background.
+// Parameters:
+//   - scene: The scene, before build().
+//   - sources: Anything else the geometry depends on, e.g. mesh file paths and dates.
+// Returns: A 64-bit FNV-1a hash.
+//
+uint64_t SceneCache::geometryFingerprint(const Scene& scene, const std::string& sources) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const Sphere& sphere : scene.spheres) {
+        hashVector(hash, sphere.center);
+        hashValues(hash, {sphere.radius});
+    }
+    for (const Triangle& triangle : scene.triangles) {
+        hashVector(hash, triangle.A);
+        hashVector(hash, triangle.B);
+        hashVector(hash, triangle.C);
+    }
+    for (const Mesh& mesh : scene.meshes) {
+        hashBytes(hash, mesh.positions.data(), mesh.positions.size() * sizeof(float));
+        hashBytes(hash, mesh.normals.data(), mesh.normals.size() * sizeof(float));
+        hashBytes(hash, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+        hashBytes(hash, mesh.normalIndices.data(), mesh.normalIndices.size() * sizeof(uint32_t));
+    }
+    hashBytes(hash, sources.data(), sources.size());
+    return hash;
+}
+
+//
+// Function: save
+// Writes a built scene to a cache file (via a temporary file that is then renamed).
+// Parameters:
+//   - scene: The built scene.
+//   - path: The cache file path.
+//   - fingerprint: The fingerprint of the scene's description.
+//   - geometryFingerprint: The geometry fingerprint of the scene's description.
+//   - error: A description of the failure (output, only written on failure).
+// Returns:
+//   - true on success, false if the file could not be written.
+//
+bool SceneCache::save(const Scene& scene, const std::string& path, uint64_t fingerprint,
+                      uint64_t geometryFingerprint, std::string& error) {
+    // Lay out the sections after the header, the section table and the lights
+    std::vector<CacheSection> sections;
+    forEachArray(scene, [&](const auto& array) {
+        sections.push_back(CacheSection{0, array.size(), sizeof(array[0])});
+    });
+    uint64_t offset = sizeof(CacheHeader) + sections.size() * sizeof(CacheSection) +
+                      scene.lights.size() * sizeof(CachedLight);
+    for (CacheSection& section : sections) {
+        section.offset = alignUp(offset);
+        offset = section.offset + section.count * section.elementSize;
+    }
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.fingerprint = fingerprint;
+    header.geometryFingerprint = geometryFingerprint;
+    header.fileSize = offset;
+    layoutOf(header.layout);
+    header.sectionCount = static_cast<uint32_t>(sections.size());
+    header.lightCount = static_cast<uint32_t>(scene.lights.size());
+    header.background[0] = scene.backgroundColor.r;
+    header.background[1] = scene.backgroundColor.g;
+    header.background[2] = scene.backgroundColor.b;
+    header.irradianceCellSize = scene.irradiance.cellSize;
+    header.irradianceLightCount = scene.irradiance.lightCount;
+
+    std::vector<CachedLight> lights;
+    for (const Light& light : scene.lights) {
+        lights.push_back(CachedLight{static_cast<uint64_t>(light.type), light.intensity,
+                                     {light.position.x, light.position.y, light.position.z},
+                                     {light.direction.x, light.direction.y, light.direction.z}, light.radius});
+    }
+
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(CacheSection));
+    file.write(reinterpret_cast<const char*>(lights.data()), lights.size() * sizeof(CachedLight));
+    size_t next = 0;
+    forEachArray(scene, [&](const auto& array) {
+        const CacheSection& section = sections[next++];
+        static const char padding[SECTION_ALIGNMENT] = {};
+        file.write(padding, static_cast<std::streamsize>(section.offset - static_cast<uint64_t>(file.tellp())));
+        file.write(reinterpret_cast<const char*>(array.data()),
+                   static_cast<std::streamsize>(section.count * section.elementSize));
+    });
+    file.close();
+    if (!file) {
+        error = "cannot write " + temporaryPath;
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        error = "cannot rename " + temporaryPath + " to " + path;
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+//
+// Function: load
+// Maps a cache file and makes the scene render from it. On success the scene's built
+// data (BVH, packed geometry, materials, irradiance grid), lights and background are
+// replaced; its spheres, triangles and meshes are left as they are. The scene keeps
+// the file mapped until it is destroyed or rebuilt.
+// Parameters:
+//   - scene: The scene to load into (output).
+//   - path: The cache file path.
+//   - fingerprint: The fingerprint the cache must have been written with.
+//   - error: Why the cache cannot be used (output, only written on failure).
+// Returns:
+//   - true on success, false if the file is missing, stale, corrupt or from another build.
+//
+bool SceneCache::load(Scene& scene, const std::string& path, uint64_t fingerprint, std::string& error) {
+    return mapFile(scene, path, fingerprint, false, error);
+}
+
+//
+// Function: loadGeometry
+// Maps only the BVH and packed geometry of a cache whose geometry matches the scene, and
+// rebuilds the materials, light tree and irradiance grid from the scene's current objects
+// and lights; mesh materials are kept from the file.
+// Parameters:
+//   - scene: The scene to load into (input/output).
+//   - path: The cache file path.
+//   - geometryFingerprint: The geometry fingerprint the cache must have been written with.
+//   - error: Why the cache cannot be used (output, only written on failure).
+// Returns:
+//   - true on success, false if the file is missing, stale, corrupt or from another build.
+//
+bool SceneCache::loadGeometry(Scene& scene, const std::string& path, uint64_t geometryFingerprint,
+                              std::string& error) {
+    if (!mapFile(scene, path, geometryFingerprint, true, error)) return false;
+    scene.buildShading();
+    return true;
+}
+
+//
+// Function: mapFile
+// Validates a cache file against one of its fingerprints, points the scene's arrays at its
+// sections and checks the indices stored in them (see geometryValid and
+// IrradianceGrid::isConsistent). The
+// lights and background are only replaced if `geometryOnly` is false.
+// Parameters:
+//   - scene: The scene to load into (output).
+//   - path: The cache file path.
+//   - fingerprint: The fingerprint, or with `geometryOnly` the geometry fingerprint, to match.
+//   - geometryOnly: Whether only the geometry has to match.
+//   - error: Why the cache cannot be used (output, only written on failure).
+// Returns:
+//   - true on success, false if the file is missing, stale, corrupt or from another build.
+//
+bool SceneCache::mapFile(Scene& scene, const std::string& path, uint64_t fingerprint, bool geometryOnly,
+                         std::string& error) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(path, error)) return false;
+
+    CacheHeader header;
+    if (file->size() < sizeof(header)) {
+        error = path + " is not a scene cache";
+        return false;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    uint32_t layout[4];
+    layoutOf(layout);
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = path + " is not a scene cache";
+        return false;
+    }
+    if (header.version != VERSION || header.byteOrder != BYTE_ORDER_MARK ||
+        std::memcmp(header.layout, layout, sizeof(layout)) != 0) {
+        error = path + " was written by an incompatible build";
+        return false;
+    }
+    if ((geometryOnly ? header.geometryFingerprint : header.fingerprint) != fingerprint) {
+        error = path + (geometryOnly ? " is stale (the geometry has changed)" : " is stale (the scene has changed)");
+        return false;
+    }
+
+    // Validate the section table before pointing anything into the file
+    std::vector<std::pair<uint64_t, size_t>> expected;   // Element size of each array
+    forEachArray(scene, [&](auto& array) { expected.emplace_back(sizeof(array[0]), 0); });
+    uint64_t tableEnd = sizeof(CacheHeader) + header.sectionCount * sizeof(CacheSection) +
+                        header.lightCount * sizeof(CachedLight);
+    if (header.fileSize != file->size() || header.sectionCount != expected.size() || tableEnd > file->size()) {
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+    const CacheSection* sections = reinterpret_cast<const CacheSection*>(file->data() + sizeof(CacheHeader));
+    for (size_t i = 0; i < expected.size(); i++) {
+        const CacheSection& section = sections[i];
+        bool valid = section.elementSize == expected[i].first && section.offset % SECTION_ALIGNMENT == 0 &&
+                     section.offset >= tableEnd && section.offset <= file->size() &&
+                     section.count <= (file->size() - section.offset) / section.elementSize;
+        if (!valid) {
+            error = path + " is truncated or corrupt";
+            return false;
+        }
+    }
+
+    // Point the arrays at their sections; only the lights are copied
+    size_t next = 0;
+    forEachArray(scene, [&](auto& array) {
+        using Element = std::remove_const_t<std::remove_reference_t<decltype(array[0])>>;
+        const CacheSection& section = sections[next++];
+        array.map(reinterpret_cast<const Element*>(file->data() + section.offset), section.count);
+    });
+
+    // Check every stored index once, so damaged contents fail here and not while rendering
+    const CachedLight* lights = reinterpret_cast<const CachedLight*>(
+        file->data() + sizeof(CacheHeader) + header.sectionCount * sizeof(CacheSection));
+    bool valid = geometryValid(scene);
+    if (valid && !geometryOnly) {
+        for (uint32_t i = 0; i < header.lightCount; i++) {
+            if (lights[i].type > static_cast<uint64_t>(LightType::DIRECTIONAL)) valid = false;
+        }
+        scene.irradiance.cellSize = header.irradianceCellSize;
+        scene.irradiance.lightCount = static_cast<size_t>(header.irradianceLightCount);
+        valid = valid && scene.irradiance.isConsistent(header.lightCount);
+    }
+    if (!valid) {
+        forEachArray(scene, [](auto& array) { array.clear(); });
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+
+    scene.cacheFile = file;
+    if (geometryOnly) return true;
+
+    scene.lights.clear();
+    for (uint32_t i = 0; i < header.lightCount; i++) {
+        Light light(lights[i].intensity);
+        light.type = static_cast<LightType>(lights[i].type);
+        light.position = Vector3D(lights[i].position[0], lights[i].position[1], lights[i].position[2]);
+        light.direction = Vector3D(lights[i].direction[0], lights[i].direction[1], lights[i].direction[2]);
+        light.radius = lights[i].radius;
+        scene.lights.push_back(light);
+    }
+    scene.lightTree.build(scene.lights);   // Small enough to rebuild on every load
+    scene.backgroundColor = Color(header.background[0], header.background[1], header.background[2]);
+    return true;
+}
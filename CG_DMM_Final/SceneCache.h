@@ -0,0 +1,116 @@
+#ifndef SCENECACHE_H
+#define SCENECACHE_H
+
+#include <cstdint>
+#include <string>
+#include "Scene.h"
+
+//
+// Class: SceneCache
+// A versioned binary file holding a built scene: the BVH, the packed geometry, the
+// materials, the irradiance grid, the lights and the background color.
+// Every array is stored as one 64-byte aligned section, located through a table of file
+// offsets (no pointers), so the file is relocatable. Loading maps the file and points the
+// scene's arrays (MappedArray) at the sections; nothing is parsed or copied except the
+// header and the lights, so a scene of millions of primitives is ready in milliseconds and
+// its pages are read from the page cache only when the renderer touches them.
+//
+// A cache is only valid for the build it was written by: the header records the format
+// version, the byte order and struct sizes of the writer, and a fingerprint of the scene
+// description (see fingerprint), all of which must match on load. It also records the
+// fingerprint of the geometry alone, so that after an edit of only lights or materials
+// loadGeometry can still map the BVH and packed geometry and rebuild just the rest.
+//
+class SceneCache {
+public:
+    static const uint32_t VERSION = 2;   // Bumped whenever the layout of any stored array changes.
+
+    //
+    // Function: fingerprint
+    // Hashes the description of a scene: its spheres, triangles, meshes, lights and
+    // background, plus a string naming inputs that are not in the scene yet.
+    // Parameters:
+    //   - scene: The scene, before build().
+    //   - sources: Anything else the built scene depends on, e.g. mesh file paths and dates.
+    // Returns: A 64-bit FNV-1a hash.
+    //
+    static uint64_t fingerprint(const Scene& scene, const std::string& sources);
+
+    //
+    // Function: geometryFingerprint
+    // Hashes only the shapes of a scene: the positions and sizes of its spheres, triangles
+    // and meshes, but not their materials, the lights or the background. Scenes with the
+    // same geometry fingerprint have the same primary hits and packed primitive order.
+    // Parameters:
+    //   - scene: The scene, before build().
+    //   - sources: Anything else the geometry depends on, e.g. mesh file paths and dates.
+    // Returns: A 64-bit FNV-1a hash.
+    //
+    static uint64_t geometryFingerprint(const Scene& scene, const std::string& sources);
+
+    //
+    // Function: save
+    // Writes a built scene to a cache file (via a temporary file that is then renamed).
+    // Parameters:
+    //   - scene: The built scene.
+    //   - path: The cache file path.
+    //   - fingerprint: The fingerprint of the scene's description.
+    //   - geometryFingerprint: The geometry fingerprint of the scene's description.
+    //   - error: A description of the failure (output, only written on failure).
+    // Returns:
+    //   - true on success, false if the file could not be written.
+    //
+    static bool save(const Scene& scene, const std::string& path, uint64_t fingerprint,
+                     uint64_t geometryFingerprint, std::string& error);
+
+    //
+    // Function: load
+    // Maps a cache file and makes the scene render from it. On success the scene's built
+    // data (BVH, packed geometry, materials, irradiance grid), lights and background are
+    // replaced; its spheres, triangles and meshes are left as they are. The scene keeps
+    // the file mapped until it is destroyed or rebuilt.
+    // Parameters:
+    //   - scene: The scene to load into (output).
+    //   - path: The cache file path.
+    //   - fingerprint: The fingerprint the cache must have been written with.
+    //   - error: Why the cache cannot be used (output, only written on failure).
+    // Returns:
+    //   - true on success, false if the file is missing, stale, corrupt or from another build.
+    //
+    static bool load(Scene& scene, const std::string& path, uint64_t fingerprint, std::string& error);
+
+    //
+    // Function: loadGeometry
+    // Maps only the BVH and packed geometry of a cache whose geometry matches the scene,
+    // and rebuilds the materials, light tree and irradiance grid from the scene's current
+    // objects and lights (Scene::buildShading); mesh materials are kept from the file. For
+    // a scene whose lights or materials changed since the cache was written.
+    // Parameters:
+    //   - scene: The scene to load into (input/output).
+    //   - path: The cache file path.
+    //   - geometryFingerprint: The geometry fingerprint the cache must have been written with.
+    //   - error: Why the cache cannot be used (output, only written on failure).
+    // Returns:
+    //   - true on success, false if the file is missing, stale, corrupt or from another build.
+    //
+    static bool loadGeometry(Scene& scene, const std::string& path, uint64_t geometryFingerprint,
+                             std::string& error);
+
+private:
+    //
+    // Function: mapFile
+    // Validates a cache file against one of its fingerprints and points the scene's arrays
+    // at its sections. The lights and background are only replaced if `geometryOnly` is false.
+    //
+    static bool mapFile(Scene& scene, const std::string& path, uint64_t fingerprint, bool geometryOnly,
+                        std::string& error);
+
+    //
+    // Function: forEachArray
+    // Calls visit(array) for every stored array of the scene, in file order.
+    //
+    template <typename SceneType, typename Visitor>
+    static void forEachArray(SceneType& scene, Visitor&& visit);
+};
+
+#endif // SCENECACHE_H
@@ -0,0 +1,79 @@
+#ifndef SIMDMATH_H
+#define SIMDMATH_H
+
+//
+// SIMD-backed small-vector math
+// Compiling with -DRAYTRACER_SIMD_MATH (e.g. `make CXXFLAGS=-DRAYTRACER_SIMD_MATH`) pads
+// Vector3D and Color to four scalars and implements their component-wise operators with
+// one 4-wide vector operation (for doubles one ymm register with AVX, two xmm registers
+// otherwise; for floats one xmm register).
+// Component-wise results are bitwise identical to the scalar build; dot and cross
+// products stay scalar, since horizontal operations gain nothing from the padding.
+//
+
+#ifdef RAYTRACER_SIMD_MATH
+
+#include <cstring>
+
+//
+// Struct: SimdLanes
+// Four scalars of type T in one GCC/Clang vector; the fourth lane is padding.
+//
+template <typename T> struct SimdLanes;
+template <> struct SimdLanes<double> { typedef double Type __attribute__((vector_size(4 * sizeof(double)))); };
+template <> struct SimdLanes<float> { typedef float Type __attribute__((vector_size(4 * sizeof(float)))); };
+
+template <typename T>
+using SimdLanes4 = typename SimdLanes<T>::Type;
+
+//
+// Function: simdLoad
+// Loads the four scalars starting at `source` into a vector.
+// Vectors are only ever passed by reference, so no function's ABI depends on AVX.
+//
+template <typename T>
+inline void simdLoad(const T* source, SimdLanes4<T>& lanes) {
+    std::memcpy(&lanes, source, sizeof(SimdLanes4<T>));
+}
+
+//
+// Function: simdStore
+// Stores a vector into the four scalars starting at `destination`.
+//
+template <typename T>
+inline void simdStore(const SimdLanes4<T>& lanes, T* destination) {
+    std::memcpy(destination, &lanes, sizeof(SimdLanes4<T>));
+}
+
+#endif // RAYTRACER_SIMD_MATH
+
+//
+// Function: constantEvaluated
+// Returns true while the compiler evaluates a constant expression, where the vector code
+// paths are not allowed (std::is_constant_evaluated before C++20).
+//
+constexpr bool constantEvaluated() {
+    return __builtin_is_constant_evaluated();
+}
+
+//
+// Function: fusedMultiplyAdd
+// Computes a * b + c, in a single rounding where the target has FMA instructions
+// (e.g. -march=native on x86-64) and as a multiply followed by an add otherwise, so the
+// default build keeps its exact results.
+//
+constexpr double fusedMultiplyAdd(double a, double b, double c) {
+#ifdef __FMA__
+    if (!constantEvaluated()) return __builtin_fma(a, b, c);
+#endif
+    return a * b + c;
+}
+
+constexpr float fusedMultiplyAdd(float a, float b, float c) {
+#ifdef __FMA__
+    if (!constantEvaluated()) return __builtin_fmaf(a, b, c);
+#endif
+    return a * b + c;
+}
+
+#endif // SIMDMATH_H
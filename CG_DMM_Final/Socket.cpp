@@ -0,0 +1,65 @@
+#include "Socket.h"
+#include <cerrno>
+#include <sys/socket.h>
+
+//
+// Function: sendAll
+// Writes a whole buffer to a socket; a closed peer gives false instead of SIGPIPE.
+// Parameters:
+//   - connection: The socket.
+//   - data: The bytes to write.
+//   - size: The number of bytes.
+// Returns:
+//   - true if every byte was written.
+//
+bool sendAll(int connection, const void* data, std::size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t sent = send(connection, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        bytes += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+//
+// Function: sendLine
+// Writes a line and its newline to a socket.
+// Returns:
+//   - true if the whole line was written.
+//
+bool sendLine(int connection, const std::string& line) {
+    std::string message = line + "\n";
+    return sendAll(connection, message.data(), message.size());
+}
+
+//
+// Constructor: LineReader
+// Parameters:
+//   - connection: The socket to read; it stays owned by the caller.
+//   - maxLength: The longest line accepted; longer lines are a protocol error.
+//
+LineReader::LineReader(int connection, std::size_t maxLength) : connection(connection), maxLength(maxLength) {}
+
+//
+// Method: next
+// Reads the next line, without the newline.
+// Returns:
+//   - false if the connection closed or the line is too long.
+//
+bool LineReader::next(std::string& line) {
+    std::size_t newline;
+    while ((newline = buffer.find('\n')) == std::string::npos) {
+        if (buffer.size() > maxLength) return false;
+        char chunk[4096];
+        ssize_t received = recv(connection, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        buffer.append(chunk, static_cast<std::size_t>(received));
+    }
+    line = buffer.substr(0, newline);
+    buffer.erase(0, newline + 1);
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef SOCKET_H
+#define SOCKET_H
+
+#include <cstddef>
+#include <string>
+
+//
+// Helpers for the line-based protocols of the render server and the tile farm, on blocking
+// stream sockets.
+//
+
+//
+// Function: sendAll
+// Writes a whole buffer to a socket; a closed peer gives false instead of SIGPIPE.
+// Parameters:
+//   - connection: The socket.
+//   - data: The bytes to write.
+//   - size: The number of bytes.
+// Returns:
+//   - true if every byte was written.
+//
+bool sendAll(int connection, const void* data, std::size_t size);
+
+//
+// Function: sendLine
+// Writes a line and its newline to a socket.
+// Returns:
+//   - true if the whole line was written.
+//
+bool sendLine(int connection, const std::string& line);
+
+//
+// Class: LineReader
+// Reads newline-terminated lines from a blocking socket.
+//
+class LineReader {
+public:
+    //
+    // Constructor: LineReader
+    // Parameters:
+    //   - connection: The socket to read; it stays owned by the caller.
+    //   - maxLength: The longest line accepted; longer lines are a protocol error.
+    //
+    LineReader(int connection, std::size_t maxLength);
+
+    //
+    // Method: next
+    // Reads the next line, without the newline.
+    // Returns:
+    //   - false if the connection closed or the line is too long.
+    //
+    bool next(std::string& line);
+
+private:
+    int connection;         // The socket.
+    std::size_t maxLength;  // The longest line accepted.
+    std::string buffer;     // Received bytes after the last line.
+};
+
+#endif // SOCKET_H
@@ -13,9 +13,10 @@
 //   - subsurfaceRadius: The radius for subsurface scattering effects.
 //   - scatteringCoefficient: The scattering coefficient for subsurface scattering.
 //
-Sphere::Sphere(const Vector3D& center, double radius, const Color& color,
-               double specular, double reflective,
-               double subsurfaceRadius, double scatteringCoefficient)
+template <typename T>
+SphereT<T>::SphereT(const Vector3T<T>& center, T radius, const ColorT<T>& color,
+                    T specular, T reflective,
+                    T subsurfaceRadius, T scatteringCoefficient)
     : center(center), 
       radius(radius), 
       color(color), 
@@ -28,10 +29,11 @@ Sphere::Sphere(const Vector3D& center, double radius, const Color& color,
 // Default Constructor: Sphere
 // Initializes a default sphere at the origin with a radius of 1, black color, and no reflectivity or scattering.
 //
-Sphere::Sphere()
-    : center(Vector3D()), 
+template <typename T>
+SphereT<T>::SphereT()
+    : center(Vector3T<T>()), 
       radius(1.0), 
-      color(Color()), 
+      color(ColorT<T>()), 
       specular(0.0), 
       reflective(0.0), 
       subsurfaceRadius(0.0), 
@@ -41,7 +43,8 @@ Sphere::Sphere()
 // Destructor: ~Sphere
 // Default destructor for the Sphere class.
 //
-Sphere::~Sphere() {}
+template <typename T>
+SphereT<T>::~SphereT() {}
 
 //
 // Method: intersect
@@ -52,20 +55,21 @@ Sphere::~Sphere() {}
 // Returns:
 //   - true if the ray intersects the sphere, false otherwise.
 //
-bool Sphere::intersect(const Ray& ray, double& t) const {
-    Vector3D oc = ray.origin - center;                 // Vector from ray origin to sphere center
-    double k1 = ray.direction.dot(ray.direction);      // Quadratic term coefficient
-    double k2 = 2 * oc.dot(ray.direction);            // Linear term coefficient
-    double k3 = oc.dot(oc) - radius * radius;         // Constant term
-    double discriminant = k2 * k2 - 4 * k1 * k3;      // Discriminant of the quadratic equation
+template <typename T>
+bool SphereT<T>::intersect(const RayT<T>& ray, T& t) const {
+    Vector3T<T> oc = ray.origin - center;              // Vector from ray origin to sphere center
+    T k1 = ray.direction.dot(ray.direction);           // Quadratic term coefficient
+    T k2 = 2 * oc.dot(ray.direction);                 // Linear term coefficient
+    T k3 = oc.dot(oc) - radius * radius;              // Constant term
+    T discriminant = k2 * k2 - 4 * k1 * k3;           // Discriminant of the quadratic equation
 
     if (discriminant < 0) {
         return false;                                 // No intersection if discriminant is negative
     }
 
-    double sqrtDiscriminant = std::sqrt(discriminant); // Square root of the discriminant
-    double t1 = (-k2 + sqrtDiscriminant) / (2 * k1);   // First root
-    double t2 = (-k2 - sqrtDiscriminant) / (2 * k1);   // Second root
+    T sqrtDiscriminant = std::sqrt(discriminant);      // Square root of the discriminant
+    T t1 = (-k2 + sqrtDiscriminant) / (2 * k1);        // First root
+    T t2 = (-k2 - sqrtDiscriminant) / (2 * k1);        // Second root
 
     if (t1 >= 0 && t2 >= 0) {
         t = std::min(t1, t2);                         // Choose the closest positive root
@@ -80,6 +84,41 @@ bool Sphere::intersect(const Ray& ray, double& t) const {
     return true;
 }
 
+//
+// Method: occludes
+// Any-hit test for shadow rays: reports whether the sphere blocks the ray segment (0, t_max).
+// With a normalized direction the roots are t = -b -/+ sqrt(b^2 - c), where b = oc.dir and
+// c = |oc|^2 - radius^2. Both root comparisons are done on squared values.
+// Parameters:
+//   - ray: The ray to test; its direction must be normalized.
+//   - t_max: The length of the segment.
+// Returns:
+//   - true if the sphere blocks the segment, false otherwise.
+//
+template <typename T>
+bool SphereT<T>::occludes(const RayT<T>& ray, T t_max) const {
+    Vector3T<T> oc = ray.origin - center;
+    T b = oc.dot(ray.direction);
+    T c = oc.dot(oc) - radius * radius;
+
+    if (c > 0.0) {
+        // Origin outside: the ray must point towards the sphere and the near root must be < t_max
+        if (b >= 0.0) return false;
+        T discriminant = b * b - c;
+        if (discriminant < 0.0) return false;
+        T m = -b - t_max;                             // near < t_max  <=>  m < sqrt(discriminant)
+        return m < 0.0 || m * m < discriminant;
+    }
+
+    if (c < 0.0) {
+        // Origin inside: the far root is the first positive one and must be < t_max
+        T m = t_max + b;                              // far < t_max  <=>  sqrt(discriminant) < m
+        return m > 0.0 && b * b - c < m * m;
+    }
+
+    return false;                                     // Origin on the surface: the hit is at t = 0
+}
+
 //
 // Method: getNormal
 // Computes the normal vector at a given point on the sphere's surface.
@@ -88,6 +127,23 @@ bool Sphere::intersect(const Ray& ray, double& t) const {
 // Returns:
 //   - The normalized normal vector at the given point.
 //
-Vector3D Sphere::getNormal(const Vector3D& point) const {
+template <typename T>
+Vector3T<T> SphereT<T>::getNormal(const Vector3T<T>& point) const {
     return (point - center).normalize();              // Normal vector is the direction from the center to the point
-}
\ No newline at end of file
+}
+
+//
+// Method: bounds
+// Computes the axis-aligned bounding box of the sphere.
+// Returns:
+//   - The smallest AABB containing the sphere.
+//
+template <typename T>
+AABB SphereT<T>::bounds() const {
+    Vector3T<T> extent(radius, radius, radius);
+    return AABB(Vector3D(center - extent), Vector3D(center + extent));
+}
+
+// Both precisions are compiled here, whichever one Real selects
+template class SphereT<float>;
+template class SphereT<double>;
@@ -4,20 +4,23 @@
 #include "Vector3D.h"
 #include "Color.h"
 #include "Ray.h"
+#include "AABB.h"
 
 //
-// Class: Sphere
+// Class: SphereT
 // Represents a 3D sphere in the scene with properties for shading, reflection, and subsurface scattering.
+// T is the scalar type; Sphere is the renderer's Real sphere (see Real.h).
 //
-class Sphere {
+template <typename T>
+class SphereT {
 public:
-    Vector3D center;               // The center of the sphere in 3D space.
-    double radius;                 // The radius of the sphere.
-    Color color;                   // The color of the sphere.
-    double specular;               // The specular reflection coefficient.
-    double reflective;             // The reflectivity of the sphere.
-    double subsurfaceRadius;       // The radius for subsurface scattering (SSS) effects.
-    double scatteringCoefficient;  // The scattering coefficient for subsurface scattering.
+    Vector3T<T> center;       // The center of the sphere in 3D space.
+    T radius;                 // The radius of the sphere.
+    ColorT<T> color;          // The color of the sphere.
+    T specular;               // The specular reflection coefficient.
+    T reflective;             // The reflectivity of the sphere.
+    T subsurfaceRadius;       // The radius for subsurface scattering (SSS) effects.
+    T scatteringCoefficient;  // The scattering coefficient for subsurface scattering.
 
     //
     // Constructor: Sphere
@@ -31,22 +34,22 @@ public:
     //   - subsurfaceRadius: (Optional) Radius for SSS effects. Default is 0.0.
     //   - scatteringCoefficient: (Optional) Scattering coefficient for SSS. Default is 0.0.
     //
-    Sphere(const Vector3D& center, double radius, const Color& color,
-           double specular, double reflective,
-           double subsurfaceRadius = 0.0, double scatteringCoefficient = 0.0);
+    SphereT(const Vector3T<T>& center, T radius, const ColorT<T>& color,
+            T specular, T reflective,
+            T subsurfaceRadius = 0, T scatteringCoefficient = 0);
 
     //
     // Default Constructor: Sphere
     // Initializes a default sphere at the origin with a radius of 1, black color,
     // no reflectivity, and no subsurface scattering.
     //
-    Sphere();
+    SphereT();
 
     //
     // Destructor: ~Sphere
     // Default destructor for the Sphere class.
     //
-    ~Sphere();
+    ~SphereT();
 
     //
     // Method: intersect
@@ -57,7 +60,20 @@ public:
     // Returns:
     //   - true if the ray intersects the sphere, false otherwise.
     //
-    bool intersect(const Ray& ray, double& t) const;
+    bool intersect(const RayT<T>& ray, T& t) const;
+
+    //
+    // Method: occludes
+    // Any-hit test for shadow rays: reports whether the sphere blocks the ray segment (0, t_max).
+    // Accepts exactly the hits that intersect() followed by a 0 < t < t_max check would, but
+    // rejects rays pointing away from the sphere first and needs no square root.
+    // Parameters:
+    //   - ray: The ray to test; its direction must be normalized.
+    //   - t_max: The length of the segment.
+    // Returns:
+    //   - true if the sphere blocks the segment, false otherwise.
+    //
+    bool occludes(const RayT<T>& ray, T t_max) const;
 
     //
     // Method: getNormal
@@ -67,7 +83,20 @@ public:
     // Returns:
     //   - The normalized normal vector at the given point.
     //
-    Vector3D getNormal(const Vector3D& point) const;
+    Vector3T<T> getNormal(const Vector3T<T>& point) const;
+
+    //
+    // Method: bounds
+    // Computes the axis-aligned bounding box of the sphere.
+    // Returns:
+    //   - The smallest AABB containing the sphere.
+    //
+    AABB bounds() const;
 };
 
-#endif // SPHERE_H
\ No newline at end of file
+extern template class SphereT<float>;
+extern template class SphereT<double>;
+
+typedef SphereT<Real> Sphere;
+
+#endif // SPHERE_H
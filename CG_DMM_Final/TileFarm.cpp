@@ -0,0 +1,668 @@
+#include "TileFarm.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Renderer.h"
+#include "SceneCache.h"
+#include "Socket.h"
+
+namespace {
+
+const int PROTOCOL_VERSION = 2;
+const int LISTEN_BACKLOG = 64;
+const int POLL_INTERVAL_MS = 250;           // How often the coordinator checks for silent workers
+const size_t MAX_LINE_LENGTH = 1 << 20;     // Longer lines are a protocol error
+const double CONNECT_TIMEOUT = 30.0;        // Seconds a worker keeps trying to reach the coordinator
+const int CONNECT_RETRY_MS = 250;
+const size_t PIXEL_BYTES = 3 * 8 + 4;       // Three doubles and a uint32
+
+//
+// Function: putUint32
+// Appends a value in little-endian byte order.
+//
+void putUint32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+//
+// Function: putDouble
+// Appends the IEEE bits of a value in little-endian byte order.
+//
+void putDouble(std::string& out, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<char>(bits >> (8 * i)));
+}
+
+//
+// Function: getUint32
+// Reads a little-endian value.
+//
+uint32_t getUint32(const unsigned char* data) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(data[i]) << (8 * i);
+    return value;
+}
+
+//
+// Function: getDouble
+// Reads the little-endian IEEE bits of a value.
+//
+double getDouble(const unsigned char* data) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) bits |= static_cast<uint64_t>(data[i]) << (8 * i);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//
+// Function: tileBytes
+// Returns: The size of a tile's pixels on the wire.
+//
+size_t tileBytes(const RenderSettings& settings, int tileIndex) {
+    int x0, y0, x1, y1;
+    tileBounds(settings, tileIndex, x0, y0, x1, y1);
+    return static_cast<size_t>(x1 - x0) * (y1 - y0) * PIXEL_BYTES;
+}
+
+//
+// Function: setNoDelay
+// Sends small messages at once instead of batching them (Nagle's algorithm).
+//
+void setNoDelay(int connection) {
+    int on = 1;
+    setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+//
+// Function: connectTo
+// Connects to HOST:PORT, trying every address the host resolves to.
+// Returns: The socket, or -1 with the reason in `error`.
+//
+int connectTo(const std::string& address, std::string& error) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == address.size()) {
+        error = "invalid coordinator address " + address + " (expected HOST:PORT)";
+        return -1;
+    }
+    std::string host = address.substr(0, colon);
+    std::string port = address.substr(colon + 1);
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    int status = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+    if (status != 0) {
+        error = "cannot resolve " + host + ": " + gai_strerror(status);
+        return -1;
+    }
+
+    int connection = -1;
+    for (addrinfo* candidate = addresses; candidate && connection < 0; candidate = candidate->ai_next) {
+        connection = socket(candidate->ai_family, candidate->ai_socktype | SOCK_CLOEXEC, candidate->ai_protocol);
+        if (connection < 0) continue;
+        if (connect(connection, candidate->ai_addr, candidate->ai_addrlen) != 0) {
+            error = "cannot connect to " + address + ": " + std::strerror(errno);
+            close(connection);
+            connection = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (connection >= 0) setNoDelay(connection);
+    return connection;
+}
+
+//
+// Class: TileQueue
+// The tiles a worker was handed and has not started yet, filled by the thread reading the
+// connection and emptied by the render threads.
+//
+class TileQueue {
+public:
+    //
+    // Method: push
+    // Queues a tile and wakes a render thread waiting for one.
+    //
+    void push(int tileIndex) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tiles.push_back(tileIndex);
+        }
+        ready.notify_one();
+    }
+
+    //
+    // Method: close
+    // Drops the tiles not started yet and lets every waiting render thread finish.
+    //
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tiles.clear();
+            closed = true;
+        }
+        ready.notify_all();
+    }
+
+    //
+    // Method: pop
+    // Waits for the next tile.
+    // Returns: Its index, or -1 once the queue is closed.
+    //
+    int pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return closed || !tiles.empty(); });
+        if (closed) return -1;
+        int tileIndex = tiles.front();
+        tiles.pop_front();
+        return tileIndex;
+    }
+
+private:
+    std::mutex mutex;                 // Guards the members below.
+    std::condition_variable ready;    // Signaled when a tile is queued or the queue closes.
+    std::deque<int> tiles;            // Tile indices, next first.
+    bool closed = false;              // Whether the frame is over.
+};
+
+} // namespace
+
+//
+// Function: farmFingerprint
+// Hashes the scene description and the shading parameters the pixels depend on.
+// Parameters:
+//   - scene: The scene, before build().
+//   - sources: Anything else the scene depends on that agrees between machines.
+// Returns: A 64-bit hash.
+//
+uint64_t farmFingerprint(const Scene& scene, const std::string& sources) {
+    // Hexadecimal floats name every bit of the parameters
+    std::ostringstream parameters;
+    parameters << std::hexfloat << sources << '\n' << scene.lightSamples << ' '
+               << static_cast<double>(scene.rouletteThroughput) << ' ' << static_cast<double>(scene.cullThroughput)
+               << ' ' << sizeof(Real);
+    return SceneCache::fingerprint(scene, parameters.str());
+}
+
+//
+// Constructor: FarmCoordinator
+// Creates a coordinator; nothing listens until listen() is called.
+// Parameters:
+//   - job: The frame's settings and camera.
+//   - fingerprint: The farmFingerprint of the coordinator's scene.
+//   - timeout: Seconds a worker with outstanding tiles may be silent before it is dropped.
+//
+FarmCoordinator::FarmCoordinator(const RenderJob& job, uint64_t fingerprint, double timeout)
+    : job(job), fingerprint(fingerprint), timeout(timeout), listener(-1), tilesLeft(0), workerCount(0),
+      reissued(0) {}
+
+//
+// Destructor: ~FarmCoordinator
+// Closes the listening socket and the worker connections.
+//
+FarmCoordinator::~FarmCoordinator() {
+    for (Worker& worker : workers) {
+        if (worker.connection >= 0) close(worker.connection);
+    }
+    if (listener >= 0) close(listener);
+}
+
+//
+// Method: listen
+// Binds a TCP socket on every IPv4 interface.
+// Parameters:
+//   - port: The port.
+//   - error: A description of the failure (output, only written on failure).
+// Returns:
+//   - true on success, false if the socket cannot be created or bound.
+//
+bool FarmCoordinator::listen(int port, std::string& error) {
+    if (port <= 0 || port > 65535) {
+        error = "invalid port " + std::to_string(port);
+        return false;
+    }
+    int descriptor = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (descriptor < 0) {
+        error = std::string("cannot create a socket: ") + std::strerror(errno);
+        return false;
+    }
+    // A coordinator restarted right after the last one can take over its port
+    int on = 1;
+    setsockopt(descriptor, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(descriptor, LISTEN_BACKLOG) != 0) {
+        error = "cannot listen on port " + std::to_string(port) + ": " + std::strerror(errno);
+        close(descriptor);
+        return false;
+    }
+    listener = descriptor;
+    return true;
+}
+
+//
+// Method: run
+// Hands out the tiles and merges their pixels until every tile is finished.
+// Parameters:
+//   - framebuffer: The output image; must match the job's resolution.
+//   - onRowsDone: Optional; called with [y0, y1) when every tile of a row of tiles is merged.
+//   - error: A description of the failure (output, only written on failure).
+// Returns:
+//   - true when every tile is merged, false if the listening socket failed or a worker
+//     refused the job.
+//
+bool FarmCoordinator::run(Framebuffer& framebuffer, const std::function<void(int, int)>& onRowsDone,
+                          std::string& error) {
+    const RenderSettings& settings = job.settings;
+    int tiles = tileCount(settings);
+    int tilesX = (settings.width + settings.tileSize - 1) / settings.tileSize;
+    pending.clear();
+    for (int i = 0; i < tiles; i++) pending.push_back(i);
+    finished.assign(tiles, 0);
+    rowTilesLeft.assign((tiles + tilesX - 1) / tilesX, tilesX);
+    tilesLeft = tiles;
+    refusal.clear();
+
+    std::vector<pollfd> descriptors;
+    while (tilesLeft > 0) {
+        // The listener first, then every worker in order
+        descriptors.clear();
+        descriptors.push_back(pollfd{listener, POLLIN, 0});
+        for (const Worker& worker : workers) descriptors.push_back(pollfd{worker.connection, POLLIN, 0});
+        int ready = poll(descriptors.data(), descriptors.size(), POLL_INTERVAL_MS);
+        if (ready < 0 && errno != EINTR) {
+            error = std::string("cannot wait for workers: ") + std::strerror(errno);
+            return false;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; ready > 0 && i < workers.size(); i++) {
+            Worker& worker = workers[i];
+            if (!(descriptors[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            char chunk[65536];
+            ssize_t received = recv(worker.connection, chunk, sizeof(chunk), 0);
+            if (received < 0 && errno == EINTR) continue;
+            if (received <= 0) {
+                drop(worker, "closed the connection");
+                continue;
+            }
+            worker.input.append(chunk, static_cast<size_t>(received));
+            worker.lastHeard = now;
+            if (!process(worker, framebuffer, onRowsDone)) {
+                if (!refusal.empty()) {
+                    error = refusal;
+                    return false;
+                }
+                drop(worker, "sent an invalid message");
+            }
+        }
+
+        // Workers that are busy (or never said hello) but silent are presumed dead
+        for (Worker& worker : workers) {
+            if (worker.connection < 0 || (worker.threads > 0 && worker.assigned.empty())) continue;
+            if (std::chrono::duration<double>(now - worker.lastHeard).count() > timeout) {
+                drop(worker, "timed out");
+            }
+        }
+        workers.erase(std::remove_if(workers.begin(), workers.end(),
+                                     [](const Worker& worker) { return worker.connection < 0; }),
+                      workers.end());
+
+        // Dropped workers' tiles go to the others, then to newcomers
+        for (Worker& worker : workers) {
+            if (worker.threads > 0 && !assign(worker)) drop(worker, "closed the connection");
+        }
+        if (descriptors[0].revents & POLLIN) accept();
+    }
+
+    for (Worker& worker : workers) {
+        if (worker.connection < 0) continue;
+        sendLine(worker.connection, "done");
+        close(worker.connection);
+        worker.connection = -1;
+    }
+    workers.clear();
+    return true;
+}
+
+//
+// Method: workersSeen
+// Returns: The number of workers that were handed tiles.
+//
+int FarmCoordinator::workersSeen() const {
+    return workerCount;
+}
+
+//
+// Method: reissuedTiles
+// Returns: The number of tiles that were queued again after their worker was dropped.
+//
+int FarmCoordinator::reissuedTiles() const {
+    return reissued;
+}
+
+//
+// Method: accept
+// Accepts a pending connection as a new worker.
+//
+void FarmCoordinator::accept() {
+    int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (connection < 0) return;   // Interrupted, or the worker gave up before being accepted
+    setNoDelay(connection);
+    Worker worker;
+    worker.connection = connection;
+    worker.lastHeard = std::chrono::steady_clock::now();
+    workers.push_back(std::move(worker));
+}
+
+//
+// Method: process
+// Handles the complete messages in a worker's input: the hello, then tile results and
+// heartbeats.
+// Returns: false if the worker must be dropped, or refused the job (see `refusal`).
+//
+bool FarmCoordinator::process(Worker& worker, Framebuffer& framebuffer,
+                              const std::function<void(int, int)>& onRowsDone) {
+    while (true) {
+        size_t newline = worker.input.find('\n');
+        if (newline == std::string::npos) return worker.input.size() <= MAX_LINE_LENGTH;
+        std::istringstream fields(worker.input.substr(0, newline));
+        std::string word;
+        fields >> word;
+
+        if (worker.threads == 0) {
+            // The hello: the worker must render the same scene with the same build
+            int version = 0, threads = 0;
+            std::string workerFingerprint;
+            if (word != "hello" || !(fields >> version >> workerFingerprint >> threads) || threads <= 0) return false;
+            worker.input.erase(0, newline + 1);
+            std::ostringstream expected;
+            expected << std::hex << fingerprint;
+            if (version != PROTOCOL_VERSION || workerFingerprint != expected.str()) {
+                const char* reason = version != PROTOCOL_VERSION ? "protocol version mismatch"
+                                                                 : "scene fingerprint mismatch";
+                std::cerr << "Warning: refused a worker: " << reason << ".\n";
+                sendLine(worker.connection, std::string("error ") + reason);
+                return false;
+            }
+            worker.threads = threads;
+            workerCount++;
+            std::ostringstream heartbeat;
+            heartbeat.precision(std::numeric_limits<double>::max_digits10);
+            heartbeat << "heartbeat " << timeout / 4;
+            if (!sendLine(worker.connection, formatRenderJob(job)) || !sendLine(worker.connection, heartbeat.str())) {
+                return false;
+            }
+            continue;
+        }
+
+        // The worker cannot render the job; no other worker of this build can either
+        if (word == "error") {
+            std::string reason;
+            std::getline(fields >> std::ws, reason);
+            refusal = "a worker refused the job: " + reason;
+            return false;
+        }
+
+        // Sent while a long tile renders, only to update lastHeard
+        if (word == "alive") {
+            worker.input.erase(0, newline + 1);
+            continue;
+        }
+
+        // A tile result: the header line and the pixels, once all of them arrived
+        int tileIndex = -1;
+        size_t bytes = 0;
+        if (word != "tile" || !(fields >> tileIndex >> bytes)) return false;
+        auto assigned = std::find(worker.assigned.begin(), worker.assigned.end(), tileIndex);
+        if (assigned == worker.assigned.end() || bytes != tileBytes(job.settings, tileIndex)) return false;
+        if (worker.input.size() < newline + 1 + bytes) return true;
+
+        worker.assigned.erase(assigned);
+        if (!finished[tileIndex]) {
+            merge(tileIndex, reinterpret_cast<const unsigned char*>(worker.input.data()) + newline + 1, framebuffer);
+            finished[tileIndex] = 1;
+            tilesLeft--;
+            int tilesX = (job.settings.width + job.settings.tileSize - 1) / job.settings.tileSize;
+            int tileRow = tileIndex / tilesX;
+            if (--rowTilesLeft[tileRow] == 0 && onRowsDone) {
+                int y0 = tileRow * job.settings.tileSize;
+                onRowsDone(y0, std::min(y0 + job.settings.tileSize, job.settings.height));
+            }
+        }
+        worker.input.erase(0, newline + 1 + bytes);
+    }
+}
+
+//
+// Method: assign
+// Hands queued tiles to a worker until it has its share outstanding.
+// Returns: false if the worker must be dropped.
+//
+bool FarmCoordinator::assign(Worker& worker) {
+    if (worker.connection < 0) return true;
+    size_t share = static_cast<size_t>(worker.threads) * TILES_PER_THREAD;
+    std::string line = "tiles";
+    size_t before = worker.assigned.size();
+    while (worker.assigned.size() < share && !pending.empty()) {
+        int tileIndex = pending.front();
+        pending.pop_front();
+        if (finished[tileIndex]) continue;
+        worker.assigned.push_back(tileIndex);
+        line += " " + std::to_string(tileIndex);
+    }
+    if (worker.assigned.size() == before) return true;
+    if (before == 0) worker.lastHeard = std::chrono::steady_clock::now();   // Idle time does not count
+    return sendLine(worker.connection, line);
+}
+
+//
+// Method: drop
+// Closes a worker's connection and queues its unfinished tiles again, in their order, ahead
+// of the tiles not handed out yet.
+//
+void FarmCoordinator::drop(Worker& worker, const char* reason) {
+    if (worker.connection < 0) return;
+    close(worker.connection);
+    worker.connection = -1;
+    int requeued = 0;
+    for (auto tile = worker.assigned.rbegin(); tile != worker.assigned.rend(); ++tile) {
+        if (finished[*tile]) continue;
+        pending.push_front(*tile);
+        requeued++;
+    }
+    worker.assigned.clear();
+    reissued += requeued;
+    if (worker.threads > 0) {
+        std::cerr << "Warning: a worker " << reason << "; " << requeued << " of its tiles are handed out again.\n";
+    }
+}
+
+//
+// Method: merge
+// Copies the pixels of a returned tile into the framebuffer.
+//
+void FarmCoordinator::merge(int tileIndex, const unsigned char* data, Framebuffer& framebuffer) {
+    int x0, y0, x1, y1;
+    tileBounds(job.settings, tileIndex, x0, y0, x1, y1);
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++, data += PIXEL_BYTES) {
+            framebuffer.setPixel(x, y, Color(static_cast<Real>(getDouble(data)), static_cast<Real>(getDouble(data + 8)),
+                                             static_cast<Real>(getDouble(data + 16))));
+            framebuffer.setSampleCount(x, y, static_cast<int>(getUint32(data + 24)));
+        }
+    }
+}
+
+//
+// Function: runFarmWorker
+// Renders the tiles a coordinator hands out until it reports the frame done.
+// Parameters:
+//   - address: The coordinator as HOST:PORT.
+//   - scene: The built scene.
+//   - fingerprint: The farmFingerprint of the scene.
+//   - defaults: Settings that do not affect the image; the job replaces the rest.
+//   - threadCount: Render threads. Values <= 0 use the hardware concurrency.
+//   - tilesRendered: The number of tiles this worker rendered (output).
+//   - error: A description of the failure (output, only written on failure).
+// Returns:
+//   - true when the coordinator sent "done", false on a connection or protocol failure.
+//
+bool runFarmWorker(const std::string& address, const Scene& scene, uint64_t fingerprint,
+                   const RenderSettings& defaults, int threadCount, int& tilesRendered, std::string& error) {
+    tilesRendered = 0;
+
+    // The coordinator may not be listening yet
+    auto start = std::chrono::steady_clock::now();
+    int connection;
+    while ((connection = connectTo(address, error)) < 0) {
+        if (error.find("cannot connect") != 0 ||
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > CONNECT_TIMEOUT) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(CONNECT_RETRY_MS));
+    }
+
+    Renderer renderer(threadCount);
+    std::ostringstream hello;
+    hello << "hello " << PROTOCOL_VERSION << " " << std::hex << fingerprint << std::dec << " " << renderer.threadCount();
+    LineReader reader(connection, MAX_LINE_LENGTH);
+    std::string line;
+    RenderJob job;
+    job.settings = defaults;
+    bool joined = sendLine(connection, hello.str()) && reader.next(line);
+    if (joined && line.compare(0, 6, "error ") == 0) {
+        error = "the coordinator refused this worker: " + line.substr(6);
+        close(connection);
+        return false;
+    }
+    if (!joined) {
+        error = "the coordinator closed the connection";
+        close(connection);
+        return false;
+    }
+    // A job this worker cannot render fails the frame, instead of going to the next worker
+    if (!parseRenderJob(line, job, error)) {
+        sendLine(connection, "error invalid job: " + error);
+        error = "invalid job from the coordinator: " + error;
+        close(connection);
+        return false;
+    }
+    double heartbeatSeconds = 0.0;
+    std::string keyword;
+    if (reader.next(line)) {
+        std::istringstream fields(line);
+        fields >> keyword >> heartbeatSeconds;
+    }
+    if (keyword != "heartbeat" || !(heartbeatSeconds > 0)) {
+        sendLine(connection, "error invalid heartbeat");
+        error = "invalid heartbeat from the coordinator";
+        close(connection);
+        return false;
+    }
+
+    const RenderSettings& settings = job.settings;
+    Camera camera(job.position, job.target, job.up, static_cast<Real>(settings.width) / settings.height);
+    Framebuffer framebuffer(settings.width, settings.height);
+    int tiles = tileCount(settings);
+
+    // Render threads send each tile as soon as it is finished
+    std::mutex sendMutex;
+    std::atomic<bool> connected(true);
+    auto sendTile = [&](int tileIndex) {
+        int x0, y0, x1, y1;
+        tileBounds(settings, tileIndex, x0, y0, x1, y1);
+        std::string message = "tile " + std::to_string(tileIndex) + " " +
+                              std::to_string(tileBytes(settings, tileIndex)) + "\n";
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                const Color& color = framebuffer.getPixel(x, y);
+                putDouble(message, color.r);
+                putDouble(message, color.g);
+                putDouble(message, color.b);
+                putUint32(message, static_cast<uint32_t>(framebuffer.getSampleCount(x, y)));
+            }
+        }
+        std::lock_guard<std::mutex> lock(sendMutex);
+        connected = connected && sendAll(connection, message.data(), message.size());
+        tilesRendered++;
+    };
+
+    // Between tiles the coordinator hears "alive", so a worker busy with long tiles is not
+    // taken for a dead one
+    bool stopping = false;
+    std::condition_variable stopCondition;
+    std::thread heartbeat([&] {
+        std::unique_lock<std::mutex> lock(sendMutex);
+        std::chrono::duration<double> interval(heartbeatSeconds);
+        while (!stopCondition.wait_for(lock, interval, [&] { return stopping; })) {
+            connected = connected && sendLine(connection, "alive");
+        }
+    });
+
+    // The render threads take tiles as soon as they arrive, so they do not wait for the
+    // rest of a batch before the next one starts
+    TileQueue queue;
+    std::thread rendering([&] {
+        renderer.renderTileStream(scene, camera, settings, [&] { return queue.pop(); }, framebuffer, sendTile);
+    });
+
+    bool done = false;
+    while (!done && connected && reader.next(line)) {
+        std::istringstream fields(line);
+        std::string word;
+        fields >> word;
+        if (word == "done") {
+            done = true;
+        } else if (word == "tiles") {
+            std::vector<int> batch;
+            std::string index;
+            bool valid = true;
+            while (valid && fields >> index) {
+                char* end;
+                long tileIndex = std::strtol(index.c_str(), &end, 10);
+                valid = *end == '\0' && tileIndex >= 0 && tileIndex < tiles;
+                batch.push_back(static_cast<int>(tileIndex));
+            }
+            if (!valid || batch.empty()) break;
+            for (int tileIndex : batch) queue.push(tileIndex);
+        } else {
+            break;
+        }
+    }
+    queue.close();
+    rendering.join();
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        stopping = true;
+    }
+    stopCondition.notify_all();
+    heartbeat.join();
+    close(connection);
+    if (!done) error = connected ? "unexpected message or closed connection from the coordinator"
+                                 : "the coordinator closed the connection";
+    return done;
+}
@@ -0,0 +1,200 @@
+#ifndef TILEFARM_H
+#define TILEFARM_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Framebuffer.h"
+#include "RenderServer.h"
+#include "Scene.h"
+
+//
+// Function: farmFingerprint
+// Hashes everything besides the job that the pixels of a tile farm depend on: the scene
+// description (see SceneCache::fingerprint), the light sampling, roulette and culling
+// parameters, and the size of Real. The coordinator only hands tiles to workers with the
+// same fingerprint.
+// Parameters:
+//   - scene: The scene, before build().
+//   - sources: Anything else the scene depends on that agrees between machines, e.g. the
+//     names and sizes of mesh files.
+// Returns: A 64-bit hash.
+//
+uint64_t farmFingerprint(const Scene& scene, const std::string& sources);
+
+//
+// Class: FarmCoordinator
+// Renders one frame on a farm of worker processes (see runFarmWorker), which connect over
+// TCP from this machine or others; the coordinator itself traces no rays. The frame is
+// split into its render tiles, which are handed out in batches: each worker has up to
+// TILES_PER_THREAD tiles per render thread outstanding and gets more as its results come
+// in, so fast workers take more tiles, and the next tiles are queued on the worker before
+// its threads run out of work. The protocol is line-based, as the render server's:
+//
+//   worker:       hello <version> <fingerprint> <threads>
+//   coordinator:  render width=... (see formatRenderJob), or error <message>
+//   coordinator:  heartbeat <seconds>
+//   coordinator:  tiles <index> <index> ...
+//   worker:       tile <index> <bytes>, followed by the tile's pixels
+//   worker:       alive, or error <message> if it cannot render the job
+//   coordinator:  done
+//
+// A tile's pixels are its accumulated colors and sample counts, row by row: per pixel the
+// three channels as little-endian IEEE doubles and the count as a little-endian uint32.
+//
+// Workers send "alive" every heartbeat interval, a quarter of the timeout, also while a
+// tile renders. A worker that closes its connection, sends anything unexpected, or is
+// silent for longer than the timeout while it has tiles outstanding is dropped, and its
+// unfinished tiles go back to the front of the queue for the next worker with room. Every
+// tile is seeded from its index (see tileSeed) and rendered whole by one process, so its
+// pixels do not depend on which worker rendered it, on how many threads it has, or on
+// which tiles it rendered before; the first result of a tile is kept. The merged image is
+// therefore the same, bit for bit, as a render of the whole frame by one process of the
+// same build, however the tiles were assigned. (The irradiance cache would break this,
+// and is not supported.)
+//
+class FarmCoordinator {
+public:
+    //
+    // Constructor: FarmCoordinator
+    // Creates a coordinator; nothing listens until listen() is called.
+    // Parameters:
+    //   - job: The frame's settings and camera; the output path is not used.
+    //   - fingerprint: The farmFingerprint of the coordinator's scene.
+    //   - timeout: Seconds a worker with outstanding tiles may be silent before it is dropped.
+    //
+    FarmCoordinator(const RenderJob& job, uint64_t fingerprint, double timeout);
+
+    //
+    // Destructor: ~FarmCoordinator
+    // Closes the listening socket and the worker connections.
+    //
+    ~FarmCoordinator();
+
+    FarmCoordinator(const FarmCoordinator&) = delete;
+    FarmCoordinator& operator=(const FarmCoordinator&) = delete;
+
+    //
+    // Method: listen
+    // Binds a TCP socket on every IPv4 interface.
+    // Parameters:
+    //   - port: The port.
+    //   - error: A description of the failure (output, only written on failure).
+    // Returns:
+    //   - true on success, false if the socket cannot be created or bound.
+    //
+    bool listen(int port, std::string& error);
+
+    //
+    // Method: run
+    // Hands out the tiles and merges their pixels into the framebuffer until every tile is
+    // finished, then sends "done" to the workers. Waits for workers as long as it takes.
+    // Parameters:
+    //   - framebuffer: The output image; must match the job's resolution.
+    //   - onRowsDone: Optional; called with [y0, y1) as soon as every tile of a row of tiles
+    //     is merged, e.g. to stream the rows to an ImageWriter.
+    //   - error: A description of the failure (output, only written on failure).
+    // Returns:
+    //   - true when every tile is merged, false if the listening socket failed or a worker
+    //     refused the job (which every worker of the same build would).
+    //
+    bool run(Framebuffer& framebuffer, const std::function<void(int, int)>& onRowsDone, std::string& error);
+
+    //
+    // Method: workersSeen
+    // Returns: The number of workers that were handed tiles.
+    //
+    int workersSeen() const;
+
+    //
+    // Method: reissuedTiles
+    // Returns: The number of tiles that were queued again after their worker was dropped.
+    //
+    int reissuedTiles() const;
+
+private:
+    //
+    // Struct: Worker
+    // The coordinator's view of one connected worker.
+    //
+    struct Worker {
+        int connection;                                       // The socket, or -1 once dropped.
+        std::string input;                                    // Received bytes not yet processed.
+        std::vector<int> assigned;                            // Tiles handed out and not yet returned.
+        int threads = 0;                                      // Render threads; 0 before the hello.
+        std::chrono::steady_clock::time_point lastHeard;      // When the worker last sent anything.
+    };
+
+    static const int TILES_PER_THREAD = 2;
+
+    //
+    // Method: accept
+    // Accepts a pending connection as a new worker.
+    //
+    void accept();
+
+    //
+    // Method: process
+    // Handles the complete messages in a worker's input.
+    // Returns: false if the worker must be dropped, or refused the job (see `refusal`).
+    //
+    bool process(Worker& worker, Framebuffer& framebuffer, const std::function<void(int, int)>& onRowsDone);
+
+    //
+    // Method: assign
+    // Hands queued tiles to a worker until it has its share outstanding.
+    // Returns: false if the worker must be dropped.
+    //
+    bool assign(Worker& worker);
+
+    //
+    // Method: drop
+    // Closes a worker's connection and queues its unfinished tiles again.
+    //
+    void drop(Worker& worker, const char* reason);
+
+    //
+    // Method: merge
+    // Copies the pixels of a returned tile into the framebuffer.
+    //
+    void merge(int tileIndex, const unsigned char* data, Framebuffer& framebuffer);
+
+    RenderJob job;                          // The frame.
+    uint64_t fingerprint;                   // The coordinator's farmFingerprint.
+    double timeout;                         // Seconds a busy worker may be silent.
+    int listener;                           // The listening socket, or -1.
+    std::vector<Worker> workers;            // The connected workers.
+    std::deque<int> pending;                // Tiles not handed out, next first.
+    std::vector<char> finished;             // Whether each tile is merged.
+    std::vector<int> rowTilesLeft;          // Unmerged tiles of each row of tiles.
+    int tilesLeft;                          // Unmerged tiles.
+    int workerCount;                        // Workers that were handed tiles.
+    int reissued;                           // Tiles queued again.
+    std::string refusal;                    // Why a worker refused the job, if one did.
+};
+
+//
+// Function: runFarmWorker
+// Works for a FarmCoordinator: connects (retrying while the coordinator is not up yet),
+// queues the tiles it hands out for renderTileStream, whose threads start on them as soon
+// as they arrive, and sends each one back as soon as it is finished, until the coordinator
+// reports the frame done. A side thread sends the heartbeat the coordinator asked for.
+// Parameters:
+//   - address: The coordinator as HOST:PORT.
+//   - scene: The built scene; its farmFingerprint must match the coordinator's.
+//   - fingerprint: The farmFingerprint of the scene.
+//   - defaults: Settings that do not affect the image (instruction set, shader); the job
+//     replaces the rest.
+//   - threadCount: Render threads. Values <= 0 use the hardware concurrency.
+//   - tilesRendered: The number of tiles this worker rendered (output).
+//   - error: A description of the failure (output, only written on failure).
+// Returns:
+//   - true when the coordinator sent "done", false on a connection or protocol failure.
+//
+bool runFarmWorker(const std::string& address, const Scene& scene, uint64_t fingerprint,
+                   const RenderSettings& defaults, int threadCount, int& tilesRendered, std::string& error);
+
+#endif // TILEFARM_H
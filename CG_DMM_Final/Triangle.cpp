@@ -12,9 +12,10 @@
 //   - subsurfaceRadius: The radius for subsurface scattering effects.
 //   - scatteringCoefficient: The scattering coefficient for subsurface scattering.
 //
-Triangle::Triangle(const Vector3D& A, const Vector3D& B, const Vector3D& C,
-                   const Color& color, double specular, double reflective,
-                   double subsurfaceRadius, double scatteringCoefficient)
+template <typename T>
+TriangleT<T>::TriangleT(const Vector3T<T>& A, const Vector3T<T>& B, const Vector3T<T>& C,
+                        const ColorT<T>& color, T specular, T reflective,
+                        T subsurfaceRadius, T scatteringCoefficient)
     : A(A), 
       B(B), 
       C(C), 
@@ -28,7 +29,8 @@ Triangle::Triangle(const Vector3D& A, const Vector3D& B, const Vector3D& C,
 // Destructor: ~Triangle
 // Default destructor for the Triangle class.
 //
-Triangle::~Triangle() {}
+template <typename T>
+TriangleT<T>::~TriangleT() {}
 
 //
 // Method: intersect
@@ -39,28 +41,29 @@ Triangle::~Triangle() {}
 // Returns:
 //   - true if the ray intersects the triangle, false otherwise.
 //
-bool Triangle::intersect(const Ray& ray, double& t) const {
-    const double EPSILON = 1e-8;             // Small threshold to avoid floating-point errors
-    Vector3D edge1 = B - A;                 // Edge vector 1
-    Vector3D edge2 = C - A;                 // Edge vector 2
-    Vector3D h = ray.direction.cross(edge2);
-    double a = edge1.dot(h);
+template <typename T>
+bool TriangleT<T>::intersect(const RayT<T>& ray, T& t) const {
+    const T EPSILON = 1e-8;                  // Small threshold to avoid floating-point errors
+    Vector3T<T> edge1 = B - A;              // Edge vector 1
+    Vector3T<T> edge2 = C - A;              // Edge vector 2
+    Vector3T<T> h = ray.direction.cross(edge2);
+    T a = edge1.dot(h);
 
-    if (fabs(a) < EPSILON)                  // Check if the ray is parallel to the triangle
+    if (std::fabs(a) < EPSILON)                  // Check if the ray is parallel to the triangle
         return false;
 
-    double f = 1.0 / a;
-    Vector3D s = ray.origin - A;
-    double u = f * s.dot(h);                // Barycentric coordinate u
+    T f = 1 / a;
+    Vector3T<T> s = ray.origin - A;
+    T u = f * s.dot(h);                     // Barycentric coordinate u
     if (u < 0.0 || u > 1.0)                 // Check if the intersection is outside the triangle
         return false;
 
-    Vector3D q = s.cross(edge1);
-    double v = f * ray.direction.dot(q);    // Barycentric coordinate v
+    Vector3T<T> q = s.cross(edge1);
+    T v = f * ray.direction.dot(q);         // Barycentric coordinate v
     if (v < 0.0 || u + v > 1.0)             // Check if the intersection is outside the triangle
         return false;
 
-    double tempT = f * edge2.dot(q);        // Calculate the distance to the intersection point
+    T tempT = f * edge2.dot(q);             // Calculate the distance to the intersection point
     if (tempT > EPSILON) {                  // Valid intersection if t > EPSILON
         t = tempT;
         return true;
@@ -69,6 +72,38 @@ bool Triangle::intersect(const Ray& ray, double& t) const {
     }
 }
 
+//
+// Method: occludes
+// Any-hit test for shadow rays: Möller-Trumbore with the segment length folded into the
+// final distance check, so a blocked ray is reported without computing a hit record.
+// Parameters:
+//   - ray: The ray to test.
+//   - t_max: The length of the segment.
+// Returns:
+//   - true if the triangle blocks the segment, false otherwise.
+//
+template <typename T>
+bool TriangleT<T>::occludes(const RayT<T>& ray, T t_max) const {
+    const T EPSILON = 1e-8;
+    Vector3T<T> edge1 = B - A;
+    Vector3T<T> edge2 = C - A;
+    Vector3T<T> h = ray.direction.cross(edge2);
+    T a = edge1.dot(h);
+    if (std::fabs(a) < EPSILON) return false;
+
+    T f = 1 / a;
+    Vector3T<T> s = ray.origin - A;
+    T u = f * s.dot(h);
+    if (u < 0.0 || u > 1.0) return false;
+
+    Vector3T<T> q = s.cross(edge1);
+    T v = f * ray.direction.dot(q);
+    if (v < 0.0 || u + v > 1.0) return false;
+
+    T t = f * edge2.dot(q);
+    return t > EPSILON && t < t_max;
+}
+
 //
 // Method: getNormal
 // Computes the normal vector of the triangle.
@@ -77,10 +112,30 @@ bool Triangle::intersect(const Ray& ray, double& t) const {
 // Notes:
 //   - Ensures that the normal faces away from the camera (assumes camera is near the origin).
 //
-Vector3D Triangle::getNormal() const {
-    Vector3D normal = (B - A).cross(C - A).normalize(); // Compute the normal using cross product
+template <typename T>
+Vector3T<T> TriangleT<T>::getNormal() const {
+    Vector3T<T> normal = (B - A).cross(C - A).normalize(); // Compute the normal using cross product
     if (normal.dot(A) > 0) {                           // Flip the normal if it faces the wrong way
         normal = -normal;
     }
     return normal;
-}
\ No newline at end of file
+}
+
+//
+// Method: bounds
+// Computes the axis-aligned bounding box of the triangle.
+// Returns:
+//   - The smallest AABB containing the triangle.
+//
+template <typename T>
+AABB TriangleT<T>::bounds() const {
+    AABB box;
+    box.expand(Vector3D(A));
+    box.expand(Vector3D(B));
+    box.expand(Vector3D(C));
+    return box;
+}
+
+// Both precisions are compiled here, whichever one Real selects
+template class TriangleT<float>;
+template class TriangleT<double>;
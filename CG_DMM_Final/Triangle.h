@@ -4,19 +4,22 @@
 #include "Vector3D.h"
 #include "Color.h"
 #include "Ray.h"
+#include "AABB.h"
 
 //
-// Class: Triangle
+// Class: TriangleT
 // Represents a 3D triangle in the scene with properties for shading, reflection, and subsurface scattering.
+// T is the scalar type; Triangle is the renderer's Real triangle (see Real.h).
 //
-class Triangle {
+template <typename T>
+class TriangleT {
 public:
-    Vector3D A, B, C;              // The vertices of the triangle.
-    Color color;                   // The color of the triangle.
-    double specular;               // The specular reflection coefficient.
-    double reflective;             // The reflectivity of the triangle.
-    double subsurfaceRadius;       // The radius for subsurface scattering (SSS) effects.
-    double scatteringCoefficient;  // The scattering coefficient for subsurface scattering.
+    Vector3T<T> A, B, C;      // The vertices of the triangle.
+    ColorT<T> color;          // The color of the triangle.
+    T specular;               // The specular reflection coefficient.
+    T reflective;             // The reflectivity of the triangle.
+    T subsurfaceRadius;       // The radius for subsurface scattering (SSS) effects.
+    T scatteringCoefficient;  // The scattering coefficient for subsurface scattering.
 
     //
     // Constructor: Triangle
@@ -29,15 +32,15 @@ public:
     //   - subsurfaceRadius: (Optional) Radius for SSS effects. Default is 0.0.
     //   - scatteringCoefficient: (Optional) Scattering coefficient for SSS. Default is 0.0.
     //
-    Triangle(const Vector3D& A, const Vector3D& B, const Vector3D& C,
-             const Color& color, double specular, double reflective,
-             double subsurfaceRadius = 0.0, double scatteringCoefficient = 0.0);
+    TriangleT(const Vector3T<T>& A, const Vector3T<T>& B, const Vector3T<T>& C,
+              const ColorT<T>& color, T specular, T reflective,
+              T subsurfaceRadius = 0, T scatteringCoefficient = 0);
 
     //
     // Destructor: ~Triangle
     // Default destructor for the Triangle class.
     //
-    ~Triangle();
+    ~TriangleT();
 
     //
     // Method: intersect
@@ -48,7 +51,18 @@ public:
     // Returns:
     //   - true if the ray intersects the triangle, false otherwise.
     //
-    bool intersect(const Ray& ray, double& t) const;
+    bool intersect(const RayT<T>& ray, T& t) const;
+
+    //
+    // Method: occludes
+    // Any-hit test for shadow rays: reports whether the triangle blocks the ray segment (0, t_max).
+    // Parameters:
+    //   - ray: The ray to test.
+    //   - t_max: The length of the segment.
+    // Returns:
+    //   - true if the triangle blocks the segment, false otherwise.
+    //
+    bool occludes(const RayT<T>& ray, T t_max) const;
 
     //
     // Method: getNormal
@@ -58,7 +72,20 @@ public:
     // Notes:
     //   - Ensures that the normal faces away from the camera (assumes camera is near the origin).
     //
-    Vector3D getNormal() const;
+    Vector3T<T> getNormal() const;
+
+    //
+    // Method: bounds
+    // Computes the axis-aligned bounding box of the triangle.
+    // Returns:
+    //   - The smallest AABB containing the triangle.
+    //
+    AABB bounds() const;
 };
 
-#endif // TRIANGLE_H
\ No newline at end of file
+extern template class TriangleT<float>;
+extern template class TriangleT<double>;
+
+typedef TriangleT<Real> Triangle;
+
+#endif // TRIANGLE_H
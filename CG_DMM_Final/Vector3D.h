@@ -3,14 +3,30 @@
 
 #include <iostream>
 #include <cmath>
+#include <type_traits>
+#include "Random.h"
+#include "Real.h"
+#include "SimdMath.h"
 
 //
-// Class: Vector3D
+// Class: Vector3T
 // Represents a 3D vector with operations for vector arithmetic, normalization, and geometric calculations.
+// All operations are defined inline here so the compiler can fold them into the
+// intersection and shading loops; the arithmetic is constexpr and the type is trivially
+// copyable. See SimdMath.h for the optional 4-wide SIMD layout.
+// T is the scalar type (float or double); Vector3D is the renderer's Real vector (see Real.h).
 //
-class Vector3D {
+template <typename T>
+#ifdef RAYTRACER_SIMD_MATH
+class alignas(4 * sizeof(T)) Vector3T {
+#else
+class Vector3T {
+#endif
 public:
-    double x, y, z; // Components of the vector
+    T x, y, z;      // Components of the vector
+#ifdef RAYTRACER_SIMD_MATH
+    T w;            // Padding lane of the SIMD layout, always 0 after construction
+#endif
 
     //
     // Constructor: Vector3D
@@ -20,19 +36,26 @@ public:
     //   - y: The y-component of the vector.
     //   - z: The z-component of the vector.
     //
-    Vector3D(double x, double y, double z);
+#ifdef RAYTRACER_SIMD_MATH
+    constexpr Vector3T(T x, T y, T z) : x(x), y(y), z(z), w(0) {}
+#else
+    constexpr Vector3T(T x, T y, T z) : x(x), y(y), z(z) {}
+#endif
 
     //
     // Default Constructor: Vector3D
     // Initializes a vector with all components set to 0.
     //
-    Vector3D();
+    constexpr Vector3T() : Vector3T(0, 0, 0) {}
 
     //
-    // Destructor: ~Vector3D
-    // Default destructor for the Vector3D class.
+    // Constructor: Vector3D
+    // Converts a vector of another scalar type, rounding each component.
+    // Parameters:
+    //   - v: The vector to convert.
     //
-    ~Vector3D();
+    template <typename U>
+    constexpr explicit Vector3T(const Vector3T<U>& v) : Vector3T(static_cast<T>(v.x), static_cast<T>(v.y), static_cast<T>(v.z)) {}
 
     //
     // Operator: -
@@ -40,7 +63,16 @@ public:
     // Returns:
     //   A new Vector3D with negated components.
     //
-    Vector3D operator-() const;
+    constexpr Vector3T operator-() const {
+#ifdef RAYTRACER_SIMD_MATH
+        if (!constantEvaluated()) {
+            SimdLanes4<T> a = {};
+            simdLoad(&x, a);
+            return fromLanes(-a);
+        }
+#endif
+        return Vector3T(-x, -y, -z);
+    }
 
     //
     // Operator: +
@@ -50,7 +82,17 @@ public:
     // Returns:
     //   A new Vector3D with the summed components.
     //
-    Vector3D operator+(const Vector3D& v) const;
+    constexpr Vector3T operator+(const Vector3T& v) const {
+#ifdef RAYTRACER_SIMD_MATH
+        if (!constantEvaluated()) {
+            SimdLanes4<T> a = {}, b = {};
+            simdLoad(&x, a);
+            simdLoad(&v.x, b);
+            return fromLanes(a + b);
+        }
+#endif
+        return Vector3T(x + v.x, y + v.y, z + v.z);
+    }
 
     //
     // Operator: -
@@ -60,7 +102,17 @@ public:
     // Returns:
     //   A new Vector3D with the subtracted components.
     //
-    Vector3D operator-(const Vector3D& v) const;
+    constexpr Vector3T operator-(const Vector3T& v) const {
+#ifdef RAYTRACER_SIMD_MATH
+        if (!constantEvaluated()) {
+            SimdLanes4<T> a = {}, b = {};
+            simdLoad(&x, a);
+            simdLoad(&v.x, b);
+            return fromLanes(a - b);
+        }
+#endif
+        return Vector3T(x - v.x, y - v.y, z - v.z);
+    }
 
     //
     // Operator: *
@@ -70,7 +122,16 @@ public:
     // Returns:
     //   A new Vector3D with scaled components.
     //
-    Vector3D operator*(double scalar) const;
+    constexpr Vector3T operator*(T scalar) const {
+#ifdef RAYTRACER_SIMD_MATH
+        if (!constantEvaluated()) {
+            SimdLanes4<T> a = {};
+            simdLoad(&x, a);
+            return fromLanes(a * scalar);
+        }
+#endif
+        return Vector3T(x * scalar, y * scalar, z * scalar);
+    }
 
     //
     // Operator: *
@@ -81,7 +142,9 @@ public:
     // Returns:
     //   A new Vector3D with scaled components.
     //
-    friend Vector3D operator*(double scalar, const Vector3D& v);
+    friend constexpr Vector3T operator*(T scalar, const Vector3T& v) {
+        return v * scalar;
+    }
 
     //
     // Operator: /
@@ -91,7 +154,36 @@ public:
     // Returns:
     //   A new Vector3D with divided components.
     //
-    Vector3D operator/(double scalar) const;
+    constexpr Vector3T operator/(T scalar) const {
+#ifdef RAYTRACER_SIMD_MATH
+        if (!constantEvaluated()) {
+            SimdLanes4<T> a = {};
+            simdLoad(&x, a);
+            Vector3T result = fromLanes(a / scalar);
+            result.w = 0;   // 0 / 0 would leave a NaN in the padding lane
+            return result;
+        }
+#endif
+        return Vector3T(x / scalar, y / scalar, z / scalar);
+    }
+
+    //
+    // Method: multiplyAdd
+    // Computes this * scalar + v, the fused form of `v + this * scalar` used to step
+    // along rays and offset points. Fused into single-rounding FMA instructions only where
+    // the target provides them (see fusedMultiplyAdd); otherwise identical to the
+    // separate operators.
+    // Parameters:
+    //   - scalar: The scalar to multiply with.
+    //   - v: The vector to add.
+    // Returns:
+    //   A new Vector3D with the result.
+    //
+    constexpr Vector3T multiplyAdd(T scalar, const Vector3T& v) const {
+        return Vector3T(fusedMultiplyAdd(x, scalar, v.x),
+                        fusedMultiplyAdd(y, scalar, v.y),
+                        fusedMultiplyAdd(z, scalar, v.z));
+    }
 
     //
     // Method: dot
@@ -101,7 +193,9 @@ public:
     // Returns:
     //   The dot product (a scalar value).
     //
-    double dot(const Vector3D& v) const;
+    constexpr T dot(const Vector3T& v) const {
+        return x * v.x + y * v.y + z * v.z;
+    }
 
     //
     // Method: cross
@@ -111,17 +205,29 @@ public:
     // Returns:
     //   A new Vector3D representing the cross product.
     //
-    Vector3D cross(const Vector3D& v) const;
+    constexpr Vector3T cross(const Vector3T& v) const {
+        return Vector3T(
+            y * v.z - z * v.y,
+            z * v.x - x * v.z,
+            x * v.y - y * v.x
+        );
+    }
 
     //
     // Method: normalize
     // Normalizes the vector to have a length of 1.
+    // Multiplies by the reciprocal square root of the squared length: one division
+    // instead of three.
     // Returns:
     //   A new Vector3D representing the normalized vector.
     // Notes:
     //   If the vector length is zero, returns a zero vector.
     //
-    Vector3D normalize() const;
+    Vector3T normalize() const {
+        T len2 = lengthSquared();
+        if (len2 == 0) return Vector3T(0, 0, 0);
+        return *this * reciprocalSqrt(len2);
+    }
 
     //
     // Method: length
@@ -129,7 +235,9 @@ public:
     // Returns:
     //   The length of the vector.
     //
-    double length() const;
+    T length() const {
+        return std::sqrt(x * x + y * y + z * z);
+    }
 
     //
     // Method: lengthSquared
@@ -137,7 +245,22 @@ public:
     // Returns:
     //   The squared length of the vector.
     //
-    double lengthSquared() const;
+    constexpr T lengthSquared() const {
+        return x * x + y * y + z * z;
+    }
+
+    //
+    // Function: reciprocalSqrt
+    // Calculates 1 / sqrt(value) with one correctly rounded square root and division.
+    // (x86 has no full-precision reciprocal square root; rsqrtps is only a 12-bit estimate.)
+    // Parameters:
+    //   - value: A positive value.
+    // Returns:
+    //   The reciprocal square root.
+    //
+    static T reciprocalSqrt(T value) {
+        return 1 / std::sqrt(value);
+    }
 
     //
     // Operator: <<
@@ -148,7 +271,10 @@ public:
     // Returns:
     //   The modified output stream.
     //
-    friend std::ostream& operator<<(std::ostream& out, const Vector3D& v);
+    friend std::ostream& operator<<(std::ostream& out, const Vector3T& v) {
+        out << "<" << v.x << ", " << v.y << ", " << v.z << ">";
+        return out;
+    }
 
     //
     // Operator: ==
@@ -158,7 +284,12 @@ public:
     // Returns:
     //   true if the vectors are equal, false otherwise.
     //
-    bool operator==(const Vector3D& v) const;
+    bool operator==(const Vector3T& v) const {
+        const T EPSILON = static_cast<T>(1e-8);
+        return (std::fabs(x - v.x) < EPSILON) &&
+               (std::fabs(y - v.y) < EPSILON) &&
+               (std::fabs(z - v.z) < EPSILON);
+    }
 
     //
     // Operator: !=
@@ -168,7 +299,9 @@ public:
     // Returns:
     //   true if the vectors are not equal, false otherwise.
     //
-    bool operator!=(const Vector3D& v) const;
+    bool operator!=(const Vector3T& v) const {
+        return !(*this == v);
+    }
 
     //
     // Method: randomHemisphere
@@ -177,7 +310,43 @@ public:
     // Returns:
     //   A new Vector3D representing the random direction.
     //
-    Vector3D randomHemisphere() const;
+    Vector3T randomHemisphere() const {
+        T u1 = randDouble();
+        T u2 = randDouble();
+
+        T r = std::sqrt(u1);
+        T theta = static_cast<T>(2.0 * M_PI) * u2;
+
+        T x_ = r * std::cos(theta);
+        T y_ = r * std::sin(theta);
+        T z_ = std::sqrt(1 - u1);
+
+        Vector3T N = this->normalize();
+
+        Vector3T helper = (std::fabs(N.x) > 0.1) ? Vector3T(0, 1, 0) : Vector3T(1, 0, 0);
+        Vector3T tangent = helper.cross(N).normalize();
+        Vector3T bitangent = N.cross(tangent);
+
+        return tangent * x_ + bitangent * y_ + N * z_;
+    }
+
+private:
+#ifdef RAYTRACER_SIMD_MATH
+    //
+    // Function: fromLanes
+    // Builds a vector from the four lanes of a SIMD register.
+    //
+    static Vector3T fromLanes(const SimdLanes4<T>& lanes) {
+        Vector3T result;
+        simdStore(lanes, &result.x);
+        return result;
+    }
+#endif
 };
 
-#endif // VECTOR3D_H
\ No newline at end of file
+typedef Vector3T<Real> Vector3D;
+
+static_assert(std::is_trivially_copyable<Vector3T<float>>::value, "Vector3D must stay trivially copyable");
+static_assert(std::is_trivially_copyable<Vector3T<double>>::value, "Vector3D must stay trivially copyable");
+
+#endif // VECTOR3D_H
@@ -0,0 +1,430 @@
+#include "Wavefront.h"
+#include <algorithm>
+#include <limits>
+#include "RayTracer.h"
+
+namespace {
+
+const int CONVERGENCE_BATCH = 8;      // Matches computeLighting
+const Real PRIMARY_T_MIN = 1.0;       // Matches Renderer::renderTile
+const Real SECONDARY_T_MIN = 0.001;   // Matches shadeHit
+
+} // namespace
+
+//
+// Method: RayQueue::clear
+// Removes every ray, keeping the capacity.
+//
+void WavefrontTracer::RayQueue::clear() {
+    originX.clear();
+    originY.clear();
+    originZ.clear();
+    directionX.clear();
+    directionY.clear();
+    directionZ.clear();
+    vertex.clear();
+    type.clear();
+}
+
+//
+// Method: RayQueue::push
+// Appends a ray.
+//
+void WavefrontTracer::RayQueue::push(const Ray& ray, int rayVertex, RayType rayType) {
+    originX.push_back(ray.origin.x);
+    originY.push_back(ray.origin.y);
+    originZ.push_back(ray.origin.z);
+    directionX.push_back(ray.direction.x);
+    directionY.push_back(ray.direction.y);
+    directionZ.push_back(ray.direction.z);
+    vertex.push_back(rayVertex);
+    type.push_back(rayType);
+}
+
+//
+// Method: RayQueue::pushFrom
+// Appends a ray of another queue.
+//
+void WavefrontTracer::RayQueue::pushFrom(const RayQueue& other, int index) {
+    push(other.ray(index), other.vertex[index], other.type[index]);
+}
+
+//
+// Method: RayQueue::ray
+// Returns: The queued ray `index`.
+//
+Ray WavefrontTracer::RayQueue::ray(int index) const {
+    return Ray(Vector3D(originX[index], originY[index], originZ[index]),
+               Vector3D(directionX[index], directionY[index], directionZ[index]));
+}
+
+//
+// Method: RayQueue::arrays
+// Returns: The component arrays, for intersectPackets.
+//
+RayArrays WavefrontTracer::RayQueue::arrays() const {
+    return RayArrays{originX.data(), originY.data(), originZ.data(),
+                     directionX.data(), directionY.data(), directionZ.data()};
+}
+
+//
+// Method: ShadowQueue::clear
+// Removes every shadow ray, keeping the capacity.
+//
+void WavefrontTracer::ShadowQueue::clear() {
+    originX.clear();
+    originY.clear();
+    originZ.clear();
+    directionX.clear();
+    directionY.clear();
+    directionZ.clear();
+    samples.clear();
+}
+
+//
+// Method: ShadowQueue::push
+// Appends a shadow ray.
+//
+void WavefrontTracer::ShadowQueue::push(const Vector3D& origin, const Vector3D& direction, int lightSamples) {
+    originX.push_back(origin.x);
+    originY.push_back(origin.y);
+    originZ.push_back(origin.z);
+    directionX.push_back(direction.x);
+    directionY.push_back(direction.y);
+    directionZ.push_back(direction.z);
+    samples.push_back(lightSamples);
+}
+
+//
+// Method: trace
+// Computes the color of every camera ray, one wave of rays per bounce.
+// Parameters:
+//   - scene: The built scene.
+//   - isa: The resolved packet instruction set for the intersection stage.
+//   - rays: The camera rays; directions must be normalized.
+//   - count: The number of rays.
+//   - maxDepth: The maximum recursion depth, as for TraceRay.
+//   - rayOrder: The order in which the secondary rays of each wave are traced.
+//   - colors: The color of each ray (output).
+//
+void WavefrontTracer::trace(const Scene& scene, PacketIsa isa, const Ray* rays, int count, int maxDepth,
+                            RayOrder rayOrder, Color* colors) {
+    if (maxDepth <= 0) {
+        std::fill(colors, colors + count, Color(0, 0, 0));
+        return;
+    }
+
+    offset = scene.rayOffset();
+    shadows.resize(scene.lights.size());
+    vertices.clear();
+    queue.clear();
+    for (int i = 0; i < count; i++) {
+        vertices.push_back(PathVertex{-1, 1, 1, false, false, Color(), Color(), Color()});
+        queue.push(rays[i], i, RayType::CAMERA);
+    }
+
+    for (int depth = maxDepth; queue.size() > 0; depth--) {
+        intersect(scene, isa, depth == maxDepth);
+        sortByMaterial(scene);
+        shade(scene, depth);
+        traceShadows(scene);
+        scatter(scene);
+        sortByDirection(rayOrder);
+    }
+
+    resolve(colors);
+}
+
+//
+// Method: intersect
+// Finds the closest hits of the queued rays in packets; misses take the background color.
+// Parameters:
+//   - scene: The scene.
+//   - isa: The packet instruction set.
+//   - primary: Whether the queue holds camera rays, which start at t = 1.
+//
+void WavefrontTracer::intersect(const Scene& scene, PacketIsa isa, bool primary) {
+    int count = queue.size();
+    const Real t_max = std::numeric_limits<Real>::infinity();
+    hits.resize(count);
+    if (foundCapacity < count) {
+        found.reset(new bool[count]);
+        foundCapacity = count;
+    }
+
+    if (primary) {
+        STATS_STAGE(PRIMARY_HITS);
+        intersectPackets(scene, isa, queue.arrays(), count, PRIMARY_T_MIN, t_max, hits.data(), found.get());
+    } else {
+        STATS_STAGE(SECONDARY_HITS);
+        intersectPackets(scene, isa, queue.arrays(), count, SECONDARY_T_MIN, t_max, hits.data(), found.get());
+    }
+
+    for (int i = 0; i < count; i++) {
+        STATS_RAYS(queue.type[i], 1);
+        STATS_HITS(queue.type[i], found[i]);
+        if (!found[i]) vertices[queue.vertex[i]].local = scene.backgroundColor;
+    }
+}
+
+//
+// Method: sortByMaterial
+// Lists the queued rays that hit something in material order (a stable counting sort).
+//
+void WavefrontTracer::sortByMaterial(const Scene& scene) {
+    STATS_STAGE(SORTING);
+    int count = queue.size();
+    bucketStart.assign(scene.materials.size() + 1, 0);
+    int hitCount = 0;
+    for (int i = 0; i < count; i++) {
+        if (!found[i]) continue;
+        bucketStart[scene.geometry.materialId(hits[i].primitive) + 1]++;
+        hitCount++;
+    }
+    for (size_t m = 1; m < bucketStart.size(); m++) bucketStart[m] += bucketStart[m - 1];
+
+    order.resize(hitCount);
+    for (int i = 0; i < count; i++) {
+        if (found[i]) order[bucketStart[scene.geometry.materialId(hits[i].primitive)]++] = i;
+    }
+}
+
+//
+// Method: shade
+// Fills a shading point for every hit in material order, queues the first batch of shadow
+// rays of each light, and spawns the reflection and indirect rays of the next wave.
+// Parameters:
+//   - scene: The scene.
+//   - depth: The remaining recursion depth of the current wave.
+//
+void WavefrontTracer::shade(const Scene& scene, int depth) {
+    STATS_STAGE(SHADING);
+    int lightCount = static_cast<int>(scene.lights.size());
+    bool sampleLights = scene.lightSamples > 0 && !scene.lightTree.empty();
+    points.clear();
+    lightSamples.clear();
+    spawned.clear();
+
+    for (int i : order) {
+        Ray ray = queue.ray(i);
+        ShadingPoint shadingPoint;
+        shadingPoint.vertex = queue.vertex[i];
+        shadingPoint.point = ray.direction.multiplyAdd(hits[i].t, ray.origin);
+        shadingPoint.normal = scene.geometry.normal(hits[i].primitive, shadingPoint.point);
+        shadingPoint.view = -ray.direction;
+        shadingPoint.material = &scene.material(hits[i].primitive);
+        shadingPoint.firstSamples = static_cast<int>(lightSamples.size());
+        vertices[shadingPoint.vertex].hit = true;
+        int pointIndex = static_cast<int>(points.size());
+        points.push_back(shadingPoint);
+
+        // With light sampling, point lights are picked from the light tree as in computeLighting
+        for (int l = 0; l < lightCount; l++) {
+            const Light& light = scene.lights[l];
+            if (sampleLights && light.type == LightType::POINT) continue;
+            addLightSamples(scene, pointIndex, l, 1);
+        }
+        for (int s = 0; sampleLights && s < scene.lightSamples; s++) {
+            Real probability;
+            int l = scene.lightTree.sample(shadingPoint.point, shadingPoint.normal, shadingPoint.view,
+                                           shadingPoint.material->specular, probability);
+            if (l < 0) break;   // No point light can reach the point
+            STATS_ADD(lightTreeSamples, 1);
+            addLightSamples(scene, pointIndex, l, 1.0 / (scene.lightSamples * probability));
+        }
+
+        const Vector3D& point = shadingPoint.point;
+        const Vector3D& normal = shadingPoint.normal;
+
+        // Reflection; at the last level it would return black
+        Real reflective = shadingPoint.material->reflective;
+        Real throughput = vertices[shadingPoint.vertex].throughput;
+        if (reflective > 0 && depth > 1) {
+            Real survival = branchSurvival(scene, throughput * reflective);
+            if (survival >= 1 || (survival > 0 && randDouble() > 1 - survival)) {
+                Vector3D reflectDir = ray.direction - normal * 2 * ray.direction.dot(normal);
+                spawn(Ray(normal.multiplyAdd(offset, point), reflectDir), shadingPoint.vertex, reflective / survival,
+                      false, RayType::REFLECTION);
+            } else if (survival > 0) {
+                STATS_ADD(rouletteTerminations, 1);
+            }
+        }
+
+        // Indirect lighting (simple diffuse)
+        if (depth > 1) {
+            Real survival = branchSurvival(scene, throughput * INDIRECT_WEIGHT);
+            if (survival > 0 && scene.indirectCache) {
+                // Interpolated (or computed recursively) instead of queued, as in shadeSurface
+                vertices[shadingPoint.vertex].indirectLight =
+                    scene.indirectCache->lookup(scene, point, normal, std::numeric_limits<Real>::infinity(), depth) *
+                    INDIRECT_WEIGHT;
+            } else if (survival >= 1 || (survival > 0 && randDouble() > 1 - survival)) {
+                Vector3D randomDir = normal.randomHemisphere();
+                spawn(Ray(normal.multiplyAdd(offset, point), randomDir), shadingPoint.vertex, INDIRECT_WEIGHT / survival,
+                      true, RayType::INDIRECT);
+            } else if (survival > 0) {
+                STATS_ADD(rouletteTerminations, 1);
+            }
+        }
+    }
+}
+
+//
+// Method: addLightSamples
+// Adds the shadow samples of one light at a shading point and queues their first batch.
+// Parameters:
+//   - scene: The scene.
+//   - point: The index of the shading point.
+//   - light: The index of the light.
+//   - weight: The factor of the light's contribution (1 unless it was picked at random).
+//
+void WavefrontTracer::addLightSamples(const Scene& scene, int point, int light, Real weight) {
+    const Light& sampled = scene.lights[light];
+    lightSamples.push_back(LightSamples{Color(0, 0, 0), weight, point, light, 0, 0, 0});
+    if (sampled.type == LightType::AMBIENT) return;
+    LightSamples& samples = lightSamples.back();
+    samples.budget = shadowSampleBudget(sampled, points[point].point);
+    queueShadowRays(scene, static_cast<int>(lightSamples.size()) - 1, std::min(samples.budget, CONVERGENCE_BATCH));
+}
+
+//
+// Method: queueShadowRays
+// Queues shadow rays from a shading point towards random points of a light.
+// Parameters:
+//   - scene: The scene.
+//   - samplesIndex: The index of the point's LightSamples of the light.
+//   - count: The number of rays.
+//
+void WavefrontTracer::queueShadowRays(const Scene& scene, int samplesIndex, int count) {
+    LightSamples& samples = lightSamples[samplesIndex];
+    const ShadingPoint& shadingPoint = points[samples.point];
+    for (int i = 0; i < count; i++) {
+        Vector3D lightDir = (sampleLightPoint(scene.lights[samples.light]) - shadingPoint.point).normalize();
+        Vector3D shadowOrig = shadingPoint.normal.multiplyAdd((lightDir.dot(shadingPoint.normal) < 0) ? -offset : offset,
+                                                              shadingPoint.point);
+        shadows[samples.light].push(shadowOrig, lightDir, samplesIndex);
+    }
+    samples.taken += count;
+}
+
+//
+// Method: spawn
+// Adds a path vertex for a child ray and queues the ray for the next wave.
+//
+void WavefrontTracer::spawn(const Ray& ray, int parent, Real weight, bool indirect, RayType type) {
+    Real throughput = vertices[parent].throughput * weight;
+    vertices.push_back(PathVertex{parent, weight, throughput, indirect, false, Color(), Color(), Color()});
+    spawned.push(ray, static_cast<int>(vertices.size()) - 1, type);
+}
+
+//
+// Method: traceShadows
+// Traces the queued shadow rays light by light, so the light's last occluder stays a good
+// first guess. Lights whose first batch was neither all lit nor all occluded then get the
+// rest of their budget in a second pass. Finally lights every shading point.
+//
+void WavefrontTracer::traceShadows(const Scene& scene) {
+    STATS_STAGE(LIGHTING);
+    int lightCount = static_cast<int>(scene.lights.size());
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int l = 0; l < lightCount; l++) {
+            const Light& light = scene.lights[l];
+            ShadowQueue& shadowQueue = shadows[l];
+            Real t_max = shadowRayLength(light);
+            PrimitiveRef lastOccluder{PrimitiveType::SPHERE, -1};
+            for (int i = 0; i < shadowQueue.size(); i++) {
+                Vector3D lightDir(shadowQueue.directionX[i], shadowQueue.directionY[i], shadowQueue.directionZ[i]);
+                Ray shadowRay(Vector3D(shadowQueue.originX[i], shadowQueue.originY[i], shadowQueue.originZ[i]),
+                              lightDir);
+                bool inShadow = scene.occluded(shadowRay, t_max, lastOccluder);
+                STATS_RAYS(RayType::SHADOW, 1);
+                STATS_HITS(RayType::SHADOW, inShadow);
+                if (inShadow) continue;
+
+                LightSamples& samples = lightSamples[shadowQueue.samples[i]];
+                const ShadingPoint& shadingPoint = points[samples.point];
+                samples.lit++;
+                addLightSample(samples.sum, light, lightDir, shadingPoint.normal, shadingPoint.view,
+                               shadingPoint.material->specular);
+            }
+            shadowQueue.clear();
+        }
+
+        if (pass > 0) break;
+        // A fully lit or fully shadowed first batch means the point is outside the penumbra
+        for (size_t s = 0; s < lightSamples.size(); s++) {
+            const LightSamples& samples = lightSamples[s];
+            if (samples.taken < samples.budget && samples.lit != 0 && samples.lit != samples.taken) {
+                queueShadowRays(scene, static_cast<int>(s), samples.budget - samples.taken);
+            }
+        }
+    }
+
+    for (size_t p = 0; p < points.size(); p++) {
+        Color lighting(0, 0, 0);
+        int end = p + 1 < points.size() ? points[p + 1].firstSamples : static_cast<int>(lightSamples.size());
+        for (int s = points[p].firstSamples; s < end; s++) {
+            const LightSamples& samples = lightSamples[s];
+            const Light& light = scene.lights[samples.light];
+            if (light.type == LightType::AMBIENT) {
+                lighting = lighting + Color(light.intensity, light.intensity, light.intensity);
+            } else {
+                lighting = lighting + (samples.sum * (1.0 / samples.taken)) * samples.weight;
+            }
+        }
+        vertices[points[p].vertex].local = points[p].material->color * lighting;
+    }
+}
+
+//
+// Method: scatter
+// Adds the subsurface scattering of the translucent shading points.
+//
+void WavefrontTracer::scatter(const Scene& scene) {
+    for (const ShadingPoint& shadingPoint : points) {
+        const Material& material = *shadingPoint.material;
+        if (material.subsurfaceRadius <= 0.0 || material.scatteringCoefficient <= 0.0) continue;
+        Color& local = vertices[shadingPoint.vertex].local;
+        local = addSubsurfaceScattering(scene, shadingPoint.point, shadingPoint.normal, material, local);
+    }
+}
+
+//
+// Method: sortByDirection
+// Moves the spawned rays into the queue in the given order (see RaySorter), so the
+// packets of the next wave hold rays that start close together and travel the same way.
+// Parameters:
+//   - rayOrder: The order of the rays in the queue.
+//
+void WavefrontTracer::sortByDirection(RayOrder rayOrder) {
+    STATS_STAGE(SORTING);
+    sorter.sort(rayOrder, spawned.arrays(), spawned.size(), order);
+    queue.clear();
+    for (int i : order) queue.pushFrom(spawned, i);
+}
+
+//
+// Method: resolve
+// Adds the colors of all waves up, from the last wave to the first: a hit's color is its
+// local color plus its weighted reflection and indirect colors, clamped as in shadeHit.
+// Parameters:
+//   - colors: The color of each camera ray, whose vertices come first (output).
+//
+void WavefrontTracer::resolve(Color* colors) {
+    for (int v = static_cast<int>(vertices.size()) - 1; v >= 0; v--) {
+        const PathVertex& vertex = vertices[v];
+        Color color = vertex.local;
+        if (vertex.hit) {
+            color = vertex.local + vertex.reflection + vertex.indirectLight;
+            color.clamp();
+        }
+        if (vertex.parent < 0) {
+            colors[v] = color;
+        } else if (vertex.indirect) {
+            vertices[vertex.parent].indirectLight = color * vertex.weight;
+        } else {
+            vertices[vertex.parent].reflection = color * vertex.weight;
+        }
+    }
+}
@@ -0,0 +1,169 @@
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include <memory>
+#include <vector>
+#include "Color.h"
+#include "PacketTracer.h"
+#include "Ray.h"
+#include "RaySort.h"
+#include "RenderStats.h"
+#include "Scene.h"
+
+//
+// Class: WavefrontTracer
+// Traces a batch of camera rays breadth-first instead of recursing through TraceRay.
+// Every bounce is one wave, and each wave runs the same stages over all of its rays:
+//
+//   1. intersection: the queued rays are intersected with the BVH in SIMD packets;
+//   2. sorting:      the hits are ordered by material, so shading runs over runs of
+//                    identical materials;
+//   3. shading:      each hit gets its normal and material, queues the first batch of
+//                    shadow rays of every light (or of the point lights picked from the
+//                    light tree) and spawns its reflection and indirect rays into the next
+//                    wave;
+//   4. shadows:      the shadow rays are traced light by light, then the lights that are
+//                    in penumbra get their remaining samples in a second pass, as in
+//                    computeLighting;
+//   5. scattering:   translucent hits add their subsurface scattering probes;
+//   6. sorting:      the spawned rays are ordered by direction octant and origin (see
+//                    RaySorter) before the next wave's packets are formed.
+//
+// Rays and shadow rays wait in queues that keep each component in its own array
+// (structure of arrays). Every ray leaves a path vertex holding its local color; when no
+// wave is left, the vertices are resolved from the last wave to the first, adding each
+// reflection and indirect color into its parent, with the same weights and clamping as
+// shadeHit. The estimate is the same as the recursive engine's, but random numbers are
+// drawn in another order, so the two engines give different (equally converged) images.
+//
+// A tracer keeps its queues between calls; use one per thread.
+//
+class WavefrontTracer {
+public:
+    //
+    // Method: trace
+    // Computes the color of every camera ray.
+    // Parameters:
+    //   - scene: The built scene.
+    //   - isa: The resolved packet instruction set for the intersection stage.
+    //   - rays: The camera rays; directions must be normalized.
+    //   - count: The number of rays.
+    //   - maxDepth: The maximum recursion depth, as for TraceRay.
+    //   - rayOrder: The order in which the secondary rays of each wave are traced.
+    //   - colors: The color of each ray (output).
+    //
+    void trace(const Scene& scene, PacketIsa isa, const Ray* rays, int count, int maxDepth, RayOrder rayOrder,
+               Color* colors);
+
+private:
+    //
+    // Struct: RayQueue
+    // The rays of one wave, one array per component.
+    //
+    struct RayQueue {
+        std::vector<Real> originX, originY, originZ;
+        std::vector<Real> directionX, directionY, directionZ;
+        std::vector<int> vertex;       // The path vertex each ray fills in.
+        std::vector<RayType> type;     // The kind of each ray, for the statistics.
+
+        void clear();
+        void push(const Ray& ray, int vertex, RayType type);
+        void pushFrom(const RayQueue& other, int index);
+        Ray ray(int index) const;
+        RayArrays arrays() const;
+        int size() const { return static_cast<int>(vertex.size()); }
+    };
+
+    //
+    // Struct: ShadowQueue
+    // The shadow rays towards one light, one array per component.
+    //
+    struct ShadowQueue {
+        std::vector<Real> originX, originY, originZ;
+        std::vector<Real> directionX, directionY, directionZ;
+        std::vector<int> samples;      // The LightSamples each ray counts into.
+
+        void clear();
+        void push(const Vector3D& origin, const Vector3D& direction, int samples);
+        int size() const { return static_cast<int>(samples.size()); }
+    };
+
+    //
+    // Struct: PathVertex
+    // The colors gathered by one ray. Reflection and indirect hold the weighted colors of
+    // the child rays, once these are resolved.
+    //
+    struct PathVertex {
+        int parent;          // The vertex whose ray spawned this one, or -1 for a camera ray.
+        Real weight;         // The factor of this color in the parent's (see branchSurvival).
+        Real throughput;     // The factor of this color in the pixel: the product of the weights up the path.
+        bool indirect;       // Whether this ray is its parent's indirect ray, not its reflection.
+        bool hit;            // Whether the ray hit anything; misses hold the background color.
+        Color local;         // The lit surface color with SSS, or the background color.
+        Color reflection;    // The weighted color of the reflection ray.
+        Color indirectLight; // The weighted color of the indirect ray.
+    };
+
+    //
+    // Struct: ShadingPoint
+    // A hit of the current wave, between the shading and the scattering stage.
+    //
+    struct ShadingPoint {
+        int vertex;                  // The path vertex of the hit.
+        Vector3D point;              // The hit point.
+        Vector3D normal;             // The surface normal at the point.
+        Vector3D view;               // The direction back along the ray.
+        const Material* material;    // The material of the hit primitive.
+        int firstSamples;            // The first of the point's LightSamples, which are contiguous.
+    };
+
+    //
+    // Struct: LightSamples
+    // The shadow samples of one light at one shading point, as counted by computeLighting.
+    //
+    struct LightSamples {
+        Color sum;         // The summed contributions of the lit samples.
+        Real weight;       // The factor of the averaged contribution (1 unless picked from the light tree).
+        int point;         // The shading point.
+        int light;         // The index of the light.
+        int budget;        // shadowSampleBudget of the light at the point.
+        int taken;         // The samples queued so far.
+        int lit;           // The samples found unoccluded.
+    };
+
+    //
+    // Methods: Stages
+    // intersect finds the hits of the queued rays and gives the misses the background
+    // color; sortByMaterial orders the hits by material; shade fills the shading points,
+    // queues their first shadow rays and spawns the next wave; traceShadows traces the
+    // shadow rays and lights the points; scatter adds subsurface scattering; sortByDirection
+    // moves the spawned rays into the queue in RaySorter order; resolve adds the colors of
+    // all waves up into the camera rays.
+    //
+    void intersect(const Scene& scene, PacketIsa isa, bool primary);
+    void sortByMaterial(const Scene& scene);
+    void shade(const Scene& scene, int depth);
+    void addLightSamples(const Scene& scene, int point, int light, Real weight);
+    void queueShadowRays(const Scene& scene, int samplesIndex, int count);
+    void spawn(const Ray& ray, int parent, Real weight, bool indirect, RayType type);
+    void traceShadows(const Scene& scene);
+    void scatter(const Scene& scene);
+    void sortByDirection(RayOrder rayOrder);
+    void resolve(Color* colors);
+
+    Real offset = 0;                        // Scene::rayOffset of the traced scene.
+    RayQueue queue;                         // The rays of the current wave.
+    RayQueue spawned;                       // The rays spawned for the next wave, unsorted.
+    std::vector<Hit> hits;                  // The closest hit of each queued ray.
+    std::unique_ptr<bool[]> found;          // Whether each queued ray hit anything.
+    int foundCapacity = 0;                  // The length of `found`.
+    std::vector<int> order;                 // The queued hits in material order; spawned rays in ray order.
+    std::vector<int> bucketStart;           // Counting sort buckets.
+    RaySorter sorter;                       // Orders the spawned rays.
+    std::vector<PathVertex> vertices;       // The vertices of every wave so far.
+    std::vector<ShadingPoint> points;       // The hits of the current wave.
+    std::vector<LightSamples> lightSamples; // Per point and evaluated light, grouped by point.
+    std::vector<ShadowQueue> shadows;       // The queued shadow rays of each light.
+};
+
+#endif // WAVEFRONT_H
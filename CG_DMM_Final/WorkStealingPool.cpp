@@ -0,0 +1,164 @@
+#include "WorkStealingPool.h"
+
+//
+// Constructor: WorkStealingPool
+// Starts the worker threads.
+// Parameters:
+//   - threadCount: Number of workers. Values <= 0 use the hardware concurrency.
+//
+WorkStealingPool::WorkStealingPool(int threadCount)
+    : currentTask(nullptr),
+      generation(0),
+      finishedWorkers(0),
+      stopping(false) {
+    if (threadCount <= 0) {
+        threadCount = defaultThreadCount();
+    }
+
+    for (int i = 0; i < threadCount; i++) {
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+//
+// Destructor: ~WorkStealingPool
+// Stops and joins all worker threads.
+//
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+//
+// Method: parallelFor
+// Runs task(i) for every i in [0, count) on the workers and waits for all of them.
+// Tasks are dealt out in contiguous blocks so each worker starts on neighbouring indices.
+// Parameters:
+//   - count: Number of tasks.
+//   - task: The function to run for each task index.
+//
+void WorkStealingPool::parallelFor(int count, const std::function<void(int)>& task) {
+    if (count <= 0) return;
+
+    std::lock_guard<std::mutex> batchLock(batchMutex);
+    int workerCount = threadCount();
+
+    for (int w = 0; w < workerCount; w++) {
+        int begin = static_cast<int>(static_cast<int64_t>(count) * w / workerCount);
+        int end = static_cast<int>(static_cast<int64_t>(count) * (w + 1) / workerCount);
+        std::lock_guard<std::mutex> queueLock(queues[w]->mutex);
+        for (int i = begin; i < end; i++) {
+            queues[w]->tasks.push_back(i);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    currentTask = &task;
+    finishedWorkers = 0;
+    generation++;
+    wakeCondition.notify_all();
+    doneCondition.wait(lock, [&] { return finishedWorkers == workerCount; });
+    currentTask = nullptr;
+}
+
+//
+// Method: threadCount
+// Returns: The number of worker threads.
+//
+int WorkStealingPool::threadCount() const {
+    return static_cast<int>(queues.size());
+}
+
+//
+// Function: defaultThreadCount
+// Returns: The number of hardware threads, or 1 if it cannot be determined.
+//
+int WorkStealingPool::defaultThreadCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? static_cast<int>(count) : 1;
+}
+
+//
+// Method: workerLoop
+// Waits for batches and runs tasks until every deque is empty.
+// Parameters:
+//   - worker: Index of this worker.
+//
+void WorkStealingPool::workerLoop(int worker) {
+    uint64_t seenGeneration = 0;
+
+    while (true) {
+        const std::function<void(int)>* task;
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wakeCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+            task = currentTask;
+        }
+
+        // No tasks are added while a batch runs, so once neither the own deque
+        // nor any other deque yields work this worker is done with the batch.
+        int index;
+        while (popLocal(worker, index) || steal(worker, index)) {
+            (*task)(index);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            finishedWorkers++;
+        }
+        doneCondition.notify_one();
+    }
+}
+
+//
+// Method: popLocal
+// Takes the next task from the front of the worker's own deque.
+// Parameters:
+//   - worker: Index of the worker.
+//   - task: The task index (output).
+// Returns:
+//   - true if a task was taken, false if the deque is empty.
+//
+bool WorkStealingPool::popLocal(int worker, int& task) {
+    WorkQueue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+//
+// Method: steal
+// Takes a task from the back of another worker's deque, visiting victims in order
+// starting after the thief so that workers do not all pick the same victim.
+// Parameters:
+//   - worker: Index of the stealing worker.
+//   - task: The task index (output).
+// Returns:
+//   - true if a task was stolen, false if every deque is empty.
+//
+bool WorkStealingPool::steal(int worker, int& task) {
+    int workerCount = threadCount();
+    for (int offset = 1; offset < workerCount; offset++) {
+        WorkQueue& victim = *queues[(worker + offset) % workerCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
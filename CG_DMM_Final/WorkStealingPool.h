@@ -0,0 +1,88 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Class: WorkStealingPool
+// A fixed set of worker threads that run batches of independent tasks.
+// Each worker owns a deque of task indices: it takes work from the front of its
+// own deque and, once that is empty, steals from the back of another worker's.
+// This keeps neighbouring tasks on the same thread while still balancing uneven work.
+//
+class WorkStealingPool {
+public:
+    //
+    // Constructor: WorkStealingPool
+    // Starts the worker threads.
+    // Parameters:
+    //   - threadCount: Number of workers. Values <= 0 use the hardware concurrency.
+    //
+    explicit WorkStealingPool(int threadCount);
+
+    //
+    // Destructor: ~WorkStealingPool
+    // Stops and joins all worker threads.
+    //
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    //
+    // Method: parallelFor
+    // Runs task(i) for every i in [0, count) on the workers and waits for all of them.
+    // Calls from several threads are serialized.
+    // Parameters:
+    //   - count: Number of tasks.
+    //   - task: The function to run for each task index.
+    //
+    void parallelFor(int count, const std::function<void(int)>& task);
+
+    //
+    // Method: threadCount
+    // Returns: The number of worker threads.
+    //
+    int threadCount() const;
+
+    //
+    // Function: defaultThreadCount
+    // Returns: The number of hardware threads, or 1 if it cannot be determined.
+    //
+    static int defaultThreadCount();
+
+private:
+    //
+    // Struct: WorkQueue
+    // The task deque owned by one worker.
+    //
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    void workerLoop(int worker);
+    bool popLocal(int worker, int& task);
+    bool steal(int worker, int& task);
+
+    std::vector<std::thread> workers;                 // The worker threads.
+    std::vector<std::unique_ptr<WorkQueue>> queues;   // One task deque per worker.
+
+    std::mutex batchMutex;                            // Serializes parallelFor calls.
+    std::mutex stateMutex;                            // Guards the fields below.
+    std::condition_variable wakeCondition;            // Signals a new batch or shutdown.
+    std::condition_variable doneCondition;            // Signals that a worker ran out of work.
+    const std::function<void(int)>* currentTask;      // The task of the running batch.
+    uint64_t generation;                              // Incremented for every batch.
+    int finishedWorkers;                              // Workers done with the running batch.
+    bool stopping;                                    // Set when the pool shuts down.
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -0,0 +1,69 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <chrono>
+#include <cmath>
+#include "Camera.h"
+#include "Framebuffer.h"
+#include "Renderer.h"
+
+//
+// Helpers shared by the benchmarks: the default view, the settings every benchmark starts
+// from, a timed render and the difference between two images.
+//
+
+//
+// Function: defaultCamera
+// Returns: The camera of main's default view for an image of the given size.
+//
+inline Camera defaultCamera(int width, int height) {
+    return Camera(Vector3D(0, 1, -3), Vector3D(0, 1, 2), Vector3D(0, 1, 0), static_cast<Real>(width) / height);
+}
+
+//
+// Function: benchSettings
+// Returns: The default render settings with the given resolution and samples per pixel.
+//
+inline RenderSettings benchSettings(int width, int height, int spp) {
+    RenderSettings settings;
+    settings.width = width;
+    settings.height = height;
+    settings.spp = spp;
+    return settings;
+}
+
+//
+// Function: timedRender
+// Renders the default view into a framebuffer.
+// Parameters:
+//   - renderer: The renderer.
+//   - scene: The built scene.
+//   - settings: The render settings; the framebuffer must match their resolution.
+//   - framebuffer: The output image.
+// Returns: The render time in seconds.
+//
+inline double timedRender(Renderer& renderer, const Scene& scene, const RenderSettings& settings,
+                          Framebuffer& framebuffer) {
+    Camera camera = defaultCamera(settings.width, settings.height);
+    auto start = std::chrono::steady_clock::now();
+    renderer.render(scene, camera, settings, framebuffer);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//
+// Function: rmsDifference
+// Returns: The RMS difference of all color channels of two framebuffers.
+//
+inline double rmsDifference(const Framebuffer& a, const Framebuffer& b) {
+    double sum = 0.0;
+    for (int y = 0; y < a.height; y++) {
+        for (int x = 0; x < a.width; x++) {
+            const Color& p = a.getPixel(x, y);
+            const Color& q = b.getPixel(x, y);
+            sum += (p.r - q.r) * (p.r - q.r) + (p.g - q.g) * (p.g - q.g) + (p.b - q.b) * (p.b - q.b);
+        }
+    }
+    return std::sqrt(sum / (3.0 * a.width * a.height));
+}
+
+#endif // BENCHUTIL_H
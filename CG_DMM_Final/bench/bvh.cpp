@@ -0,0 +1,150 @@
+//
+// Benchmark: bvh
+// Measures how frame time grows with the number of primitives when closest-hit queries
+// go through the SAH BVH, and compares primary-ray queries against a linear scan of
+// every primitive (the approach TraceRay used before the BVH) for the smaller scenes.
+//
+// Build and run:  make bench-bvh && ./bench-bvh [maxPrimitives]
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include "BenchUtil.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 320;
+const int FRAME_HEIGHT = 180;
+const long LINEAR_SCAN_LIMIT = 10000;   // Linear scans above this size take minutes.
+
+//
+// Function: buildRandomScene
+// Fills the scene with `count` small spheres and triangles scattered in front of the camera.
+// Primitive size shrinks with count so the visible depth complexity stays comparable.
+// Only an ambient light is added so frame time measures visibility, not shadow rays.
+//
+void buildRandomScene(Scene& scene, long count) {
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    double size = 2.0 / std::cbrt(static_cast<double>(count));
+
+    for (long i = 0; i < count; i++) {
+        Vector3D center(-4.0 + 8.0 * unit(generator),
+                        -2.0 + 6.0 * unit(generator),
+                         2.0 + 10.0 * unit(generator));
+        Color color(unit(generator), unit(generator), unit(generator));
+        if (i % 2 == 0) {
+            scene.spheres.push_back(Sphere(center, 0.5 * size, color, 100, 0.0));
+        } else {
+            Vector3D a = center + Vector3D(unit(generator) - 0.5, unit(generator) - 0.5, unit(generator) - 0.5) * size;
+            Vector3D b = center + Vector3D(unit(generator) - 0.5, unit(generator) - 0.5, unit(generator) - 0.5) * size;
+            Vector3D c = center + Vector3D(unit(generator) - 0.5, unit(generator) - 0.5, unit(generator) - 0.5) * size;
+            scene.triangles.push_back(Triangle(a, b, c, color, 100, 0.0));
+        }
+    }
+    scene.lights.push_back(Light(1.0));
+}
+
+//
+// Function: linearClosestHit
+// Closest-hit query that tests every primitive, as TraceRay did before the BVH.
+//
+bool linearClosestHit(const Scene& scene, const Ray& ray, double t_min, double t_max, double& closest_t) {
+    closest_t = t_max;
+    bool found = false;
+    for (const Sphere& sphere : scene.spheres) {
+        Real t;
+        if (sphere.intersect(ray, t) && t > t_min && t < closest_t) {
+            closest_t = t;
+            found = true;
+        }
+    }
+    for (const Triangle& triangle : scene.triangles) {
+        Real t;
+        if (triangle.intersect(ray, t) && t > t_min && t < closest_t) {
+            closest_t = t;
+            found = true;
+        }
+    }
+    return found;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long maxPrimitives = argc > 1 ? std::atol(argv[1]) : 1000000;
+
+    RenderSettings settings = benchSettings(FRAME_WIDTH, FRAME_HEIGHT, 1);
+    settings.maxDepth = 1;
+
+    Camera camera = defaultCamera(FRAME_WIDTH, FRAME_HEIGHT);
+    Renderer renderer(1);
+
+    std::printf("%-12s %10s %8s %12s %14s %14s\n",
+                "primitives", "build ms", "nodes", "frame ms", "bvh Mrays/s", "linear Mrays/s");
+
+    for (long count = 10; count <= maxPrimitives; count *= 10) {
+        Scene scene;
+        buildRandomScene(scene, count);
+
+        auto start = std::chrono::steady_clock::now();
+        scene.build();
+        double buildSeconds = secondsSince(start);
+
+        Framebuffer framebuffer(FRAME_WIDTH, FRAME_HEIGHT);
+        start = std::chrono::steady_clock::now();
+        renderer.render(scene, camera, settings, framebuffer);
+        double frameSeconds = secondsSince(start);
+
+        // Primary-visibility throughput: one ray through every pixel center
+        long rays = static_cast<long>(FRAME_WIDTH) * FRAME_HEIGHT;
+        long hits = 0;
+        start = std::chrono::steady_clock::now();
+        for (int y = 0; y < FRAME_HEIGHT; y++) {
+            for (int x = 0; x < FRAME_WIDTH; x++) {
+                Ray ray = camera.generateRay((x + 0.5) / FRAME_WIDTH - 0.5, (y + 0.5) / FRAME_HEIGHT - 0.5);
+                Hit hit;
+                hits += scene.intersect(ray, 1.0, std::numeric_limits<double>::infinity(), hit);
+            }
+        }
+        double bvhRate = rays / secondsSince(start) * 1e-6;
+
+        double linearRate = 0.0;
+        if (count <= LINEAR_SCAN_LIMIT) {
+            long linearHits = 0;
+            start = std::chrono::steady_clock::now();
+            for (int y = 0; y < FRAME_HEIGHT; y++) {
+                for (int x = 0; x < FRAME_WIDTH; x++) {
+                    Ray ray = camera.generateRay((x + 0.5) / FRAME_WIDTH - 0.5, (y + 0.5) / FRAME_HEIGHT - 0.5);
+                    double t;
+                    linearHits += linearClosestHit(scene, ray, 1.0, std::numeric_limits<double>::infinity(), t);
+                }
+            }
+            linearRate = rays / secondsSince(start) * 1e-6;
+            if (linearHits != hits) {
+                std::fprintf(stderr, "Hit count mismatch: bvh %ld, linear %ld\n", hits, linearHits);
+                return 1;
+            }
+        }
+
+        std::printf("%-12ld %10.1f %8zu %12.1f %14.3f ", count, buildSeconds * 1e3,
+                    scene.bvh.nodes.size(), frameSeconds * 1e3, bvhRate);
+        if (linearRate > 0.0) {
+            std::printf("%14.3f\n", linearRate);
+        } else {
+            std::printf("%14s\n", "-");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+//
+// Benchmark: gbuffer
+// Measures the turnaround of a lighting edit with and without reusing the previous render.
+// Each scene is built and rendered once while recording its primary hits; then its lights
+// are dimmed and moved and a sphere is recolored. Without reuse, the edited scene is built
+// (BVH and packing included) and rendered in full. With reuse, only the shading data is
+// rebuilt (Scene::buildShading, what SceneCache::loadGeometry does after mapping the
+// cached geometry) and the recorded hits are re-shaded (Renderer::reshade). Both images
+// must be byte-identical. The scenes are the default scene, and the default scene with a
+// torus of about a million triangles filling the middle of the view.
+//
+// Build and run:  make bench-gbuffer && ./bench-gbuffer [torusTriangles]
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "BenchUtil.h"
+#include "GBuffer.h"
+#include "ImageWriter.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 320;
+const int FRAME_HEIGHT = 180;
+const int SAMPLES_PER_PIXEL = 4;
+
+//
+// Function: makeTorus
+// Builds a torus around the y axis with about `triangles` triangles and exact vertex normals.
+//
+Mesh makeTorus(long triangles) {
+    int rings = std::max(3, static_cast<int>(std::sqrt(triangles / 4.0)));
+    int segments = std::max(3, static_cast<int>(triangles / (2 * rings)));
+    const double majorRadius = 1.0, minorRadius = 0.35;
+
+    Mesh mesh;
+    for (int i = 0; i < segments; i++) {
+        double u = 2.0 * M_PI * i / segments;
+        for (int j = 0; j < rings; j++) {
+            double v = 2.0 * M_PI * j / rings;
+            Vector3D normal(std::cos(u) * std::cos(v), std::sin(v), std::sin(u) * std::cos(v));
+            Vector3D position = Vector3D(majorRadius * std::cos(u), 0, majorRadius * std::sin(u)) + normal * minorRadius;
+            mesh.positions.insert(mesh.positions.end(), {static_cast<float>(position.x), static_cast<float>(position.y),
+                                                         static_cast<float>(position.z)});
+            mesh.normals.insert(mesh.normals.end(), {static_cast<float>(normal.x), static_cast<float>(normal.y),
+                                                     static_cast<float>(normal.z)});
+        }
+    }
+    for (int i = 0; i < segments; i++) {
+        for (int j = 0; j < rings; j++) {
+            uint32_t a = i * rings + j, b = ((i + 1) % segments) * rings + j;
+            uint32_t c = ((i + 1) % segments) * rings + (j + 1) % rings, d = i * rings + (j + 1) % rings;
+            mesh.indices.insert(mesh.indices.end(), {a, d, c, a, c, b});
+        }
+    }
+    mesh.normalIndices = mesh.indices;
+    mesh.fitInto(AABB(Vector3D(-1.5, -0.5, 2.0), Vector3D(1.5, 2.5, 3.0)));
+    return mesh;
+}
+
+//
+// Function: setupBenchScene
+// Sets up the default scene, optionally with the torus.
+//
+void setupBenchScene(Scene& scene, long torusTriangles) {
+    setupScene(scene);
+    if (torusTriangles > 0) scene.meshes.push_back(makeTorus(torusTriangles));
+}
+
+//
+// Function: editLighting
+// Dims and moves the lights and recolors a sphere.
+//
+void editLighting(Scene& scene) {
+    for (Light& light : scene.lights) {
+        light.intensity *= 0.8;
+        light.position = light.position + Vector3D(0.5, 0.25, 0);
+    }
+    scene.spheres[0].color = Color(0.9, 0.8, 0.2);
+}
+
+//
+// Function: seconds
+// Returns: The time since `start` in seconds.
+//
+double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long torusTriangles = argc > 1 ? std::atol(argv[1]) : 1000000;
+    Renderer renderer(0);
+    Camera camera = defaultCamera(FRAME_WIDTH, FRAME_HEIGHT);
+    std::printf("%dx%d, %d spp, %d threads\n", FRAME_WIDTH, FRAME_HEIGHT, SAMPLES_PER_PIXEL, renderer.threadCount());
+
+    RenderSettings settings = benchSettings(FRAME_WIDTH, FRAME_HEIGHT, SAMPLES_PER_PIXEL);
+
+    bool identical = true;
+    for (long triangles : {0L, torusTriangles}) {
+        std::printf("%s\n", triangles > 0 ? (std::to_string(triangles) + "-triangle torus").c_str() : "default scene");
+
+        // The render before the edit, recording the primary hits
+        Scene scene;
+        setupBenchScene(scene, triangles);
+        scene.build();
+        GBuffer gbuffer;
+        Framebuffer framebuffer(FRAME_WIDTH, FRAME_HEIGHT);
+        auto start = std::chrono::steady_clock::now();
+        renderer.render(scene, camera, settings, framebuffer, nullptr, &gbuffer);
+        std::printf("    recording render %7.3f s, G-buffer %.1f MiB\n", seconds(start),
+                    gbuffer.samples.size() * sizeof(GBufferSample) / (1024.0 * 1024.0));
+
+        // The edit without reuse: build and render from scratch
+        Scene edited;
+        setupBenchScene(edited, triangles);
+        editLighting(edited);
+        Framebuffer full(FRAME_WIDTH, FRAME_HEIGHT);
+        start = std::chrono::steady_clock::now();
+        edited.build();
+        double buildSeconds = seconds(start);
+        start = std::chrono::steady_clock::now();
+        renderer.render(edited, camera, settings, full);
+        double renderSeconds = seconds(start);
+
+        // The edit with reuse: rebuild the shading data and re-shade the recorded hits
+        editLighting(scene);
+        Framebuffer reshaded(FRAME_WIDTH, FRAME_HEIGHT);
+        start = std::chrono::steady_clock::now();
+        scene.buildShading();
+        double shadingSeconds = seconds(start);
+        start = std::chrono::steady_clock::now();
+        renderer.reshade(scene, camera, gbuffer, settings, reshaded);
+        double reshadeSeconds = seconds(start);
+
+        bool same = encodeImage(full, ImageFormat::PFM) == encodeImage(reshaded, ImageFormat::PFM);
+        identical = identical && same;
+        std::printf("    edit, from scratch: build   %7.3f s + render  %7.3f s = %7.3f s\n", buildSeconds,
+                    renderSeconds, buildSeconds + renderSeconds);
+        std::printf("    edit, reused:       shading %7.3f s + reshade %7.3f s = %7.3f s  %5.2fx%s\n",
+                    shadingSeconds, reshadeSeconds, shadingSeconds + reshadeSeconds,
+                    (buildSeconds + renderSeconds) / (shadingSeconds + reshadeSeconds),
+                    same ? "" : "  (images differ!)");
+    }
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+//
+// Benchmark: irradiance
+// Measures the irradiance cache against one traced indirect ray per hit. Each scene is
+// rendered without the cache, with a new (cold) cache, and again with the cache the cold
+// render filled (warm, as for the next frame of a render server). Each image's noise is
+// its RMS difference to a reference rendered without the cache at REFERENCE_SPP samples
+// per pixel (whose own noise is included). The scenes are the default scene, whose
+// indirect rays mostly escape to the sky, and the default scene inside three diffuse
+// walls, where every indirect ray hits a surface and is shaded; the walled scene is also
+// rendered at depth 3, where the records' own rays use the cache one level down.
+//
+// Build and run:  make bench-irradiance && ./bench-irradiance [accuracy]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include "BenchUtil.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 640;
+const int FRAME_HEIGHT = 360;
+const int SAMPLES_PER_PIXEL = 4;
+const int REFERENCE_SPP = 32;
+
+//
+// Function: addWalls
+// Puts matte walls behind and beside the default scene, from the ground up to y = 6.
+//
+void addWalls(Scene& scene) {
+    const Color wall(0.8, 0.8, 0.75);
+    const Vector3D corners[] = {Vector3D(-6, -2, -4), Vector3D(-6, -2, 8), Vector3D(6, -2, 8), Vector3D(6, -2, -4)};
+    for (int i = 0; i < 3; i++) {
+        Vector3D a = corners[i], b = corners[i + 1];
+        Vector3D up(0, 8, 0);
+        scene.triangles.push_back(Triangle(a, b, b + up, wall, -1, 0.0, 0.0, 0.0));
+        scene.triangles.push_back(Triangle(a, b + up, a + up, wall, -1, 0.0, 0.0, 0.0));
+    }
+}
+
+//
+// Function: render
+// Renders the default view into a framebuffer.
+// Returns: The render time in seconds.
+//
+double render(Renderer& renderer, const Scene& scene, int spp, int depth, Framebuffer& framebuffer) {
+    RenderSettings settings = benchSettings(FRAME_WIDTH, FRAME_HEIGHT, spp);
+    settings.maxDepth = depth;
+    return timedRender(renderer, scene, settings, framebuffer);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    double accuracy = argc > 1 ? std::atof(argv[1]) : 0.3;
+    Renderer renderer(0);
+    std::printf("%dx%d, %d spp, %d threads, accuracy %.2f; noise is the RMS difference to a %d spp render "
+                "without the cache\n",
+                FRAME_WIDTH, FRAME_HEIGHT, SAMPLES_PER_PIXEL, renderer.threadCount(), accuracy, REFERENCE_SPP);
+    std::printf("%-16s %-12s %9s %9s %9s %8s\n", "scene", "indirect", "seconds", "speedup", "noise", "records");
+
+    struct Case {
+        const char* name;
+        bool walls;
+        int depth;
+    };
+    const Case cases[] = {{"default", false, 2}, {"walls", true, 2}, {"walls, depth 3", true, 3}};
+    for (const Case& c : cases) {
+        Scene scene;
+        setupScene(scene);
+        if (c.walls) addWalls(scene);
+        scene.build();
+
+        Framebuffer reference(FRAME_WIDTH, FRAME_HEIGHT);
+        render(renderer, scene, REFERENCE_SPP, c.depth, reference);
+
+        Framebuffer traced(FRAME_WIDTH, FRAME_HEIGHT);
+        double tracedSeconds = render(renderer, scene, SAMPLES_PER_PIXEL, c.depth, traced);
+        std::printf("%-16s %-12s %9.3f %9s %9.5f\n", c.name, "traced", tracedSeconds, "",
+                    rmsDifference(traced, reference));
+
+        scene.indirectCache = std::make_unique<IrradianceCache>(accuracy);
+        for (const char* pass : {"cache, cold", "cache, warm"}) {
+            Framebuffer cached(FRAME_WIDTH, FRAME_HEIGHT);
+            double seconds = render(renderer, scene, SAMPLES_PER_PIXEL, c.depth, cached);
+            std::printf("%-16s %-12s %9.3f %8.2fx %9.5f %8zu\n", "", pass, seconds, tracedSeconds / seconds,
+                        rmsDifference(cached, reference), scene.indirectCache->recordCount());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+//
+// Benchmark: lighttree
+// Measures shading cost and noise with many point lights: the default scene plus a grid
+// of street lamps over the ground, from 16 to 1024 lights (or up to the count given on
+// the command line). Each light count is rendered visiting every light at every shading
+// point, and picking 1 and 4 lights per point from the light tree (Scene::lightSamples). The noise of each image is its RMS
+// difference to a reference rendered with every light at REFERENCE_SPP samples per
+// pixel; the reference's own noise is included, so the numbers only compare the
+// settings with each other. The total intensity is kept constant across light counts,
+// since lights do not fall off with distance.
+//
+// Build and run:  make bench-lighttree && ./bench-lighttree [maxLights]
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include "BenchUtil.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 96;
+const int FRAME_HEIGHT = 54;
+const int SAMPLES_PER_PIXEL = 4;
+const int REFERENCE_SPP = 16;
+const Real TOTAL_INTENSITY = 1.2;
+
+//
+// Function: addStreetLamps
+// Adds `count` point lights on a grid 3 to 4 units above the ground in front of the camera,
+// with random intensities summing to about TOTAL_INTENSITY.
+//
+void addStreetLamps(Scene& scene, int count) {
+    std::mt19937 generator(99);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+    for (int i = 0; i < count; i++) {
+        Real x = -20.0 + 40.0 * ((i % side) + 0.5) / side;
+        Real z = -5.0 + 35.0 * ((i / side) + 0.5) / side;
+        Real intensity = TOTAL_INTENSITY / count * (0.5 + unit(generator));
+        scene.lights.push_back(Light(intensity, Vector3D(x, 3.0 + unit(generator), z)));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int maxLights = argc > 1 ? std::atoi(argv[1]) : 1024;
+    Renderer renderer(0);
+    std::printf("%dx%d, %d spp, %d threads; noise is the RMS difference to a %d spp reference\n", FRAME_WIDTH,
+                FRAME_HEIGHT, SAMPLES_PER_PIXEL, renderer.threadCount(), REFERENCE_SPP);
+    RenderSettings settings = benchSettings(FRAME_WIDTH, FRAME_HEIGHT, SAMPLES_PER_PIXEL);
+    RenderSettings referenceSettings = benchSettings(FRAME_WIDTH, FRAME_HEIGHT, REFERENCE_SPP);
+
+    for (int lights = 16; lights <= maxLights; lights *= 4) {
+        Scene scene;
+        setupScene(scene);
+        addStreetLamps(scene, lights);
+        scene.build();
+
+        Framebuffer reference(FRAME_WIDTH, FRAME_HEIGHT);
+        timedRender(renderer, scene, referenceSettings, reference);
+        std::printf("%5d point lights\n", lights);
+
+        double allLights = 0.0;
+        for (int samples : {0, 1, 4}) {
+            scene.lightSamples = samples;
+            Framebuffer framebuffer(FRAME_WIDTH, FRAME_HEIGHT);
+            double seconds = timedRender(renderer, scene, settings, framebuffer);
+            if (samples == 0) allLights = seconds;
+            char name[32];
+            if (samples == 0) {
+                std::snprintf(name, sizeof(name), "every light");
+            } else {
+                std::snprintf(name, sizeof(name), "light tree, %d per point", samples);
+            }
+            std::printf("    %-26s %8.3f s  %6.2fx   noise %.4f\n", name, seconds, allLights / seconds,
+                        rmsDifference(framebuffer, reference));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,280 @@
+//
+// Benchmark: math
+// Compares the header-only Vector3D/Color against the previous out-of-line versions
+// (every operator a call into another translation unit, modelled here with noinline
+// copies) on three kernels written once for both: the Sphere::intersect quadratic, the
+// Triangle::intersect Moller-Trumbore test, and a computeLighting-style diffuse and
+// specular shading loop. Intersection checksums must match exactly; shading checksums
+// may differ in the last bits, since normalize() now multiplies by a reciprocal.
+//
+// Build and run:  make bench-math && ./bench-math
+// SIMD layout:    make -B bench-math CXXFLAGS=-DRAYTRACER_SIMD_MATH && ./bench-math
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+#include "Color.h"
+#include "Vector3D.h"
+
+namespace {
+
+const int ITEM_COUNT = 4096;
+const int REPETITIONS = 200;
+
+#define LEGACY_CALL __attribute__((noinline))
+
+//
+// Class: LegacyVector3D
+// The previous Vector3D: out-of-line operators and a user-declared destructor.
+//
+class LegacyVector3D {
+public:
+    double x, y, z;
+    LEGACY_CALL LegacyVector3D(double x, double y, double z) : x(x), y(y), z(z) {}
+    LEGACY_CALL LegacyVector3D() : x(0.0), y(0.0), z(0.0) {}
+    LEGACY_CALL ~LegacyVector3D() {}
+    LEGACY_CALL LegacyVector3D operator+(const LegacyVector3D& v) const { return LegacyVector3D(x + v.x, y + v.y, z + v.z); }
+    LEGACY_CALL LegacyVector3D operator-(const LegacyVector3D& v) const { return LegacyVector3D(x - v.x, y - v.y, z - v.z); }
+    LEGACY_CALL LegacyVector3D operator*(double s) const { return LegacyVector3D(x * s, y * s, z * s); }
+    LEGACY_CALL double dot(const LegacyVector3D& v) const { return x * v.x + y * v.y + z * v.z; }
+    LEGACY_CALL LegacyVector3D cross(const LegacyVector3D& v) const {
+        return LegacyVector3D(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x);
+    }
+    LEGACY_CALL double length() const { return std::sqrt(x * x + y * y + z * z); }
+    LEGACY_CALL LegacyVector3D normalize() const {
+        double len = length();
+        if (len == 0) return LegacyVector3D(0, 0, 0);
+        return LegacyVector3D(x / len, y / len, z / len);
+    }
+};
+
+//
+// Class: LegacyColor
+// The previous Color: out-of-line operators and a user-declared destructor.
+//
+class LegacyColor {
+public:
+    double r, g, b;
+    LEGACY_CALL LegacyColor(double r, double g, double b) : r(r), g(g), b(b) {}
+    LEGACY_CALL LegacyColor() : r(0.0), g(0.0), b(0.0) {}
+    LEGACY_CALL ~LegacyColor() {}
+    LEGACY_CALL LegacyColor operator+(const LegacyColor& c) const { return LegacyColor(r + c.r, g + c.g, b + c.b); }
+    LEGACY_CALL LegacyColor operator*(double s) const { return LegacyColor(r * s, g * s, b * s); }
+    LEGACY_CALL LegacyColor operator*(const LegacyColor& c) const { return LegacyColor(r * c.r, g * c.g, b * c.b); }
+};
+
+#undef LEGACY_CALL
+
+//
+// Function: sphereKernel
+// Sphere::intersect on ray i against sphere i; returns the sum of hit distances.
+//
+template <typename V>
+double sphereKernel(const std::vector<V>& origins, const std::vector<V>& directions,
+                    const std::vector<V>& centers, const std::vector<double>& radii) {
+    double sum = 0.0;
+    for (size_t i = 0; i < origins.size(); i++) {
+        V oc = origins[i] - centers[i];
+        double k1 = directions[i].dot(directions[i]);
+        double k2 = 2 * oc.dot(directions[i]);
+        double k3 = oc.dot(oc) - radii[i] * radii[i];
+        double discriminant = k2 * k2 - 4 * k1 * k3;
+        if (discriminant < 0) continue;
+        double sqrtDiscriminant = std::sqrt(discriminant);
+        double t1 = (-k2 + sqrtDiscriminant) / (2 * k1);
+        double t2 = (-k2 - sqrtDiscriminant) / (2 * k1);
+        if (t1 >= 0 && t2 >= 0) sum += std::min(t1, t2);
+        else if (t1 >= 0) sum += t1;
+        else if (t2 >= 0) sum += t2;
+    }
+    return sum;
+}
+
+//
+// Function: triangleKernel
+// Triangle::intersect on ray i against triangle (a, b, c)[i]; returns the sum of hit distances.
+//
+template <typename V>
+double triangleKernel(const std::vector<V>& origins, const std::vector<V>& directions,
+                      const std::vector<V>& a, const std::vector<V>& b, const std::vector<V>& c) {
+    const double EPSILON = 1e-8;
+    double sum = 0.0;
+    for (size_t i = 0; i < origins.size(); i++) {
+        V edge1 = b[i] - a[i];
+        V edge2 = c[i] - a[i];
+        V h = directions[i].cross(edge2);
+        double det = edge1.dot(h);
+        if (std::fabs(det) < EPSILON) continue;
+        double f = 1.0 / det;
+        V s = origins[i] - a[i];
+        double u = f * s.dot(h);
+        if (u < 0.0 || u > 1.0) continue;
+        V q = s.cross(edge1);
+        double v = f * directions[i].dot(q);
+        if (v < 0.0 || u + v > 1.0) continue;
+        double t = f * edge2.dot(q);
+        if (t > EPSILON) sum += t;
+    }
+    return sum;
+}
+
+//
+// Function: shadeKernel
+// Diffuse plus Phong specular from four point lights at every point; returns the sum of
+// the resulting color channels.
+//
+template <typename V, typename C>
+double shadeKernel(const std::vector<V>& points, const std::vector<V>& normals,
+                   const std::vector<V>& lights, const C& objectColor) {
+    double sum = 0.0;
+    for (size_t i = 0; i < points.size(); i++) {
+        C color(0, 0, 0);
+        V view = (points[i] * -1.0).normalize();
+        for (const V& light : lights) {
+            V lightDir = (light - points[i]).normalize();
+            double nDotL = normals[i].dot(lightDir);
+            if (nDotL <= 0) continue;
+            V reflectDir = normals[i] * (2 * nDotL) - lightDir;
+            double rDotV = reflectDir.dot(view);
+            double specular = rDotV > 0 ? std::pow(rDotV / (reflectDir.length() * view.length()), 32) : 0.0;
+            color = color + objectColor * (0.25 * nDotL) + C(1, 1, 1) * (0.25 * specular);
+        }
+        color = color * objectColor;
+        sum += color.r + color.g + color.b;
+    }
+    return sum;
+}
+
+//
+// Struct: KernelInputs
+// The random inputs of all kernels for one vector type.
+//
+template <typename V>
+struct KernelInputs {
+    std::vector<V> origins, directions, centers, a, b, c, points, normals, lights;
+    std::vector<double> radii;
+};
+
+//
+// Function: makeInputs
+// Generates the random inputs of all kernels.
+//
+KernelInputs<Vector3D> makeInputs() {
+    typedef Vector3D V;
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    auto random = [&]() { return V(unit(generator), unit(generator), unit(generator)); };
+
+    KernelInputs<V> inputs;
+    for (int i = 0; i < ITEM_COUNT; i++) {
+        inputs.origins.push_back(random() * 0.5);
+        inputs.directions.push_back((random() + V(0, 0, 2)).normalize());
+        inputs.centers.push_back(random() + V(0, 0, 3));
+        inputs.radii.push_back(0.5 + 0.5 * std::fabs(unit(generator)));
+        V base = random() + V(0, 0, 3);
+        inputs.a.push_back(base);
+        inputs.b.push_back(base + random());
+        inputs.c.push_back(base + random());
+        inputs.points.push_back(random() + V(0, 0, 4));
+        inputs.normals.push_back((random() + V(0, 0, -2)).normalize());
+    }
+    for (int i = 0; i < 4; i++) {
+        inputs.lights.push_back(random() * 4.0 + V(0, 3, 0));
+    }
+    return inputs;
+}
+
+//
+// Function: toLegacy
+// Copies the inputs into LegacyVector3D, so both versions see bitwise identical data.
+//
+KernelInputs<LegacyVector3D> toLegacy(const KernelInputs<Vector3D>& inputs) {
+    auto convert = [](const std::vector<Vector3D>& vectors) {
+        std::vector<LegacyVector3D> result;
+        for (const Vector3D& v : vectors) result.push_back(LegacyVector3D(v.x, v.y, v.z));
+        return result;
+    };
+    KernelInputs<LegacyVector3D> legacy;
+    legacy.origins = convert(inputs.origins);
+    legacy.directions = convert(inputs.directions);
+    legacy.centers = convert(inputs.centers);
+    legacy.a = convert(inputs.a);
+    legacy.b = convert(inputs.b);
+    legacy.c = convert(inputs.c);
+    legacy.points = convert(inputs.points);
+    legacy.normals = convert(inputs.normals);
+    legacy.lights = convert(inputs.lights);
+    legacy.radii = inputs.radii;
+    return legacy;
+}
+
+//
+// Function: measure
+// Runs a kernel REPETITIONS times and returns the best time per item in nanoseconds.
+//
+template <typename Kernel>
+double measure(Kernel kernel, double& checksum) {
+    double best = std::numeric_limits<double>::infinity();
+    for (int r = 0; r < REPETITIONS; r++) {
+        auto start = std::chrono::steady_clock::now();
+        checksum = kernel();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best / ITEM_COUNT * 1e9;
+}
+
+//
+// Function: compare
+// Times one kernel with both math types and prints ns/item and the speedup.
+//
+template <typename Legacy, typename Inline>
+bool compare(const char* name, Legacy legacy, Inline inlined) {
+    double legacySum, inlineSum;
+    double legacyNs = measure(legacy, legacySum);
+    double inlineNs = measure(inlined, inlineSum);
+    std::printf("  %-10s legacy %8.2f ns   inline %8.2f ns   %5.2fx\n", name, legacyNs, inlineNs, legacyNs / inlineNs);
+    if (legacySum != inlineSum) {
+        std::fprintf(stderr, "%s checksums differ: legacy %.17g, inline %.17g\n", name, legacySum, inlineSum);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+#ifdef RAYTRACER_SIMD_MATH
+    std::printf("Vector3D/Color: 4-wide SIMD layout (%zu bytes)\n", sizeof(Vector3D));
+#else
+    std::printf("Vector3D/Color: scalar layout (%zu bytes)\n", sizeof(Vector3D));
+#endif
+
+    KernelInputs<Vector3D> inlined = makeInputs();
+    KernelInputs<LegacyVector3D> legacy = toLegacy(inlined);
+    LegacyColor legacyColor(0.8, 0.3, 0.2);
+    Color inlineColor(0.8, 0.3, 0.2);
+
+    bool ok = compare("sphere",
+        [&]() { return sphereKernel(legacy.origins, legacy.directions, legacy.centers, legacy.radii); },
+        [&]() { return sphereKernel(inlined.origins, inlined.directions, inlined.centers, inlined.radii); });
+    ok = compare("triangle",
+        [&]() { return triangleKernel(legacy.origins, legacy.directions, legacy.a, legacy.b, legacy.c); },
+        [&]() { return triangleKernel(inlined.origins, inlined.directions, inlined.a, inlined.b, inlined.c); }) && ok;
+    // Shading normalizes vectors, which the new Vector3D does with a reciprocal, so its
+    // checksum may differ from the legacy one in the last bits; only time it
+    double legacySum, inlineSum;
+    double legacyNs = measure([&]() { return shadeKernel(legacy.points, legacy.normals, legacy.lights, legacyColor); }, legacySum);
+    double inlineNs = measure([&]() { return shadeKernel(inlined.points, inlined.normals, inlined.lights, inlineColor); }, inlineSum);
+    std::printf("  %-10s legacy %8.2f ns   inline %8.2f ns   %5.2fx\n", "shading", legacyNs, inlineNs, legacyNs / inlineNs);
+    if (std::fabs(legacySum - inlineSum) > 1e-9 * std::fabs(legacySum)) {
+        std::fprintf(stderr, "shading checksums differ: legacy %.17g, inline %.17g\n", legacySum, inlineSum);
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+//
+// Benchmark: mesh
+// Measures the mesh loader and the memory of indexed meshes:
+//   - writes a torus of the requested triangle count (with vertex normals) as OBJ and as
+//     binary PLY into a directory,
+//   - times loadMesh on both with one thread and with all hardware threads,
+//   - compares the mesh buffers with the same triangles stored as standalone Triangle objects,
+//   - checks that rays hit the mesh at exactly the distances they hit the equivalent Triangles.
+//
+// Build and run:  make bench-mesh && ./bench-mesh [triangles] [directory]
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "MeshLoader.h"
+#include "RayTracer.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+//
+// Function: makeTorus
+// Builds a torus around the y axis with about `triangles` triangles and exact vertex normals.
+//
+Mesh makeTorus(long triangles) {
+    int rings = std::max(3, static_cast<int>(std::sqrt(triangles / 4.0)));
+    int segments = std::max(3, static_cast<int>(triangles / (2 * rings)));
+    const double majorRadius = 1.0, minorRadius = 0.35;
+
+    Mesh mesh;
+    for (int i = 0; i < segments; i++) {
+        double u = 2.0 * M_PI * i / segments;
+        for (int j = 0; j < rings; j++) {
+            double v = 2.0 * M_PI * j / rings;
+            Vector3D normal(std::cos(u) * std::cos(v), std::sin(v), std::sin(u) * std::cos(v));
+            Vector3D center(majorRadius * std::cos(u), 0, majorRadius * std::sin(u));
+            Vector3D position = center + normal * minorRadius;
+            mesh.positions.insert(mesh.positions.end(), {static_cast<float>(position.x), static_cast<float>(position.y),
+                                                         static_cast<float>(position.z)});
+            mesh.normals.insert(mesh.normals.end(), {static_cast<float>(normal.x), static_cast<float>(normal.y),
+                                                     static_cast<float>(normal.z)});
+        }
+    }
+    for (int i = 0; i < segments; i++) {
+        for (int j = 0; j < rings; j++) {
+            uint32_t a = i * rings + j, b = ((i + 1) % segments) * rings + j;
+            uint32_t c = ((i + 1) % segments) * rings + (j + 1) % rings, d = i * rings + (j + 1) % rings;
+            mesh.indices.insert(mesh.indices.end(), {a, d, c, a, c, b});
+        }
+    }
+    mesh.normalIndices = mesh.indices;
+    return mesh;
+}
+
+//
+// Function: writeObj
+// Writes positions, normals and "f v//vn" faces; floats are printed with enough digits to
+// read back exactly.
+//
+bool writeObj(const Mesh& mesh, const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    std::fprintf(file, "# torus, %zu triangles\n", mesh.triangleCount());
+    for (std::size_t i = 0; i < mesh.positions.size(); i += 3) {
+        std::fprintf(file, "v %.9g %.9g %.9g\n", mesh.positions[i], mesh.positions[i + 1], mesh.positions[i + 2]);
+    }
+    for (std::size_t i = 0; i < mesh.normals.size(); i += 3) {
+        std::fprintf(file, "vn %.9g %.9g %.9g\n", mesh.normals[i], mesh.normals[i + 1], mesh.normals[i + 2]);
+    }
+    for (std::size_t i = 0; i < mesh.indices.size(); i += 3) {
+        std::fprintf(file, "f %u//%u %u//%u %u//%u\n", mesh.indices[i] + 1, mesh.normalIndices[i] + 1,
+                     mesh.indices[i + 1] + 1, mesh.normalIndices[i + 1] + 1,
+                     mesh.indices[i + 2] + 1, mesh.normalIndices[i + 2] + 1);
+    }
+    return std::fclose(file) == 0;
+}
+
+//
+// Function: writePly
+// Writes a little-endian binary PLY with float x, y, z, nx, ny, nz and uchar/int face lists.
+//
+bool writePly(const Mesh& mesh, const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    std::fprintf(file, "ply\nformat binary_little_endian 1.0\ncomment torus\n"
+                       "element vertex %zu\nproperty float x\nproperty float y\nproperty float z\n"
+                       "property float nx\nproperty float ny\nproperty float nz\n"
+                       "element face %zu\nproperty list uchar int vertex_indices\nend_header\n",
+                 mesh.vertexCount(), mesh.triangleCount());
+    for (std::size_t v = 0; v < mesh.vertexCount(); v++) {
+        std::fwrite(&mesh.positions[3 * v], sizeof(float), 3, file);
+        std::fwrite(&mesh.normals[3 * v], sizeof(float), 3, file);
+    }
+    for (std::size_t t = 0; t < mesh.triangleCount(); t++) {
+        unsigned char corners = 3;
+        std::fwrite(&corners, 1, 1, file);
+        std::fwrite(&mesh.indices[3 * t], sizeof(uint32_t), 3, file);
+    }
+    return std::fclose(file) == 0;
+}
+
+//
+// Function: timeLoad
+// Loads a file with the given thread count; returns the seconds taken, or -1 on failure.
+//
+double timeLoad(const std::string& path, int threads, Mesh& mesh) {
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    if (!loadMesh(path, mesh, error, threads)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return -1.0;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//
+// Function: sameBuffers
+// Returns: true if two meshes have identical buffers.
+//
+bool sameBuffers(const Mesh& a, const Mesh& b) {
+    return a.positions == b.positions && a.normals == b.normals && a.indices == b.indices &&
+           a.normalIndices == b.normalIndices;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long triangles = argc > 1 ? std::atol(argv[1]) : 2000000;
+    std::string directory = argc > 2 ? argv[2] : "/tmp";
+
+    Mesh torus = makeTorus(triangles);
+    std::string objPath = directory + "/bench-mesh.obj", plyPath = directory + "/bench-mesh.ply";
+    if (!writeObj(torus, objPath) || !writePly(torus, plyPath)) {
+        std::fprintf(stderr, "Cannot write the test meshes to %s\n", directory.c_str());
+        return 1;
+    }
+    std::printf("torus: %zu triangles, %zu vertices\n", torus.triangleCount(), torus.vertexCount());
+
+    // Load times
+    std::vector<int> threadCounts = {1};
+    if (WorkStealingPool::defaultThreadCount() > 1) threadCounts.push_back(WorkStealingPool::defaultThreadCount());
+    Mesh loaded;
+    for (const std::string& path : {objPath, plyPath}) {
+        for (int threads : threadCounts) {
+            double seconds = timeLoad(path, threads, loaded);
+            if (seconds < 0) return 1;
+            std::printf("  %-4s %2d threads %8.3f s  %8.2f Mtriangles/s\n", path.substr(path.size() - 3).c_str(),
+                        threads, seconds, loaded.triangleCount() / seconds * 1e-6);
+            if (!sameBuffers(loaded, torus)) {
+                std::fprintf(stderr, "Loaded %s differs from the written mesh\n", path.c_str());
+                return 1;
+            }
+        }
+    }
+
+    // Memory: indexed buffers against one Triangle object per triangle
+    double meshBytes = static_cast<double>(torus.memoryBytes());
+    double triangleBytes = static_cast<double>(torus.triangleCount()) * sizeof(Triangle);
+    std::printf("memory: mesh %.1f MiB (%.1f B/triangle), Triangle objects %.1f MiB (%.1f B/triangle)\n",
+                meshBytes / (1 << 20), meshBytes / torus.triangleCount(),
+                triangleBytes / (1 << 20), triangleBytes / torus.triangleCount());
+
+    // Hits: the mesh against the same triangles as Triangle objects
+    Scene meshScene, triangleScene;
+    for (std::size_t t = 0; t < torus.triangleCount(); t++) {
+        triangleScene.triangles.push_back(Triangle(torus.vertex(torus.indices[3 * t]), torus.vertex(torus.indices[3 * t + 1]),
+                                                   torus.vertex(torus.indices[3 * t + 2]), torus.color,
+                                                   torus.specular, torus.reflective));
+    }
+    meshScene.meshes.push_back(torus);
+    auto buildStart = std::chrono::steady_clock::now();
+    meshScene.build();
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count();
+    triangleScene.build();
+    std::printf("scene build (BVH and packing): %.3f s\n", buildSeconds);
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    int mismatches = 0;
+    const int rays = 100000;
+    for (int i = 0; i < rays; i++) {
+        Vector3D origin(uniform(generator) * 3, uniform(generator) * 3, -4);
+        Vector3D target(uniform(generator), uniform(generator) * 0.4, uniform(generator));
+        Ray ray(origin, (target - origin).normalize());
+        Hit meshHit, triangleHit;
+        bool a = meshScene.intersect(ray, 0.001, 1e9, meshHit);
+        bool b = triangleScene.intersect(ray, 0.001, 1e9, triangleHit);
+        if (a != b || (a && meshHit.t != triangleHit.t)) mismatches++;
+    }
+    std::printf("hits: %d of %d rays differ between the mesh and Triangle objects\n", mismatches, rays);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,252 @@
+//
+// Benchmark: micro
+// Times the hot functions of the renderer on fixed, seeded inputs:
+//   - sphere_intersect:   Sphere::intersect, one ray against one sphere per operation,
+//   - triangle_intersect: Triangle::intersect, one ray against one triangle per operation,
+//   - random_hemisphere:  Vector3D::randomHemisphere around a surface normal,
+//   - compute_lighting:   computeLighting at a visible point of the default scene,
+//   - trace_ray:          TraceRay of a camera ray of the default scene (depth 2).
+// Each benchmark runs one warm-up batch and then `repetitions` timed batches of the same
+// inputs (the random sequence is reseeded before every batch, so every batch does the same
+// work). The table reports the median, minimum and standard deviation of ns/op and the
+// operations (rays) per second at the median; --json writes the same numbers, plus a
+// checksum of the results, for comparison between commits.
+//
+// Build and run:  make bench   (writes bench.json)
+//                 make bench-micro && ./bench-micro [--repetitions N] [--filter NAME] [--json PATH]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "BenchUtil.h"
+#include "Camera.h"
+#include "RayTracer.h"
+
+namespace {
+
+const int ITEM_COUNT = 4096;   // Inputs per batch of the intersection and sampling kernels
+const int IMAGE_WIDTH = 64;    // Camera rays per batch of the lighting and tracing kernels
+const int IMAGE_HEIGHT = 36;
+
+//
+// Struct: Result
+// The statistics of one benchmark.
+//
+struct Result {
+    std::string name;
+    long operations;        // Operations per batch.
+    double medianNs;        // ns/op of the median batch.
+    double minNs;           // ns/op of the fastest batch.
+    double meanNs;          // Mean ns/op over the batches.
+    double stddevNs;        // Sample standard deviation of ns/op over the batches.
+    double opsPerSecond;    // Operations (rays) per second at the median.
+    double checksum;        // Sum of the results of one batch; equal between runs of the same code.
+};
+
+//
+// Function: measure
+// Runs a batch once to warm up and then `repetitions` more times, timing each.
+// Parameters:
+//   - name: The benchmark name.
+//   - operations: The number of operations in one batch.
+//   - repetitions: The number of timed batches.
+//   - batch: Runs one batch and returns its checksum.
+// Returns: The statistics of the timed batches.
+//
+Result measure(const std::string& name, long operations, int repetitions, const std::function<double()>& batch) {
+    Result result = {name, operations, 0, 0, 0, 0, 0, batch()};
+    std::vector<double> ns;
+    for (int r = 0; r < repetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        double checksum = batch();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        ns.push_back(elapsed.count() / operations);
+        if (checksum != result.checksum) {
+            std::fprintf(stderr, "%s: checksum changed between batches\n", name.c_str());
+        }
+    }
+    std::vector<double> sorted = ns;
+    std::sort(sorted.begin(), sorted.end());
+    result.medianNs = sorted[sorted.size() / 2];
+    result.minNs = sorted.front();
+    for (double value : ns) result.meanNs += value / ns.size();
+    for (double value : ns) result.stddevNs += (value - result.meanNs) * (value - result.meanNs);
+    result.stddevNs = ns.size() > 1 ? std::sqrt(result.stddevNs / (ns.size() - 1)) : 0.0;
+    result.opsPerSecond = 1e9 / result.medianNs;
+    return result;
+}
+
+//
+// Function: randomUnit
+// Returns: A uniformly distributed unit vector.
+//
+Vector3D randomUnit(std::mt19937& generator) {
+    std::normal_distribution<double> normal(0.0, 1.0);
+    return Vector3D(normal(generator), normal(generator), normal(generator)).normalize();
+}
+
+//
+// Function: cameraRays
+// Returns: One ray through the center of every pixel of a small image of the default view.
+//
+std::vector<Ray> cameraRays() {
+    Camera camera = defaultCamera(IMAGE_WIDTH, IMAGE_HEIGHT);
+    std::vector<Ray> rays;
+    for (int y = 0; y < IMAGE_HEIGHT; y++) {
+        for (int x = 0; x < IMAGE_WIDTH; x++) {
+            rays.push_back(camera.generateRay((x + 0.5) / IMAGE_WIDTH - 0.5, (y + 0.5) / IMAGE_HEIGHT - 0.5));
+        }
+    }
+    return rays;
+}
+
+//
+// Function: writeJson
+// Writes the results as a JSON document.
+// Returns: false if the file cannot be written.
+//
+bool writeJson(const std::string& path, int repetitions, const std::vector<Result>& results) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    std::fprintf(file, "{\n  \"benchmark\": \"micro\",\n  \"compiler\": \"%s\",\n  \"repetitions\": %d,\n"
+                       "  \"results\": [\n", __VERSION__, repetitions);
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        std::fprintf(file, "    {\"name\": \"%s\", \"operations\": %ld, \"ns_per_op_median\": %.4f, "
+                           "\"ns_per_op_min\": %.4f, \"ns_per_op_mean\": %.4f, \"ns_per_op_stddev\": %.4f, "
+                           "\"ops_per_second\": %.1f, \"checksum\": %.17g}%s\n",
+                     r.name.c_str(), r.operations, r.medianNs, r.minNs, r.meanNs, r.stddevNs,
+                     r.opsPerSecond, r.checksum, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int repetitions = 15;
+    std::string filter, jsonPath;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && std::strcmp(argv[i], "--repetitions") == 0) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (i + 1 < argc && std::strcmp(argv[i], "--filter") == 0) {
+            filter = argv[++i];
+        } else if (i + 1 < argc && std::strcmp(argv[i], "--json") == 0) {
+            jsonPath = argv[++i];
+        } else {
+            std::fprintf(stderr, "Usage: %s [--repetitions N] [--filter NAME] [--json PATH]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Fixed inputs: rays from a box around the origin aimed at targets near the origin,
+    // so that about half of them hit
+    std::mt19937 generator(12345);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::vector<Ray> rays;
+    std::vector<Sphere> spheres;
+    std::vector<Triangle> triangles;
+    std::vector<Vector3D> normals;
+    for (int i = 0; i < ITEM_COUNT; i++) {
+        Vector3D origin(uniform(generator) * 4, uniform(generator) * 4, -5);
+        Vector3D target(uniform(generator), uniform(generator), uniform(generator));
+        rays.push_back(Ray(origin, (target - origin).normalize()));
+        spheres.push_back(Sphere(Vector3D(uniform(generator), uniform(generator), uniform(generator)) * 0.5,
+                                 0.3 + 0.5 * std::fabs(uniform(generator)), Color(1, 1, 1), 10, 0));
+        Vector3D a(uniform(generator), uniform(generator), uniform(generator));
+        triangles.push_back(Triangle(a, a + randomUnit(generator), a + randomUnit(generator), Color(1, 1, 1), 10, 0));
+        normals.push_back(randomUnit(generator));
+    }
+
+    Scene scene;
+    setupScene(scene);
+    scene.build();
+    std::vector<Ray> primary = cameraRays();
+    const double t_max = std::numeric_limits<double>::infinity();
+
+    // Visible points of the default scene for computeLighting
+    std::vector<Vector3D> points, pointNormals, views;
+    std::vector<double> speculars;
+    for (const Ray& ray : primary) {
+        Hit hit;
+        if (!scene.intersect(ray, 1.0, t_max, hit)) continue;
+        Vector3D point = ray.origin + ray.direction * hit.t;
+        points.push_back(point);
+        pointNormals.push_back(scene.geometry.normal(hit.primitive, point));
+        views.push_back(ray.direction * -1.0);
+        speculars.push_back(scene.material(hit.primitive).specular);
+    }
+
+    std::vector<Result> results;
+    auto run = [&](const std::string& name, long operations, const std::function<double()>& batch) {
+        if (filter.empty() || name.find(filter) != std::string::npos) {
+            results.push_back(measure(name, operations, repetitions, batch));
+        }
+    };
+
+    run("sphere_intersect", ITEM_COUNT, [&] {
+        double sum = 0.0;
+        for (int i = 0; i < ITEM_COUNT; i++) {
+            Real t;
+            if (spheres[i].intersect(rays[i], t)) sum += t;
+        }
+        return sum;
+    });
+    run("triangle_intersect", ITEM_COUNT, [&] {
+        double sum = 0.0;
+        for (int i = 0; i < ITEM_COUNT; i++) {
+            Real t;
+            if (triangles[i].intersect(rays[i], t)) sum += t;
+        }
+        return sum;
+    });
+    run("random_hemisphere", ITEM_COUNT, [&] {
+        seedRandom(1);
+        double sum = 0.0;
+        for (int i = 0; i < ITEM_COUNT; i++) sum += normals[i].randomHemisphere().dot(normals[i]);
+        return sum;
+    });
+    run("compute_lighting", static_cast<long>(points.size()), [&] {
+        seedRandom(2);
+        double sum = 0.0;
+        for (std::size_t i = 0; i < points.size(); i++) {
+            Color c = computeLighting(scene, points[i], pointNormals[i], views[i], speculars[i]);
+            sum += c.r + c.g + c.b;
+        }
+        return sum;
+    });
+    run("trace_ray", static_cast<long>(primary.size()), [&] {
+        seedRandom(3);
+        double sum = 0.0;
+        for (const Ray& ray : primary) {
+            Color c = TraceRay(scene, ray, 1.0, t_max, 2);
+            sum += c.r + c.g + c.b;
+        }
+        return sum;
+    });
+
+    std::printf("%-20s %10s %12s %12s %12s %14s\n", "benchmark", "ops/batch", "median ns/op", "min ns/op",
+                "stddev", "ops/s");
+    for (const Result& r : results) {
+        std::printf("%-20s %10ld %12.2f %12.2f %11.1f%% %14.0f\n", r.name.c_str(), r.operations, r.medianNs,
+                    r.minNs, 100.0 * r.stddevNs / r.meanNs, r.opsPerSecond);
+    }
+    if (!jsonPath.empty()) {
+        if (!writeJson(jsonPath, repetitions, results)) {
+            std::fprintf(stderr, "Cannot write %s\n", jsonPath.c_str());
+            return 1;
+        }
+        std::printf("Results written to %s\n", jsonPath.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+//
+// Benchmark: packet
+// Measures primary-visibility throughput of packet tracing against one-ray-at-a-time
+// traversal. Camera rays are generated tile by tile, like Renderer::renderTile does, and
+// traced with every packet instruction set the CPU supports. Every instruction set must
+// report exactly the same hits as the scalar path.
+//
+// Build and run:  make bench-packet && ./bench-packet [randomPrimitives]
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+#include "BenchUtil.h"
+#include "PacketTracer.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 640;
+const int FRAME_HEIGHT = 360;
+const int SAMPLES_PER_PIXEL = 4;
+const int TILE_SIZE = 16;
+const int REPETITIONS = 5;
+
+//
+// Function: addRandomPrimitives
+// Adds `count` small random spheres and triangles in front of the camera.
+//
+void addRandomPrimitives(Scene& scene, long count) {
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (long i = 0; i < count; i++) {
+        Vector3D center(-6.0 + 12.0 * unit(generator), -2.0 + 7.0 * unit(generator), 2.0 + 10.0 * unit(generator));
+        if (i % 2 == 0) {
+            scene.spheres.push_back(Sphere(center, 0.02 + 0.08 * unit(generator), Color(1, 1, 1), 10, 0.0));
+        } else {
+            Vector3D a = center + Vector3D(unit(generator), unit(generator), unit(generator)) * 0.2;
+            Vector3D b = center + Vector3D(unit(generator), unit(generator), unit(generator)) * 0.2;
+            scene.triangles.push_back(Triangle(center, a, b, Color(1, 1, 1), 10, 0.0));
+        }
+    }
+}
+
+//
+// Function: generateTileRays
+// Generates the jittered camera rays of a frame, grouped by tile in render order.
+//
+std::vector<std::vector<Ray>> generateTileRays() {
+    Camera camera = defaultCamera(FRAME_WIDTH, FRAME_HEIGHT);
+    std::vector<std::vector<Ray>> tiles;
+    seedRandom(11);
+
+    for (int y0 = 0; y0 < FRAME_HEIGHT; y0 += TILE_SIZE) {
+        for (int x0 = 0; x0 < FRAME_WIDTH; x0 += TILE_SIZE) {
+            std::vector<Ray> rays;
+            for (int y = y0; y < std::min(y0 + TILE_SIZE, FRAME_HEIGHT); y++) {
+                for (int x = x0; x < std::min(x0 + TILE_SIZE, FRAME_WIDTH); x++) {
+                    for (int s = 0; s < SAMPLES_PER_PIXEL; s++) {
+                        double u = ((x + randDouble()) / FRAME_WIDTH) - 0.5;
+                        double v = ((y + randDouble()) / FRAME_HEIGHT) - 0.5;
+                        rays.push_back(camera.generateRay(u, v));
+                    }
+                }
+            }
+            tiles.push_back(std::move(rays));
+        }
+    }
+    return tiles;
+}
+
+//
+// Struct: TileHits
+// The closest hits of one tile's rays.
+//
+struct TileHits {
+    std::vector<Hit> hits;
+    std::unique_ptr<bool[]> found;
+};
+
+//
+// Function: measure
+// Traces all tiles with one instruction set (best of REPETITIONS) and prints Mrays/s.
+// Returns: The hits of the last repetition.
+//
+std::vector<TileHits> measure(const Scene& scene, PacketIsa isa,
+                              const std::vector<std::vector<Ray>>& tiles, double scalarSeconds,
+                              double& seconds) {
+    std::vector<TileHits> results(tiles.size());
+    for (size_t i = 0; i < tiles.size(); i++) {
+        results[i].hits.resize(tiles[i].size());
+        results[i].found.reset(new bool[tiles[i].size()]);
+    }
+
+    long rayCount = 0;
+    for (const std::vector<Ray>& rays : tiles) rayCount += rays.size();
+
+    seconds = std::numeric_limits<double>::infinity();
+    for (int r = 0; r < REPETITIONS; r++) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < tiles.size(); i++) {
+            intersectPackets(scene, isa, tiles[i].data(), static_cast<int>(tiles[i].size()), 1.0,
+                             std::numeric_limits<double>::infinity(), results[i].hits.data(),
+                             results[i].found.get());
+        }
+        seconds = std::min(seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::printf("  %-7s %2d-wide %10.3f Mrays/s", packetIsaName(isa), packetWidth(isa),
+                rayCount / seconds * 1e-6);
+    if (scalarSeconds > 0) std::printf("   %5.2fx", scalarSeconds / seconds);
+    std::printf("\n");
+    return results;
+}
+
+//
+// Function: sameHits
+// Returns: true if both runs found the same primitive at the same distance for every ray.
+//
+bool sameHits(const std::vector<TileHits>& a, const std::vector<TileHits>& b) {
+    for (size_t i = 0; i < a.size(); i++) {
+        for (size_t j = 0; j < a[i].hits.size(); j++) {
+            if (a[i].found[j] != b[i].found[j]) return false;
+            if (!a[i].found[j]) continue;
+            const Hit& x = a[i].hits[j];
+            const Hit& y = b[i].hits[j];
+            if (x.t != y.t || x.primitive.type != y.primitive.type || x.primitive.index != y.primitive.index) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//
+// Function: runScene
+// Measures every supported instruction set on one scene and checks the hits agree.
+//
+bool runScene(const char* title, Scene& scene, const std::vector<std::vector<Ray>>& tiles) {
+    scene.build();
+    std::printf("%s: %zu primitives, %d rays per frame\n", title,
+                scene.spheres.size() + scene.triangles.size(),
+                FRAME_WIDTH * FRAME_HEIGHT * SAMPLES_PER_PIXEL);
+
+    double scalarSeconds;
+    std::vector<TileHits> reference = measure(scene, PacketIsa::SCALAR, tiles, 0.0, scalarSeconds);
+
+    const PacketIsa widths[] = {PacketIsa::SSE2, PacketIsa::AVX2, PacketIsa::AVX512};
+    for (PacketIsa isa : widths) {
+        if (resolvePacketIsa(isa) != isa) {
+            std::printf("  %-7s not supported by this CPU\n", packetIsaName(isa));
+            continue;
+        }
+        double seconds;
+        std::vector<TileHits> results = measure(scene, isa, tiles, scalarSeconds, seconds);
+        if (!sameHits(reference, results)) {
+            std::fprintf(stderr, "%s hits differ from the scalar path\n", packetIsaName(isa));
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long randomPrimitives = argc > 1 ? std::atol(argv[1]) : 10000;
+    std::vector<std::vector<Ray>> tiles = generateTileRays();
+
+    Scene defaultScene;
+    setupScene(defaultScene);
+    if (!runScene("default scene", defaultScene, tiles)) return 1;
+
+    Scene randomScene;
+    setupScene(randomScene);
+    addRandomPrimitives(randomScene, randomPrimitives);
+    if (!runScene("random scene", randomScene, tiles)) return 1;
+
+    return 0;
+}
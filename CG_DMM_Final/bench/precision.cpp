@@ -0,0 +1,176 @@
+//
+// Benchmark: precision
+// Compares single and double precision geometry, side by side in one binary:
+//   - memory:     the size of a vector, ray, sphere and triangle in each precision,
+//   - throughput: Sphere/Triangle::intersect over the same random rays and primitives,
+//   - robustness: how often a shadow ray leaving the ground sphere of the default scene
+//                 (radius 5000) hits the sphere itself, with the fixed 1e-5 origin offset
+//                 and with the scene-scaled offset of Scene::rayOffset.
+// A float coordinate near 5000 is only resolved to about 5e-4, so with the 1e-5 offset
+// many float shadow rays start below the surface; the scaled offset removes the acne.
+//
+// Build and run:  make bench-precision && ./bench-precision
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+#include "Sphere.h"
+#include "Triangle.h"
+
+namespace {
+
+const int ITEM_COUNT = 4096;
+const int PRIMITIVE_COUNT = 16;
+const int REPETITIONS = 50;
+const int SELF_HIT_RAYS = 100000;
+
+//
+// Struct: Inputs
+// Rays and primitives of one precision, converted from the same double values.
+//
+template <typename T>
+struct Inputs {
+    std::vector<RayT<T>> rays;
+    std::vector<SphereT<T>> spheres;
+    std::vector<TriangleT<T>> triangles;
+};
+
+//
+// Function: makeInputs
+// Builds seeded rays from around the origin and primitives in front of them.
+//
+template <typename T>
+Inputs<T> makeInputs() {
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    auto point = [&](double z) {
+        return Vector3T<T>(unit(generator), unit(generator), z + unit(generator));
+    };
+    Inputs<T> inputs;
+    for (int i = 0; i < ITEM_COUNT; i++) {
+        Vector3T<T> direction = Vector3T<T>(unit(generator) * 0.3, unit(generator) * 0.3, 1).normalize();
+        inputs.rays.push_back(RayT<T>(point(0) * T(0.1), direction));
+    }
+    ColorT<T> white(1, 1, 1);
+    for (int i = 0; i < PRIMITIVE_COUNT; i++) {
+        inputs.spheres.push_back(SphereT<T>(point(5), T(0.4), white, 10, 0));
+        inputs.triangles.push_back(TriangleT<T>(point(5), point(5), point(5), white, 10, 0));
+    }
+    return inputs;
+}
+
+//
+// Function: intersectAll
+// Intersects every ray with every primitive.
+// Returns: The sum of the hit distances, as a checksum.
+//
+template <typename Primitive, typename T>
+double intersectAll(const std::vector<RayT<T>>& rays, const std::vector<Primitive>& primitives) {
+    double sum = 0.0;
+    for (const RayT<T>& ray : rays) {
+        for (const Primitive& primitive : primitives) {
+            T t;
+            if (primitive.intersect(ray, t)) sum += t;
+        }
+    }
+    return sum;
+}
+
+//
+// Function: measure
+// Runs a kernel REPETITIONS times and returns the best time per intersection test in ns.
+//
+template <typename Kernel>
+double measure(Kernel kernel, double& checksum) {
+    double best = std::numeric_limits<double>::infinity();
+    for (int r = 0; r < REPETITIONS; r++) {
+        auto start = std::chrono::steady_clock::now();
+        checksum = kernel();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best / (static_cast<double>(ITEM_COUNT) * PRIMITIVE_COUNT) * 1e9;
+}
+
+//
+// Function: compare
+// Times one primitive type in both precisions and prints ns/test, the speedup and the
+// relative difference of the checksums.
+//
+template <typename FloatKernel, typename DoubleKernel>
+void compare(const char* name, FloatKernel floatKernel, DoubleKernel doubleKernel) {
+    double floatSum, doubleSum;
+    double floatNs = measure(floatKernel, floatSum);
+    double doubleNs = measure(doubleKernel, doubleSum);
+    std::printf("  %-10s double %7.2f ns   float %7.2f ns   %5.2fx   checksum difference %.1e\n",
+                name, doubleNs, floatNs, doubleNs / floatNs, std::fabs(floatSum - doubleSum) / doubleSum);
+}
+
+//
+// Function: selfHitRate
+// Shoots shadow rays from points on the top of the default scene's ground sphere, offset
+// along the normal, towards random directions of the upper hemisphere.
+// Parameters:
+//   - offset: The distance the ray origins are moved off the surface.
+// Returns: The fraction of rays that hit the ground sphere itself.
+//
+template <typename T>
+double selfHitRate(T offset) {
+    SphereT<T> ground(Vector3T<T>(0, -5002, 0), 5000, ColorT<T>(1, 1, 0), 1000, 0.5);
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    int selfHits = 0;
+    for (int i = 0; i < SELF_HIT_RAYS; i++) {
+        // A primary ray from above, as from the camera, finds the shading point
+        RayT<T> primary(Vector3T<T>(unit(generator) * 20, 2, 5 + unit(generator) * 20), Vector3T<T>(0, -1, 0));
+        T t;
+        if (!ground.intersect(primary, t)) continue;
+        Vector3T<T> point = primary.origin + primary.direction * t;
+        Vector3T<T> normal = ground.getNormal(point);
+
+        Vector3T<T> direction = normal.randomHemisphere();
+        RayT<T> shadowRay(normal.multiplyAdd(offset, point), direction);
+        selfHits += ground.occludes(shadowRay, std::numeric_limits<T>::infinity());
+    }
+    return static_cast<double>(selfHits) / SELF_HIT_RAYS;
+}
+
+//
+// Function: scaledOffset
+// The offset Scene::rayOffset gives the default scene in precision T: four ulps of its
+// largest coordinate (the bottom of the ground sphere, 10002), but at least 1e-5.
+//
+template <typename T>
+T scaledOffset() {
+    return std::max(T(1e-5), 4 * std::numeric_limits<T>::epsilon() * T(10002));
+}
+
+} // namespace
+
+int main() {
+    std::printf("Memory (bytes)      double   float\n");
+    std::printf("  Vector3D        %8zu %7zu\n", sizeof(Vector3T<double>), sizeof(Vector3T<float>));
+    std::printf("  Ray             %8zu %7zu\n", sizeof(RayT<double>), sizeof(RayT<float>));
+    std::printf("  Sphere          %8zu %7zu\n", sizeof(SphereT<double>), sizeof(SphereT<float>));
+    std::printf("  Triangle        %8zu %7zu\n", sizeof(TriangleT<double>), sizeof(TriangleT<float>));
+
+    Inputs<double> doubles = makeInputs<double>();
+    Inputs<float> floats = makeInputs<float>();
+    std::printf("Intersection throughput (%d rays x %d primitives)\n", ITEM_COUNT, PRIMITIVE_COUNT);
+    compare("sphere",
+        [&]() { return intersectAll(floats.rays, floats.spheres); },
+        [&]() { return intersectAll(doubles.rays, doubles.spheres); });
+    compare("triangle",
+        [&]() { return intersectAll(floats.rays, floats.triangles); },
+        [&]() { return intersectAll(doubles.rays, doubles.triangles); });
+
+    std::printf("Ground sphere self-hits (%d shadow rays)\n", SELF_HIT_RAYS);
+    std::printf("  double, offset 1e-5:    %6.2f%%\n", 100 * selfHitRate<double>(1e-5));
+    std::printf("  float,  offset 1e-5:    %6.2f%%\n", 100 * selfHitRate<float>(1e-5f));
+    std::printf("  float,  offset %.1e: %6.2f%%\n", scaledOffset<float>(), 100 * selfHitRate<float>(scaledOffset<float>()));
+    return 0;
+}
@@ -0,0 +1,334 @@
+//
+// Benchmark: raysort
+// Measures how the order of secondary rays affects intersection throughput and cache
+// misses. The camera rays of a frame are traced into a scene with many small random
+// primitives (its BVH and geometry are far larger than L2), and every hit spawns a
+// reflection ray and a hemisphere ray, as shadeHit does. The secondary rays are grouped
+// into waves of the size the wavefront engine traces with 64-pixel tiles, and each wave
+// is traced in every RayOrder, in packets and one ray at a time. Cache misses and
+// references of the tracing are read from the hardware counters (perf_event_open), when
+// the kernel allows it. Every order must find the same hits.
+//
+// Build and run:  make bench-raysort && ./bench-raysort [randomPrimitives]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "BenchUtil.h"
+#include "PacketTracer.h"
+#include "RaySort.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 640;
+const int FRAME_HEIGHT = 360;
+const int SAMPLES_PER_PIXEL = 4;
+const int WAVE_SIZE = 64 * 64 * SAMPLES_PER_PIXEL;   // Rays of a 64-pixel tile round
+const int REPETITIONS = 3;
+
+//
+// Class: CacheCounters
+// Counts the cache misses and references of the calling thread between start and stop.
+// Both counts stay -1 if the hardware counters cannot be opened.
+//
+class CacheCounters {
+public:
+    CacheCounters() {
+        misses = open(PERF_COUNT_HW_CACHE_MISSES, -1);
+        references = open(PERF_COUNT_HW_CACHE_REFERENCES, misses);
+    }
+
+    ~CacheCounters() {
+#ifdef __linux__
+        if (references >= 0) close(references);
+        if (misses >= 0) close(misses);
+#endif
+    }
+
+    void start() {
+#ifdef __linux__
+        if (misses < 0) return;
+        ioctl(misses, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(misses, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    //
+    // Method: stop
+    // Stops counting and returns the counts since start (-1 if unavailable).
+    //
+    void stop(long long& missCount, long long& referenceCount) {
+        missCount = referenceCount = -1;
+#ifdef __linux__
+        if (misses < 0) return;
+        ioctl(misses, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        if (read(misses, &missCount, sizeof(missCount)) != sizeof(missCount)) missCount = -1;
+        if (references >= 0 && read(references, &referenceCount, sizeof(referenceCount)) != sizeof(referenceCount)) {
+            referenceCount = -1;
+        }
+#endif
+    }
+
+private:
+    int open(unsigned long long config, int group) {
+#ifdef __linux__
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.size = sizeof(attributes);
+        attributes.config = config;
+        attributes.disabled = group < 0 ? 1 : 0;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, group, 0));
+#else
+        (void)config;
+        (void)group;
+        return -1;
+#endif
+    }
+
+    int misses;
+    int references;
+};
+
+//
+// Function: addRandomPrimitives
+// Adds `count` small random spheres and triangles in front of the camera, so that most
+// secondary rays hit something nearby.
+//
+void addRandomPrimitives(Scene& scene, long count) {
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (long i = 0; i < count; i++) {
+        Vector3D center(-6.0 + 12.0 * unit(generator), -2.0 + 7.0 * unit(generator), 2.0 + 10.0 * unit(generator));
+        if (i % 2 == 0) {
+            scene.spheres.push_back(Sphere(center, 0.02 + 0.08 * unit(generator), Color(1, 1, 1), 10, 0.5));
+        } else {
+            Vector3D a = center + Vector3D(unit(generator), unit(generator), unit(generator)) * 0.2;
+            Vector3D b = center + Vector3D(unit(generator), unit(generator), unit(generator)) * 0.2;
+            scene.triangles.push_back(Triangle(center, a, b, Color(1, 1, 1), 10, 0.5));
+        }
+    }
+}
+
+//
+// Struct: Wave
+// Secondary rays in spawn order, one array per component.
+//
+struct Wave {
+    std::vector<Real> originX, originY, originZ;
+    std::vector<Real> directionX, directionY, directionZ;
+
+    void push(const Vector3D& origin, const Vector3D& direction) {
+        originX.push_back(origin.x);
+        originY.push_back(origin.y);
+        originZ.push_back(origin.z);
+        directionX.push_back(direction.x);
+        directionY.push_back(direction.y);
+        directionZ.push_back(direction.z);
+    }
+
+    int size() const { return static_cast<int>(originX.size()); }
+
+    RayArrays arrays() const {
+        return RayArrays{originX.data(), originY.data(), originZ.data(),
+                         directionX.data(), directionY.data(), directionZ.data()};
+    }
+
+    //
+    // Method: permuted
+    // Returns: The rays in the order of a permutation.
+    //
+    Wave permuted(const std::vector<int>& permutation) const {
+        Wave result;
+        for (int i : permutation) {
+            result.push(Vector3D(originX[i], originY[i], originZ[i]),
+                        Vector3D(directionX[i], directionY[i], directionZ[i]));
+        }
+        return result;
+    }
+};
+
+//
+// Function: generateWaves
+// Traces the camera rays of a frame, 64-pixel tile by tile, and spawns the reflection and
+// hemisphere rays of their hits, one wave per tile.
+//
+std::vector<Wave> generateWaves(const Scene& scene) {
+    Camera camera = defaultCamera(FRAME_WIDTH, FRAME_HEIGHT);
+    const int tileSize = 64;
+    const Real t_max = std::numeric_limits<Real>::infinity();
+    std::vector<Wave> waves;
+    seedRandom(11);
+
+    std::vector<Ray> rays;
+    std::vector<Hit> hits;
+    for (int y0 = 0; y0 < FRAME_HEIGHT; y0 += tileSize) {
+        for (int x0 = 0; x0 < FRAME_WIDTH; x0 += tileSize) {
+            rays.clear();
+            for (int y = y0; y < std::min(y0 + tileSize, FRAME_HEIGHT); y++) {
+                for (int x = x0; x < std::min(x0 + tileSize, FRAME_WIDTH); x++) {
+                    for (int s = 0; s < SAMPLES_PER_PIXEL; s++) {
+                        Real u = ((x + randDouble()) / FRAME_WIDTH) - 0.5;
+                        Real v = ((y + randDouble()) / FRAME_HEIGHT) - 0.5;
+                        rays.push_back(camera.generateRay(u, v));
+                    }
+                }
+            }
+            int count = static_cast<int>(rays.size());
+            hits.resize(count);
+            std::unique_ptr<bool[]> found(new bool[count]);
+            intersectPackets(scene, PacketIsa::SCALAR, rays.data(), count, 1.0, t_max, hits.data(), found.get());
+
+            Wave wave;
+            for (int i = 0; i < count; i++) {
+                if (!found[i]) continue;
+                Vector3D point = rays[i].origin + rays[i].direction * hits[i].t;
+                Vector3D normal = scene.geometry.normal(hits[i].primitive, point);
+                Vector3D origin = normal.multiplyAdd(scene.rayOffset(), point);
+                wave.push(origin, rays[i].direction - normal * 2 * rays[i].direction.dot(normal));
+                wave.push(origin, normal.randomHemisphere());
+            }
+            waves.push_back(std::move(wave));
+        }
+    }
+    return waves;
+}
+
+//
+// Struct: Result
+// The outcome of tracing all waves in one order.
+//
+struct Result {
+    double seconds = std::numeric_limits<double>::infinity();
+    long long misses = -1;
+    long long references = -1;
+    long hitCount = 0;
+    double tSum = 0;
+};
+
+//
+// Function: traceWaves
+// Traces every wave (best of REPETITIONS), in packets or one ray at a time.
+//
+Result traceWaves(const Scene& scene, PacketIsa isa, const std::vector<Wave>& waves) {
+    Result result;
+    CacheCounters counters;
+    std::vector<Hit> hits;
+    std::unique_ptr<bool[]> found;
+    size_t capacity = 0;
+    for (const Wave& wave : waves) capacity = std::max(capacity, static_cast<size_t>(wave.size()));
+    hits.resize(capacity);
+    found.reset(new bool[capacity]);
+
+    for (int r = 0; r < REPETITIONS; r++) {
+        long hitCount = 0;
+        double tSum = 0;
+        long long misses, references;
+        counters.start();
+        auto start = std::chrono::steady_clock::now();
+        for (const Wave& wave : waves) {
+            intersectPackets(scene, isa, wave.arrays(), wave.size(), 0.001, std::numeric_limits<Real>::infinity(),
+                             hits.data(), found.get());
+            for (int i = 0; i < wave.size(); i++) {
+                if (!found[i]) continue;
+                hitCount++;
+                tSum += hits[i].t;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        counters.stop(misses, references);
+        if (seconds < result.seconds) {
+            result.seconds = seconds;
+            result.misses = misses;
+            result.references = references;
+        }
+        result.hitCount = hitCount;
+        result.tSum = tSum;
+    }
+    return result;
+}
+
+//
+// Function: printResult
+// Prints one line of throughput and cache counts.
+//
+void printResult(const char* order, PacketIsa isa, long rayCount, const Result& result, double baseline) {
+    std::printf("    %-7s %-7s %8.3f Mrays/s  %5.2fx", order, packetIsaName(isa), rayCount / result.seconds * 1e-6,
+                baseline / result.seconds);
+    if (result.misses >= 0) {
+        std::printf("   %7.2f misses/ray", static_cast<double>(result.misses) / rayCount);
+        if (result.references > 0) {
+            std::printf("  (%4.1f%% of references)", 100.0 * result.misses / result.references);
+        }
+    } else {
+        std::printf("   cache misses n/a");
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long randomPrimitives = argc > 1 ? std::atol(argv[1]) : 1000000;
+
+    Scene scene;
+    setupScene(scene);
+    addRandomPrimitives(scene, randomPrimitives);
+    scene.build();
+    std::vector<Wave> waves = generateWaves(scene);
+
+    long rayCount = 0;
+    for (const Wave& wave : waves) rayCount += wave.size();
+    std::printf("%zu primitives, %zu waves, %ld secondary rays\n", scene.spheres.size() + scene.triangles.size(),
+                waves.size(), rayCount);
+
+    const PacketIsa isas[] = {PacketIsa::SCALAR, resolvePacketIsa(PacketIsa::AUTO)};
+    const RayOrder orders[] = {RayOrder::NONE, RayOrder::OCTANT, RayOrder::MORTON};
+    RaySorter sorter;
+    std::vector<int> permutation;
+    Result reference;
+    double baseline[2] = {0, 0};
+    for (RayOrder order : orders) {
+        // Sort every wave, timing the sort on its own
+        std::vector<Wave> sorted;
+        auto start = std::chrono::steady_clock::now();
+        for (const Wave& wave : waves) {
+            sorter.sort(order, wave.arrays(), wave.size(), permutation);
+            sorted.push_back(wave.permuted(permutation));
+        }
+        double sortSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("  %s: sort and permute %.3f s\n", rayOrderName(order), sortSeconds);
+
+        for (int i = 0; i < 2; i++) {
+            if (i == 1 && isas[1] == PacketIsa::SCALAR) break;
+            Result result = traceWaves(scene, isas[i], sorted);
+            if (order == RayOrder::NONE) {
+                baseline[i] = result.seconds;
+                if (i == 0) reference = result;
+            } else if (result.hitCount != reference.hitCount) {
+                std::fprintf(stderr, "%s order finds %ld hits, spawn order %ld\n", rayOrderName(order),
+                             result.hitCount, reference.hitCount);
+                return 1;
+            }
+            printResult(rayOrderName(order), isas[i], rayCount, result, baseline[i]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+//
+// Benchmark: roulette
+// Measures what throughput-based Russian roulette and contribution culling save at
+// increasing recursion depths. The default scene inside three matte walls (so indirect
+// rays hit something) is rendered at depths 2 to 8 with every reflection and indirect ray
+// traced, with culling only, and with roulette and culling (the defaults). Each image's
+// noise is its RMS difference to a reference rendered with the defaults at REFERENCE_SPP
+// samples per pixel (whose own noise is included); all three estimate the same image, up
+// to the culled contributions.
+//
+// Build and run:  make bench-roulette && ./bench-roulette
+//
+
+#include <cstdio>
+#include "BenchUtil.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 160;
+const int FRAME_HEIGHT = 90;
+const int SAMPLES_PER_PIXEL = 4;
+const int REFERENCE_SPP = 64;
+const int DEPTHS[] = {2, 4, 6, 8};
+
+//
+// Function: addWalls
+// Puts matte walls behind and beside the default scene, from the ground up to y = 6.
+//
+void addWalls(Scene& scene) {
+    const Color wall(0.8, 0.8, 0.75);
+    const Vector3D corners[] = {Vector3D(-6, -2, -4), Vector3D(-6, -2, 8), Vector3D(6, -2, 8), Vector3D(6, -2, -4)};
+    for (int i = 0; i < 3; i++) {
+        Vector3D a = corners[i], b = corners[i + 1];
+        Vector3D up(0, 8, 0);
+        scene.triangles.push_back(Triangle(a, b, b + up, wall, -1, 0.0, 0.0, 0.0));
+        scene.triangles.push_back(Triangle(a, b + up, a + up, wall, -1, 0.0, 0.0, 0.0));
+    }
+}
+
+//
+// Function: render
+// Renders the default view into a framebuffer.
+// Returns: The render time in seconds.
+//
+double render(Renderer& renderer, const Scene& scene, int spp, int depth, Framebuffer& framebuffer) {
+    RenderSettings settings = benchSettings(FRAME_WIDTH, FRAME_HEIGHT, spp);
+    settings.maxDepth = depth;
+    return timedRender(renderer, scene, settings, framebuffer);
+}
+
+} // namespace
+
+int main() {
+    Scene scene;
+    setupScene(scene);
+    addWalls(scene);
+    scene.build();
+    const Real defaultRoulette = scene.rouletteThroughput;
+    const Real defaultCull = scene.cullThroughput;
+
+    Renderer renderer(0);
+    std::printf("%dx%d, %d spp, %d threads; noise is the RMS difference to a %d spp render with the defaults\n",
+                FRAME_WIDTH, FRAME_HEIGHT, SAMPLES_PER_PIXEL, renderer.threadCount(), REFERENCE_SPP);
+    std::printf("%-6s %-18s %9s %9s %9s\n", "depth", "rays", "seconds", "speedup", "noise");
+
+    struct Mode {
+        const char* name;
+        Real roulette;
+        Real cull;
+    };
+    const Mode modes[] = {{"every ray", 0, 0}, {"culling", 0, defaultCull}, {"roulette, culling", defaultRoulette, defaultCull}};
+    for (int depth : DEPTHS) {
+        scene.rouletteThroughput = defaultRoulette;
+        scene.cullThroughput = defaultCull;
+        Framebuffer reference(FRAME_WIDTH, FRAME_HEIGHT);
+        render(renderer, scene, REFERENCE_SPP, depth, reference);
+
+        double everySeconds = 0.0;
+        for (const Mode& mode : modes) {
+            scene.rouletteThroughput = mode.roulette;
+            scene.cullThroughput = mode.cull;
+            Framebuffer framebuffer(FRAME_WIDTH, FRAME_HEIGHT);
+            double seconds = render(renderer, scene, SAMPLES_PER_PIXEL, depth, framebuffer);
+            if (mode.roulette == 0 && mode.cull == 0) everySeconds = seconds;
+            std::printf("%-6d %-18s %9.3f %8.2fx %9.5f\n", depth, mode.name, seconds, everySeconds / seconds,
+                        rmsDifference(framebuffer, reference));
+        }
+    }
+    return 0;
+}
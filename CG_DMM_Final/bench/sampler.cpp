@@ -0,0 +1,111 @@
+//
+// Benchmark: sampler
+// Measures how fast each sampler's renders converge. The default scene is rendered at
+// 1 to 64 samples per pixel with every sampler, and each image's noise is its RMS
+// difference to a reference rendered at REFERENCE_SPP samples per pixel with the random
+// sampler (whose own noise is included, so the numbers only compare the samplers with each
+// other). For each sampler the benchmark also reports how many samples per pixel it needs
+// to reach the noise of the random sampler at TARGET_SPP, interpolating log-log between the
+// measured counts, and checks that its images do not depend on the thread count or the
+// tile size.
+//
+// Build and run:  make bench-sampler && ./bench-sampler [referenceSpp]
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "BenchUtil.h"
+#include "ImageWriter.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 160;
+const int FRAME_HEIGHT = 90;
+const int TARGET_SPP = 16;
+const int SAMPLE_COUNTS[] = {1, 2, 4, 8, 16, 32, 64};
+
+//
+// Function: render
+// Renders the default view with a sampler and tile size.
+// Returns: The render time in seconds.
+//
+double render(Renderer& renderer, const Scene& scene, SamplerType sampler, int spp, int tileSize,
+              Framebuffer& framebuffer) {
+    RenderSettings settings = benchSettings(FRAME_WIDTH, FRAME_HEIGHT, spp);
+    settings.tileSize = tileSize;
+    settings.sampler = sampler;
+    return timedRender(renderer, scene, settings, framebuffer);
+}
+
+//
+// Function: samplesForNoise
+// Returns: The samples per pixel at which the noise reaches `target`, interpolated log-log
+//          between the measured counts, or 0 if it is not reached within them.
+//
+double samplesForNoise(const std::vector<double>& noise, double target) {
+    const int count = static_cast<int>(noise.size());
+    if (noise[0] <= target) return SAMPLE_COUNTS[0];
+    for (int i = 1; i < count; i++) {
+        if (noise[i] <= target) {
+            double t = std::log(noise[i - 1] / target) / std::log(noise[i - 1] / noise[i]);
+            return std::exp(std::log(SAMPLE_COUNTS[i - 1]) + t * std::log(SAMPLE_COUNTS[i] / SAMPLE_COUNTS[i - 1]));
+        }
+    }
+    return 0.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int referenceSpp = argc > 1 ? std::atoi(argv[1]) : 256;
+    Scene scene;
+    setupScene(scene);
+    scene.build();
+    Renderer renderer(0);
+    std::printf("%dx%d, %d threads; noise is the RMS difference to a %d spp random-sampler reference\n",
+                FRAME_WIDTH, FRAME_HEIGHT, renderer.threadCount(), referenceSpp);
+
+    Framebuffer reference(FRAME_WIDTH, FRAME_HEIGHT);
+    render(renderer, scene, SamplerType::RANDOM, referenceSpp, 16, reference);
+
+    std::printf("%-8s", "spp");
+    for (int spp : SAMPLE_COUNTS) std::printf("%9d", spp);
+    std::printf("   spp for the noise of random at %d   ms/spp\n", TARGET_SPP);
+
+    const SamplerType samplers[] = {SamplerType::RANDOM, SamplerType::HASH, SamplerType::HALTON, SamplerType::SOBOL};
+    double targetNoise = 0.0;
+    bool reproducible = true;
+    for (SamplerType sampler : samplers) {
+        std::vector<double> noise;
+        double seconds = 0.0;
+        int samples = 0;
+        for (int spp : SAMPLE_COUNTS) {
+            Framebuffer framebuffer(FRAME_WIDTH, FRAME_HEIGHT);
+            seconds += render(renderer, scene, sampler, spp, 16, framebuffer);
+            samples += spp;
+            noise.push_back(rmsDifference(framebuffer, reference));
+            if (sampler == SamplerType::RANDOM && spp == TARGET_SPP) targetNoise = noise.back();
+        }
+        std::printf("%-8s", samplerTypeName(sampler));
+        for (double n : noise) std::printf("%9.5f", n);
+        std::printf("   %8.1f                          %6.2f\n", samplesForNoise(noise, targetNoise),
+                    seconds / samples * 1e3);
+
+        // Pixel-keyed samplers give the same image for any thread count and tile size
+        if (sampler != SamplerType::RANDOM) {
+            Framebuffer a(FRAME_WIDTH, FRAME_HEIGHT), b(FRAME_WIDTH, FRAME_HEIGHT);
+            Renderer fourThreads(4);
+            render(renderer, scene, sampler, 4, 16, a);
+            render(fourThreads, scene, sampler, 4, 48, b);
+            if (encodeImage(a, ImageFormat::PFM) != encodeImage(b, ImageFormat::PFM)) {
+                std::printf("    %s: the image depends on the thread count or tile size!\n", samplerTypeName(sampler));
+                reproducible = false;
+            }
+        }
+    }
+    return reproducible ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+//
+// Benchmark: server
+// Measures what the render server saves over one process per frame. A process per frame
+// pays for building the scene (and for starting up) before every frame; the server pays
+// it once. The benchmark times the scene build, then serves the default scene in-process
+// and requests frames over the socket from one client and from several clients at once,
+// comparing each frame's round trip (request, render, returned PPM) with its render time
+// as reported by the server. Every returned frame must be byte-identical to the same
+// frame rendered directly.
+//
+// Build and run:  make bench-server && ./bench-server [frames]
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "ImageWriter.h"
+#include "RayTracer.h"
+#include "RenderServer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 320;
+const int FRAME_HEIGHT = 180;
+const int SAMPLES_PER_PIXEL = 4;
+const int CLIENTS = 4;
+
+//
+// Function: connectTo
+// Returns: A socket connected to the server, or -1.
+//
+int connectTo(const std::string& path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection >= 0 && connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        close(connection);
+        return -1;
+    }
+    return connection;
+}
+
+//
+// Function: requestFrame
+// Sends one render request and reads the returned frame.
+// Returns: false if the server did not answer with a frame.
+//
+bool requestFrame(int connection, const std::string& request, std::vector<unsigned char>& image,
+                  double& renderSeconds) {
+    std::string line = request + "\n";
+    if (write(connection, line.data(), line.size()) != static_cast<ssize_t>(line.size())) return false;
+
+    std::string reply;
+    char c;
+    while (read(connection, &c, 1) == 1 && c != '\n') reply += c;
+    size_t bytes;
+    if (std::sscanf(reply.c_str(), "frame %lf %zu", &renderSeconds, &bytes) != 2) {
+        std::fprintf(stderr, "unexpected reply: %s\n", reply.c_str());
+        return false;
+    }
+    image.resize(bytes);
+    for (size_t done = 0; done < bytes;) {
+        ssize_t received = read(connection, image.data() + done, bytes - done);
+        if (received <= 0) return false;
+        done += static_cast<size_t>(received);
+    }
+    return true;
+}
+
+//
+// Function: frameRequest
+// Returns: The request of the i-th frame: the default view, orbiting the scene.
+//
+std::string frameRequest(int i) {
+    char request[256];
+    std::snprintf(request, sizeof(request),
+                  "render width=%d height=%d spp=%d depth=2 position=%.3f,1,-3 target=0,1,2 seed=%d",
+                  FRAME_WIDTH, FRAME_HEIGHT, SAMPLES_PER_PIXEL, 0.1 * (i % 10), i);
+    return request;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 8;
+    std::string path = "/tmp/bench-server-" + std::to_string(getpid()) + ".sock";
+
+    // What every frame would pay in a process of its own
+    auto buildStart = std::chrono::steady_clock::now();
+    Scene scene;
+    setupScene(scene);
+    scene.build();
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count();
+    std::printf("scene setup and build: %.3f ms (paid once by the server, per frame without it)\n",
+                buildSeconds * 1e3);
+
+    RenderJob defaults;
+    defaults.position = Vector3D(0, 1, -3);
+    defaults.target = Vector3D(0, 1, 2);
+    defaults.up = Vector3D(0, 1, 0);
+    RenderServer server(scene, defaults, 0, 1);
+    std::string error;
+    if (!server.listen(path, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::thread serverThread([&server] { server.run(); });
+
+    // One client: round trip against render time
+    int connection = connectTo(path);
+    std::vector<unsigned char> image;
+    double renderSum = 0.0, roundTripSum = 0.0;
+    for (int i = 0; i < frames; i++) {
+        double renderSeconds;
+        auto start = std::chrono::steady_clock::now();
+        if (!requestFrame(connection, frameRequest(i), image, renderSeconds)) return 1;
+        roundTripSum += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        renderSum += renderSeconds;
+    }
+    std::printf("1 client, %d frames of %dx%d at %d spp:\n", frames, FRAME_WIDTH, FRAME_HEIGHT, SAMPLES_PER_PIXEL);
+    std::printf("    render %.3f ms, round trip %.3f ms per frame (%.3f ms protocol and transfer)\n",
+                renderSum / frames * 1e3, roundTripSum / frames * 1e3, (roundTripSum - renderSum) / frames * 1e3);
+
+    // The last frame must match a direct render of the same job
+    RenderJob job = defaults;
+    if (!parseRenderJob(frameRequest(frames - 1), job, error)) return 1;
+    Framebuffer framebuffer(FRAME_WIDTH, FRAME_HEIGHT);
+    Renderer renderer(0);
+    renderer.render(scene, Camera(job.position, job.target, job.up, static_cast<Real>(FRAME_WIDTH) / FRAME_HEIGHT),
+                    job.settings, framebuffer);
+    if (encodeImage(framebuffer, ImageFormat::PPM) != image) {
+        std::fprintf(stderr, "the served frame differs from a direct render\n");
+        return 1;
+    }
+    close(connection);
+
+    // Several clients at once: every job is answered
+    std::vector<std::thread> clients;
+    std::vector<int> answered(CLIENTS, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < CLIENTS; c++) {
+        clients.emplace_back([&, c] {
+            int clientConnection = connectTo(path);
+            std::vector<unsigned char> clientImage;
+            double renderSeconds;
+            for (int i = c; i < frames; i += CLIENTS) {
+                if (requestFrame(clientConnection, frameRequest(i), clientImage, renderSeconds)) answered[c]++;
+            }
+            close(clientConnection);
+        });
+    }
+    for (std::thread& client : clients) client.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    int total = 0;
+    for (int count : answered) total += count;
+    std::printf("%d clients: %d of %d frames answered, %.3f ms per frame\n", CLIENTS, total, frames,
+                seconds / frames * 1e3);
+
+    server.shutdown();
+    serverThread.join();
+    return total == frames ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+//
+// Benchmark: shadow
+// Measures shadow-ray throughput of three occlusion strategies on identical ray sets:
+//   - linear:   full Sphere/Triangle::intersect on every primitive, then a t < t_max check
+//               (what computeLighting did before the occlusion API),
+//   - any-hit:  BVH::occluded, stopping at the first blocker,
+//   - cached:   Scene::occluded, trying the light's last blocker before the BVH.
+// The shadow rays are generated exactly like computeLighting does, from the primary hit
+// points of a small frame of the default scene and of the default scene plus clutter.
+//
+// Build and run:  make bench-shadow && ./bench-shadow [clutterPrimitives]
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+#include "BenchUtil.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 80;
+const int FRAME_HEIGHT = 45;
+const int SAMPLES_PER_LIGHT = 128;
+
+//
+// Struct: ShadowQuery
+// One shadow ray with its segment length and the light it belongs to.
+//
+struct ShadowQuery {
+    Ray ray;
+    double t_max;
+    int light;
+};
+
+//
+// Function: addClutter
+// Adds `count` small random spheres and triangles around the default objects.
+//
+void addClutter(Scene& scene, long count) {
+    std::mt19937 generator(99);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (long i = 0; i < count; i++) {
+        Vector3D center(-5.0 + 10.0 * unit(generator), -2.0 + 6.0 * unit(generator), 1.0 + 8.0 * unit(generator));
+        if (i % 2 == 0) {
+            scene.spheres.push_back(Sphere(center, 0.05, Color(1, 1, 1), 10, 0.0));
+        } else {
+            Vector3D a = center + Vector3D(unit(generator), unit(generator), unit(generator)) * 0.1;
+            Vector3D b = center + Vector3D(unit(generator), unit(generator), unit(generator)) * 0.1;
+            scene.triangles.push_back(Triangle(center, a, b, Color(1, 1, 1), 10, 0.0));
+        }
+    }
+}
+
+//
+// Function: generateQueries
+// Builds the shadow rays computeLighting would trace at every primary hit point.
+//
+std::vector<ShadowQuery> generateQueries(const Scene& scene) {
+    Camera camera = defaultCamera(FRAME_WIDTH, FRAME_HEIGHT);
+    std::vector<ShadowQuery> queries;
+    seedRandom(7);
+
+    for (int y = 0; y < FRAME_HEIGHT; y++) {
+        for (int x = 0; x < FRAME_WIDTH; x++) {
+            Ray ray = camera.generateRay((x + 0.5) / FRAME_WIDTH - 0.5, (y + 0.5) / FRAME_HEIGHT - 0.5);
+            Hit hit;
+            if (!scene.intersect(ray, 1.0, std::numeric_limits<double>::infinity(), hit)) continue;
+
+            Vector3D point = ray.origin + ray.direction * hit.t;
+            Vector3D normal = scene.geometry.normal(hit.primitive, point);
+
+            for (size_t l = 0; l < scene.lights.size(); l++) {
+                const Light& light = scene.lights[l];
+                if (light.type == LightType::AMBIENT) continue;
+                for (int i = 0; i < SAMPLES_PER_LIGHT; i++) {
+                    Vector3D lightSample = light.position;
+                    if (light.radius > 0) {
+                        double r = light.radius * std::sqrt(randDouble());
+                        double theta = 2.0 * M_PI * randDouble();
+                        lightSample = light.position + Vector3D(r * std::cos(theta), r * std::sin(theta), 0.0);
+                    }
+                    Vector3D lightDir = (lightSample - point).normalize();
+                    double t_max = (light.type == LightType::POINT) ? 1.0 : std::numeric_limits<double>::infinity();
+                    Vector3D shadowOrig = (lightDir.dot(normal) < 0) ? point - normal * 1e-5 : point + normal * 1e-5;
+                    queries.push_back({Ray(shadowOrig, lightDir), t_max, static_cast<int>(l)});
+                }
+            }
+        }
+    }
+    return queries;
+}
+
+//
+// Function: linearOccluded
+// The pre-occlusion-API shadow test: full intersection against every primitive.
+//
+bool linearOccluded(const Scene& scene, const Ray& shadowRay, double t_max) {
+    for (const Sphere& sphere : scene.spheres) {
+        Real t;
+        if (sphere.intersect(shadowRay, t) && t > 0 && t < t_max) return true;
+    }
+    for (const Triangle& triangle : scene.triangles) {
+        Real t;
+        if (triangle.intersect(shadowRay, t) && t > 0 && t < t_max) return true;
+    }
+    return false;
+}
+
+//
+// Function: measure
+// Runs a strategy over all queries and prints rays/second and the blocked fraction.
+//
+template <typename Strategy>
+long measure(const char* name, const std::vector<ShadowQuery>& queries, Strategy strategy) {
+    long blocked = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const ShadowQuery& query : queries) {
+        blocked += strategy(query);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("  %-10s %12.3f Mrays/s   %6.2f%% blocked\n", name,
+                queries.size() / seconds * 1e-6, 100.0 * blocked / queries.size());
+    return blocked;
+}
+
+//
+// Function: runScene
+// Measures every strategy on one scene and checks that they agree.
+//
+bool runScene(const char* title, Scene& scene) {
+    scene.build();
+    std::vector<ShadowQuery> queries = generateQueries(scene);
+    std::printf("%s: %zu primitives, %zu shadow rays\n", title,
+                scene.spheres.size() + scene.triangles.size(), queries.size());
+
+    long linear = measure("linear", queries, [&](const ShadowQuery& q) {
+        return linearOccluded(scene, q.ray, q.t_max);
+    });
+    long anyHit = measure("any-hit", queries, [&](const ShadowQuery& q) {
+        PrimitiveRef occluder;
+        return scene.bvh.occluded(scene.geometry, q.ray, q.t_max, occluder);
+    });
+    std::vector<PrimitiveRef> lastOccluders(scene.lights.size(), PrimitiveRef{PrimitiveType::SPHERE, -1});
+    long cached = measure("cached", queries, [&](const ShadowQuery& q) {
+        return scene.occluded(q.ray, q.t_max, lastOccluders[q.light]);
+    });
+
+    if (linear != anyHit || linear != cached) {
+        std::fprintf(stderr, "Blocked counts differ: linear %ld, any-hit %ld, cached %ld\n", linear, anyHit, cached);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long clutter = argc > 1 ? std::atol(argv[1]) : 2000;
+
+    Scene defaultScene;
+    setupScene(defaultScene);
+    if (!runScene("default scene", defaultScene)) return 1;
+
+    Scene clutteredScene;
+    setupScene(clutteredScene);
+    addClutter(clutteredScene, clutter);
+    if (!runScene("cluttered scene", clutteredScene)) return 1;
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+//
+// Benchmark: specialize
+// Measures the shaders specialized by selectSurfaceShader against the generic shadeSurface.
+// The default scene is rendered with its optional shading parts switched off one after the
+// other (subsurface scattering, then reflection, then the radius of the point lights), at
+// several depths with the generic shader and with the specialized one, alternately, so
+// both see the same machine load. Each time is the best of RUNS renders. Both shaders must
+// produce the same image; the last column says whether they did.
+//
+// Build and run:  make bench-specialize && ./bench-specialize
+//
+
+#include <algorithm>
+#include <cstdio>
+#include "BenchUtil.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 320;
+const int FRAME_HEIGHT = 180;
+const int SAMPLES_PER_PIXEL = 4;
+const int RUNS = 7;
+const int DEPTHS[] = {1, 2, 4};
+
+//
+// Function: render
+// Renders the default view into a framebuffer.
+// Returns: The render time in seconds.
+//
+double render(Renderer& renderer, const Scene& scene, int depth, bool specialize, Framebuffer& framebuffer) {
+    RenderSettings settings = benchSettings(FRAME_WIDTH, FRAME_HEIGHT, SAMPLES_PER_PIXEL);
+    settings.maxDepth = depth;
+    settings.specializeShading = specialize;
+    return timedRender(renderer, scene, settings, framebuffer);
+}
+
+//
+// Function: identical
+// Returns: true if two framebuffers hold exactly the same colors.
+//
+bool identical(const Framebuffer& a, const Framebuffer& b) {
+    for (int y = 0; y < a.height; y++) {
+        for (int x = 0; x < a.width; x++) {
+            const Color& p = a.getPixel(x, y);
+            const Color& q = b.getPixel(x, y);
+            if (p.r != q.r || p.g != q.g || p.b != q.b) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    Renderer renderer(0);
+    std::printf("%dx%d, %d spp, %d threads, best of %d\n", FRAME_WIDTH, FRAME_HEIGHT, SAMPLES_PER_PIXEL,
+                renderer.threadCount(), RUNS);
+    std::printf("%-22s %-6s %9s %12s %9s %10s\n", "scene", "depth", "generic", "specialized", "speedup", "identical");
+
+    const char* names[] = {"default", "no SSS", "no SSS, reflection", "matte, point lights"};
+    for (int variant = 0; variant < 4; variant++) {
+        Scene scene;
+        setupScene(scene);
+        for (Sphere& sphere : scene.spheres) {
+            if (variant >= 1) sphere.subsurfaceRadius = 0;
+            if (variant >= 2) sphere.reflective = 0;
+        }
+        for (Triangle& triangle : scene.triangles) {
+            if (variant >= 1) triangle.subsurfaceRadius = 0;
+            if (variant >= 2) triangle.reflective = 0;
+        }
+        for (Light& light : scene.lights) {
+            if (variant >= 3) light.radius = 0;
+        }
+        scene.build();
+
+        for (int depth : DEPTHS) {
+            Framebuffer generic(FRAME_WIDTH, FRAME_HEIGHT);
+            Framebuffer specialized(FRAME_WIDTH, FRAME_HEIGHT);
+            double genericSeconds = 0.0, specializedSeconds = 0.0;
+            for (int run = 0; run < RUNS; run++) {
+                double seconds = render(renderer, scene, depth, false, generic);
+                genericSeconds = run == 0 ? seconds : std::min(genericSeconds, seconds);
+                seconds = render(renderer, scene, depth, true, specialized);
+                specializedSeconds = run == 0 ? seconds : std::min(specializedSeconds, seconds);
+            }
+            std::printf("%-22s %-6d %9.3f %12.3f %8.2fx %10s\n", names[variant], depth, genericSeconds,
+                        specializedSeconds, genericSeconds / specializedSeconds,
+                        identical(generic, specialized) ? "yes" : "NO");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+//
+// Benchmark: wavefront
+// Compares the recursive and the wavefront shading engine on whole frames: the default
+// scene, and the default scene with many small random primitives, at recursion depth 2
+// and 4. Both engines render on one thread with the same settings; the wavefront engine
+// also runs with larger tiles, which gives it larger waves. The engines draw random
+// numbers in a different order, so their images differ in noise only; the mean pixel
+// values are printed to show that they agree.
+//
+// Build and run:  make bench-wavefront && ./bench-wavefront [randomPrimitives]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include "BenchUtil.h"
+#include "RayTracer.h"
+#include "Renderer.h"
+
+namespace {
+
+const int FRAME_WIDTH = 320;
+const int FRAME_HEIGHT = 180;
+const int SAMPLES_PER_PIXEL = 4;
+const int REPETITIONS = 3;
+
+//
+// Function: addRandomPrimitives
+// Adds `count` small random spheres and triangles in front of the camera, a third of
+// them reflective.
+//
+void addRandomPrimitives(Scene& scene, long count) {
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (long i = 0; i < count; i++) {
+        Vector3D center(-6.0 + 12.0 * unit(generator), -2.0 + 7.0 * unit(generator), 2.0 + 10.0 * unit(generator));
+        Color color(unit(generator), unit(generator), unit(generator));
+        double reflective = (i % 3 == 0) ? 0.3 : 0.0;
+        if (i % 2 == 0) {
+            scene.spheres.push_back(Sphere(center, 0.02 + 0.08 * unit(generator), color, 10, reflective));
+        } else {
+            Vector3D a = center + Vector3D(unit(generator), unit(generator), unit(generator)) * 0.2;
+            Vector3D b = center + Vector3D(unit(generator), unit(generator), unit(generator)) * 0.2;
+            scene.triangles.push_back(Triangle(center, a, b, color, 10, reflective));
+        }
+    }
+}
+
+//
+// Function: meanValue
+// Returns: The mean of all color channels of a framebuffer.
+//
+double meanValue(const Framebuffer& framebuffer) {
+    double sum = 0.0;
+    for (int y = 0; y < framebuffer.height; y++) {
+        for (int x = 0; x < framebuffer.width; x++) {
+            const Color& color = framebuffer.getPixel(x, y);
+            sum += color.r + color.g + color.b;
+        }
+    }
+    return sum / (3.0 * framebuffer.width * framebuffer.height);
+}
+
+//
+// Function: measure
+// Renders the frame REPETITIONS times and prints the best time and the mean pixel value.
+// Returns: The best time in seconds.
+//
+double measure(const char* name, Renderer& renderer, const Scene& scene, const RenderSettings& settings,
+               double baseline) {
+    Camera camera = defaultCamera(FRAME_WIDTH, FRAME_HEIGHT);
+    Framebuffer framebuffer(settings.width, settings.height);
+    double best = 1e30;
+    for (int r = 0; r < REPETITIONS; r++) {
+        auto start = std::chrono::steady_clock::now();
+        renderer.render(scene, camera, settings, framebuffer);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    double samples = static_cast<double>(settings.width) * settings.height * settings.spp;
+    std::printf("    %-22s %8.3f s  %8.3f Msamples/s  %5.2fx   mean %.4f\n", name, best, samples / best * 1e-6,
+                baseline > 0 ? baseline / best : 1.0, meanValue(framebuffer));
+    return best;
+}
+
+//
+// Function: runScene
+// Measures both engines at depth 2 and 4 on one scene.
+//
+void runScene(const char* title, Scene& scene) {
+    scene.build();
+    std::printf("%s: %zu primitives\n", title, scene.spheres.size() + scene.triangles.size());
+    Renderer renderer(1);
+    for (int depth : {2, 4}) {
+        std::printf("  depth %d\n", depth);
+        RenderSettings settings = benchSettings(FRAME_WIDTH, FRAME_HEIGHT, SAMPLES_PER_PIXEL);
+        settings.maxDepth = depth;
+        double recursive = measure("recursive", renderer, scene, settings, 0.0);
+        settings.engine = RenderEngine::WAVEFRONT;
+        measure("wavefront, 16px tiles", renderer, scene, settings, recursive);
+        settings.tileSize = 64;
+        measure("wavefront, 64px tiles", renderer, scene, settings, recursive);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long primitives = argc > 1 ? std::atol(argv[1]) : 100000;
+
+    Scene defaultScene;
+    setupScene(defaultScene);
+    runScene("default scene", defaultScene);
+
+    Scene largeScene;
+    setupScene(largeScene);
+    addRandomPrimitives(largeScene, primitives);
+    runScene("large scene", largeScene);
+    return 0;
+}
@@ -1,88 +1,482 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <fstream>
-#include <limits>
+#include <string>
+#include <sys/stat.h>
+#include "GBuffer.h"
+#include "ImageWriter.h"
+#include "MeshLoader.h"
 #include "RayTracer.h"
+#include "Renderer.h"
+#include "RenderServer.h"
+#include "SceneCache.h"
+#include "TileFarm.h"
+
+//
+// Function: printUsage
+// Prints the supported command line options.
+//
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --threads N   Number of render threads (default: all hardware threads)\n"
+              << "  --width N     Image width in pixels (default: 1280)\n"
+              << "  --height N    Image height in pixels (default: 720)\n"
+              << "  --spp N       Samples per pixel; the minimum with --max-spp (default: 4)\n"
+              << "  --max-spp N   Adaptive sampling: up to N samples for noisy pixels (default: off)\n"
+              << "  --threshold E Adaptive sampling: target standard error of pixel luminance (default: 0.01)\n"
+              << "  --sample-map PATH  Also write the per-pixel sample counts as a grayscale image\n"
+              << "  --depth N     Maximum ray recursion depth (default: 2)\n"
+              << "  --tile N      Tile edge length in pixels (default: 16)\n"
+              << "  --seed N      Random seed (default: 0)\n"
+              << "  --mesh PATH   Add an OBJ or binary PLY model, standing on the ground beside the spheres\n"
+              << "  --scene-cache PATH  Load the built scene from PATH, or build it and save it there\n"
+              << "  --gbuffer PATH  Re-shade the primary hits stored in PATH, or render and store them there\n"
+              << "  --stats PATH  Also write the render statistics as JSON (builds with RAYTRACER_STATS only)\n"
+              << "  --simd ISA    Packet tracing: auto, scalar, sse2, avx2 or avx512 (default: auto)\n"
+              << "  --engine E    Shading engine: recursive or wavefront (default: recursive)\n"
+              << "  --ray-order O Wavefront engine: secondary ray order none, octant or morton (default: morton)\n"
+              << "  --sampler S   Random numbers: random, hash, halton or sobol (default: random)\n"
+              << "  --shading S   Recursive engine: generic, or specialized for the scene's features and depth\n"
+              << "                (default: specialized)\n"
+              << "  --light-samples N  Pick N point lights per shading point from the light tree (default: 0, all)\n"
+              << "  --roulette T  Russian roulette for reflection and indirect rays below path throughput T\n"
+              << "                (default: 0.1; 0 traces every ray)\n"
+              << "  --cull T      Skip reflection and indirect rays that can add less than T to a pixel\n"
+              << "                (default: 1/512; 0 culls nothing)\n"
+              << "  --irradiance-cache A  Interpolate indirect light from an irradiance cache with accuracy A,\n"
+              << "                e.g. 0.3 (default: off, one indirect ray per hit)\n"
+              << "  --serve PATH  Run as a render server on the Unix socket PATH instead of rendering once\n"
+              << "  --renderers N Render server: jobs rendered at the same time, sharing the threads (default: 1)\n"
+              << "  --serve-output DIR  Render server: directory for the images of jobs with output=PATH\n"
+              << "                (default: none; such jobs are refused)\n"
+              << "  --farm PORT   Coordinate a tile farm: hand the frame's tiles to workers connecting on TCP PORT\n"
+              << "  --worker HOST:PORT  Render tiles for the farm coordinator at HOST:PORT, then exit\n"
+              << "  --farm-timeout S    Tile farm: drop workers silent for S seconds with tiles outstanding\n"
+              << "                (default: 60)\n"
+              << "  --output PATH Output image path; .pfm writes a float map, anything else binary PPM\n"
+              << "                (default: output.ppm)\n";
+}
+
+//
+// Function: addMesh
+// Loads a mesh file and places it on the ground beside the spheres.
+// Returns: false (after printing the error) if the file cannot be loaded.
+//
+static bool addMesh(Scene& scene, const std::string& path, int threadCount) {
+    Mesh mesh;
+    std::string error;
+    auto loadStart = std::chrono::steady_clock::now();
+    if (!loadMesh(path, mesh, error, threadCount)) {
+        std::cerr << "Error: " << error << "\n";
+        return false;
+    }
+    std::chrono::duration<double> loadTime = std::chrono::steady_clock::now() - loadStart;
+    std::cout << "Loaded " << mesh.triangleCount() << " triangles and " << mesh.vertexCount()
+              << " vertices in " << loadTime.count() << " s (" << mesh.memoryBytes() / (1024.0 * 1024.0) << " MiB).\n";
+
+    mesh.fitInto(AABB(Vector3D(2.6, -2, 1.2), Vector3D(4.6, 0, 3.2)));
+    scene.meshes.push_back(std::move(mesh));
+    return true;
+}
+
+//
+// Function: fileSignature
+// Returns: The path, size and modification time of a file, so a scene cache built from an
+//          older version of the file is recognized as stale without reading it.
+//
+static std::string fileSignature(const std::string& path) {
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0) return path;
+    return path + ":" + std::to_string(status.st_size) + ":" + std::to_string(status.st_mtim.tv_sec) + "." +
+           std::to_string(status.st_mtim.tv_nsec);
+}
+
+//
+// Function: fileNameAndSize
+// Returns: The name (without the directory) and size of a file, which unlike its path and
+//          date agree between machines holding copies of the same file.
+//
+static std::string fileNameAndSize(const std::string& path) {
+    struct stat status;
+    std::string name = path.substr(path.rfind('/') + 1);
+    if (stat(path.c_str(), &status) != 0) return name;
+    return name + ":" + std::to_string(status.st_size);
+}
+
+//
+// Function: writeSampleMap
+// Writes the per-pixel sample counts as a grayscale debug image, if a path is given.
+// Returns: false if the image could not be written.
+//
+static bool writeSampleMap(const Framebuffer& framebuffer, const RenderSettings& settings,
+                           const std::string& sampleMapPath) {
+    if (sampleMapPath.empty()) return true;
+    Framebuffer sampleMap = framebuffer.sampleCountImage(std::max(settings.spp, settings.maxSpp));
+    ImageWriter sampleMapWriter(sampleMap, sampleMapPath, imageFormatForPath(sampleMapPath));
+    sampleMapWriter.submitRows(0, sampleMap.height);
+    if (!sampleMapWriter.finish()) {
+        std::cerr << "Error: Could not write " << sampleMapPath << ".\n";
+        return false;
+    }
+    std::cout << "Sample counts saved as " << sampleMapPath << "\n";
+    return true;
+}
 
 //
 // Main function
-// Sets up the scene, performs ray tracing, and outputs the rendered image as a PPM file.
+// Sets up the scene, renders it on all requested threads, and streams the rendered image
+// to a binary PPM or PFM file while rendering. With --serve, keeps the built scene and
+// renders the jobs sent over a Unix socket instead (see RenderServer). With --farm, hands
+// the tiles to --worker processes instead (see TileFarm.h).
 //
-int main() {
-    // Set up the scene
-    setupScene();
+int main(int argc, char* argv[]) {
+    RenderSettings settings;
+    int threadCount = 0;
+    std::string outputPath = "output.ppm";
+    std::string sampleMapPath;
+    std::string meshPath;
+    std::string sceneCachePath;
+    std::string gbufferPath;
+    std::string statsPath;
+    int lightSamples = 0;
+    Real cacheAccuracy = 0;
+    Real rouletteThroughput = 0.1;
+    Real cullThroughput = 1.0 / 512;
+    std::string servePath;
+    int rendererCount = 1;
+    std::string serveOutputDirectory;
+    int farmPort = 0;
+    std::string workerAddress;
+    double farmTimeout = 60.0;
 
-    const int width = 1280;        // Image width in pixels
-    const int height = 720;        // Image height in pixels
-    const int maxDepth = 2;        // Maximum recursion depth for ray tracing
+    // Parse the command line options
+    for (int i = 1; i < argc; i++) {
+        const char* option = argv[i];
+        if (std::strcmp(option, "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (std::strcmp(option, "--threads") == 0) {
+            threadCount = std::atoi(value);
+        } else if (std::strcmp(option, "--width") == 0) {
+            settings.width = std::atoi(value);
+        } else if (std::strcmp(option, "--height") == 0) {
+            settings.height = std::atoi(value);
+        } else if (std::strcmp(option, "--spp") == 0) {
+            settings.spp = std::atoi(value);
+        } else if (std::strcmp(option, "--max-spp") == 0) {
+            settings.maxSpp = std::atoi(value);
+        } else if (std::strcmp(option, "--threshold") == 0) {
+            settings.errorThreshold = std::atof(value);
+        } else if (std::strcmp(option, "--sample-map") == 0) {
+            sampleMapPath = value;
+        } else if (std::strcmp(option, "--depth") == 0) {
+            settings.maxDepth = std::atoi(value);
+        } else if (std::strcmp(option, "--tile") == 0) {
+            settings.tileSize = std::atoi(value);
+        } else if (std::strcmp(option, "--seed") == 0) {
+            settings.seed = std::strtoull(value, nullptr, 10);
+        } else if (std::strcmp(option, "--mesh") == 0) {
+            meshPath = value;
+        } else if (std::strcmp(option, "--scene-cache") == 0) {
+            sceneCachePath = value;
+        } else if (std::strcmp(option, "--gbuffer") == 0) {
+            gbufferPath = value;
+        } else if (std::strcmp(option, "--stats") == 0) {
+            statsPath = value;
+        } else if (std::strcmp(option, "--simd") == 0) {
+            if (!parsePacketIsa(value, settings.packetIsa)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(option, "--engine") == 0) {
+            if (std::strcmp(value, "recursive") == 0) {
+                settings.engine = RenderEngine::RECURSIVE;
+            } else if (std::strcmp(value, "wavefront") == 0) {
+                settings.engine = RenderEngine::WAVEFRONT;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(option, "--ray-order") == 0) {
+            if (!parseRayOrder(value, settings.rayOrder)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(option, "--sampler") == 0) {
+            if (!parseSamplerType(value, settings.sampler)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(option, "--shading") == 0) {
+            if (std::strcmp(value, "generic") == 0) {
+                settings.specializeShading = false;
+            } else if (std::strcmp(value, "specialized") == 0) {
+                settings.specializeShading = true;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(option, "--light-samples") == 0) {
+            lightSamples = std::atoi(value);
+        } else if (std::strcmp(option, "--roulette") == 0) {
+            rouletteThroughput = std::atof(value);
+        } else if (std::strcmp(option, "--cull") == 0) {
+            cullThroughput = std::atof(value);
+        } else if (std::strcmp(option, "--irradiance-cache") == 0) {
+            cacheAccuracy = std::atof(value);
+        } else if (std::strcmp(option, "--serve") == 0) {
+            servePath = value;
+        } else if (std::strcmp(option, "--renderers") == 0) {
+            rendererCount = std::atoi(value);
+        } else if (std::strcmp(option, "--serve-output") == 0) {
+            serveOutputDirectory = value;
+        } else if (std::strcmp(option, "--farm") == 0) {
+            farmPort = std::atoi(value);
+            if (farmPort <= 0) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(option, "--worker") == 0) {
+            workerAddress = value;
+        } else if (std::strcmp(option, "--farm-timeout") == 0) {
+            farmTimeout = std::atof(value);
+            if (!(farmTimeout > 0)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(option, "--output") == 0) {
+            outputPath = value;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
 
-    // Samples per pixel (spp) for anti-aliasing
-    const int spp = 4;
+    if (settings.width <= 0 || settings.height <= 0 || settings.spp <= 0 || settings.tileSize <= 0) {
+        std::cerr << "Error: width, height, spp and tile size must be positive.\n";
+        return 1;
+    }
+    if (settings.sampler != SamplerType::RANDOM && settings.engine == RenderEngine::WAVEFRONT) {
+        std::cerr << "Warning: the wavefront engine always uses the random sampler.\n";
+    }
+    if (!gbufferPath.empty() && (settings.engine != RenderEngine::RECURSIVE || settings.maxSpp > settings.spp)) {
+        std::cerr << "Error: --gbuffer needs the recursive engine and a fixed number of samples per pixel.\n";
+        return 1;
+    }
 
-    // Open the output file for the rendered image
-    std::ofstream outFile("output.ppm");
-    if (!outFile) {
-        std::cerr << "Error: Could not open output.ppm for writing.\n";
+    bool farming = farmPort > 0 || !workerAddress.empty();
+    if ((farmPort > 0) + !workerAddress.empty() + !servePath.empty() + !gbufferPath.empty() > 1) {
+        std::cerr << "Error: --farm, --worker, --serve and --gbuffer cannot be combined.\n";
+        return 1;
+    }
+    if (farming && cacheAccuracy > 0) {
+        std::cerr << "Error: the irradiance cache is not supported in a tile farm.\n";
         return 1;
     }
 
-    // Write the PPM file header
-    outFile << "P3\n" << width << " " << height << "\n255\n";
+    // Camera setup
+    Real aspectRatio = static_cast<Real>(settings.width) / settings.height; // Aspect ratio of the image
+    Camera camera(Vector3D(0, 1, -3),      // Camera position
+                  Vector3D(0, 1, 2),       // Point the camera is looking at
+                  Vector3D(0, 1, 0),       // Up direction vector
+                  aspectRatio);
 
-    double aspectRatio = static_cast<double>(width) / height;  // Aspect ratio of the image
-    double viewportHeight = 2.0;                              // Viewport height
-    double viewportWidth = viewportHeight * aspectRatio;      // Viewport width
+    // Set up the scene and build its acceleration structure, or map it from the scene cache
+    Scene scene;
+    setupScene(scene);
+    scene.lightSamples = lightSamples;
+    scene.rouletteThroughput = rouletteThroughput;
+    scene.cullThroughput = cullThroughput;
+    if (cacheAccuracy > 0) scene.indirectCache = std::make_unique<IrradianceCache>(cacheAccuracy);
+    std::string sources = meshPath.empty() ? "" : fileSignature(meshPath);
+    uint64_t gbufferFingerprint = GBuffer::computeFingerprint(scene, sources, camera, settings);
 
-    // Camera setup
-    Vector3D origin(0, 1, -3);            // Camera position
-    Vector3D lookAt(0, 1, 2);             // Point the camera is looking at
-    Vector3D cameraDirection = (lookAt - origin).normalize(); // Camera direction (normalized)
-
-    Vector3D up(0, 1, 0);                         // Up direction vector
-    Vector3D right = cameraDirection.cross(up).normalize(); // Right direction vector
-    Vector3D cameraUp = right.cross(cameraDirection).normalize(); // Adjusted up vector
-
-    // Render each pixel
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            Color pixelColor(0, 0, 0); // Initialize pixel color to black
-
-            // Perform anti-aliasing by averaging multiple samples per pixel
-            for (int s = 0; s < spp; s++) {
-                double u = ((x + randDouble()) / width) - 0.5;  // Randomized horizontal offset
-                double v = ((y + randDouble()) / height) - 0.5; // Randomized vertical offset
-
-                // Compute the direction of the ray for this sample
-                Vector3D direction = (cameraDirection +
-                                      right * (u * viewportWidth) +
-                                      cameraUp * (v * viewportHeight)).normalize();
-                Ray ray(origin, direction);
-
-                // Trace the ray and accumulate the resulting color
-                Color sampleColor = TraceRay(ray, 1.0, std::numeric_limits<double>::infinity(), maxDepth);
-                pixelColor = pixelColor + sampleColor;
+    // Tile farm coordinator: the workers build and trace the scene, this process only merges
+    // their tiles, so it needs no more of the scene than its fingerprint
+    uint64_t farmScene = farming ? farmFingerprint(scene, meshPath.empty() ? "" : fileNameAndSize(meshPath)) : 0;
+    if (farmPort > 0) {
+        RenderJob job;
+        job.settings = settings;
+        job.position = Vector3D(0, 1, -3);
+        job.target = Vector3D(0, 1, 2);
+        job.up = Vector3D(0, 1, 0);
+        FarmCoordinator coordinator(job, farmScene, farmTimeout);
+        std::string error;
+        if (!coordinator.listen(farmPort, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        std::cout << "Coordinating " << tileCount(settings) << " tiles; waiting for workers on port " << farmPort
+                  << "." << std::endl;
+
+        Framebuffer framebuffer(settings.width, settings.height);
+        ImageWriter writer(framebuffer, outputPath, imageFormatForPath(outputPath));
+        auto start = std::chrono::steady_clock::now();
+        bool rendered = coordinator.run(framebuffer, [&writer](int y0, int y1) { writer.submitRows(y0, y1); }, error);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        bool written = writer.finish();
+        if (!rendered) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        if (!written) {
+            std::cerr << "Error: Could not write " << outputPath << ".\n";
+            return 1;
+        }
+        std::cout << "Farm rendering completed in " << elapsed.count() << " s by " << coordinator.workersSeen()
+                  << " worker(s), " << coordinator.reissuedTiles() << " tile(s) handed out again. Image saved as "
+                  << outputPath << "\n";
+        return writeSampleMap(framebuffer, settings, sampleMapPath) ? 0 : 1;
+    }
+    uint64_t fingerprint = 0;
+    uint64_t geometryFingerprint = 0;
+    bool mapped = false;
+    if (!sceneCachePath.empty()) {
+        fingerprint = SceneCache::fingerprint(scene, sources);
+        geometryFingerprint = SceneCache::geometryFingerprint(scene, sources);
+        std::string error;
+        auto loadStart = std::chrono::steady_clock::now();
+        mapped = SceneCache::load(scene, sceneCachePath, fingerprint, error);
+        if (mapped) {
+            std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - loadStart;
+            std::cout << "Mapped the scene from " << sceneCachePath << " in " << loadTime.count() << " ms.\n";
+        } else if (SceneCache::loadGeometry(scene, sceneCachePath, geometryFingerprint, error)) {
+            // Only lights or materials changed: keep the BVH, rebuild the shading data
+            mapped = true;
+            std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - loadStart;
+            std::cout << "Mapped the geometry from " << sceneCachePath << " and rebuilt the lights and materials in "
+                      << loadTime.count() << " ms.\n";
+        } else {
+            std::cout << "Scene cache not used: " << error << "\n";
+        }
+    }
+    if (!mapped) {
+        if (!meshPath.empty() && !addMesh(scene, meshPath, threadCount)) return 1;
+        auto buildStart = std::chrono::steady_clock::now();
+        scene.build();
+        std::chrono::duration<double> buildTime = std::chrono::steady_clock::now() - buildStart;
+        if (!sceneCachePath.empty()) {
+            std::string error;
+            if (SceneCache::save(scene, sceneCachePath, fingerprint, geometryFingerprint, error)) {
+                std::cout << "Built the scene in " << buildTime.count() << " s and saved it to " << sceneCachePath << ".\n";
+            } else {
+                std::cerr << "Warning: " << error << "\n";
             }
+        }
+    }
 
-            // Average the samples to compute the final pixel color
-            pixelColor = pixelColor * (1.0 / spp);
-            pixelColor.clamp(); // Ensure the color values are in range [0.0, 1.0]
+    // Render server: keep the built scene and render the jobs sent over the socket
+    if (!servePath.empty()) {
+        RenderJob defaults;
+        defaults.settings = settings;
+        defaults.position = Vector3D(0, 1, -3);
+        defaults.target = Vector3D(0, 1, 2);
+        defaults.up = Vector3D(0, 1, 0);
+        RenderServer server(scene, defaults, threadCount, rendererCount, serveOutputDirectory);
+        std::string error;
+        if (!server.listen(servePath, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        std::cout << "Serving render jobs on " << servePath << " with " << std::max(1, rendererCount)
+                  << " renderer(s); send \"shutdown\" to stop." << std::endl;
+        server.run();
+        return 0;
+    }
 
-            // Convert color values to integers in range [0, 255]
-            int r = static_cast<int>(pixelColor.r * 255);
-            int g = static_cast<int>(pixelColor.g * 255);
-            int b = static_cast<int>(pixelColor.b * 255);
+    // Tile farm worker: render the coordinator's tiles with the built scene
+    if (!workerAddress.empty()) {
+        std::string error;
+        int tilesRendered = 0;
+        if (!runFarmWorker(workerAddress, scene, farmScene, settings, threadCount, tilesRendered, error)) {
+            std::cerr << "Error: " << error << " (after " << tilesRendered << " tiles)\n";
+            return 1;
+        }
+        std::cout << "Rendered " << tilesRendered << " tiles for " << workerAddress << ".\n";
+        return 0;
+    }
+
+    // G-buffer: re-shade the stored primary hits if they were recorded for this geometry,
+    // camera and sampling, otherwise record them during the render
+    GBuffer gbuffer;
+    bool reshading = false;
+    if (!gbufferPath.empty()) {
+        std::string error;
+        reshading = gbuffer.load(gbufferPath, scene, gbufferFingerprint, error);
+        if (reshading) {
+            std::cout << "Re-shading the primary hits stored in " << gbufferPath << ".\n";
+        } else {
+            std::cout << "G-buffer not used: " << error << "\n";
+        }
+    }
+
+    // Render every tile into the framebuffer; the writer thread encodes and writes each row
+    // of tiles as soon as it is finished
+    Framebuffer framebuffer(settings.width, settings.height);
+    Renderer renderer(threadCount);
+    ImageWriter writer(framebuffer, outputPath, imageFormatForPath(outputPath));
+
+    auto start = std::chrono::steady_clock::now();
+    auto onRowsDone = [&writer](int y0, int y1) { writer.submitRows(y0, y1); };
+    if (reshading) {
+        renderer.reshade(scene, camera, gbuffer, settings, framebuffer, onRowsDone);
+    } else {
+        renderer.render(scene, camera, settings, framebuffer, onRowsDone, gbufferPath.empty() ? nullptr : &gbuffer);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    bool written = writer.finish();
+    std::chrono::duration<double> total = std::chrono::steady_clock::now() - start;
+    if (!written) {
+        std::cerr << "Error: Could not write " << outputPath << ".\n";
+        return 1;
+    }
+
+    std::cout << "Rendering completed in " << elapsed.count() << " s on "
+              << renderer.threadCount() << " threads (SIMD: " << packetIsaName(resolvePacketIsa(settings.packetIsa))
+              << (settings.engine == RenderEngine::WAVEFRONT ? ", wavefront" : "") << "), written after " << total.count() << " s. Image saved as " << outputPath << "\n";
+
+    if (!gbufferPath.empty() && !reshading) {
+        std::string error;
+        gbuffer.fingerprint = gbufferFingerprint;
+        if (gbuffer.save(gbufferPath, error)) {
+            std::cout << "Primary hits saved to " << gbufferPath << " ("
+                      << gbuffer.samples.size() * sizeof(GBufferSample) / (1024.0 * 1024.0) << " MiB).\n";
+        } else {
+            std::cerr << "Warning: " << error << "\n";
+        }
+    }
 
-            // Clamp the integer values to ensure they are within the valid range
-            r = std::min(255, std::max(0, r));
-            g = std::min(255, std::max(0, g));
-            b = std::min(255, std::max(0, b));
+    if (scene.indirectCache) {
+        std::cout << "Irradiance cache: " << scene.indirectCache->recordCount() << " records.\n";
+    }
 
-            // Write the pixel color to the output file
-            outFile << r << " " << g << " " << b << "\n";
+    // Render statistics: counted only in builds with RAYTRACER_STATS (make main-stats)
+    if (RenderStats::enabled) {
+        renderer.statistics().print(std::cout, elapsed.count());
+        std::string error;
+        if (!statsPath.empty() && !renderer.statistics().writeJson(statsPath, elapsed.count(), error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
         }
+    } else if (!statsPath.empty()) {
+        std::cerr << "Warning: --stats needs a build with RAYTRACER_STATS (make main-stats); no statistics written.\n";
     }
 
-    outFile.close(); // Close the output file
-    std::cout << "Rendering completed. Image saved as output.ppm\n";
+    if (settings.maxSpp > settings.spp) {
+        long totalSamples = 0;
+        for (int count : framebuffer.sampleCounts) totalSamples += count;
+        std::cout << "Adaptive sampling: " << static_cast<double>(totalSamples) / framebuffer.sampleCounts.size()
+                  << " samples per pixel on average (" << settings.spp << " to " << settings.maxSpp << ").\n";
+    }
 
-    return 0;
-}
\ No newline at end of file
+    return writeSampleMap(framebuffer, settings, sampleMapPath) ? 0 : 1;
+}